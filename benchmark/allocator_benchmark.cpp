@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <data/facilities/allocators.h>
+
+// Allocate/free churn as seen by concurrently evaluated EvalUnits: every thread repeatedly takes a few
+// buffers of matrix-like sizes and drops them. Compared with the previous single-mutex pool, whose
+// deleter also took the lock.
+
+namespace
+{
+struct GlobalLockPool
+{
+    template <typename T>
+    static std::shared_ptr<T> Allocate(size_t p_elemSize)
+    {
+        const size_t bytes = (p_elemSize * sizeof(T) + 1023) & (size_t(-1) ^ 1023);
+        std::lock_guard<std::mutex> guard(Mutex());
+        static std::unordered_map<size_t, std::deque<void*>> buffer;
+        auto& slot = buffer[bytes];
+        void* mem;
+        if (slot.empty())
+        {
+            mem = new char[bytes];
+        }
+        else
+        {
+            mem = slot.back();
+            slot.pop_back();
+        }
+        return std::shared_ptr<T>((T*)mem, [&slot](T* p) {
+            std::lock_guard<std::mutex> guard(Mutex());
+            slot.push_back(p);
+        });
+    }
+
+    static std::mutex& Mutex()
+    {
+        static std::mutex inst;
+        return inst;
+    }
+};
+
+const size_t kSizes[] = {16, 100, 784, 1000, 4096, 10000};
+
+template <typename TAlloc>
+void Churn(benchmark::State& state)
+{
+    std::shared_ptr<float> live[4];
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        live[i % 4] = TAlloc::template Allocate<float>(kSizes[i % 6]);
+        benchmark::DoNotOptimize(live[i % 4].get());
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+}
+
+static void BM_ThreadCachedAllocator(benchmark::State& state)
+{
+    Churn<Allocator<DeviceTags::CPU>>(state);
+    if (state.thread_index() == 0)
+    {
+        state.counters["cache_hit_rate"] = static_cast<double>(Allocator<DeviceTags::CPU>::Statistics().cacheHits) /
+                                           Allocator<DeviceTags::CPU>::Statistics().allocations;
+    }
+}
+
+static void BM_GlobalLockAllocator(benchmark::State& state)
+{
+    Churn<GlobalLockPool>(state);
+}
+
+BENCHMARK(BM_ThreadCachedAllocator)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_GlobalLockAllocator)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include "../src/tensor/tensor.hpp"
+
+// Bias add (x[M, N] + b[N]) and row scaling (x[M, N] * s[M, 1]) through the broadcasting engine, against
+// a memcpy of the same tensor and a per-element loop over operator().
+
+constexpr size_t kM = 2048, kN = 1024;
+
+static Tensor<float, 2> make_input() {
+    Tensor<float, 2> t(std::array<size_t, 2>{kM, kN});
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = static_cast<float>(i % 13) * 0.25f;
+    }
+    return t;
+}
+
+static void set_bytes(benchmark::State& state) {
+    state.SetBytesProcessed(state.iterations() * kM * kN * 2 * sizeof(float));
+}
+
+static void BM_Memcpy(benchmark::State& state) {
+    const auto x = make_input();
+    Tensor<float, 2> y(x.shape());
+    for (auto _ : state) {
+        std::memcpy(y.data(), x.data(), x.size() * sizeof(float));
+        benchmark::DoNotOptimize(y.data());
+    }
+    set_bytes(state);
+}
+
+static void BM_NaiveBiasAdd(benchmark::State& state) {
+    const auto x = make_input();
+    Tensor<float, 1> bias(std::array<size_t, 1>{kN});
+    Tensor<float, 2> y(x.shape());
+    for (auto _ : state) {
+        for (size_t i = 0; i < kM; ++i) {
+            for (size_t j = 0; j < kN; ++j) {
+                y({{i, j}}) = x({{i, j}}) + bias({{j}});
+            }
+        }
+        benchmark::DoNotOptimize(y.data());
+    }
+    set_bytes(state);
+}
+
+static void BM_BiasAdd(benchmark::State& state) {
+    const auto x = make_input();
+    Tensor<float, 1> bias(std::array<size_t, 1>{kN});
+    Tensor<float, 2> y(x.shape());
+    for (auto _ : state) {
+        add_out(x, bias, y);
+        benchmark::DoNotOptimize(y.data());
+    }
+    set_bytes(state);
+}
+
+static void BM_RowScale(benchmark::State& state) {
+    const auto x = make_input();
+    Tensor<float, 2> scale(std::array<size_t, 2>{kM, 1});
+    Tensor<float, 2> y(x.shape());
+    for (auto _ : state) {
+        mul_out(x, scale, y);
+        benchmark::DoNotOptimize(y.data());
+    }
+    set_bytes(state);
+}
+
+static void BM_ChannelBiasAdd(benchmark::State& state) {
+    // [N, C, H, W] + [C, 1, 1], with the same element count as the 2-D cases.
+    Tensor<float, 4> x(std::array<size_t, 4>{8, 64, 64, 64});
+    Tensor<float, 3> bias(std::array<size_t, 3>{64, 1, 1});
+    Tensor<float, 4> y(x.shape());
+    for (auto _ : state) {
+        add_out(x, bias, y);
+        benchmark::DoNotOptimize(y.data());
+    }
+    set_bytes(state);
+}
+
+static void BM_GreaterThanScalar(benchmark::State& state) {
+    const auto x = make_input();
+    Tensor<uint8_t, 2> mask(x.shape());
+    for (auto _ : state) {
+        greater_out(x, 1.0f, mask);
+        benchmark::DoNotOptimize(mask.data());
+    }
+    set_bytes(state);
+}
+
+BENCHMARK(BM_Memcpy)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NaiveBiasAdd)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BiasAdd)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RowScale)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ChannelBiasAdd)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GreaterThanScalar)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
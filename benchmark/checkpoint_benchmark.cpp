@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <vector>
+#include "../src/tensor/checkpoint.hpp"
+
+// The time a training step loses to saving a 64 MB checkpoint (16 parameters of 1024x1024 floats).
+// SyncSave is the old path, writing and flushing on the calling thread. AsyncSaveStall measures only
+// what CheckpointWriter leaves on the caller: snapshotting and queueing, with the write itself excluded
+// from the timing (so its iteration count is fixed; the untimed writes would otherwise dominate the run).
+// AsyncSaveThenUpdate adds the following parameter update, which pays for one copy-on-write duplication
+// of every buffer while the checkpoint is pending; Update is that update alone.
+
+static const char* kPath = "checkpoint_benchmark.tnsr";
+constexpr size_t kParams = 16, kRows = 1024, kCols = 1024;
+
+static std::vector<Tensor<float, 2>> make_params() {
+    std::vector<Tensor<float, 2>> params;
+    for (size_t p = 0; p < kParams; ++p) {
+        params.emplace_back(std::array<size_t, 2>{kRows, kCols});
+        for (size_t i = 0; i < params.back().size(); ++i) {
+            params.back().data()[i] = static_cast<float>((p + i) % 101);
+        }
+    }
+    return params;
+}
+
+static TensorFileWriter snapshot(const std::vector<Tensor<float, 2>>& params) {
+    TensorFileWriter tensors;
+    for (size_t p = 0; p < params.size(); ++p) {
+        tensors.add("param" + std::to_string(p), params[p]);
+    }
+    return tensors;
+}
+
+static void set_bytes(benchmark::State& state) {
+    state.SetBytesProcessed(state.iterations() * kParams * kRows * kCols * sizeof(float));
+}
+
+static void BM_SyncSave(benchmark::State& state) {
+    auto params = make_params();
+    for (auto _ : state) {
+        snapshot(params).write(kPath, true);
+    }
+    set_bytes(state);
+}
+
+static void BM_AsyncSaveStall(benchmark::State& state) {
+    auto params = make_params();
+    CheckpointWriter checkpoints;
+    for (auto _ : state) {
+        std::future<void> done = checkpoints.save(snapshot(params), kPath);
+        state.PauseTiming();
+        done.get();
+        state.ResumeTiming();
+    }
+    set_bytes(state);
+}
+
+static void BM_Update(benchmark::State& state) {
+    auto params = make_params();
+    for (auto _ : state) {
+        for (auto& p : params) {
+            p.add_(1.0f);
+        }
+    }
+    set_bytes(state);
+}
+
+static void BM_AsyncSaveThenUpdate(benchmark::State& state) {
+    auto params = make_params();
+    CheckpointWriter checkpoints;
+    for (auto _ : state) {
+        std::future<void> done = checkpoints.save(snapshot(params), kPath);
+        for (auto& p : params) {
+            p.add_(1.0f);
+        }
+        state.PauseTiming();
+        done.get();
+        state.ResumeTiming();
+    }
+    set_bytes(state);
+}
+
+BENCHMARK(BM_SyncSave)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_AsyncSaveStall)->Iterations(20)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(BM_Update)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_AsyncSaveThenUpdate)->Iterations(20)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    std::remove(kPath);
+    return 0;
+}
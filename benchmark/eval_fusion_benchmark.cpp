@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+#include <type_traits>
+#include <iterator>
+#include <facilities/traits.h>
+#include <data/facilities/traits.h>
+#include <data/facilities/tags.h>
+#include <evaluate/facilities/eval_handle.h>
+#include <evaluate/facilities/eval_buffer.h>
+#include <evaluate/facilities/eval_plan.h>
+#include <data/matrics/cpu_matrix.h>
+#include <data/matrics/trival_matrix.h>
+#include <data/batch/duplicate.h>
+#include <operators/dot.h>
+#include <operators/add.h>
+#include <operators/sigmoid.h>
+#include <operators/element_mul.h>
+#include <operators/tanh.h>
+#include <operators/substract.h>
+
+using CpuMatrix = Matrix<float, DeviceTags::CPU>;
+
+static CpuMatrix MakeMatrix(size_t rowNum, size_t colNum, size_t seed)
+{
+    CpuMatrix res(rowNum, colNum);
+    for (size_t i = 0; i < rowNum; ++i)
+    {
+        for (size_t j = 0; j < colNum; ++j)
+        {
+            res.SetValue(i, j, static_cast<float>((i * 7 + j * 3 + seed) % 11) / 10 - 0.5f);
+        }
+    }
+    return res;
+}
+
+// Sigmoid(Dot(x, W) + b): with fusion the bias add and the sigmoid run as one pass.
+static void BM_DenseSigmoid(benchmark::State& state)
+{
+    const size_t batch = state.range(0);
+    const bool fuse = state.range(1) != 0;
+    CpuMatrix x = MakeMatrix(batch, 256, 1);
+    CpuMatrix w = MakeMatrix(256, 1024, 2);
+    CpuMatrix b = MakeMatrix(batch, 1024, 3);
+
+    EvalPlan<DeviceTags::CPU>::SetFusion(fuse);
+    for (auto _ : state)
+    {
+        auto res = Evaluate(Sigmoid(Dot(x, w) + b));
+        benchmark::DoNotOptimize(res);
+    }
+    EvalPlan<DeviceTags::CPU>::SetFusion(false);
+}
+
+BENCHMARK(BM_DenseSigmoid)->ArgNames({"batch", "fuse"})
+    ->Args({64, 0})->Args({64, 1})->Args({512, 0})->Args({512, 1});
+
+// A purely element-wise chain, Tanh(Sigmoid(a + b) * c), where memory traffic dominates.
+static void BM_ElementwiseChain(benchmark::State& state)
+{
+    const size_t size = state.range(0);
+    const bool fuse = state.range(1) != 0;
+    CpuMatrix a = MakeMatrix(size, 1024, 1);
+    CpuMatrix b = MakeMatrix(size, 1024, 2);
+    CpuMatrix c = MakeMatrix(size, 1024, 3);
+
+    EvalPlan<DeviceTags::CPU>::SetFusion(fuse);
+    for (auto _ : state)
+    {
+        auto res = Evaluate(Tanh(Sigmoid(a + b) * c));
+        benchmark::DoNotOptimize(res);
+    }
+    EvalPlan<DeviceTags::CPU>::SetFusion(false);
+    state.SetBytesProcessed(state.iterations() * size * 1024 * sizeof(float) * 4);
+}
+
+BENCHMARK(BM_ElementwiseChain)->ArgNames({"rows", "fuse"})
+    ->Args({64, 0})->Args({64, 1})->Args({2048, 0})->Args({2048, 1});
+
+// (a + b) * c - d: cheap arithmetic, so the intermediate passes over memory are the whole cost.
+static void BM_ArithmeticChain(benchmark::State& state)
+{
+    const size_t size = state.range(0);
+    const bool fuse = state.range(1) != 0;
+    CpuMatrix a = MakeMatrix(size, 1024, 1);
+    CpuMatrix b = MakeMatrix(size, 1024, 2);
+    CpuMatrix c = MakeMatrix(size, 1024, 3);
+    CpuMatrix d = MakeMatrix(size, 1024, 4);
+
+    EvalPlan<DeviceTags::CPU>::SetFusion(fuse);
+    for (auto _ : state)
+    {
+        auto res = Evaluate((a + b) * c - d);
+        benchmark::DoNotOptimize(res);
+    }
+    EvalPlan<DeviceTags::CPU>::SetFusion(false);
+    state.SetBytesProcessed(state.iterations() * size * 1024 * sizeof(float) * 5);
+}
+
+BENCHMARK(BM_ArithmeticChain)->ArgNames({"rows", "fuse"})
+    ->Args({64, 0})->Args({64, 1})->Args({2048, 0})->Args({2048, 1});
+
+BENCHMARK_MAIN();
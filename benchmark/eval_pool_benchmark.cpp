@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <facilities/traits.h>
+#include <data/facilities/traits.h>
+#include <data/facilities/tags.h>
+#include <evaluate/facilities/eval_handle.h>
+#include <evaluate/facilities/eval_buffer.h>
+#include <evaluate/facilities/eval_plan.h>
+#include <data/matrics/cpu_matrix.h>
+#include <data/matrics/trival_matrix.h>
+#include <data/batch/duplicate.h>
+#include <operators/dot.h>
+#include <operators/add.h>
+#include <operators/sigmoid.h>
+
+using CpuMatrix = Matrix<float, DeviceTags::CPU>;
+
+static CpuMatrix MakeMatrix(size_t rowNum, size_t colNum, size_t seed)
+{
+    CpuMatrix res(rowNum, colNum);
+    for (size_t i = 0; i < rowNum; ++i)
+    {
+        for (size_t j = 0; j < colNum; ++j)
+        {
+            res.SetValue(i, j, static_cast<float>((i * 7 + j * 3 + seed) % 11) / 10 - 0.5f);
+        }
+    }
+    return res;
+}
+
+// `chains` independent Sigmoid(Dot(x, W) + b) registered into one plan: every cluster holds one unit
+// per chain, which the work-stealing pool spreads over its workers.
+static void BM_IndependentChains(benchmark::State& state)
+{
+    const size_t chains = state.range(0);
+    const bool workStealing = state.range(1) != 0;
+    std::vector<CpuMatrix> x, w, b;
+    for (size_t i = 0; i < chains; ++i)
+    {
+        x.push_back(MakeMatrix(64, 256, i));
+        w.push_back(MakeMatrix(256, 256, i + 1));
+        b.push_back(MakeMatrix(64, 256, i + 2));
+    }
+
+    EvalPlan<DeviceTags::CPU>::SetEvalPool(workStealing ? EvalPoolEnum::WorkStealing : EvalPoolEnum::Trival);
+    for (auto _ : state)
+    {
+        std::vector<decltype(Sigmoid(Dot(x[0], w[0]) + b[0]).EvalRegister())> handles;
+        for (size_t i = 0; i < chains; ++i)
+        {
+            handles.push_back(Sigmoid(Dot(x[i], w[i]) + b[i]).EvalRegister());
+        }
+        EvalPlan<DeviceTags::CPU>::Eval();
+        benchmark::DoNotOptimize(handles.back().Data());
+    }
+    EvalPlan<DeviceTags::CPU>::SetEvalPool(EvalPoolEnum::Trival);
+}
+
+BENCHMARK(BM_IndependentChains)->ArgNames({"chains", "ws"})
+    ->Args({1, 0})->Args({1, 1})->Args({16, 0})->Args({16, 1})->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "../src/tensor/fixed_tensor.hpp"
+
+// Chains of N x N matrix products, the pattern of transform composition in geometry code, with Tensor
+// (heap storage, runtime shapes, gemm dispatch) against FixedTensor.
+
+constexpr size_t kChain = 64;
+
+template<size_t N>
+static void BM_TensorMatmul(benchmark::State& state) {
+    std::vector<Tensor<float, 2>> mats;
+    for (size_t m = 0; m < kChain; ++m) {
+        Tensor<float, 2> t(std::array<size_t, 2>{N, N});
+        for (size_t i = 0; i < t.size(); ++i) {
+            t.data()[i] = (i % (N + 1) == 0 ? 1.0f : 0.0f) + static_cast<float>((m + i) % 5) * 1e-3f;
+        }
+        mats.push_back(t);
+    }
+    for (auto _ : state) {
+        Tensor<float, 2> acc = mats[0];
+        for (size_t m = 1; m < kChain; ++m) {
+            acc = acc.matmul(mats[m]);
+        }
+        benchmark::DoNotOptimize(acc.data());
+    }
+    state.SetItemsProcessed(state.iterations() * (kChain - 1));
+}
+
+template<size_t N>
+static void BM_FixedMatmul(benchmark::State& state) {
+    std::vector<FixedTensor<float, N, N>> mats;
+    for (size_t m = 0; m < kChain; ++m) {
+        FixedTensor<float, N, N> t;
+        for (size_t i = 0; i < t.size(); ++i) {
+            t[i] = (i % (N + 1) == 0 ? 1.0f : 0.0f) + static_cast<float>((m + i) % 5) * 1e-3f;
+        }
+        mats.push_back(t);
+    }
+    for (auto _ : state) {
+        FixedTensor<float, N, N> acc = mats[0];
+        for (size_t m = 1; m < kChain; ++m) {
+            acc = acc.matmul(mats[m]);
+        }
+        benchmark::DoNotOptimize(acc.data());
+    }
+    state.SetItemsProcessed(state.iterations() * (kChain - 1));
+}
+
+BENCHMARK_TEMPLATE(BM_TensorMatmul, 3);
+BENCHMARK_TEMPLATE(BM_FixedMatmul, 3);
+BENCHMARK_TEMPLATE(BM_TensorMatmul, 4);
+BENCHMARK_TEMPLATE(BM_FixedMatmul, 4);
+BENCHMARK_TEMPLATE(BM_TensorMatmul, 16);
+BENCHMARK_TEMPLATE(BM_FixedMatmul, 16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include "../src/tensor/tensor.hpp"
+
+template <typename T>
+static void fill(Tensor<T, 2>& t) {
+    T* data = t.data();
+    for (size_t i = 0; i < t.size(); ++i) {
+        data[i] = static_cast<T>(i % 17) / 17;
+    }
+}
+
+static void set_flops(benchmark::State& state, size_t n) {
+    state.counters["GFLOP/s"] = benchmark::Counter(2.0 * n * n * n * state.iterations() / 1e9,
+                                                   benchmark::Counter::kIsRate);
+}
+
+template <typename T>
+static void BM_Matmul(benchmark::State& state) {
+    const size_t n = state.range(0);
+    Tensor<T, 2> a(std::array<size_t, 2>{n, n});
+    Tensor<T, 2> b(std::array<size_t, 2>{n, n});
+    fill(a);
+    fill(b);
+
+    for (auto _ : state) {
+        auto c = a.matmul(b);
+        benchmark::DoNotOptimize(c.data());
+        benchmark::ClobberMemory();
+    }
+    set_flops(state, n);
+}
+
+BENCHMARK_TEMPLATE(BM_Matmul, float)->RangeMultiplier(2)->Range(32, 2048)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_Matmul, double)->RangeMultiplier(2)->Range(32, 2048)->Unit(benchmark::kMicrosecond);
+
+// The i-j-k loop Tensor::matmul used before it was routed through gemm().
+template <typename T>
+static void BM_NaiveMatmul(benchmark::State& state) {
+    const size_t n = state.range(0);
+    Tensor<T, 2> a(std::array<size_t, 2>{n, n});
+    Tensor<T, 2> b(std::array<size_t, 2>{n, n});
+    fill(a);
+    fill(b);
+
+    for (auto _ : state) {
+        Tensor<T, 2> c(std::array<size_t, 2>{n, n});
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                T sum = 0;
+                for (size_t k = 0; k < n; ++k) {
+                    sum += a({i, k}) * b({k, j});
+                }
+                c({i, j}) = sum;
+            }
+        }
+        benchmark::DoNotOptimize(c.data());
+        benchmark::ClobberMemory();
+    }
+    set_flops(state, n);
+}
+
+BENCHMARK_TEMPLATE(BM_NaiveMatmul, float)->RangeMultiplier(2)->Range(32, 512)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
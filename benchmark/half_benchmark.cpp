@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+#include "../src/tensor/tensor_advanced.hpp"
+
+// Bandwidth-bound inference shapes with float, float16 and bfloat16 storage: a batch of activations
+// times a 4096 x 4096 weight matrix, and whole-tensor reductions and activations. Items are elements
+// (weights for BM_Linear), so rates compare directly; the 16-bit variants read half the bytes for them.
+
+template <typename T>
+static Tensor<T, 2> make(size_t rows, size_t cols) {
+    Tensor<T, 2> t(std::array<size_t, 2>{rows, cols});
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = T(static_cast<float>(i % 17) / 17 - 0.5f);
+    }
+    return t;
+}
+
+template <typename T>
+static void BM_Linear(benchmark::State& state) {
+    const size_t batch = state.range(0), n = 4096;
+    auto x = make<T>(batch, n);
+    auto w = make<T>(n, n);
+    for (auto _ : state) {
+        auto y = x.matmul(w);
+        benchmark::DoNotOptimize(y.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n * n);
+}
+
+template <typename T>
+static void BM_Sum(benchmark::State& state) {
+    AdvancedTensor<T, 2> t(make<T>(4096, 4096));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(t.optimize_sum());
+    }
+    state.SetItemsProcessed(state.iterations() * t.size());
+}
+
+template <typename T>
+static void BM_Tanh(benchmark::State& state) {
+    AdvancedTensor<T, 2> t(make<T>(4096, 4096));
+    for (auto _ : state) {
+        t.optimize_tanh();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * t.size());
+}
+
+static void BM_ConvertToFloat(benchmark::State& state) {
+    std::vector<float16> h(1 << 20, float16(0.25f));
+    std::vector<float> f(h.size());
+    for (auto _ : state) {
+        convert_half(h.data(), f.data(), h.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * h.size());
+}
+
+BENCHMARK_TEMPLATE(BM_Linear, float)->ArgName("batch")->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Linear, float16)->ArgName("batch")->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Linear, bfloat16)->ArgName("batch")->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Sum, float)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Sum, float16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Sum, bfloat16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Tanh, float)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Tanh, float16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Tanh, bfloat16)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ConvertToFloat);
+
+BENCHMARK_MAIN();
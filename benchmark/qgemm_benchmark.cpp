@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include "../src/tensor/tensor.hpp"
+
+// A batch of float activations times a 4096 x 4096 weight matrix, with float weights and with int8
+// weights quantised per column (activations quantised on the fly), and the int8 kernel alone at every
+// level. Items are weights, so rates compare directly.
+
+static Tensor<float, 2> make(size_t rows, size_t cols) {
+    Tensor<float, 2> t(std::array<size_t, 2>{rows, cols});
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = static_cast<float>(i % 17) / 17 - 0.5f;
+    }
+    return t;
+}
+
+static void BM_LinearFloat(benchmark::State& state) {
+    const size_t batch = state.range(0), n = 4096;
+    auto x = make(batch, n);
+    auto w = make(n, n);
+    for (auto _ : state) {
+        auto y = x.matmul(w);
+        benchmark::DoNotOptimize(y.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n * n);
+}
+
+static void BM_LinearInt8(benchmark::State& state) {
+    const size_t batch = state.range(0), n = 4096;
+    auto x = make(batch, n);
+    const auto w = make(n, n);
+    const auto qw = QuantizedTensor<2>::quantize(w, calibrate_per_channel(w, 1));
+    for (auto _ : state) {
+        auto y = x.matmul(qw);
+        benchmark::DoNotOptimize(y.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n * n);
+}
+
+static void BM_QGemmKernel(benchmark::State& state) {
+    const auto level = static_cast<SimdLevel>(state.range(0));
+    if (level > detected_simd_level()) {
+        state.SkipWithError("level not supported on this CPU");
+        return;
+    }
+    const QGemmKernel& kernel = qgemm_kernel(level);
+    state.SetLabel(kernel.name);
+    const size_t m = 64, n = 1024, k = 1024;
+    std::vector<int8_t> a(m * k, 3), b(k * n, -2);
+    std::vector<int32_t> c(m * n);
+    const float scale = 1.0f;
+    const int32_t zero = 0;
+    for (auto _ : state) {
+        qgemm_s32(m, n, k, a.data(), k, 0, b.data(), n, QuantChannels{&scale, &zero, false}, c.data(), n, kernel);
+        benchmark::DoNotOptimize(c.data());
+    }
+    state.SetItemsProcessed(state.iterations() * m * n * k);
+}
+
+BENCHMARK(BM_LinearFloat)->ArgName("batch")->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinearInt8)->ArgName("batch")->Arg(1)->Arg(8)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_QGemmKernel)->ArgName("level")->DenseRange(0, static_cast<int>(SimdLevel::AVX512))
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include "../src/tensor/tensor.hpp"
+
+// Initialising 16M floats (a 4096 x 4096 weight). StdNormal / StdUniform are the usual single-threaded
+// std::mt19937 loops; Normal / Uniform / TruncatedNormal are the Philox fills of kernels/random.hpp at
+// the scalar and the best available level, spread over the ThreadPool.
+
+constexpr size_t kElements = size_t(1) << 24;
+
+static void set_bytes(benchmark::State& state) {
+    state.SetBytesProcessed(state.iterations() * kElements * sizeof(float));
+}
+
+static void BM_StdUniform(benchmark::State& state) {
+    std::vector<float> v(kElements);
+    std::mt19937 engine(42);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (auto _ : state) {
+        for (float& x : v) {
+            x = dist(engine);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_bytes(state);
+}
+
+static void BM_StdNormal(benchmark::State& state) {
+    std::vector<float> v(kElements);
+    std::mt19937 engine(42);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    for (auto _ : state) {
+        for (float& x : v) {
+            x = dist(engine);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    set_bytes(state);
+}
+
+template<int Dist>
+static void BM_Philox(benchmark::State& state) {
+    std::vector<float> v(kElements);
+    const RandomKernel& kernel = random_kernel(static_cast<SimdLevel>(state.range(0)));
+    Philox gen(42);
+    for (auto _ : state) {
+        if (Dist == 0) {
+            random_uniform(v.data(), v.size(), gen.next(), -1.0f, 1.0f, kernel);
+        } else if (Dist == 1) {
+            random_normal(v.data(), v.size(), gen.next(), 0.0f, 1.0f, kernel);
+        } else {
+            random_truncated_normal(v.data(), v.size(), gen.next(), 0.0f, 1.0f, kernel);
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetLabel(kernel.name);
+    set_bytes(state);
+}
+
+static void BM_TensorXavier(benchmark::State& state) {
+    Tensor<float, 2> w(std::array<size_t, 2>{4096, 4096});
+    Philox gen(42);
+    for (auto _ : state) {
+        fill_xavier_uniform(w, gen);
+        benchmark::DoNotOptimize(w.data());
+    }
+    set_bytes(state);
+}
+
+BENCHMARK(BM_StdUniform)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Philox, 0)->Name("BM_Uniform")->ArgName("level")->Arg(0)->Arg(2)->Arg(3)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_StdNormal)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Philox, 1)->Name("BM_Normal")->ArgName("level")->Arg(0)->Arg(2)->Arg(3)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Philox, 2)->Name("BM_TruncatedNormal")->ArgName("level")->Arg(0)->Arg(2)->Arg(3)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_TensorXavier)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+#include "../src/tensor/tensor.hpp"
+
+// Row and column sums of a 4096 x 4096 float tensor, through reduce_sum against a loop over operator().
+
+constexpr size_t kN = 4096;
+
+static Tensor<float, 2> make_input() {
+    Tensor<float, 2> t(std::array<size_t, 2>{kN, kN});
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = static_cast<float>(i % 17) * 0.125f;
+    }
+    return t;
+}
+
+static void BM_NaiveSum(benchmark::State& state) {
+    const auto t = make_input();
+    const size_t axis = state.range(0);
+    Tensor<float, 1> out(std::array<size_t, 1>{kN});
+    for (auto _ : state) {
+        for (size_t o = 0; o < kN; ++o) {
+            float s = 0;
+            for (size_t r = 0; r < kN; ++r) {
+                s += axis == 0 ? t({{r, o}}) : t({{o, r}});
+            }
+            out({{o}}) = s;
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * kN * kN * sizeof(float));
+}
+
+static void BM_ReduceSum(benchmark::State& state) {
+    const auto t = make_input();
+    const size_t axis = state.range(0);
+    for (auto _ : state) {
+        auto out = reduce_sum(t, axis);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * kN * kN * sizeof(float));
+}
+
+static void BM_ReduceMax(benchmark::State& state) {
+    const auto t = make_input();
+    const size_t axis = state.range(0);
+    for (auto _ : state) {
+        auto out = reduce_max(t, axis);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * kN * kN * sizeof(float));
+}
+
+BENCHMARK(BM_NaiveSum)->ArgName("axis")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReduceSum)->ArgName("axis")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReduceMax)->ArgName("axis")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
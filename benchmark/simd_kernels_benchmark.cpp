@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <vector>
+#include "../src/kernels/simd_kernels.hpp"
+
+// Each kernel at every instruction-set level (0 = scalar, 1 = SSE4.2, 2 = AVX2, 3 = AVX-512). Levels the
+// host lacks are skipped. Built without -m flags, this also shows the registry picking up wide kernels in
+// a baseline binary.
+
+static bool select_level(benchmark::State& state, SimdLevel& level) {
+    level = static_cast<SimdLevel>(state.range(1));
+    if (level > detected_simd_level()) {
+        state.SkipWithError("instruction set not supported on this CPU");
+        return false;
+    }
+    state.SetLabel(simd_level_name(level));
+    return true;
+}
+
+static std::vector<float> ramp(size_t n, float scale) {
+    std::vector<float> v(n);
+    for (size_t i = 0; i < n; ++i) {
+        v[i] = scale * (static_cast<float>(i % 97) / 48.0f - 1.0f);
+    }
+    return v;
+}
+
+static void BM_KernelAdd(benchmark::State& state) {
+    SimdLevel level;
+    if (!select_level(state, level)) return;
+    const size_t n = state.range(0);
+    std::vector<float> a = ramp(n, 1.0f), b = ramp(n, 2.0f);
+    const SimdKernels<float>& k = simd_kernels<float>(level);
+    for (auto _ : state) {
+        k.add(a.data(), b.data(), a.data(), n);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * n * sizeof(float) * 3);
+}
+
+static void BM_KernelSum(benchmark::State& state) {
+    SimdLevel level;
+    if (!select_level(state, level)) return;
+    const size_t n = state.range(0);
+    std::vector<float> a = ramp(n, 1.0f);
+    const SimdKernels<float>& k = simd_kernels<float>(level);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(k.sum(a.data(), n));
+    }
+    state.SetBytesProcessed(state.iterations() * n * sizeof(float));
+}
+
+static void BM_KernelSigmoid(benchmark::State& state) {
+    SimdLevel level;
+    if (!select_level(state, level)) return;
+    const size_t n = state.range(0);
+    std::vector<float> a = ramp(n, 8.0f), out(n);
+    const SimdKernels<float>& k = simd_kernels<float>(level);
+    for (auto _ : state) {
+        k.sigmoid(a.data(), out.data(), n);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// libm reference for the activation kernels.
+static void BM_StdSigmoid(benchmark::State& state) {
+    const size_t n = state.range(0);
+    std::vector<float> a = ramp(n, 8.0f), out(n);
+    for (auto _ : state) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = 1.0f / (1.0f + std::exp(-a[i]));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define SIMD_LEVEL_ARGS ->ArgNames({"n", "level"})->ArgsProduct({{4096, 1 << 20}, {0, 1, 2, 3}})
+
+BENCHMARK(BM_KernelAdd) SIMD_LEVEL_ARGS;
+BENCHMARK(BM_KernelSum) SIMD_LEVEL_ARGS;
+BENCHMARK(BM_KernelSigmoid) SIMD_LEVEL_ARGS;
+BENCHMARK(BM_StdSigmoid)->Arg(4096)->Arg(1 << 20);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+#include "../src/tensor/tensor.hpp"
+
+// Creating and combining scalar and 4x4 tensors, as scalar-heavy loss code and the autograd graph do.
+// BM_SharedVector is the cost of the previous storage: a shared_ptr to a heap std::vector.
+
+static void BM_SharedVector(benchmark::State& state) {
+    const size_t n = state.range(0);
+    for (auto _ : state) {
+        auto p = std::make_shared<std::vector<float>>(n);
+        benchmark::DoNotOptimize(p->data());
+    }
+}
+
+static void BM_CreateTensor(benchmark::State& state) {
+    const size_t n = state.range(0);
+    for (auto _ : state) {
+        Tensor<float, 1> t(std::array<size_t, 1>{n});
+        benchmark::DoNotOptimize(t.data());
+    }
+}
+
+static void BM_TinyArithmetic(benchmark::State& state) {
+    const size_t n = state.range(0);
+    Tensor<float, 1> a(std::array<size_t, 1>{n});
+    Tensor<float, 1> b(std::array<size_t, 1>{n});
+    for (auto _ : state) {
+        Tensor<float, 1> c = a * b + a;
+        Tensor<float, 1> d = c - b;
+        benchmark::DoNotOptimize(d.data());
+    }
+}
+
+BENCHMARK(BM_SharedVector)->Arg(1)->Arg(16)->Arg(64);
+BENCHMARK(BM_CreateTensor)->Arg(1)->Arg(16)->Arg(64);
+BENCHMARK(BM_TinyArithmetic)->Arg(1)->Arg(16)->Arg(64);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include "../src/kernels/gemm.hpp"
+#include "../src/kernels/spmm.hpp"
+
+// Pruned-weight shapes: a batch of 32 activations times 2048 x 2048 weights with the given percentage
+// of non-zeros, dense GEMM against CSR and 4 x 4 BSR, with the sparse matrix on either side.
+
+static std::vector<float> make_sparse(size_t rows, size_t cols, double density) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> pick(0, 1);
+    std::vector<float> m(rows * cols, 0.0f);
+    // Non-zeros come in 4 x 4 groups, as structured pruning leaves them.
+    for (size_t i = 0; i < rows; i += 4) {
+        for (size_t j = 0; j < cols; j += 4) {
+            if (pick(gen) < density) {
+                for (size_t r = i; r < std::min(i + 4, rows); ++r) {
+                    for (size_t c = j; c < std::min(j + 4, cols); ++c) {
+                        m[r * cols + c] = 0.25f;
+                    }
+                }
+            }
+        }
+    }
+    return m;
+}
+
+constexpr size_t kBatch = 32, kDim = 2048;
+
+static void BM_DenseGemm(benchmark::State& state) {
+    const auto w = make_sparse(kDim, kDim, state.range(0) / 100.0);
+    const std::vector<float> x(kBatch * kDim, 1.0f);
+    std::vector<float> y(kBatch * kDim);
+    for (auto _ : state) {
+        gemm(kBatch, kDim, kDim, x.data(), kDim, w.data(), kDim, y.data(), kDim);
+        benchmark::DoNotOptimize(y.data());
+    }
+}
+
+// Dense activations times sparse weights.
+static void BM_DenseSparse(benchmark::State& state) {
+    const auto w = make_sparse(kDim, kDim, state.range(0) / 100.0);
+    const auto sw = BsrMatrix<float>::from_dense(kDim, kDim, w.data(), kDim, state.range(1), state.range(1));
+    const std::vector<float> x(kBatch * kDim, 1.0f);
+    std::vector<float> y(kBatch * kDim);
+    for (auto _ : state) {
+        spmm(kBatch, x.data(), kDim, sw, y.data(), kDim);
+        benchmark::DoNotOptimize(y.data());
+    }
+}
+
+// Sparse weights times dense activations laid out by column.
+static void BM_SparseDense(benchmark::State& state) {
+    const auto w = make_sparse(kDim, kDim, state.range(0) / 100.0);
+    const auto sw = BsrMatrix<float>::from_dense(kDim, kDim, w.data(), kDim, state.range(1), state.range(1));
+    const std::vector<float> x(kDim * kBatch, 1.0f);
+    std::vector<float> y(kDim * kBatch);
+    for (auto _ : state) {
+        spmm(sw, kBatch, x.data(), kBatch, y.data(), kBatch);
+        benchmark::DoNotOptimize(y.data());
+    }
+}
+
+BENCHMARK(BM_DenseGemm)->ArgName("pct")->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DenseSparse)->ArgNames({"pct", "block"})->ArgsProduct({{1, 10}, {1, 4}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SparseDense)->ArgNames({"pct", "block"})->ArgsProduct({{1, 10}, {1, 4}})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -63,4 +63,66 @@ BENCHMARK_TEMPLATE(BM_OptimizeAdd_Size, 1000);
 BENCHMARK_TEMPLATE(BM_OptimizeAdd_Size, 10000);
 BENCHMARK_TEMPLATE(BM_OptimizeAdd_Size, 100000);
 
+// a + b * c - d as one fused expression against the same chain with every intermediate materialised,
+// which is what the eager operators used to do.
+static void fill_operands(std::array<Tensor<float, 1>, 4>& t, size_t size) {
+    for (auto& x : t) {
+        x = Tensor<float, 1>({size});
+        for (size_t i = 0; i < size; ++i) {
+            x({{i}}) = static_cast<float>(i % 97) * 0.5f + 1.0f;
+        }
+    }
+}
+
+static void BM_FusedExpression(benchmark::State& state) {
+    const size_t size = state.range(0);
+    std::array<Tensor<float, 1>, 4> t;
+    fill_operands(t, size);
+
+    for (auto _ : state) {
+        Tensor<float, 1> r = t[0] + t[1] * t[2] - t[3];
+        benchmark::DoNotOptimize(r.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * size * sizeof(float) * 5);
+}
+
+BENCHMARK(BM_FusedExpression)->Arg(1000)->Arg(100000)->Arg(4000000);
+
+static void BM_UnfusedExpression(benchmark::State& state) {
+    const size_t size = state.range(0);
+    std::array<Tensor<float, 1>, 4> t;
+    fill_operands(t, size);
+
+    for (auto _ : state) {
+        Tensor<float, 1> prod = t[1] * t[2];
+        Tensor<float, 1> sum = t[0] + prod;
+        Tensor<float, 1> r = sum - t[3];
+        benchmark::DoNotOptimize(r.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * size * sizeof(float) * 5);
+}
+
+BENCHMARK(BM_UnfusedExpression)->Arg(1000)->Arg(100000)->Arg(4000000);
+
+// The same chain through the out-parameter variants into a preallocated result: no allocation per
+// iteration, one kernel pass per operation.
+static void BM_OutExpression(benchmark::State& state) {
+    const size_t size = state.range(0);
+    std::array<Tensor<float, 1>, 4> t;
+    fill_operands(t, size);
+    Tensor<float, 1> r({size});
+
+    for (auto _ : state) {
+        mul_out(t[1], t[2], r);
+        r.add_(t[0]).sub_(t[3]);
+        benchmark::DoNotOptimize(r.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * size * sizeof(float) * 5);
+}
+
+BENCHMARK(BM_OutExpression)->Arg(1000)->Arg(100000)->Arg(4000000);
+
 BENCHMARK_MAIN();
\ No newline at end of file
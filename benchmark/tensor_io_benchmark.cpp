@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include "../src/tensor/tensor.hpp"
+
+// Write + read round trip of one float tensor of n MB: the earlier raw format (shape, then elements read
+// into a fresh buffer through ifstream) against the mapped tensor file. Every variant also sums the
+// loaded tensor ("touch"), since a mapping only pays for the pages that are actually read.
+
+static const char* kPath = "tensor_io_benchmark.bin";
+
+static Tensor<float, 2> make_tensor(size_t mb) {
+    const size_t cols = 1024;
+    Tensor<float, 2> t(std::array<size_t, 2>{mb * 256, cols});
+    std::iota(t.data(), t.data() + t.size(), 0.0f);
+    return t;
+}
+
+static float touch(const Tensor<float, 2>& t) {
+    float sum = 0;
+    for (size_t i = 0; i < t.size(); i += 1024) {
+        sum += t.data()[i];
+    }
+    return sum;
+}
+
+static void raw_save(const Tensor<float, 2>& t, const std::string& filename) {
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(t.shape().data()), sizeof(size_t) * 2);
+    file.write(reinterpret_cast<const char*>(t.data()), sizeof(float) * t.size());
+}
+
+static Tensor<float, 2> raw_load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::array<size_t, 2> shape;
+    file.read(reinterpret_cast<char*>(shape.data()), sizeof(size_t) * 2);
+    Tensor<float, 2> result(shape);
+    file.read(reinterpret_cast<char*>(result.data()), sizeof(float) * result.size());
+    return result;
+}
+
+static void BM_RawSave(benchmark::State& state) {
+    auto t = make_tensor(state.range(0));
+    for (auto _ : state) {
+        raw_save(t, kPath);
+    }
+    std::remove(kPath);
+    state.SetBytesProcessed(state.iterations() * t.size() * sizeof(float));
+}
+
+static void BM_TensorFileSave(benchmark::State& state) {
+    auto t = make_tensor(state.range(0));
+    for (auto _ : state) {
+        t.save(kPath);
+    }
+    std::remove(kPath);
+    state.SetBytesProcessed(state.iterations() * t.size() * sizeof(float));
+}
+
+static void BM_RawLoad(benchmark::State& state) {
+    auto t = make_tensor(state.range(0));
+    raw_save(t, kPath);
+    for (auto _ : state) {
+        auto loaded = raw_load(kPath);
+        benchmark::DoNotOptimize(touch(loaded));
+    }
+    std::remove(kPath);
+    state.SetBytesProcessed(state.iterations() * t.size() * sizeof(float));
+}
+
+static void BM_TensorFileLoad(benchmark::State& state) {
+    auto t = make_tensor(state.range(0));
+    t.save(kPath);
+    for (auto _ : state) {
+        auto loaded = Tensor<float, 2>::load(kPath);
+        benchmark::DoNotOptimize(touch(loaded));
+    }
+    std::remove(kPath);
+    state.SetBytesProcessed(state.iterations() * t.size() * sizeof(float));
+}
+
+// Opening only: what model startup pays before the first use of each weight.
+static void BM_TensorFileOpen(benchmark::State& state) {
+    auto t = make_tensor(state.range(0));
+    t.save(kPath);
+    for (auto _ : state) {
+        auto loaded = Tensor<float, 2>::load(kPath);
+        benchmark::DoNotOptimize(loaded.data());
+    }
+    std::remove(kPath);
+}
+
+BENCHMARK(BM_RawSave)->ArgName("MB")->Arg(4)->Arg(64)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TensorFileSave)->ArgName("MB")->Arg(4)->Arg(64)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RawLoad)->ArgName("MB")->Arg(4)->Arg(64)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TensorFileLoad)->ArgName("MB")->Arg(4)->Arg(64)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TensorFileOpen)->ArgName("MB")->Arg(4)->Arg(64)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -25,6 +25,52 @@ static void BM_ParallelAdd(benchmark::State& state) {
 BENCHMARK_TEMPLATE(BM_ParallelAdd, float)->Range(1<<10, 1<<20);
 BENCHMARK_TEMPLATE(BM_ParallelAdd, double)->Range(1<<10, 1<<20);
 
+// The pre-pool implementation of parallel_add: spawn and join hardware_concurrency() threads per call.
+template <typename T>
+static void BM_SpawnPerCallAdd(benchmark::State& state) {
+    const size_t size = state.range(0);
+    std::array<size_t, 1> shape = {size};
+    MultithreadedTensor<T, 1> t1(shape);
+    MultithreadedTensor<T, 1> t2(shape);
+
+    for (size_t i = 0; i < size; ++i) {
+        t1({{i}}) = static_cast<T>(i);
+        t2({{i}}) = static_cast<T>(size - i);
+    }
+
+    T* dst = t1.data();
+    const T* src = t2.data();
+    for (auto _ : state) {
+        size_t num_threads = std::thread::hardware_concurrency();
+        size_t elements_per_thread = std::max<size_t>(1000, size / num_threads);
+        num_threads = std::min(num_threads, (size + elements_per_thread - 1) / elements_per_thread);
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            size_t start = t * elements_per_thread;
+            size_t end = std::min(start + elements_per_thread, size);
+            threads.emplace_back([dst, src, start, end]() {
+                for (size_t i = start; i < end; ++i) {
+                    dst[i] += src[i];
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        benchmark::DoNotOptimize(t1);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+    state.SetBytesProcessed(state.iterations() * size * sizeof(T) * 2);
+}
+
+BENCHMARK_TEMPLATE(BM_SpawnPerCallAdd, float)->Range(1<<10, 1<<20);
+
+// Latency of the serving-sized range (10k - 1M elements) with the persistent pool.
+BENCHMARK_TEMPLATE(BM_ParallelAdd, float)->Name("BM_PoolAdd<float>")->Arg(10000)->Arg(100000)->Arg(1000000)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SpawnPerCallAdd, float)->Name("BM_SpawnPerCallAdd<float>")->Arg(10000)->Arg(100000)->Arg(1000000)->UseRealTime();
+
 template <typename T>
 static void BM_ParallelSum(benchmark::State& state) {
     const size_t size = state.range(0);
@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../src/tensor/tensor_stream.hpp"
+
+// Streams a 256 MB chunked tensor file (4 MB chunks) with a consumer that sums every chunk, as a training
+// loop would touch each batch. The baseline is plain sequential pread into one buffer with no consumer,
+// i.e. the bandwidth of the file system (or page cache) itself; SyncReadAndSum does the same reads with the
+// summing in between, which is what the reader's read-ahead thread overlaps.
+
+static const char* kPath = "tensor_stream_benchmark.tchk";
+constexpr size_t kRows = 64 * 1024, kCols = 1024, kChunkRows = 1024;
+
+static void ensure_file() {
+    static bool written = false;
+    if (written) {
+        return;
+    }
+    ChunkedTensorWriter<float, 2> writer(kPath, {kChunkRows, kCols});
+    Tensor<float, 2> rows(std::array<size_t, 2>{kChunkRows, kCols});
+    for (size_t r = 0; r < kRows; r += kChunkRows) {
+        for (size_t i = 0; i < rows.size(); ++i) {
+            rows.data()[i] = static_cast<float>((r + i) % 97);
+        }
+        writer.append(rows);
+    }
+    writer.close();
+    written = true;
+}
+
+static float sum(const float* p, size_t n) {
+    float s = 0;
+    for (size_t i = 0; i < n; ++i) {
+        s += p[i];
+    }
+    return s;
+}
+
+static void set_bytes(benchmark::State& state) {
+    state.SetBytesProcessed(state.iterations() * kRows * kCols * sizeof(float));
+}
+
+static void BM_RawPread(benchmark::State& state) {
+    ensure_file();
+    const size_t bytes = kChunkRows * kCols * sizeof(float);
+    std::vector<char> buffer(bytes);
+    for (auto _ : state) {
+        const int fd = ::open(kPath, O_RDONLY);
+        for (size_t c = 0; c < kRows / kChunkRows; ++c) {
+            benchmark::DoNotOptimize(::pread(fd, buffer.data(), bytes, 4096 + c * bytes));
+        }
+        ::close(fd);
+    }
+    set_bytes(state);
+}
+
+static void BM_SyncReadAndSum(benchmark::State& state) {
+    ensure_file();
+    const size_t bytes = kChunkRows * kCols * sizeof(float);
+    std::vector<float> buffer(kChunkRows * kCols);
+    for (auto _ : state) {
+        const int fd = ::open(kPath, O_RDONLY);
+        float total = 0;
+        for (size_t c = 0; c < kRows / kChunkRows; ++c) {
+            benchmark::DoNotOptimize(::pread(fd, buffer.data(), bytes, 4096 + c * bytes));
+            total += sum(buffer.data(), buffer.size());
+        }
+        ::close(fd);
+        benchmark::DoNotOptimize(total);
+    }
+    set_bytes(state);
+}
+
+static void BM_ChunkedReader(benchmark::State& state) {
+    ensure_file();
+    for (auto _ : state) {
+        ChunkedTensorReader<float, 2> reader(kPath, state.range(0), state.range(1) != 0);
+        Tensor<float, 2> chunk;
+        float total = 0;
+        while (reader.next(chunk)) {
+            total += sum(std::as_const(chunk).data(), chunk.size());
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    set_bytes(state);
+}
+
+BENCHMARK(BM_RawPread)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SyncReadAndSum)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ChunkedReader)->ArgNames({"prefetch", "direct"})
+    ->Args({1, 0})->Args({2, 0})->Args({4, 0})->Args({2, 1})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    std::remove(kPath);
+    return 0;
+}
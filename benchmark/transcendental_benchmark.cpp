@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "../src/kernels/simd_kernels.hpp"
+
+// Throughput and precision of the vectorised exp/log/tanh/sigmoid/softmax kernels at every instruction-set
+// level (0 = scalar, 1 = SSE4.2, 2 = AVX2, 3 = AVX-512), next to the libm loop they replace. Each kernel
+// run also reports max_ulp, the worst error over its inputs against a long double libm reference.
+
+static bool select_level(benchmark::State& state, SimdLevel& level) {
+    level = static_cast<SimdLevel>(state.range(1));
+    if (level > detected_simd_level()) {
+        state.SkipWithError("instruction set not supported on this CPU");
+        return false;
+    }
+    state.SetLabel(simd_level_name(level));
+    return true;
+}
+
+static std::vector<float> uniform(size_t n, float lo, float hi) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(lo, hi);
+    std::vector<float> v(n);
+    for (auto& x : v) x = dist(gen);
+    return v;
+}
+
+static double ulps(float actual, long double expected) {
+    const float rounded = static_cast<float>(expected);
+    float ulp = std::nextafter(std::fabs(rounded), INFINITY) - std::fabs(rounded);
+    ulp = std::max(ulp, std::numeric_limits<float>::denorm_min());
+    return static_cast<double>(std::fabs(actual - expected) / ulp);
+}
+
+struct Transcendental {
+    const char* name;
+    float lo, hi;
+    SimdKernels<float>::Unary (*kernel)(const SimdKernels<float>&);
+    long double (*reference)(long double);
+};
+
+static const Transcendental kFunctions[] = {
+    {"exp", -87.0f, 88.0f, [](const SimdKernels<float>& k) { return k.exp; },
+     [](long double x) { return std::exp(x); }},
+    {"log", 1e-30f, 1e30f, [](const SimdKernels<float>& k) { return k.log; },
+     [](long double x) { return std::log(x); }},
+    {"tanh", -10.0f, 10.0f, [](const SimdKernels<float>& k) { return k.tanh; },
+     [](long double x) { return std::tanh(x); }},
+    {"sigmoid", -20.0f, 20.0f, [](const SimdKernels<float>& k) { return k.sigmoid; },
+     [](long double x) { return 1 / (1 + std::exp(-x)); }},
+};
+
+static void BM_Kernel(benchmark::State& state) {
+    SimdLevel level;
+    if (!select_level(state, level)) return;
+    const Transcendental& f = kFunctions[state.range(2)];
+    const size_t n = state.range(0);
+    std::vector<float> a = uniform(n, f.lo, f.hi), out(n);
+    const auto kernel = f.kernel(simd_kernels<float>(level));
+    for (auto _ : state) {
+        kernel(a.data(), out.data(), n);
+        benchmark::ClobberMemory();
+    }
+    double worst = 0;
+    for (size_t i = 0; i < n; ++i) worst = std::max(worst, ulps(out[i], f.reference(a[i])));
+    state.counters["max_ulp"] = worst;
+    state.SetLabel(std::string(f.name) + "/" + simd_level_name(level));
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// The libm loop each kernel replaces.
+static void BM_Libm(benchmark::State& state) {
+    const Transcendental& f = kFunctions[state.range(1)];
+    const size_t n = state.range(0);
+    std::vector<float> a = uniform(n, f.lo, f.hi), out(n);
+    for (auto _ : state) {
+        switch (state.range(1)) {
+        case 0: for (size_t i = 0; i < n; ++i) out[i] = std::exp(a[i]); break;
+        case 1: for (size_t i = 0; i < n; ++i) out[i] = std::log(a[i]); break;
+        case 2: for (size_t i = 0; i < n; ++i) out[i] = std::tanh(a[i]); break;
+        default: for (size_t i = 0; i < n; ++i) out[i] = 1.0f / (1.0f + std::exp(-a[i])); break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(f.name);
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// One softmax row, as VecSoftmax evaluates it.
+static void BM_KernelSoftmax(benchmark::State& state) {
+    SimdLevel level;
+    if (!select_level(state, level)) return;
+    const size_t n = state.range(0);
+    std::vector<float> a = uniform(n, -10.0f, 10.0f), out(n);
+    const SimdKernels<float>& k = simd_kernels<float>(level);
+    for (auto _ : state) {
+        k.softmax(a.data(), out.data(), n);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void BM_LibmSoftmax(benchmark::State& state) {
+    const size_t n = state.range(0);
+    std::vector<float> a = uniform(n, -10.0f, 10.0f), out(n);
+    for (auto _ : state) {
+        const float m = *std::max_element(a.begin(), a.end());
+        float sum = 0;
+        for (size_t i = 0; i < n; ++i) sum += out[i] = std::exp(a[i] - m);
+        for (size_t i = 0; i < n; ++i) out[i] /= sum;
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(BM_Kernel)->ArgNames({"n", "level", "fn"})->ArgsProduct({{1 << 16}, {0, 1, 2, 3}, {0, 1, 2, 3}});
+BENCHMARK(BM_Libm)->ArgNames({"n", "fn"})->ArgsProduct({{1 << 16}, {0, 1, 2, 3}});
+BENCHMARK(BM_KernelSoftmax)->ArgNames({"n", "level"})->ArgsProduct({{1000, 1 << 16}, {0, 1, 2, 3}});
+BENCHMARK(BM_LibmSoftmax)->Arg(1000)->Arg(1 << 16);
+
+BENCHMARK_MAIN();
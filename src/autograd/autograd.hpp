@@ -49,8 +49,8 @@ public:
             grad_ = AdvancedTensor<T, Dim>(data_.shape());
         }
         
-        if (grad_.data_ptr()->size() == 1) {
-            (*grad_.data_ptr())[0] = 1;
+        if (grad_.size() == 1) {
+            grad_.data()[0] = 1;
         }
 
         std::unordered_set<Variable<T, Dim>*> visited;
@@ -87,7 +87,7 @@ public:
     }
 
     void forward() override {
-        result_->data().optimize_add(lhs_->data());
+        result_->data() = lhs_->data();
         result_->data().optimize_add(rhs_->data());
     }
 
@@ -124,9 +124,7 @@ public:
             lhs_->grad().optimize_add(result_->grad());
         }
         if (rhs_->requires_grad()) {
-            for (size_t i = 0; i < rhs_->grad().data_ptr()->size(); ++i) {
-                (*rhs_->grad().data_ptr())[i] -= (*result_->grad().data_ptr())[i];
-            }
+            rhs_->grad().optimize_sub(result_->grad());
         }
     }
 };
@@ -192,17 +190,14 @@ public:
             AdvancedTensor<T, Dim> temp = result_->grad();
             temp.optimize_mul(result_->data());
             temp.optimize_div(rhs_->data());
-            for (size_t i = 0; i < rhs_->grad().data_ptr()->size(); ++i) {
-                (*rhs_->grad().data_ptr())[i] -= (*temp.data_ptr())[i];
-            }
+            rhs_->grad().optimize_sub(temp);
         }
     }
 };
 
 template<typename T, size_t Dim>
 Variable<T, Dim> operator+(Variable<T, Dim>& lhs, Variable<T, Dim>& rhs) {
-    AdvancedTensor<T, Dim> result_data(lhs.data().shape());
-    result_data = lhs.data();
+    AdvancedTensor<T, Dim> result_data = lhs.data();
     result_data.optimize_add(rhs.data());
     Variable<T, Dim> result(result_data, lhs.requires_grad() || rhs.requires_grad());
     if (result.requires_grad()) {
@@ -214,8 +209,7 @@ Variable<T, Dim> operator+(Variable<T, Dim>& lhs, Variable<T, Dim>& rhs) {
 
 template<typename T, size_t Dim>
 Variable<T, Dim> operator-(Variable<T, Dim>& lhs, Variable<T, Dim>& rhs) {
-    AdvancedTensor<T, Dim> result_data(lhs.data().shape());
-    result_data = lhs.data();
+    AdvancedTensor<T, Dim> result_data = lhs.data();
     result_data.optimize_sub(rhs.data());
     Variable<T, Dim> result(result_data, lhs.requires_grad() || rhs.requires_grad());
     if (result.requires_grad()) {
@@ -227,8 +221,7 @@ Variable<T, Dim> operator-(Variable<T, Dim>& lhs, Variable<T, Dim>& rhs) {
 
 template<typename T, size_t Dim>
 Variable<T, Dim> operator*(Variable<T, Dim>& lhs, Variable<T, Dim>& rhs) {
-    AdvancedTensor<T, Dim> result_data(lhs.data().shape());
-    result_data = lhs.data();
+    AdvancedTensor<T, Dim> result_data = lhs.data();
     result_data.optimize_mul(rhs.data());
     Variable<T, Dim> result(result_data, lhs.requires_grad() || rhs.requires_grad());
     if (result.requires_grad()) {
@@ -240,8 +233,7 @@ Variable<T, Dim> operator*(Variable<T, Dim>& lhs, Variable<T, Dim>& rhs) {
 
 template<typename T, size_t Dim>
 Variable<T, Dim> operator/(Variable<T, Dim>& lhs, Variable<T, Dim>& rhs) {
-    AdvancedTensor<T, Dim> result_data(lhs.data().shape());
-    result_data = lhs.data();
+    AdvancedTensor<T, Dim> result_data = lhs.data();
     result_data.optimize_div(rhs.data());
     Variable<T, Dim> result(result_data, lhs.requires_grad() || rhs.requires_grad());
     if (result.requires_grad()) {
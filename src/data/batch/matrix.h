@@ -1,7 +1,9 @@
 #pragma once
 
 #include <data/batch/batch.h>
+#include <data/facilities/row_layout.h>
 #include <data/matrices/matrices.h>
+#include <algorithm>
 #include <vector>
 #include <lower_access.h>
 #include <scalar.h>
@@ -19,14 +21,21 @@ public:
     friend struct LowerAccessImpl<Batch<TElement, TDevice, CategoryTags::Matrix>>;
     
 public:
-    Batch(size_t p_batchNum = 0, size_t p_rowNum = 0, size_t p_colNum = 0)
-        : m_mem(p_rowNum * p_colNum * p_batchNum)
+    Batch(size_t p_batchNum = 0, size_t p_rowNum = 0, size_t p_colNum = 0,
+          RowLayout p_layout = DefaultRowLayout())
+        : m_mem(p_rowNum * RowLenFor<TElement>(p_colNum, p_layout) * p_batchNum)
         , m_rowNum(p_rowNum)
         , m_colNum(p_colNum)
         , m_batchNum(p_batchNum)
-        , m_rowLen(p_colNum)
-        , m_rawMatrixSize(p_rowNum * p_colNum)
-    {}
+        , m_rowLen(RowLenFor<TElement>(p_colNum, p_layout))
+        , m_rawMatrixSize(p_rowNum * m_rowLen)
+    {
+        for (size_t i = 0; (m_rowLen != m_colNum) && (i < m_rowNum * m_batchNum); ++i)
+        {
+            auto row = m_mem.RawMemory() + i * m_rowLen;
+            std::fill(row + m_colNum, row + m_rowLen, ElementType());
+        }
+    }
 
     bool operator== (const Batch& val) const
     {
@@ -143,6 +152,14 @@ struct LowerAccessImpl<Batch<TElem, TDevice, CategoryTags::Matrix>>
         return m_rawData.m_rawMatrixSize;
     }
 
+    // True if the matrices follow each other directly (RawMatrixSize() == RowNum() * RowLen()) and all
+    // BatchNum() * RawMatrixSize() elements from RawMemory() belong to the batch's own allocation.
+    bool Dense() const
+    {
+        return (m_rawData.m_mem.RawMemory() == m_rawData.m_mem.SharedPtr().get()) &&
+               (m_rawData.m_rawMatrixSize == m_rawData.m_rowNum * m_rawData.m_rowLen);
+    }
+
 private:
     Batch<TElem, TDevice, CategoryTags::Matrix> m_rawData;
 };
\ No newline at end of file
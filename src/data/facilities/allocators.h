@@ -1,83 +1,481 @@
 #pragma once
 
 #include <data/facilities/tags.h>
+#include <tensor/numa_placement.hpp>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <unordered_map>
+#include <vector>
 //#include <cuda_runtime.h>
 #include <deque>
 
 template <typename TDevice>
 struct Allocator;
 
+// Snapshot of Allocator<DeviceTags::CPU>. Counters of threads that are still running are read without
+// stopping them, so the numbers are exact only while no other thread allocates or frees.
+struct AllocatorStatistics
+{
+    size_t allocations = 0;        // Allocate() calls that returned memory
+    size_t cacheHits = 0;          // ... served from the calling thread's cache, without taking a lock
+    size_t systemAllocations = 0;  // blocks obtained from operator new
+    size_t bytesInUse = 0;         // block bytes owned by live shared_ptrs
+    size_t bytesCached = 0;        // block bytes parked in thread caches and the shared depot
+    size_t bytesReserved = 0;      // bytesInUse + bytesCached
+    size_t peakBytesReserved = 0;
+};
+
+// CPU allocator with per-thread free lists.
+//
+// Blocks are 64-byte aligned and rounded up to a size class: multiples of 64 bytes up to 256 bytes,
+// then four classes per power of two up to 256KB (at most 25% padding). Each thread keeps a bounded
+// free list per class, so allocating and freeing a recently used size takes no lock. A thread whose
+// list runs dry refills half of it from the shared depot; one whose list overflows moves half of it
+// back. Blocks above 256KB are rounded to 4KB and always go through the depot, where the lock is cheap
+// next to touching the memory. A block freed on another thread joins that thread's cache.
+//
+// Nothing is returned to the system unless asked: Trim() releases cached blocks down to a byte count,
+// and SetHighWaterMark() makes the depot do so whenever its cache grows past the mark.
+//
+// SetNumaPlacement() chooses where the pages of new large blocks go (see tensor/numa_placement.hpp). A cached
+// block keeps the placement it was created with.
 template <>
 struct Allocator<DeviceTags::CPU>
 {
 private:
-    struct AllocHelper
+    static constexpr size_t s_alignment = 64;
+    static constexpr size_t s_classNum = 44;
+    static constexpr size_t s_maxSmall = size_t(1) << 18;
+    static constexpr size_t s_largeGranularity = 4096;
+    static constexpr size_t s_threadCacheBytes = size_t(1) << 18;
+
+    static size_t ClassIndex(size_t p_bytes)
+    {
+        if (p_bytes <= 256)
+        {
+            return p_bytes == 0 ? 0 : (p_bytes - 1) / 64;
+        }
+        const size_t sz = p_bytes - 1;
+        const size_t msb = 63 - __builtin_clzll(sz);
+        return 4 + (msb - 8) * 4 + ((sz >> (msb - 2)) & 3);
+    }
+
+    static size_t ClassSize(size_t p_index)
+    {
+        if (p_index < 4)
+        {
+            return (p_index + 1) * 64;
+        }
+        const size_t msb = (p_index - 4) / 4 + 8;
+        return (4 + (p_index - 4) % 4 + 1) << (msb - 2);
+    }
+
+    // Free blocks a thread keeps per class before handing half of them to the depot.
+    static size_t CacheLimit(size_t p_index)
+    {
+        return std::min<size_t>(64, std::max<size_t>(2, s_threadCacheBytes / ClassSize(p_index)));
+    }
+
+    static void* SystemAlloc(size_t p_bytes)
+    {
+        return ::operator new(p_bytes, std::align_val_t(s_alignment));
+    }
+
+    static void SystemFree(void* p_mem)
     {
-        std::unordered_map<size_t, std::deque<void*> > memBuffer;
-        ~AllocHelper()
+        ::operator delete(p_mem, std::align_val_t(s_alignment));
+    }
+
+    // Counters a thread updates without atomic read-modify-writes; only Statistics() reads them.
+    struct ThreadCounters
+    {
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> cacheHits{0};
+        std::atomic<size_t> cachedBytes{0};
+
+        static void Add(std::atomic<size_t>& p_counter, size_t p_val)
+        {
+            p_counter.store(p_counter.load(std::memory_order_relaxed) + p_val, std::memory_order_relaxed);
+        }
+
+        static void Sub(std::atomic<size_t>& p_counter, size_t p_val)
+        {
+            p_counter.store(p_counter.load(std::memory_order_relaxed) - p_val, std::memory_order_relaxed);
+        }
+    };
+
+    struct ThreadCache;
+
+    struct Depot
+    {
+        std::mutex m_mutex;
+        std::vector<void*> m_small[s_classNum];
+        std::unordered_map<size_t, std::vector<void*>> m_large;
+        std::vector<ThreadCache*> m_caches;
+
+        size_t m_cachedBytes = 0;
+        size_t m_reservedBytes = 0;
+        size_t m_peakReservedBytes = 0;
+        size_t m_systemAllocations = 0;
+        size_t m_highWaterMark = size_t(-1);
+        NumaPlacement m_numaPlacement = NumaPlacement::Default;
+        // Counters of threads that have exited.
+        size_t m_retiredAllocations = 0;
+        size_t m_retiredCacheHits = 0;
+
+        void* NewBlock(size_t p_bytes)
+        {
+            void* mem = SystemAlloc(p_bytes);
+            std::lock_guard<std::mutex> guard(m_mutex);
+            ++m_systemAllocations;
+            m_reservedBytes += p_bytes;
+            m_peakReservedBytes = std::max(m_peakReservedBytes, m_reservedBytes);
+            return mem;
+        }
+
+        // Moves up to p_count blocks of class p_index into p_out; returns how many were moved.
+        size_t Refill(size_t p_index, std::vector<void*>& p_out, size_t p_count)
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            auto& slot = m_small[p_index];
+            const size_t n = std::min(p_count, slot.size());
+            p_out.insert(p_out.end(), slot.end() - n, slot.end());
+            slot.resize(slot.size() - n);
+            m_cachedBytes -= n * ClassSize(p_index);
+            return n;
+        }
+
+        // Takes the blocks of class p_index from position p_from of p_in onwards. Blocks it has no room
+        // to record are returned to the system.
+        void Release(size_t p_index, std::vector<void*>& p_in, size_t p_from) noexcept
+        {
+            std::lock_guard<std::mutex> guard(m_mutex);
+            auto& slot = m_small[p_index];
+            const size_t n = p_in.size() - p_from;
+            try
+            {
+                slot.insert(slot.end(), p_in.begin() + p_from, p_in.end());
+                m_cachedBytes += n * ClassSize(p_index);
+            }
+            catch (...)
+            {
+                std::for_each(p_in.begin() + p_from, p_in.end(), SystemFree);
+                m_reservedBytes -= n * ClassSize(p_index);
+            }
+            p_in.resize(p_from);
+            TrimLocked(m_highWaterMark);
+        }
+
+        void Discard(void* p_mem, size_t p_bytes) noexcept
+        {
+            SystemFree(p_mem);
+            std::lock_guard<std::mutex> guard(m_mutex);
+            m_reservedBytes -= p_bytes;
+        }
+
+        void* TakeLarge(size_t p_bytes)
+        {
+            NumaPlacement placement;
+            {
+                std::lock_guard<std::mutex> guard(m_mutex);
+                auto it = m_large.find(p_bytes);
+                if (it != m_large.end() && !it->second.empty())
+                {
+                    void* mem = it->second.back();
+                    it->second.pop_back();
+                    m_cachedBytes -= p_bytes;
+                    return mem;
+                }
+                placement = m_numaPlacement;
+            }
+            void* mem = NewBlock(p_bytes);
+            numa_place(mem, p_bytes, placement);
+            return mem;
+        }
+
+        void ReleaseLarge(void* p_mem, size_t p_bytes) noexcept
         {
-            for (auto& p : memBuffer)
             {
-                auto& refVec = p.second;
-                for (auto& p1 : refVec)
+                std::lock_guard<std::mutex> guard(m_mutex);
+                try
                 {
-                    char* buf = (char*)(p1);
-                    delete []buf;
+                    m_large[p_bytes].push_back(p_mem);
+                    m_cachedBytes += p_bytes;
+                    TrimLocked(m_highWaterMark);
+                    return;
                 }
-                refVec.clear();
+                catch (...) {}
             }
+            Discard(p_mem, p_bytes);
+        }
+
+        // Frees cached blocks, large ones first, until at most p_keepBytes remain cached.
+        size_t TrimLocked(size_t p_keepBytes) noexcept
+        {
+            size_t released = 0;
+            for (auto it = m_large.begin(); it != m_large.end() && m_cachedBytes > p_keepBytes; )
+            {
+                auto& slot = it->second;
+                while (!slot.empty() && m_cachedBytes > p_keepBytes)
+                {
+                    SystemFree(slot.back());
+                    slot.pop_back();
+                    m_cachedBytes -= it->first;
+                    released += it->first;
+                }
+                it = slot.empty() ? m_large.erase(it) : std::next(it);
+            }
+            for (size_t i = s_classNum; i-- > 0 && m_cachedBytes > p_keepBytes; )
+            {
+                auto& slot = m_small[i];
+                while (!slot.empty() && m_cachedBytes > p_keepBytes)
+                {
+                    SystemFree(slot.back());
+                    slot.pop_back();
+                    m_cachedBytes -= ClassSize(i);
+                    released += ClassSize(i);
+                }
+            }
+            m_reservedBytes -= released;
+            return released;
         }
     };
 
+    // Intentionally never destroyed: blocks owned by static objects are freed after every other static.
+    static Depot& GetDepot()
+    {
+        static Depot* inst = new Depot;
+        return *inst;
+    }
+
+    struct ThreadCache
+    {
+        std::vector<void*> m_free[s_classNum];
+        ThreadCounters m_counters;
+
+        ThreadCache()
+        {
+            Depot& depot = GetDepot();
+            std::lock_guard<std::mutex> guard(depot.m_mutex);
+            depot.m_caches.push_back(this);
+        }
+
+        ~ThreadCache()
+        {
+            t_cacheDestroyed = true;
+            for (size_t i = 0; i < s_classNum; ++i)
+            {
+                if (!m_free[i].empty())
+                {
+                    GetDepot().Release(i, m_free[i], 0);
+                }
+            }
+            Depot& depot = GetDepot();
+            std::lock_guard<std::mutex> guard(depot.m_mutex);
+            depot.m_retiredAllocations += m_counters.allocations.load(std::memory_order_relaxed);
+            depot.m_retiredCacheHits += m_counters.cacheHits.load(std::memory_order_relaxed);
+            depot.m_caches.erase(std::find(depot.m_caches.begin(), depot.m_caches.end(), this));
+        }
+
+        // Moves the second half of class p_index's list to the depot (all of it if p_all).
+        void Flush(size_t p_index, bool p_all)
+        {
+            auto& slot = m_free[p_index];
+            const size_t keep = p_all ? 0 : slot.size() / 2;
+            ThreadCounters::Sub(m_counters.cachedBytes, (slot.size() - keep) * ClassSize(p_index));
+            GetDepot().Release(p_index, slot, keep);
+        }
+    };
+
+    static inline thread_local bool t_cacheDestroyed = false;
+
+    // The calling thread's cache, or nullptr once it has been destroyed at thread exit.
+    static ThreadCache* LocalCache()
+    {
+        if (t_cacheDestroyed)
+        {
+            return nullptr;
+        }
+        thread_local ThreadCache cache;
+        return &cache;
+    }
+
+    static void* AllocBlock(size_t p_bytes)
+    {
+        if (p_bytes > s_maxSmall)
+        {
+            if (ThreadCache* cache = LocalCache())
+            {
+                ThreadCounters::Add(cache->m_counters.allocations, 1);
+            }
+            return GetDepot().TakeLarge(p_bytes);
+        }
+
+        const size_t index = ClassIndex(p_bytes);
+        ThreadCache* cache = LocalCache();
+        if (!cache)
+        {
+            std::vector<void*> one;
+            return GetDepot().Refill(index, one, 1) ? one.back() : GetDepot().NewBlock(ClassSize(index));
+        }
+
+        ThreadCounters::Add(cache->m_counters.allocations, 1);
+        auto& slot = cache->m_free[index];
+        if (slot.empty())
+        {
+            slot.reserve(CacheLimit(index) + 1);
+            if (GetDepot().Refill(index, slot, std::max<size_t>(1, CacheLimit(index) / 2)) == 0)
+            {
+                return GetDepot().NewBlock(ClassSize(index));
+            }
+            ThreadCounters::Add(cache->m_counters.cachedBytes, slot.size() * ClassSize(index));
+        }
+        else
+        {
+            ThreadCounters::Add(cache->m_counters.cacheHits, 1);
+        }
+        void* mem = slot.back();
+        slot.pop_back();
+        ThreadCounters::Sub(cache->m_counters.cachedBytes, ClassSize(index));
+        return mem;
+    }
+
+    // p_bytes is the block size handed to AllocBlock. Blocks that cannot be recorded for lack of memory
+    // are returned to the system.
+    static void FreeBlock(void* p_mem, size_t p_bytes) noexcept
+    {
+        if (p_bytes > s_maxSmall)
+        {
+            GetDepot().ReleaseLarge(p_mem, p_bytes);
+            return;
+        }
+
+        const size_t index = ClassIndex(p_bytes);
+        ThreadCache* cache = nullptr;
+        try
+        {
+            cache = LocalCache();
+            if (!cache)
+            {
+                std::vector<void*> one{p_mem};
+                GetDepot().Release(index, one, 0);
+                return;
+            }
+            auto& slot = cache->m_free[index];
+            slot.reserve(CacheLimit(index) + 1);
+            slot.push_back(p_mem);
+        }
+        catch (...)
+        {
+            GetDepot().Discard(p_mem, p_bytes);
+            return;
+        }
+        ThreadCounters::Add(cache->m_counters.cachedBytes, p_bytes);
+        if (cache->m_free[index].size() > CacheLimit(index))
+        {
+            cache->Flush(index, false);
+        }
+    }
+
     struct DesImpl
     {
-        DesImpl(std::deque<void*>& p_refPool)
-            : m_refPool(p_refPool) {}
+        explicit DesImpl(size_t p_bytes)
+            : m_bytes(p_bytes) {}
 
         void operator () (void* p_val) const
         {
-            std::lock_guard<std::mutex> guard(GetMutex());
-            m_refPool.push_back(p_val);
+            FreeBlock(p_val, m_bytes);
         }
     private:
-        std::deque<void*>& m_refPool;
+        size_t m_bytes;
     };
 
 public:
     template<typename T>
     static std::shared_ptr<T> Allocate(size_t p_elemSize)
     {
+        static_assert(alignof(T) <= s_alignment);
         if (p_elemSize == 0)
         {
             return nullptr;
         }
-        p_elemSize = (p_elemSize * sizeof(T) + 1023) & (size_t(-1) ^ 1023);
-
-        std::lock_guard<std::mutex> guard(GetMutex());
-
-        static AllocHelper allocateHelper;
-        auto& slot = allocateHelper.memBuffer[p_elemSize];
-        if (slot.empty())
+        size_t bytes = p_elemSize * sizeof(T);
+        bytes = bytes > s_maxSmall ? (bytes + s_largeGranularity - 1) & ~(s_largeGranularity - 1)
+                                   : ClassSize(ClassIndex(bytes));
+        void* mem = AllocBlock(bytes);
+        try
         {
-            auto raw_buf = (T*)new char[p_elemSize];
-            return std::shared_ptr<T>(raw_buf, DesImpl(slot));
+            return std::shared_ptr<T>((T*)mem, DesImpl(bytes));
         }
-        else
+        catch (...)
         {
-            void* mem = slot.back();
-            slot.pop_back();
-            return std::shared_ptr<T>((T*)mem, DesImpl(slot));
+            FreeBlock(mem, bytes);
+            throw;
         }
     }
-    
-private:
-    static std::mutex& GetMutex()
+
+    // Returns cached blocks to the system until at most p_keepBytes stay cached, and returns the number of
+    // bytes released. The calling thread's cache is emptied into the depot first; other threads' caches
+    // are left alone (they are trimmed when those threads exit or overflow).
+    static size_t Trim(size_t p_keepBytes = 0)
+    {
+        if (ThreadCache* cache = LocalCache())
+        {
+            for (size_t i = 0; i < s_classNum; ++i)
+            {
+                if (!cache->m_free[i].empty())
+                {
+                    cache->Flush(i, true);
+                }
+            }
+        }
+        Depot& depot = GetDepot();
+        std::lock_guard<std::mutex> guard(depot.m_mutex);
+        return depot.TrimLocked(p_keepBytes);
+    }
+
+    // Makes the depot trim itself to p_bytes whenever blocks handed back to it push its cache past
+    // p_bytes. The default, size_t(-1), never trims.
+    static void SetHighWaterMark(size_t p_bytes)
     {
-        static std::mutex inst;
-        return inst;
+        Depot& depot = GetDepot();
+        std::lock_guard<std::mutex> guard(depot.m_mutex);
+        depot.m_highWaterMark = p_bytes;
+        depot.TrimLocked(p_bytes);
+    }
+
+    // Places the pages of large blocks obtained from the system from now on: interleaved over the NUMA
+    // nodes, or zero-filled by the tensor ThreadPool so that each pool thread first-touches its share.
+    static void SetNumaPlacement(NumaPlacement p_placement)
+    {
+        Depot& depot = GetDepot();
+        std::lock_guard<std::mutex> guard(depot.m_mutex);
+        depot.m_numaPlacement = p_placement;
+    }
+
+    static AllocatorStatistics Statistics()
+    {
+        Depot& depot = GetDepot();
+        std::lock_guard<std::mutex> guard(depot.m_mutex);
+        AllocatorStatistics res;
+        res.allocations = depot.m_retiredAllocations;
+        res.cacheHits = depot.m_retiredCacheHits;
+        res.bytesCached = depot.m_cachedBytes;
+        for (ThreadCache* cache : depot.m_caches)
+        {
+            res.allocations += cache->m_counters.allocations.load(std::memory_order_relaxed);
+            res.cacheHits += cache->m_counters.cacheHits.load(std::memory_order_relaxed);
+            res.bytesCached += cache->m_counters.cachedBytes.load(std::memory_order_relaxed);
+        }
+        res.systemAllocations = depot.m_systemAllocations;
+        res.bytesReserved = depot.m_reservedBytes;
+        res.bytesInUse = res.bytesReserved - std::min(res.bytesCached, res.bytesReserved);
+        res.peakBytesReserved = depot.m_peakReservedBytes;
+        return res;
     }
 };
 
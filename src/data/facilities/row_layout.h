@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Row layout of newly allocated CPU matrices and batches of matrices.
+//
+// Packed rows follow each other directly. Padded rows are rounded up to a multiple of CpuRowAlignment
+// bytes; since every CPU allocation starts on a 64-byte boundary, each row then starts on a cache line
+// and holds a whole number of SIMD registers. The padding is zero-filled on allocation. Element-wise
+// evaluation units may process the padding of dense operands along with the data (see
+// ElementwiseEvalUnit), so after evaluation its content is unspecified; everything else only touches
+// the first ColNum() elements of a row.
+enum class RowLayout
+{
+    Packed,
+    Padded
+};
+
+constexpr size_t CpuRowAlignment = 64;
+
+// Layout of matrices constructed without an explicit one, including every evaluation result.
+inline std::atomic<RowLayout>& DefaultRowLayout()
+{
+    static std::atomic<RowLayout> inst{RowLayout::Packed};
+    return inst;
+}
+
+// Elements between the starts of two consecutive rows of p_colNum elements.
+template <typename TElem>
+size_t RowLenFor(size_t p_colNum, RowLayout p_layout)
+{
+    if ((p_layout == RowLayout::Packed) || (CpuRowAlignment % sizeof(TElem) != 0))
+    {
+        return p_colNum;
+    }
+    constexpr size_t step = CpuRowAlignment / sizeof(TElem);
+    return (p_colNum + step - 1) / step * step;
+}
@@ -4,6 +4,8 @@
 
 template <typename TElem, typename TDevice> class Matrix;
 template <typename TElem, typename TDevice> class Scalar;
+template <typename TDevice> class QuantizedMatrix;
+template <typename TElem, typename TDevice> class SparseMatrix;
 
 template<typename TElement, typename TDevice, typename TCategory> class Batch;
 
@@ -70,6 +72,40 @@ constexpr bool IsMatrix<T&&> = IsMatrix<T>;
 template <typename TElem, typename TDevice>
 constexpr bool IsMatrix<Matrix<TElem, TDevice>> = true;
 
+/// is quantized matrix: int8 weights that read as a float matrix. Only Dot accepts one, so IsMatrix
+/// stays false and element-wise operators reject it.
+template <typename T>
+constexpr bool IsQuantizedMatrix = false;
+
+template <typename T>
+constexpr bool IsQuantizedMatrix<const T> = IsQuantizedMatrix<T>;
+
+template <typename T>
+constexpr bool IsQuantizedMatrix<T&> = IsQuantizedMatrix<T>;
+
+template <typename T>
+constexpr bool IsQuantizedMatrix<T&&> = IsQuantizedMatrix<T>;
+
+template <typename TDevice>
+constexpr bool IsQuantizedMatrix<QuantizedMatrix<TDevice>> = true;
+
+/// is sparse matrix: block compressed rows, usable as either operand of Dot and nowhere else, so it
+/// is not IsMatrix either
+template <typename T>
+constexpr bool IsSparseMatrix = false;
+
+template <typename T>
+constexpr bool IsSparseMatrix<const T> = IsSparseMatrix<T>;
+
+template <typename T>
+constexpr bool IsSparseMatrix<T&> = IsSparseMatrix<T>;
+
+template <typename T>
+constexpr bool IsSparseMatrix<T&&> = IsSparseMatrix<T>;
+
+template <typename TElem, typename TDevice>
+constexpr bool IsSparseMatrix<SparseMatrix<TElem, TDevice>> = true;
+
 /// is batch scalar
 template <typename T>
 constexpr bool IsBatchScalar = false;
@@ -149,6 +185,18 @@ public:
     using type = typename helper<IsScalar<T>, IsMatrix<T>, IsBatchScalar<T>, IsBatchMatrix<T>>::type;
 };
 
+template <typename TDevice>
+struct DataCategory_<QuantizedMatrix<TDevice>>
+{
+    using type = CategoryTags::Matrix;
+};
+
+template <typename TElem, typename TDevice>
+struct DataCategory_<SparseMatrix<TElem, TDevice>>
+{
+    using type = CategoryTags::Matrix;
+};
+
 template <typename T>
 using DataCategory = typename DataCategory_<T>::type;
 
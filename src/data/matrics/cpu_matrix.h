@@ -2,9 +2,11 @@
 
 #include <data/facilities/continuous_memory.h>
 #include <data/facilities/lower_access.h>
+#include <data/facilities/row_layout.h>
 #include <data/scalar.h>
 #include <evaluate/facilities/eval_handle.h>
 #include <cassert>
+#include <algorithm>
 #include <cstring>
 #include <type_traits>
 
@@ -25,12 +27,18 @@ public:
     friend class Batch<TElem, DeviceTags::CPU, CategoryTags::Matrix>;
 
 public:
-    Matrix(size_t p_rowNum = 0, size_t p_colNum = 0)
-        : m_mem(p_rowNum * p_colNum)
+    Matrix(size_t p_rowNum = 0, size_t p_colNum = 0, RowLayout p_layout = DefaultRowLayout())
+        : m_mem(p_rowNum * RowLenFor<TElem>(p_colNum, p_layout))
         , m_rowNum(p_rowNum)
         , m_colNum(p_colNum)
-        , m_rowLen(p_colNum)
-    {}
+        , m_rowLen(RowLenFor<TElem>(p_colNum, p_layout))
+    {
+        for (size_t i = 0; (m_rowLen != m_colNum) && (i < m_rowNum); ++i)
+        {
+            auto row = m_mem.RawMemory() + i * m_rowLen;
+            std::fill(row + m_colNum, row + m_rowLen, ElementType());
+        }
+    }
 
     bool operator== (const Matrix& val) const
     {
@@ -126,6 +134,13 @@ struct LowerAccessImpl<Matrix<TElem, DeviceTags::CPU>>
         return m_matrix.m_rowLen;
     }
 
+    // True if the RowNum() * RowLen() elements from RawMemory(), padding included, all belong to the
+    // matrix's own allocation, i.e. the matrix is not a view starting inside another one.
+    bool Dense() const
+    {
+        return m_matrix.m_mem.RawMemory() == m_matrix.m_mem.SharedPtr().get();
+    }
+
 private:
     Matrix<TElem, DeviceTags::CPU> m_matrix;
 };
\ No newline at end of file
@@ -6,10 +6,13 @@
 #include <evaluate/facilities/eval_plan.h>
 #include <evaluate/facilities/eval_unit.h>
 #include <cassert>
+#include <cstring>
 #include <memory>
 #include <data/facilities/tags.h>
 #include <data/facilities/traits.h>
 
+namespace NSOneHotVector
+{
 template <typename TElem, typename TDevice>
 class EvalUnit;
 
@@ -33,9 +36,10 @@ public:
         auto& mutableData = m_resHandle.MutableData();
         m_resHandle.Allocate(m_rowNum, m_colNum);
         auto lowLayer = LowerAccess(mutableData);
+        const size_t rowLen = lowLayer.RowLen();
         auto mem = lowLayer.MutableRawMemory();
-        memset(mem, 0, sizeof(TElement) * m_rowNum * m_colNum);
-        mem[m_val] = 1;
+        memset(mem, 0, sizeof(TElement) * m_rowNum * rowLen);
+        mem[m_val / m_colNum * rowLen + m_val % m_colNum] = 1;
         m_resHandle.SetEval();
     }
 
@@ -45,6 +49,7 @@ private:
     size_t m_colNum;
     size_t m_val;
 };
+}
 
 template <typename TElem, typename TDevice>
 class OneHotVector
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <data/facilities/continuous_memory.h>
+#include <data/facilities/lower_access.h>
+#include <data/facilities/traits.h>
+#include <data/matrics/cpu_matrix.h>
+#include <evaluate/facilities/eval_handle.h>
+#include <kernels/qgemm.hpp>
+#include <cassert>
+#include <algorithm>
+
+template <>
+struct LowerAccessImpl<QuantizedMatrix<DeviceTags::CPU>>;
+
+// Read-only int8 weights with one symmetric scale per column. Reads as a float matrix, so it can be
+// the right operand of Dot, which then multiplies in int8 (see kernels/qgemm.hpp).
+template <>
+class QuantizedMatrix<DeviceTags::CPU>
+{
+public:
+    using ElementType = float;
+    using DeviceType = DeviceTags::CPU;
+
+    friend struct LowerAccessImpl<QuantizedMatrix<DeviceTags::CPU>>;
+
+public:
+    explicit QuantizedMatrix(const Matrix<float, DeviceTags::CPU>& p_weights)
+        : m_mem(p_weights.RowNum() * p_weights.ColNum())
+        , m_scales(p_weights.ColNum())
+        , m_zeroPoints(p_weights.ColNum())
+        , m_rowNum(p_weights.RowNum())
+        , m_colNum(p_weights.ColNum())
+    {
+        auto src = LowerAccess(p_weights);
+        const float* in = src.RawMemory();
+        const size_t rowLen = src.RowLen();
+        for (size_t j = 0; j < m_colNum; ++j)
+        {
+            float lo = 0, hi = 0;
+            for (size_t i = 0; i < m_rowNum; ++i)
+            {
+                lo = std::min(lo, in[i * rowLen + j]);
+                hi = std::max(hi, in[i * rowLen + j]);
+            }
+            const QuantScale s = choose_quant_scale(lo, hi, true);
+            m_scales.RawMemory()[j] = s.scale;
+            m_zeroPoints.RawMemory()[j] = s.zero_point;
+        }
+        for (size_t i = 0; i < m_rowNum; ++i)
+        {
+            for (size_t j = 0; j < m_colNum; ++j)
+            {
+                m_mem.RawMemory()[i * m_colNum + j] = quantize_value(in[i * rowLen + j], Channel(j));
+            }
+        }
+    }
+
+    bool operator== (const QuantizedMatrix& val) const
+    {
+        return (m_mem == val.m_mem) &&
+               (m_rowNum == val.m_rowNum) &&
+               (m_colNum == val.m_colNum);
+    }
+
+    template <typename TOtherType>
+    bool operator== (const TOtherType&) const
+    {
+        return false;
+    }
+
+    template <typename TData>
+    bool operator!= (const TData& val) const
+    {
+        return !(operator==(val));
+    }
+
+    size_t RowNum() const { return m_rowNum; }
+    size_t ColNum() const { return m_colNum; }
+
+    // Dequantised value
+    float operator () (size_t p_rowId, size_t p_colId) const
+    {
+        assert((p_rowId < m_rowNum) && (p_colId < m_colNum));
+        return dequantize_value(m_mem.RawMemory()[p_rowId * m_colNum + p_colId], Channel(p_colId));
+    }
+
+    auto EvalRegister() const
+    {
+        return MakeConstEvalHandle(*this);
+    }
+
+private:
+    QuantScale Channel(size_t p_colId) const
+    {
+        return {m_scales.RawMemory()[p_colId], m_zeroPoints.RawMemory()[p_colId]};
+    }
+
+private:
+    ContinuousMemory<int8_t, DeviceType> m_mem;
+    ContinuousMemory<float, DeviceType> m_scales;
+    ContinuousMemory<int32_t, DeviceType> m_zeroPoints;
+    size_t m_rowNum;
+    size_t m_colNum;
+};
+
+template <>
+struct LowerAccessImpl<QuantizedMatrix<DeviceTags::CPU>>
+{
+    LowerAccessImpl(QuantizedMatrix<DeviceTags::CPU> p)
+        : m_matrix(std::move(p))
+    {}
+
+    const int8_t* RawMemory() const
+    {
+        return m_matrix.m_mem.RawMemory();
+    }
+
+    size_t RowLen() const
+    {
+        return m_matrix.m_colNum;
+    }
+
+    QuantChannels Channels() const
+    {
+        return {m_matrix.m_scales.RawMemory(), m_matrix.m_zeroPoints.RawMemory(), true};
+    }
+
+private:
+    QuantizedMatrix<DeviceTags::CPU> m_matrix;
+};
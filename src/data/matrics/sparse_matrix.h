@@ -0,0 +1,111 @@
+#pragma once
+
+#include <data/facilities/lower_access.h>
+#include <data/facilities/traits.h>
+#include <data/matrics/cpu_matrix.h>
+#include <evaluate/facilities/eval_handle.h>
+#include <kernels/spmm.hpp>
+#include <cassert>
+#include <algorithm>
+#include <memory>
+
+template <typename TElem>
+struct LowerAccessImpl<SparseMatrix<TElem, DeviceTags::CPU>>;
+
+// Read-only matrix in block compressed sparse row form (see kernels/spmm.hpp); 1 x 1 blocks are CSR.
+// Either operand of Dot may be sparse, and the product then costs time proportional to the stored
+// values. Copies share the storage.
+template <typename TElem>
+class SparseMatrix<TElem, DeviceTags::CPU>
+{
+public:
+    using ElementType = TElem;
+    using DeviceType = DeviceTags::CPU;
+
+    friend struct LowerAccessImpl<SparseMatrix<TElem, DeviceTags::CPU>>;
+
+public:
+    explicit SparseMatrix(BsrMatrix<ElementType> p_storage)
+        : m_storage(std::make_shared<const BsrMatrix<ElementType>>(std::move(p_storage)))
+    {}
+
+    // Keeps the p_blockRows x p_blockCols blocks of p_dense that hold a non-zero.
+    explicit SparseMatrix(const Matrix<ElementType, DeviceTags::CPU>& p_dense,
+                          size_t p_blockRows = 1, size_t p_blockCols = 1)
+        : SparseMatrix(Compress(p_dense, p_blockRows, p_blockCols))
+    {}
+
+    bool operator== (const SparseMatrix& val) const
+    {
+        return m_storage == val.m_storage;
+    }
+
+    template <typename TOtherType>
+    bool operator== (const TOtherType&) const
+    {
+        return false;
+    }
+
+    template <typename TData>
+    bool operator!= (const TData& val) const
+    {
+        return !(operator==(val));
+    }
+
+    size_t RowNum() const { return m_storage->rows; }
+    size_t ColNum() const { return m_storage->cols; }
+
+    size_t BlockRowNum() const { return m_storage->br; }
+    size_t BlockColNum() const { return m_storage->bc; }
+    size_t BlockCount() const { return m_storage->block_count(); }
+
+    const auto operator () (size_t p_rowId, size_t p_colId) const
+    {
+        assert((p_rowId < RowNum()) && (p_colId < ColNum()));
+        const auto& s = *m_storage;
+        const size_t blockRow = p_rowId / s.br;
+        const size_t blockCol = p_colId / s.bc;
+        for (size_t blk = s.block_ptr[blockRow]; blk < s.block_ptr[blockRow + 1]; ++blk)
+        {
+            if (s.block_col[blk] == blockCol)
+            {
+                return s.values[blk * s.br * s.bc + (p_rowId % s.br) * s.bc + p_colId % s.bc];
+            }
+        }
+        return ElementType();
+    }
+
+    auto EvalRegister() const
+    {
+        return MakeConstEvalHandle(*this);
+    }
+
+private:
+    static BsrMatrix<ElementType> Compress(const Matrix<ElementType, DeviceTags::CPU>& p_dense,
+                                           size_t p_blockRows, size_t p_blockCols)
+    {
+        auto mem = LowerAccess(p_dense);
+        return BsrMatrix<ElementType>::from_dense(p_dense.RowNum(), p_dense.ColNum(),
+                                                  mem.RawMemory(), mem.RowLen(),
+                                                  p_blockRows, p_blockCols);
+    }
+
+private:
+    std::shared_ptr<const BsrMatrix<ElementType>> m_storage;
+};
+
+template <typename TElem>
+struct LowerAccessImpl<SparseMatrix<TElem, DeviceTags::CPU>>
+{
+    LowerAccessImpl(SparseMatrix<TElem, DeviceTags::CPU> p)
+        : m_matrix(std::move(p))
+    {}
+
+    const BsrMatrix<TElem>& Storage() const
+    {
+        return *(m_matrix.m_storage);
+    }
+
+private:
+    SparseMatrix<TElem, DeviceTags::CPU> m_matrix;
+};
@@ -10,6 +10,8 @@
 #include <cassert>
 #include <memory>
 
+namespace NSTrivalMatrix
+{
 template <typename TElem, typename TDevice>
 class EvalUnit;
 
@@ -51,6 +53,7 @@ private:
     size_t m_colNum;
     TElem  m_val;
 };
+}
 
 template<typename TElem, typename TDevice, typename TScalar>
 class TrivalMatrix
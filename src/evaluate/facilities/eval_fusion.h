@@ -0,0 +1,469 @@
+#pragma once
+
+#include <data/facilities/tags.h>
+#include <data/facilities/traits.h>
+#include <evaluate/facilities/eval_group.h>
+#include <evaluate/facilities/eval_handle.h>
+#include <evaluate/facilities/eval_unit.h>
+#include <algorithm>
+#include <cassert>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Element-wise operator fusion.
+//
+// Element-wise evaluation units (Add, Sigmoid, ...) derive from ElementwiseEvalUnit and only provide a
+// kernel that maps rows of their operands to a row of their output. When fusion is enabled in EvalPlan,
+// EvalLayer::FuseElementwise() looks for chains of such units in which every intermediate result has a
+// single consumer, and replaces each chain with one FusedEvalUnit. The fused unit walks the output once,
+// tile by tile, and passes every intermediate tile to the next stage while it is still in cache.
+// Intermediate results that were only registered by the units reading them are not allocated at all.
+template <typename TDevice>
+class BaseFusableEvalUnit
+{
+public:
+    using UnitPtr = std::shared_ptr<BaseEvalUnit<TDevice>>;
+
+    virtual ~BaseFusableEvalUnit() = default;
+
+    // DataPtr() of every operand, in operand order.
+    virtual const std::vector<const void*>& OperandPtrs() const = 0;
+
+    // DataPtr() of the result.
+    virtual const void* OutputPtr() const = 0;
+
+    // Builds one unit evaluating `chain`, which starts with this unit; every later unit consumes the
+    // result of the one before it. The result of chain[i] is written to its output only if
+    // materialize[i] is set. Returns nullptr if the units cannot be fused.
+    virtual UnitPtr Fuse(const std::vector<UnitPtr>& chain, const std::vector<bool>& materialize) const = 0;
+};
+
+namespace NSEvalFusion
+{
+    // Elements of an intermediate result kept in cache between two stages of a fused chain.
+    constexpr size_t TileSize = 256;
+
+    struct Shape
+    {
+        size_t m_batchNum;
+        size_t m_rowNum;
+        size_t m_colNum;
+
+        bool operator== (const Shape& val) const
+        {
+            return (m_batchNum == val.m_batchNum) &&
+                   (m_rowNum == val.m_rowNum) &&
+                   (m_colNum == val.m_colNum);
+        }
+    };
+
+    template <typename TCategory>
+    struct CategoryAccess_;
+
+    template <>
+    struct CategoryAccess_<CategoryTags::Matrix>
+    {
+        template <typename TData>
+        static Shape GetShape(const TData& data)
+        {
+            return Shape{1, data.RowNum(), data.ColNum()};
+        }
+
+        template <typename THandle>
+        static void Allocate(THandle& handle, const Shape& shape)
+        {
+            handle.Allocate(shape.m_rowNum, shape.m_colNum);
+        }
+
+        template <typename TData, typename TPointer>
+        static size_t RowBases(const TData& data, std::vector<TPointer>& bases, bool& dense)
+        {
+            auto mem = LowerAccess(data);
+            bases.assign(1, mem.MutableRawMemory());
+            dense = mem.Dense();
+            return mem.RowLen();
+        }
+    };
+
+    template <>
+    struct CategoryAccess_<CategoryTags::BatchMatrix>
+    {
+        template <typename TData>
+        static Shape GetShape(const TData& data)
+        {
+            return Shape{data.BatchNum(), data.RowNum(), data.ColNum()};
+        }
+
+        template <typename THandle>
+        static void Allocate(THandle& handle, const Shape& shape)
+        {
+            handle.Allocate(shape.m_batchNum, shape.m_rowNum, shape.m_colNum);
+        }
+
+        template <typename TData, typename TPointer>
+        static size_t RowBases(const TData& data, std::vector<TPointer>& bases, bool& dense)
+        {
+            size_t rowLen = 0;
+            dense = LowerAccess(data).Dense();
+            bases.clear();
+            for (size_t i = 0; i < data.BatchNum(); ++i)
+            {
+                auto mem = LowerAccess(data[i]);
+                bases.push_back(mem.MutableRawMemory());
+                rowLen = mem.RowLen();
+            }
+            return rowLen;
+        }
+    };
+
+    // DenseRowLen() of a set of rows that imposes no row length.
+    constexpr size_t AnyRowLen = static_cast<size_t>(-1);
+
+    // Combines the DenseRowLen() of two sets of rows: the common row length, or 0 if there is none.
+    inline size_t CommonRowLen(size_t a, size_t b)
+    {
+        return (a == AnyRowLen) ? b : ((b == AnyRowLen) || (a == b)) ? a : 0;
+    }
+
+    // Rows of a Matrix, or of all matrices of a Batch numbered consecutively.
+    template <typename TPointer>
+    class RowAccess
+    {
+    public:
+        template <typename TCategory, typename TData>
+        void Bind(const TData& data)
+        {
+            m_rowLen = CategoryAccess_<TCategory>::RowBases(data, m_bases, m_dense);
+            m_rowNum = data.RowNum();
+        }
+
+        TPointer Row(size_t row) const
+        {
+            return m_bases[row / m_rowNum] + (row % m_rowNum) * m_rowLen;
+        }
+
+        // The row length if all rows, padding included, form one span starting at Row(0); 0 otherwise.
+        size_t DenseRowLen() const
+        {
+            return m_dense ? m_rowLen : 0;
+        }
+
+    private:
+        std::vector<TPointer> m_bases;
+        size_t m_rowLen = 0;
+        size_t m_rowNum = 1;
+        bool m_dense = false;
+    };
+
+    // Rows and columns an element-wise pass walks over `shape`: a single row spanning every row and its
+    // padding if all operands and results agree on a dense row length, the shape itself otherwise.
+    inline std::pair<size_t, size_t> PassExtent(const Shape& shape, size_t denseRowLen)
+    {
+        const size_t rowNum = shape.m_batchNum * shape.m_rowNum;
+        if ((rowNum == 0) || (denseRowLen == 0) || (denseRowLen == AnyRowLen))
+        {
+            return {rowNum, shape.m_colNum};
+        }
+        return {1, rowNum * denseRowLen};
+    }
+
+    // Holds units that are already built, so fused units can be put back into an EvalCluster.
+    template <typename TDevice>
+    class UnitListGroup : public BaseEvalGroup<TDevice>
+    {
+    public:
+        void Push(std::shared_ptr<BaseEvalUnit<TDevice>> unit)
+        {
+            m_unitList.push_back(std::move(unit));
+        }
+
+        std::shared_ptr<BaseEvalUnit<TDevice>> GetEvalUnit() override
+        {
+            std::shared_ptr<BaseEvalUnit<TDevice>> res;
+            if (!m_unitList.empty())
+            {
+                res = std::move(m_unitList.front());
+                m_unitList.pop_front();
+            }
+            return res;
+        }
+
+        void Merge(BaseEvalUnit<TDevice>&) override
+        {
+            throw std::runtime_error("UnitListGroup does not merge evaluation units.");
+        }
+
+        void Merge(BaseEvalUnit<TDevice>&&) override
+        {
+            throw std::runtime_error("UnitListGroup does not merge evaluation units.");
+        }
+
+    private:
+        std::list<std::shared_ptr<BaseEvalUnit<TDevice>>> m_unitList;
+    };
+}
+
+// Row-wise interface of an element-wise CPU unit, used by FusedEvalUnit to drive it stage by stage.
+template <typename TElem>
+class BaseElementwiseEvalUnit : public BaseEvalUnit<DeviceTags::CPU>
+                              , public BaseFusableEvalUnit<DeviceTags::CPU>
+{
+public:
+    using ElementType = TElem;
+    using DeviceType = DeviceTags::CPU;
+    using UnitPtr = typename BaseFusableEvalUnit<DeviceTags::CPU>::UnitPtr;
+
+    static constexpr size_t NoOperand = static_cast<size_t>(-1);
+
+    // Fetches the operands (except `chained`, which the previous stage of a fused chain provides with
+    // shape `chainedShape`) and, if `materialize` is set, allocates the result. Returns the shape.
+    virtual NSEvalFusion::Shape Prepare(size_t chained, const NSEvalFusion::Shape& chainedShape,
+                                        bool materialize) = 0;
+
+    virtual const TElem* OperandRow(size_t operand, size_t row) const = 0;
+    virtual TElem* OutputRow(size_t row) const = 0;
+
+    // Common NSEvalFusion::RowAccess::DenseRowLen() of the operands and result bound by Prepare():
+    // NSEvalFusion::AnyRowLen if nothing is bound, 0 if they are not all dense with one row length.
+    virtual size_t DenseRowLen() const = 0;
+
+    // out[j] = f(operands[0][j], operands[1][j], ...) for j in [0, n). `out` never aliases an operand.
+    virtual void Apply(const TElem* const* operands, TElem* out, size_t n) const = 0;
+
+    // Marks the result as evaluated.
+    virtual void Finish() = 0;
+
+    UnitPtr Fuse(const std::vector<UnitPtr>& chain, const std::vector<bool>& materialize) const override;
+};
+
+// Evaluates a chain of element-wise units in one pass over the output.
+template <typename TElem>
+class FusedEvalUnit : public BaseEvalUnit<DeviceTags::CPU>
+{
+    using Stage = BaseElementwiseEvalUnit<TElem>;
+
+public:
+    // chained[i]: operand of stage i fed by stage i - 1 (unused for stage 0).
+    // materialize[i]: whether the result of stage i is written to its own output.
+    FusedEvalUnit(std::vector<std::shared_ptr<Stage>> stages,
+                  std::vector<size_t> chained,
+                  std::vector<bool> materialize)
+        : m_stages(std::move(stages))
+        , m_chained(std::move(chained))
+        , m_materialize(std::move(materialize)) {}
+
+    size_t StageNum() const
+    {
+        return m_stages.size();
+    }
+
+    void Eval() override
+    {
+        NSEvalFusion::Shape shape{0, 0, 0};
+        for (size_t s = 0; s < m_stages.size(); ++s)
+        {
+            shape = m_stages[s]->Prepare(s ? m_chained[s] : Stage::NoOperand, shape, m_materialize[s]);
+        }
+
+        // Dense operands with padded rows are walked as one span, so tiles are never cut at row ends.
+        size_t denseRowLen = NSEvalFusion::AnyRowLen;
+        for (const auto& stage : m_stages)
+        {
+            denseRowLen = NSEvalFusion::CommonRowLen(denseRowLen, stage->DenseRowLen());
+        }
+        const auto [rowNum, colNum] = NSEvalFusion::PassExtent(shape, denseRowLen);
+        std::vector<TElem> tiles(2 * NSEvalFusion::TileSize);
+        std::vector<const TElem*> operands;
+
+        for (size_t row = 0; row < rowNum; ++row)
+        {
+            for (size_t col = 0; col < colNum; col += NSEvalFusion::TileSize)
+            {
+                const size_t n = std::min(NSEvalFusion::TileSize, colNum - col);
+                const TElem* prev = nullptr;
+                for (size_t s = 0; s < m_stages.size(); ++s)
+                {
+                    const Stage& stage = *m_stages[s];
+                    operands.resize(stage.OperandPtrs().size());
+                    for (size_t k = 0; k < operands.size(); ++k)
+                    {
+                        operands[k] = (s && k == m_chained[s]) ? prev : stage.OperandRow(k, row) + col;
+                    }
+                    TElem* out = m_materialize[s] ? stage.OutputRow(row) + col
+                                                  : tiles.data() + (s % 2) * NSEvalFusion::TileSize;
+                    stage.Apply(operands.data(), out, n);
+                    prev = out;
+                }
+            }
+        }
+
+        for (size_t s = 0; s < m_stages.size(); ++s)
+        {
+            if (m_materialize[s]) m_stages[s]->Finish();
+        }
+    }
+
+private:
+    std::vector<std::shared_ptr<Stage>> m_stages;
+    std::vector<size_t> m_chained;
+    std::vector<bool> m_materialize;
+};
+
+template <typename TElem>
+auto BaseElementwiseEvalUnit<TElem>::Fuse(const std::vector<UnitPtr>& chain,
+                                          const std::vector<bool>& materialize) const -> UnitPtr
+{
+    std::vector<std::shared_ptr<BaseElementwiseEvalUnit>> stages;
+    std::vector<size_t> chained;
+    for (size_t s = 0; s < chain.size(); ++s)
+    {
+        auto stage = std::dynamic_pointer_cast<BaseElementwiseEvalUnit>(chain[s]);
+        if (!stage) return nullptr;
+
+        size_t operand = NoOperand;
+        if (s)
+        {
+            const auto& ptrs = stage->OperandPtrs();
+            auto it = std::find(ptrs.begin(), ptrs.end(), stages.back()->OutputPtr());
+            if (it == ptrs.end()) return nullptr;
+            operand = it - ptrs.begin();
+        }
+        stages.push_back(std::move(stage));
+        chained.push_back(operand);
+    }
+    return std::make_shared<FusedEvalUnit<TElem>>(std::move(stages), std::move(chained), materialize);
+}
+
+// Base class of element-wise evaluation units over Matrix or BatchMatrix operands of the same shape.
+// TDerived provides Apply(); Eval() runs it row by row, and the fusion pass can chain it with others.
+// When the operands and the result are dense and share a row length (e.g. all allocated with
+// RowLayout::Padded), Apply() runs once over every row including the padding, with no row tails.
+template <typename TElem, typename TCategory, typename... TOperHandles>
+class ElementwiseEvalUnit : public BaseElementwiseEvalUnit<TElem>
+{
+    static constexpr size_t OperandNum = sizeof...(TOperHandles);
+    using Base = BaseElementwiseEvalUnit<TElem>;
+    using OutputType = PrincipalDataType<TCategory, TElem, DeviceTags::CPU>;
+
+public:
+    ElementwiseEvalUnit(TOperHandles... opers, EvalHandle<OutputType> evalOutput)
+        : m_opers(std::move(opers)...)
+        , m_evalOutput(std::move(evalOutput))
+        , m_operandPtrs(CollectOperandPtrs(std::index_sequence_for<TOperHandles...>{})) { }
+
+    void Eval() override
+    {
+        const NSEvalFusion::Shape shape = Prepare(Base::NoOperand, NSEvalFusion::Shape{0, 0, 0}, true);
+        const auto [rowNum, colNum] = NSEvalFusion::PassExtent(shape, DenseRowLen());
+        const TElem* operands[OperandNum];
+        for (size_t row = 0; row < rowNum; ++row)
+        {
+            for (size_t k = 0; k < OperandNum; ++k)
+            {
+                operands[k] = OperandRow(k, row);
+            }
+            this->Apply(operands, OutputRow(row), colNum);
+        }
+        Finish();
+    }
+
+    const std::vector<const void*>& OperandPtrs() const override
+    {
+        return m_operandPtrs;
+    }
+
+    const void* OutputPtr() const override
+    {
+        return m_evalOutput.DataPtr();
+    }
+
+    NSEvalFusion::Shape Prepare(size_t chained, const NSEvalFusion::Shape& chainedShape,
+                                bool materialize) override
+    {
+        m_shape = chainedShape;
+        m_shapeSet = (chained != Base::NoOperand);
+        m_chained = chained;
+        m_materialized = materialize;
+        BindOperands(chained, std::index_sequence_for<TOperHandles...>{});
+
+        if (materialize)
+        {
+            NSEvalFusion::CategoryAccess_<TCategory>::Allocate(m_evalOutput, m_shape);
+            m_output.template Bind<TCategory>(m_evalOutput.MutableData());
+        }
+        return m_shape;
+    }
+
+    const TElem* OperandRow(size_t operand, size_t row) const override
+    {
+        return m_inputs[operand].Row(row);
+    }
+
+    TElem* OutputRow(size_t row) const override
+    {
+        return m_output.Row(row);
+    }
+
+    size_t DenseRowLen() const override
+    {
+        size_t res = m_materialized ? m_output.DenseRowLen() : NSEvalFusion::AnyRowLen;
+        for (size_t k = 0; k < OperandNum; ++k)
+        {
+            if (k != m_chained)
+            {
+                res = NSEvalFusion::CommonRowLen(res, m_inputs[k].DenseRowLen());
+            }
+        }
+        return res;
+    }
+
+    void Finish() override
+    {
+        m_evalOutput.SetEval();
+    }
+
+private:
+    template <size_t... I>
+    std::vector<const void*> CollectOperandPtrs(std::index_sequence<I...>) const
+    {
+        return {std::get<I>(m_opers).DataPtr()...};
+    }
+
+    template <size_t... I>
+    void BindOperands(size_t chained, std::index_sequence<I...>)
+    {
+        (BindOperand<I>(chained), ...);
+    }
+
+    template <size_t I>
+    void BindOperand(size_t chained)
+    {
+        if (I == chained) return;
+
+        const auto& data = std::get<I>(m_opers).Data();
+        const NSEvalFusion::Shape shape = NSEvalFusion::CategoryAccess_<TCategory>::GetShape(data);
+        if (m_shapeSet)
+        {
+            assert(shape == m_shape);
+        }
+        m_shape = shape;
+        m_shapeSet = true;
+        m_inputs[I].template Bind<TCategory>(data);
+    }
+
+private:
+    std::tuple<TOperHandles...> m_opers;
+    EvalHandle<OutputType> m_evalOutput;
+    std::vector<const void*> m_operandPtrs;
+
+    NSEvalFusion::Shape m_shape{0, 0, 0};
+    bool m_shapeSet = false;
+    size_t m_chained = Base::NoOperand;
+    bool m_materialized = false;
+    NSEvalFusion::RowAccess<const TElem*> m_inputs[OperandNum];
+    NSEvalFusion::RowAccess<TElem*> m_output;
+};
@@ -2,6 +2,8 @@
 
 // Include necessary headers related to evaluation processing, groups, handles, pools, and units.
 #include <evaluate/processor/trival_eval_pool.h>
+#include <evaluate/processor/work_stealing_eval_pool.h>
+#include <evaluate/facilities/eval_fusion.h>
 #include <evaluate/facilities/eval_group.h>
 #include <evaluate/facilities/eval_handle.h>
 #include <evaluate/facilities/eval_pool.h>
@@ -13,9 +15,11 @@
 #include <list>
 #include <memory>
 #include <stdexcept>
-#include <unordered_set>
+#include <unordered_map>
 #include <typeindex>
 #include <algorithm>
+#include <atomic>
+#include <unordered_set>
 
 // Namespace for evaluation planning related functions and types.
 namespace NSEvalPlan
@@ -93,6 +97,7 @@ public:
         m_evalSeq.clear();
         m_operands.clear();
         m_outputs.clear();
+        m_requests.clear();
     }
 
     /**
@@ -109,6 +114,8 @@ public:
     {
         // If the result pointer is null, do nothing.
         if (!resPtr) return;
+        // Count every request for the result, including the ones dropped below as duplicates.
+        ++m_requests[resPtr];
         // If the result pointer is already in the outputs map, do nothing.
         if (m_outputs.find(resPtr) != m_outputs.end()) return;
 
@@ -138,15 +145,132 @@ public:
 
         // Insert the result pointer and its depth into the outputs map.
         m_outputs.insert({resPtr, depth});
+        // Count the registered units reading each operand.
+        for (auto p : paramPtr) ++m_operands[p];
+    }
+
+    /**
+     * @brief Merge chains of element-wise evaluation units into fused units (see eval_fusion.h).
+     *
+     * A unit is chained with its consumer if both are element-wise and the consumer is the only
+     * registered unit reading its result. Each chain is replaced by one unit placed at the depth of
+     * its last member, so every operand from outside the chain is evaluated before it runs.
+     *
+     * Every unit registers each of its operands once, so an intermediate result requested more often
+     * than it is read was also registered by a caller that holds on to it, and is still written out.
+     */
+    void FuseElementwise()
+    {
+        using UnitPtr = std::shared_ptr<BaseEvalUnit<TDevice>>;
+        using FusablePtr = BaseFusableEvalUnit<TDevice>*;
+
+        // Take every unit out of its group, remembering its depth.
+        std::vector<std::vector<UnitPtr>> units(m_evalSeq.size());
+        for (size_t depth = 0; depth < m_evalSeq.size(); ++depth)
+        {
+            for (auto& eg : m_evalSeq[depth])
+            {
+                while (auto unit = eg.second->GetEvalUnit())
+                {
+                    units[depth].push_back(std::move(unit));
+                }
+            }
+        }
+
+        // Link every element-wise unit to the element-wise unit consuming its result, if that is
+        // the result's only consumer. A consumer takes at most one producer, so links form chains.
+        std::unordered_map<const void*, UnitPtr> producers;
+        for (auto& level : units)
+        {
+            for (auto& unit : level)
+            {
+                if (auto fusable = dynamic_cast<FusablePtr>(unit.get()))
+                {
+                    producers[fusable->OutputPtr()] = unit;
+                }
+            }
+        }
+
+        std::unordered_map<BaseEvalUnit<TDevice>*, UnitPtr> next;
+        std::unordered_set<BaseEvalUnit<TDevice>*> linked;
+        for (auto& level : units)
+        {
+            for (auto& unit : level)
+            {
+                auto fusable = dynamic_cast<FusablePtr>(unit.get());
+                if (!fusable) continue;
+                for (auto p : fusable->OperandPtrs())
+                {
+                    auto it = producers.find(p);
+                    if ((it == producers.end()) || (m_operands[p] != 1)) continue;
+                    next[it->second.get()] = unit;
+                    linked.insert(unit.get());
+                    break;
+                }
+            }
+        }
+
+        // Replace each chain by its fused unit, placed at the depth of the chain's last member.
+        std::unordered_map<BaseEvalUnit<TDevice>*, size_t> depthOf;
+        for (size_t depth = 0; depth < units.size(); ++depth)
+        {
+            for (auto& unit : units[depth]) depthOf[unit.get()] = depth;
+        }
+
+        std::vector<std::vector<UnitPtr>> result(units.size());
+        std::unordered_set<BaseEvalUnit<TDevice>*> fused;
+        for (auto& level : units)
+        {
+            for (auto& unit : level)
+            {
+                if (linked.count(unit.get()) || !next.count(unit.get())) continue;
+
+                std::vector<UnitPtr> chain{unit};
+                for (auto it = next.find(unit.get()); it != next.end(); it = next.find(it->second.get()))
+                {
+                    chain.push_back(it->second);
+                }
+                std::vector<bool> materialize;
+                for (size_t s = 0; s < chain.size(); ++s)
+                {
+                    const void* out = dynamic_cast<FusablePtr>(chain[s].get())->OutputPtr();
+                    materialize.push_back((s + 1 == chain.size()) || (m_requests[out] != m_operands[out]));
+                }
+                auto fusedUnit = dynamic_cast<FusablePtr>(unit.get())->Fuse(chain, materialize);
+                if (!fusedUnit) continue;
+
+                for (auto& member : chain) fused.insert(member.get());
+                result[depthOf[chain.back().get()]].push_back(std::move(fusedUnit));
+            }
+        }
+
+        for (size_t depth = 0; depth < units.size(); ++depth)
+        {
+            for (auto& unit : units[depth])
+            {
+                if (!fused.count(unit.get())) result[depth].push_back(std::move(unit));
+            }
+        }
+
+        // Put the units back, one group per cluster.
+        for (size_t depth = 0; depth < result.size(); ++depth)
+        {
+            auto group = std::make_shared<NSEvalFusion::UnitListGroup<TDevice>>();
+            for (auto& unit : result[depth]) group->Push(std::move(unit));
+            m_evalSeq[depth].clear();
+            m_evalSeq[depth].insert({std::type_index(typeid(NSEvalFusion::UnitListGroup<TDevice>)), group});
+        }
     }
 
 private:
     // A vector of evaluation clusters representing the evaluation sequence.
     std::vector<EvalCluster<TDevice>> m_evalSeq;
-    // An unordered set of pointers to the operands.
-    std::unordered_set<const void*> m_operands;
+    // The number of registered units reading each operand.
+    std::unordered_map<const void*, size_t> m_operands;
     // An unordered map that stores the depth of each output.
     std::unordered_map<const void*, size_t> m_outputs;
+    // The number of times each output was registered, duplicates included.
+    std::unordered_map<const void*, size_t> m_requests;
 };
 
 // Class representing an evaluation plan, which manages evaluation layers and the evaluation pool.
@@ -176,6 +300,16 @@ private:
         return inst;
     }
     
+    /**
+     * @brief Get a reference to the global element-wise fusion switch.
+     * @return A reference to the global fusion flag.
+     */
+    static std::atomic<bool>& GlobalFusion()
+    {
+        static std::atomic<bool> inst{false};
+        return inst;
+    }
+
     /**
      * @brief Get a reference to the thread-local evaluation plan instance.
      * @return A reference to the thread-local evaluation plan instance.
@@ -197,6 +331,18 @@ public:
         GlobalEvalPool() = epType;
     }
 
+    /**
+     * @brief Enable or disable element-wise operator fusion for all evaluation plans.
+     *
+     * When enabled, chains of element-wise evaluation units are merged into single units before a
+     * layer is evaluated (see EvalLayer::FuseElementwise). Disabled by default.
+     * @param enable Whether to fuse element-wise units.
+     */
+    static void SetFusion(bool enable)
+    {
+        GlobalFusion() = enable;
+    }
+
     /**
      * @brief Register an evaluation request in the evaluation plan.
      * @tparam TEvalGroup The type of the evaluation group.
@@ -229,6 +375,9 @@ public:
             case EvalPoolEnum::Trival:
                 plan.m_evalPool = &(TrivalEvalPool<TDevice>::Instance());
                 break;
+            case EvalPoolEnum::WorkStealing:
+                plan.m_evalPool = &(WorkStealingEvalPool<TDevice>::Instance());
+                break;
             default:
                 // Assert false if an unsupported evaluation pool type is encountered.
                 assert(false);
@@ -285,6 +434,8 @@ private:
         EvalLayer<TDevice>& curLayer = m_evalLayers.back();
         // If the current layer is empty, do nothing.
         if (curLayer.Empty()) return;
+        // Merge element-wise units before anything of this layer is evaluated.
+        if (GlobalFusion()) curLayer.FuseElementwise();
 
         // Push a new empty evaluation layer onto the list.
         m_evalLayers.push_back(EvalLayer<TDevice>{});
@@ -6,13 +6,16 @@
 /**
  * @brief Enumeration class representing different types of evaluation pools.
  * 
- * This enum class defines the available types of evaluation pools. Currently,
- * only one type, `Trival`, is defined.
+ * This enum class defines the available types of evaluation pools: `Trival`, which
+ * evaluates every unit inline, and `WorkStealing`, which runs independent units on a
+ * persistent set of worker threads.
  */
 enum class EvalPoolEnum
 {
     // Represents a trivial evaluation pool.
-    Trival
+    Trival,
+    // Represents a multi-threaded, work-stealing evaluation pool.
+    WorkStealing
 };
 
 /**
@@ -62,4 +65,12 @@ public:
  * @tparam TDevice The type of the device on which the trivial evaluation pool will operate.
  */
 template <typename TDevice>
-class TrivalEvalPool;
\ No newline at end of file
+class TrivalEvalPool;
+
+/**
+ * @brief Forward declaration of the WorkStealingEvalPool class template.
+ * 
+ * @tparam TDevice The type of the device on which the work-stealing evaluation pool will operate.
+ */
+template <typename TDevice>
+class WorkStealingEvalPool;
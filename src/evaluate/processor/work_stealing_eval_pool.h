@@ -0,0 +1,252 @@
+#pragma once
+
+#include <data/facilities/tags.h>
+#include <evaluate/facilities/eval_pool.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Specialization of WorkStealingEvalPool for CPU
+//
+// Every worker owns a deque of evaluation units. Process() distributes units round-robin over the
+// deques; a worker pops from the back of its own deque and, once that is empty, steals from the front
+// of the others. Barrier() makes the calling thread help with the remaining units and then blocks
+// until every unit it handed to Process() has finished.
+//
+// EvalPlan only calls Barrier() at the end of an EvalCluster, so all units of one cluster (which are
+// independent by construction) are evaluated in parallel.
+//
+// EvalPlan is thread_local while the pool is shared, so the pending count and the first exception are
+// kept per submitting thread: a Barrier() only waits for, and only rethrows from, the caller's units.
+template <>
+class WorkStealingEvalPool<DeviceTags::CPU> : public BaseEvalPool<DeviceTags::CPU> {
+    using UnitPtr = std::shared_ptr<BaseEvalUnit<DeviceTags::CPU>>;
+
+    // State of the units submitted by one thread.
+    struct Submitter {
+        // Units handed to Process() that have not finished yet.
+        std::atomic<size_t> m_pending{0};
+        // First exception thrown by one of them, guarded by m_waitMutex.
+        std::exception_ptr m_error;
+    };
+
+    struct Task {
+        UnitPtr m_unit;
+        std::shared_ptr<Submitter> m_owner;
+    };
+
+    struct Worker {
+        std::mutex m_mutex;
+        std::deque<Task> m_units;
+        std::thread m_thread;
+    };
+
+public:
+    // Singleton instance method for the CPU version of WorkStealingEvalPool
+    static WorkStealingEvalPool& Instance() {
+        static WorkStealingEvalPool inst;
+        return inst;
+    }
+
+    size_t WorkerNum() const {
+        return m_workers.size();
+    }
+
+private:
+    // The thread calling Barrier() also evaluates units, so one hardware thread is left for it.
+    WorkStealingEvalPool()
+        : m_queued(0)
+        , m_nextWorker(0)
+        , m_stop(false) {
+        const size_t hc = std::thread::hardware_concurrency();
+        const size_t workerNum = std::max<size_t>(1, hc > 1 ? hc - 1 : 1);
+        for (size_t i = 0; i < workerNum; ++i) {
+            m_workers.emplace_back(new Worker);
+        }
+        for (size_t i = 0; i < workerNum; ++i) {
+            m_workers[i]->m_thread = std::thread([this, i]() { WorkerLoop(i); });
+        }
+    }
+
+public:
+    ~WorkStealingEvalPool() {
+        {
+            std::lock_guard<std::mutex> guard(m_waitMutex);
+            m_stop = true;
+        }
+        m_workCv.notify_all();
+        for (auto& w : m_workers) {
+            w->m_thread.join();
+        }
+    }
+
+    WorkStealingEvalPool(const WorkStealingEvalPool&) = delete;
+    WorkStealingEvalPool& operator=(const WorkStealingEvalPool&) = delete;
+
+    // Process method for CPU: queue the unit on one of the workers.
+    // A unit processed from inside a running unit (nested evaluation) is evaluated inline instead, since
+    // that thread's own plan will call Barrier() on it right away.
+    void Process(UnitPtr& eu) override {
+        if (CurrentPool() == this) {
+            eu->Eval();
+            return;
+        }
+
+        const auto& owner = CurrentSubmitter();
+        owner->m_pending.fetch_add(1);
+        Worker& w = *m_workers[m_nextWorker.fetch_add(1) % m_workers.size()];
+        {
+            std::lock_guard<std::mutex> guard(w.m_mutex);
+            w.m_units.push_back(Task{eu, owner});
+        }
+        m_queued.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> guard(m_waitMutex);
+        }
+        m_workCv.notify_one();
+    }
+
+    // Barrier method: help evaluate the queued units, then wait until the caller's units are done.
+    // The first exception thrown by one of the caller's units is rethrown here.
+    void Barrier() override {
+        if (CurrentPool() == this) {
+            return;
+        }
+
+        // While the caller helps, it counts as a worker: a unit it runs that evaluates another plan
+        // must do so inline rather than wait on the barrier the caller is already inside.
+        Submitter& owner = *CurrentSubmitter();
+        while (owner.m_pending.load() != 0) {
+            Task task = Steal(0);
+            if (task.m_unit) {
+                CurrentPool() = this;
+                Run(task);
+                CurrentPool() = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            m_doneCv.wait(lock, [&owner]() { return owner.m_pending.load() == 0; });
+        }
+
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> guard(m_waitMutex);
+            std::swap(error, owner.m_error);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    static WorkStealingEvalPool*& CurrentPool() {
+        static thread_local WorkStealingEvalPool* inst = nullptr;
+        return inst;
+    }
+
+    static const std::shared_ptr<Submitter>& CurrentSubmitter() {
+        static thread_local std::shared_ptr<Submitter> inst = std::make_shared<Submitter>();
+        return inst;
+    }
+
+    void WorkerLoop(size_t id) {
+        CurrentPool() = this;
+        while (true) {
+            Task task = PopLocal(id);
+            if (!task.m_unit) {
+                task = Steal(id + 1);
+            }
+            if (task.m_unit) {
+                Run(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            m_workCv.wait(lock, [this]() { return m_stop || m_queued.load() != 0; });
+            if (m_stop && m_queued.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    Task PopLocal(size_t id) {
+        Worker& w = *m_workers[id];
+        std::lock_guard<std::mutex> guard(w.m_mutex);
+        if (w.m_units.empty()) {
+            return Task{};
+        }
+        Task res = std::move(w.m_units.back());
+        w.m_units.pop_back();
+        m_queued.fetch_sub(1);
+        return res;
+    }
+
+    // Scan all deques starting at `start`, taking the oldest unit of the first non-empty one.
+    Task Steal(size_t start) {
+        const size_t num = m_workers.size();
+        for (size_t i = 0; i < num; ++i) {
+            Worker& w = *m_workers[(start + i) % num];
+            std::lock_guard<std::mutex> guard(w.m_mutex);
+            if (!w.m_units.empty()) {
+                Task res = std::move(w.m_units.front());
+                w.m_units.pop_front();
+                m_queued.fetch_sub(1);
+                return res;
+            }
+        }
+        return Task{};
+    }
+
+    void Run(Task& task) {
+        Submitter& owner = *task.m_owner;
+        try {
+            task.m_unit->Eval();
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(m_waitMutex);
+            if (!owner.m_error) {
+                owner.m_error = std::current_exception();
+            }
+        }
+        task.m_unit.reset();
+        if (owner.m_pending.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> guard(m_waitMutex);
+            m_doneCv.notify_all();
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    // Units sitting in a deque, used to park idle workers.
+    std::atomic<size_t> m_queued;
+    std::atomic<size_t> m_nextWorker;
+    bool m_stop;
+    std::mutex m_waitMutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_doneCv;
+};
+
+// Specialization of WorkStealingEvalPool for GPU
+// Device work is already asynchronous, so units are launched inline as in TrivalEvalPool.
+template <>
+class WorkStealingEvalPool<DeviceTags::GPU> : public BaseEvalPool<DeviceTags::GPU> {
+public:
+    static WorkStealingEvalPool& Instance() {
+        static WorkStealingEvalPool inst;
+        return inst;
+    }
+
+private:
+    WorkStealingEvalPool() = default;
+
+public:
+    void Process(std::shared_ptr<BaseEvalUnit<DeviceTags::GPU>>& eu) override {
+        eu->Eval();
+    }
+
+    void Barrier() override {}
+};
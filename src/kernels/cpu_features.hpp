@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define TENSOR_X86_DISPATCH 1
+#else
+#define TENSOR_X86_DISPATCH 0
+#endif
+
+// Instruction-set features of the host CPU, detected once with cpuid. A feature that needs OS support
+// for its registers (AVX, AVX-512) is only reported if XGETBV says the OS saves that state.
+struct CpuFeatures {
+    bool sse42 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool avx512f = false;
+    bool avx512dq = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+    bool avx512vnni = false;
+    bool avx512bf16 = false;
+};
+
+namespace cpu_detail {
+#if TENSOR_X86_DISPATCH
+    inline uint64_t xgetbv0() {
+        uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+    }
+
+    inline CpuFeatures detect() {
+        CpuFeatures f;
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            return f;
+        }
+        f.sse42 = (ecx >> 20) & 1;
+        const bool osxsave = (ecx >> 27) & 1;
+        const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+        const bool os_avx = (xcr0 & 0x6) == 0x6;
+        const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+        f.avx = os_avx && ((ecx >> 28) & 1);
+        f.fma = f.avx && ((ecx >> 12) & 1);
+        f.f16c = f.avx && ((ecx >> 29) & 1);
+
+        if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+            f.avx2 = f.avx && ((ebx >> 5) & 1);
+            f.avx512f = os_avx512 && ((ebx >> 16) & 1);
+            f.avx512dq = f.avx512f && ((ebx >> 17) & 1);
+            f.avx512bw = f.avx512f && ((ebx >> 30) & 1);
+            f.avx512vl = f.avx512f && ((ebx >> 31) & 1);
+            f.avx512vnni = f.avx512f && ((ecx >> 11) & 1);
+        }
+        if (f.avx512f && __get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)) {
+            f.avx512bf16 = (eax >> 5) & 1;
+        }
+        return f;
+    }
+#else
+    inline CpuFeatures detect() { return CpuFeatures(); }
+#endif
+}
+
+inline const CpuFeatures& cpu_features() {
+    static const CpuFeatures features = cpu_detail::detect();
+    return features;
+}
+
+// Kernel variants, from least to most capable.
+enum class SimdLevel {
+    Scalar = 0,
+    SSE42 = 1,
+    AVX2 = 2,   // AVX2 + FMA
+    AVX512 = 3  // AVX-512 F/DQ/BW/VL
+};
+
+inline const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE42: return "sse4.2";
+    case SimdLevel::AVX2: return "avx2";
+    case SimdLevel::AVX512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+// Best level the host supports.
+inline SimdLevel detected_simd_level() {
+    const CpuFeatures& f = cpu_features();
+    if (f.avx512f && f.avx512dq && f.avx512bw && f.avx512vl && f.avx2 && f.fma) {
+        return SimdLevel::AVX512;
+    }
+    if (f.avx2 && f.fma) {
+        return SimdLevel::AVX2;
+    }
+    if (f.sse42) {
+        return SimdLevel::SSE42;
+    }
+    return SimdLevel::Scalar;
+}
+
+// Level used by default: the detected one, optionally capped by the TENSOR_SIMD environment variable
+// (scalar, sse4.2, avx2 or avx512). Read once.
+inline SimdLevel simd_level() {
+    static const SimdLevel level = []() {
+        SimdLevel best = detected_simd_level();
+        const char* env = std::getenv("TENSOR_SIMD");
+        if (!env) {
+            return best;
+        }
+        for (int l = static_cast<int>(SimdLevel::Scalar); l <= static_cast<int>(SimdLevel::AVX512); ++l) {
+            if (std::strcmp(env, simd_level_name(static_cast<SimdLevel>(l))) == 0) {
+                return static_cast<int>(best) < l ? best : static_cast<SimdLevel>(l);
+            }
+        }
+        return best;
+    }();
+    return level;
+}
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "cpu_features.hpp"
+#include "half.hpp"
+
+#if TENSOR_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// Blocked GEMM shared by Tensor::matmul and the Dot operator.
+//
+// Computes C = A * B where A is m x k, B is k x n and C is m x n (row major, leading dimension ldc).
+// A and B are described by a row stride and a column stride, so transposed or sliced operands can be
+// passed without materialising them first.
+//
+// The loop structure follows the usual Goto/BLIS scheme:
+//   jc (NC columns of B, sized for L3) -> pc (KC depth, sized so a packed B panel stays in L2/L3)
+//   -> ic (MC rows of A, sized for L2) -> jr / ir (NR x MR register tile, one micro-kernel call).
+// A and B blocks are packed into contiguous MR-row / NR-column panels so the micro-kernel only ever
+// streams unit-stride memory.
+//
+// float16 and bfloat16 operands are widened to float while they are packed, multiplied with the float
+// micro-kernel and accumulated in float over the whole depth, one MC x NC block of C at a time; each block
+// is rounded to 16 bits once, when it is complete.
+//
+// The float and double micro-kernels have an AVX2/FMA variant compiled with `#pragma GCC target`, so
+// the binary needs no -mavx2; gemm_kernel() picks it at run time from simd_level().
+
+template <typename T>
+struct GemmBlocking
+{
+    static constexpr size_t MR = 4;
+    static constexpr size_t NR = 4;
+    static constexpr size_t MC = 128;
+    static constexpr size_t KC = 256;
+    static constexpr size_t NC = 2048;
+};
+
+template <>
+struct GemmBlocking<float>
+{
+    static constexpr size_t MR = 6;
+    static constexpr size_t NR = 16;
+    static constexpr size_t MC = 144;
+    static constexpr size_t KC = 256;
+    static constexpr size_t NC = 4096;
+};
+
+template <>
+struct GemmBlocking<double>
+{
+    static constexpr size_t MR = 6;
+    static constexpr size_t NR = 8;
+    static constexpr size_t MC = 96;
+    static constexpr size_t KC = 256;
+    static constexpr size_t NC = 2048;
+};
+
+namespace gemm_detail
+{
+    // Packs an mc x kc block of A into panels of MR rows. Inside a panel the MR values of one
+    // column are adjacent; rows past mc are zero filled so the micro-kernel never branches.
+    // TSrc differs from T only for 16-bit operands, which are widened on the way.
+    template <typename T, typename TSrc>
+    void pack_a(size_t mc, size_t kc, const TSrc* a, size_t rsa, size_t csa, T* buf)
+    {
+        constexpr size_t MR = GemmBlocking<T>::MR;
+        for (size_t i = 0; i < mc; i += MR) {
+            const size_t mr = std::min(MR, mc - i);
+            for (size_t p = 0; p < kc; ++p) {
+                const TSrc* src = a + i * rsa + p * csa;
+                size_t r = 0;
+                for (; r < mr; ++r) {
+                    buf[r] = static_cast<T>(src[r * rsa]);
+                }
+                for (; r < MR; ++r) {
+                    buf[r] = T();
+                }
+                buf += MR;
+            }
+        }
+    }
+
+    // Packs a kc x nc block of B into panels of NR columns, zero filling past nc. Rows of a
+    // 16-bit B with unit column stride go through the bulk converter.
+    template <typename T, typename TSrc>
+    void pack_b(size_t kc, size_t nc, const TSrc* b, size_t rsb, size_t csb, T* buf)
+    {
+        constexpr size_t NR = GemmBlocking<T>::NR;
+        for (size_t j = 0; j < nc; j += NR) {
+            const size_t nr = std::min(NR, nc - j);
+            for (size_t p = 0; p < kc; ++p) {
+                const TSrc* src = b + p * rsb + j * csb;
+                size_t c = 0;
+                if (csb == 1) {
+                    if constexpr (is_half_float_v<TSrc>) {
+                        convert_half(src, buf, nr);
+                        c = nr;
+                    } else {
+                        for (; c < nr; ++c) {
+                            buf[c] = src[c];
+                        }
+                    }
+                } else {
+                    for (; c < nr; ++c) {
+                        buf[c] = static_cast<T>(src[c * csb]);
+                    }
+                }
+                for (; c < NR; ++c) {
+                    buf[c] = T();
+                }
+                buf += NR;
+            }
+        }
+    }
+
+    // Writes an MR x NR accumulator tile into C, clipped to mr x nr. The first depth block
+    // overwrites C, later ones accumulate into it.
+    template <typename T>
+    void store_tile(const T* acc, size_t mr, size_t nr, T* c, size_t ldc, bool accumulate)
+    {
+        constexpr size_t NR = GemmBlocking<T>::NR;
+        for (size_t i = 0; i < mr; ++i) {
+            for (size_t j = 0; j < nr; ++j) {
+                c[i * ldc + j] = accumulate ? c[i * ldc + j] + acc[i * NR + j] : acc[i * NR + j];
+            }
+        }
+    }
+
+    // Multiplies an MR-row panel of A by an NR-column panel of B over kc and stores the tile with
+    // store_tile() semantics.
+    template <typename T>
+    using MicroKernel = void (*)(size_t kc, const T* pa, const T* pb, T* c, size_t ldc,
+                                 size_t mr, size_t nr, bool accumulate);
+
+    // Portable micro-kernel. The fixed-size accumulator lets the compiler keep it in registers
+    // and vectorise the inner NR loop for whatever instruction set the build targets.
+    template <typename T>
+    void micro_kernel(size_t kc, const T* pa, const T* pb, T* c, size_t ldc,
+                      size_t mr, size_t nr, bool accumulate)
+    {
+        constexpr size_t MR = GemmBlocking<T>::MR;
+        constexpr size_t NR = GemmBlocking<T>::NR;
+        T acc[MR * NR] = {};
+        for (size_t p = 0; p < kc; ++p) {
+            for (size_t i = 0; i < MR; ++i) {
+                const T av = pa[i];
+                for (size_t j = 0; j < NR; ++j) {
+                    acc[i * NR + j] += av * pb[j];
+                }
+            }
+            pa += MR;
+            pb += NR;
+        }
+        store_tile(acc, mr, nr, c, ldc, accumulate);
+    }
+}
+
+#if TENSOR_X86_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace gemm_avx2
+{
+    using gemm_detail::store_tile;
+
+    // 6x16 single precision tile: 12 ymm accumulators, 2 loads of B and 6 broadcasts of A per step.
+    inline void micro_kernel(size_t kc, const float* pa, const float* pb, float* c, size_t ldc,
+                             size_t mr, size_t nr, bool accumulate)
+    {
+        __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+        __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+        __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+        __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+        __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+        __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+        for (size_t p = 0; p < kc; ++p) {
+            const __m256 b0 = _mm256_loadu_ps(pb);
+            const __m256 b1 = _mm256_loadu_ps(pb + 8);
+            __m256 a = _mm256_broadcast_ss(pa);
+            c00 = _mm256_fmadd_ps(a, b0, c00); c01 = _mm256_fmadd_ps(a, b1, c01);
+            a = _mm256_broadcast_ss(pa + 1);
+            c10 = _mm256_fmadd_ps(a, b0, c10); c11 = _mm256_fmadd_ps(a, b1, c11);
+            a = _mm256_broadcast_ss(pa + 2);
+            c20 = _mm256_fmadd_ps(a, b0, c20); c21 = _mm256_fmadd_ps(a, b1, c21);
+            a = _mm256_broadcast_ss(pa + 3);
+            c30 = _mm256_fmadd_ps(a, b0, c30); c31 = _mm256_fmadd_ps(a, b1, c31);
+            a = _mm256_broadcast_ss(pa + 4);
+            c40 = _mm256_fmadd_ps(a, b0, c40); c41 = _mm256_fmadd_ps(a, b1, c41);
+            a = _mm256_broadcast_ss(pa + 5);
+            c50 = _mm256_fmadd_ps(a, b0, c50); c51 = _mm256_fmadd_ps(a, b1, c51);
+            pa += 6;
+            pb += 16;
+        }
+
+        const __m256 rows[6][2] = {{c00, c01}, {c10, c11}, {c20, c21},
+                                   {c30, c31}, {c40, c41}, {c50, c51}};
+        if (mr == 6 && nr == 16) {
+            for (size_t i = 0; i < 6; ++i) {
+                float* dst = c + i * ldc;
+                __m256 lo = rows[i][0];
+                __m256 hi = rows[i][1];
+                if (accumulate) {
+                    lo = _mm256_add_ps(lo, _mm256_loadu_ps(dst));
+                    hi = _mm256_add_ps(hi, _mm256_loadu_ps(dst + 8));
+                }
+                _mm256_storeu_ps(dst, lo);
+                _mm256_storeu_ps(dst + 8, hi);
+            }
+            return;
+        }
+
+        alignas(32) float acc[6 * 16];
+        for (size_t i = 0; i < 6; ++i) {
+            _mm256_store_ps(acc + i * 16, rows[i][0]);
+            _mm256_store_ps(acc + i * 16 + 8, rows[i][1]);
+        }
+        store_tile(acc, mr, nr, c, ldc, accumulate);
+    }
+
+    // 6x8 double precision tile: same register budget as the float kernel.
+    inline void micro_kernel(size_t kc, const double* pa, const double* pb, double* c, size_t ldc,
+                             size_t mr, size_t nr, bool accumulate)
+    {
+        __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+        __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+        __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+        __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+        __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+        __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+
+        for (size_t p = 0; p < kc; ++p) {
+            const __m256d b0 = _mm256_loadu_pd(pb);
+            const __m256d b1 = _mm256_loadu_pd(pb + 4);
+            __m256d a = _mm256_broadcast_sd(pa);
+            c00 = _mm256_fmadd_pd(a, b0, c00); c01 = _mm256_fmadd_pd(a, b1, c01);
+            a = _mm256_broadcast_sd(pa + 1);
+            c10 = _mm256_fmadd_pd(a, b0, c10); c11 = _mm256_fmadd_pd(a, b1, c11);
+            a = _mm256_broadcast_sd(pa + 2);
+            c20 = _mm256_fmadd_pd(a, b0, c20); c21 = _mm256_fmadd_pd(a, b1, c21);
+            a = _mm256_broadcast_sd(pa + 3);
+            c30 = _mm256_fmadd_pd(a, b0, c30); c31 = _mm256_fmadd_pd(a, b1, c31);
+            a = _mm256_broadcast_sd(pa + 4);
+            c40 = _mm256_fmadd_pd(a, b0, c40); c41 = _mm256_fmadd_pd(a, b1, c41);
+            a = _mm256_broadcast_sd(pa + 5);
+            c50 = _mm256_fmadd_pd(a, b0, c50); c51 = _mm256_fmadd_pd(a, b1, c51);
+            pa += 6;
+            pb += 8;
+        }
+
+        const __m256d rows[6][2] = {{c00, c01}, {c10, c11}, {c20, c21},
+                                    {c30, c31}, {c40, c41}, {c50, c51}};
+        if (mr == 6 && nr == 8) {
+            for (size_t i = 0; i < 6; ++i) {
+                double* dst = c + i * ldc;
+                __m256d lo = rows[i][0];
+                __m256d hi = rows[i][1];
+                if (accumulate) {
+                    lo = _mm256_add_pd(lo, _mm256_loadu_pd(dst));
+                    hi = _mm256_add_pd(hi, _mm256_loadu_pd(dst + 4));
+                }
+                _mm256_storeu_pd(dst, lo);
+                _mm256_storeu_pd(dst + 4, hi);
+            }
+            return;
+        }
+
+        alignas(32) double acc[6 * 8];
+        for (size_t i = 0; i < 6; ++i) {
+            _mm256_store_pd(acc + i * 8, rows[i][0]);
+            _mm256_store_pd(acc + i * 8 + 4, rows[i][1]);
+        }
+        store_tile(acc, mr, nr, c, ldc, accumulate);
+    }
+}
+#pragma GCC pop_options
+#endif // TENSOR_X86_DISPATCH
+
+// A micro-kernel for T and the level it was written for.
+template <typename T>
+struct GemmKernel
+{
+    SimdLevel level;
+    const char* name;
+    gemm_detail::MicroKernel<T> kernel;
+};
+
+// Kernel for `level`, or the portable one if the host (or `level`) is below AVX2 or T has no
+// hand-written kernel.
+template <typename T>
+const GemmKernel<T>& gemm_kernel(SimdLevel level)
+{
+    static const GemmKernel<T> portable{SimdLevel::Scalar, "portable", gemm_detail::micro_kernel<T>};
+#if TENSOR_X86_DISPATCH
+    if constexpr (std::is_same<T, float>::value || std::is_same<T, double>::value) {
+        static const GemmKernel<T> avx2{SimdLevel::AVX2, "avx2-fma",
+                                        static_cast<gemm_detail::MicroKernel<T>>(gemm_avx2::micro_kernel)};
+        return std::min(level, detected_simd_level()) >= SimdLevel::AVX2 ? avx2 : portable;
+    }
+#endif
+    (void)level;
+    return portable;
+}
+
+// Kernel for the active level (see simd_level()).
+template <typename T>
+const GemmKernel<T>& gemm_kernel()
+{
+    static const GemmKernel<T>& active = gemm_kernel<T>(simd_level());
+    return active;
+}
+
+namespace gemm_detail
+{
+    // Packing scratch is reused across calls; one set per thread so concurrent EvalUnits never share it.
+    template <typename T>
+    T* scratch_a()
+    {
+        static thread_local std::vector<T> buf(GemmBlocking<T>::MC * GemmBlocking<T>::KC);
+        return buf.data();
+    }
+
+    template <typename T>
+    T* scratch_b()
+    {
+        static thread_local std::vector<T> buf(GemmBlocking<T>::KC * GemmBlocking<T>::NC);
+        return buf.data();
+    }
+
+    // MC x NC accumulator for one block of a 16-bit C.
+    template <typename T>
+    T* scratch_c()
+    {
+        static thread_local std::vector<T> buf(GemmBlocking<T>::MC * GemmBlocking<T>::NC);
+        return buf.data();
+    }
+}
+
+namespace gemm_detail
+{
+    // The blocked loop nest. T is the type the kernel computes and accumulates in; the operands may be
+    // stored in a narrower type (see pack_a / pack_b).
+    template <typename T, typename TA, typename TB>
+    void gemm_blocked(size_t m, size_t n, size_t k,
+                      const TA* a, size_t rsa, size_t csa,
+                      const TB* b, size_t rsb, size_t csb,
+                      T* c, size_t ldc, MicroKernel<T> kernel)
+    {
+        using Blk = GemmBlocking<T>;
+
+        T* pa = scratch_a<T>();
+        T* pb = scratch_b<T>();
+
+        for (size_t jc = 0; jc < n; jc += Blk::NC) {
+            const size_t nc = std::min(Blk::NC, n - jc);
+            for (size_t pc = 0; pc < k; pc += Blk::KC) {
+                const size_t kc = std::min(Blk::KC, k - pc);
+                const bool accumulate = pc != 0;
+                pack_b(kc, nc, b + pc * rsb + jc * csb, rsb, csb, pb);
+
+                for (size_t ic = 0; ic < m; ic += Blk::MC) {
+                    const size_t mc = std::min(Blk::MC, m - ic);
+                    pack_a(mc, kc, a + ic * rsa + pc * csa, rsa, csa, pa);
+
+                    for (size_t jr = 0; jr < nc; jr += Blk::NR) {
+                        const size_t nr = std::min(Blk::NR, nc - jr);
+                        for (size_t ir = 0; ir < mc; ir += Blk::MR) {
+                            const size_t mr = std::min(Blk::MR, mc - ir);
+                            kernel(kc, pa + ir * kc, pb + jr * kc,
+                                   c + (ic + ir) * ldc + jc + jr, ldc,
+                                   mr, nr, accumulate);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void gemm(size_t m, size_t n, size_t k,
+          const T* a, size_t rsa, size_t csa,
+          const T* b, size_t rsb, size_t csb,
+          T* c, size_t ldc,
+          const GemmKernel<accum_t<T>>& kernel = gemm_kernel<accum_t<T>>())
+{
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (k == 0) {
+        for (size_t i = 0; i < m; ++i) {
+            std::fill(c + i * ldc, c + i * ldc + n, T());
+        }
+        return;
+    }
+
+    if constexpr (is_half_float_v<T>) {
+        // Accumulating every depth block straight into a 16-bit C would round after each KC step, so
+        // each MC x NC block of C is accumulated over the whole depth in float and then rounded.
+        using Blk = GemmBlocking<float>;
+        float* acc = gemm_detail::scratch_c<float>();
+        for (size_t ic = 0; ic < m; ic += Blk::MC) {
+            const size_t mc = std::min(Blk::MC, m - ic);
+            for (size_t jc = 0; jc < n; jc += Blk::NC) {
+                const size_t nc = std::min(Blk::NC, n - jc);
+                gemm_detail::gemm_blocked(mc, nc, k, a + ic * rsa, rsa, csa, b + jc * csb, rsb, csb,
+                                          acc, nc, kernel.kernel);
+                for (size_t i = 0; i < mc; ++i) {
+                    convert_half(acc + i * nc, c + (ic + i) * ldc + jc, nc);
+                }
+            }
+        }
+    } else {
+        gemm_detail::gemm_blocked(m, n, k, a, rsa, csa, b, rsb, csb, c, ldc, kernel.kernel);
+    }
+}
+
+// Convenience overload for dense row-major operands with leading dimensions lda / ldb.
+template <typename T>
+void gemm(size_t m, size_t n, size_t k,
+          const T* a, size_t lda,
+          const T* b, size_t ldb,
+          T* c, size_t ldc)
+{
+    gemm(m, n, k, a, lda, 1, b, ldb, 1, c, ldc);
+}
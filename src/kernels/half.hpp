@@ -0,0 +1,379 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "cpu_features.hpp"
+
+#if TENSOR_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// 16-bit floating point storage types: IEEE 754 binary16 (float16) and bfloat16 (the upper half of a
+// float). They only store values; arithmetic on them happens in float, through the implicit conversion,
+// and the result is rounded back (to nearest, ties to even) when it is assigned to a 16-bit value.
+//
+// Bulk conversion (convert_half) is dispatched at run time like the SIMD kernel registry: F16C or
+// AVX-512 for float16, AVX2 or AVX-512 integer rounding for bfloat16, and a scalar fallback that gives
+// bit-identical results. Kernels that work on 16-bit data (GEMM, AdvancedTensor's element-wise,
+// reduction and activation ops, MetaNN's activations) widen blocks to float, run the float kernel and
+// accumulate in float; accum_t<T> names that accumulation type.
+
+namespace half_detail {
+    inline uint32_t float_bits(float f) {
+        uint32_t x;
+        std::memcpy(&x, &f, sizeof(x));
+        return x;
+    }
+
+    inline float bits_float(uint32_t x) {
+        float f;
+        std::memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+
+    inline uint16_t float_to_half_bits(float f) {
+#if defined(__F16C__)
+        return static_cast<uint16_t>(_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT));
+#else
+        uint32_t x = float_bits(f);
+        const uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+        x &= 0x7fffffff;
+        if (x >= 0x7f800000) {  // inf stays inf, NaN stays a (quiet) NaN
+            return sign | 0x7c00 | (x > 0x7f800000 ? 0x200 | ((x >> 13) & 0x3ff) : 0);
+        }
+        if (x >= 0x477ff000) {  // rounds past 65504
+            return sign | 0x7c00;
+        }
+        if (x < 0x38800000) {
+            // Subnormal or zero: adding 0.5 lines the half subnormal ulp (2^-24) up with the float ulp
+            // at 0.5, so the float addition does the rounding.
+            const float v = bits_float(x) + 0.5f;
+            return sign | static_cast<uint16_t>(float_bits(v) - 0x3f000000);
+        }
+        // Normal: rebias the exponent (127 -> 15) and round the 13 dropped mantissa bits to even.
+        x += 0xc8000fff + ((x >> 13) & 1);
+        return sign | static_cast<uint16_t>(x >> 13);
+#endif
+    }
+
+    inline float half_bits_to_float(uint16_t h) {
+#if defined(__F16C__)
+        return _cvtsh_ss(h);
+#else
+        const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+        const uint32_t em = h & 0x7fff;
+        if (em >= 0x7c00) {  // a NaN comes back quiet, as with F16C
+            return bits_float(sign | 0x7f800000 | (em > 0x7c00 ? 0x400000 : 0) | ((em & 0x3ff) << 13));
+        }
+        if (em >= 0x400) {
+            return bits_float(sign | ((em << 13) + 0x38000000));
+        }
+        const float mag = static_cast<float>(em) * 5.9604644775390625e-8f;  // em * 2^-24
+        return bits_float(sign | float_bits(mag));
+#endif
+    }
+
+    inline uint16_t float_to_bfloat16_bits(float f) {
+        const uint32_t x = float_bits(f);
+        if ((x & 0x7fffffff) > 0x7f800000) {
+            return static_cast<uint16_t>((x >> 16) | 0x40);
+        }
+        return static_cast<uint16_t>((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+    }
+
+    inline float bfloat16_bits_to_float(uint16_t h) {
+        return bits_float(static_cast<uint32_t>(h) << 16);
+    }
+}
+
+struct float16 {
+    uint16_t bits;
+
+    float16() = default;
+    float16(float f) : bits(half_detail::float_to_half_bits(f)) {}
+    operator float() const { return half_detail::half_bits_to_float(bits); }
+
+    static float16 from_bits(uint16_t b) {
+        float16 h;
+        h.bits = b;
+        return h;
+    }
+
+    // Exact, so it stays in 16 bits.
+    float16 operator-() const { return from_bits(bits ^ 0x8000); }
+
+    float16& operator+=(float x) { return *this = float(*this) + x; }
+    float16& operator-=(float x) { return *this = float(*this) - x; }
+    float16& operator*=(float x) { return *this = float(*this) * x; }
+    float16& operator/=(float x) { return *this = float(*this) / x; }
+};
+
+struct bfloat16 {
+    uint16_t bits;
+
+    bfloat16() = default;
+    bfloat16(float f) : bits(half_detail::float_to_bfloat16_bits(f)) {}
+    operator float() const { return half_detail::bfloat16_bits_to_float(bits); }
+
+    static bfloat16 from_bits(uint16_t b) {
+        bfloat16 h;
+        h.bits = b;
+        return h;
+    }
+
+    // Exact, so it stays in 16 bits.
+    bfloat16 operator-() const { return from_bits(bits ^ 0x8000); }
+
+    bfloat16& operator+=(float x) { return *this = float(*this) + x; }
+    bfloat16& operator-=(float x) { return *this = float(*this) - x; }
+    bfloat16& operator*=(float x) { return *this = float(*this) * x; }
+    bfloat16& operator/=(float x) { return *this = float(*this) / x; }
+};
+
+static_assert(sizeof(float16) == 2 && std::is_trivially_copyable<float16>::value, "float16 must be 2 bytes");
+static_assert(sizeof(bfloat16) == 2 && std::is_trivially_copyable<bfloat16>::value, "bfloat16 must be 2 bytes");
+
+// True for the 16-bit storage types.
+template <typename T>
+constexpr bool is_half_float_v = std::is_same<T, float16>::value || std::is_same<T, bfloat16>::value;
+
+// Type kernels accumulate T in: float for the 16-bit types, T itself otherwise.
+template <typename T>
+using accum_t = std::conditional_t<is_half_float_v<T>, float, T>;
+
+// Bulk conversion routines for one instruction set.
+struct HalfConverters {
+    SimdLevel level;
+    void (*f16_to_f32)(const float16*, float*, size_t);
+    void (*f32_to_f16)(const float*, float16*, size_t);
+    void (*bf16_to_f32)(const bfloat16*, float*, size_t);
+    void (*f32_to_bf16)(const float*, bfloat16*, size_t);
+};
+
+namespace half_scalar {
+    inline void f16_to_f32(const float16* src, float* dst, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            dst[i] = half_detail::half_bits_to_float(src[i].bits);
+        }
+    }
+
+    inline void f32_to_f16(const float* src, float16* dst, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            dst[i].bits = half_detail::float_to_half_bits(src[i]);
+        }
+    }
+
+    inline void bf16_to_f32(const bfloat16* src, float* dst, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            dst[i] = half_detail::bfloat16_bits_to_float(src[i].bits);
+        }
+    }
+
+    inline void f32_to_bf16(const float* src, bfloat16* dst, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            dst[i].bits = half_detail::float_to_bfloat16_bits(src[i]);
+        }
+    }
+}
+
+#if TENSOR_X86_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx2,fma,f16c")
+namespace half_avx2 {
+    inline void f16_to_f32(const float16* src, float* dst, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+        }
+        half_scalar::f16_to_f32(src + i, dst + i, n - i);
+    }
+
+    inline void f32_to_f16(const float* src, float16* dst, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+        }
+        half_scalar::f32_to_f16(src + i, dst + i, n - i);
+    }
+
+    inline void bf16_to_f32(const bfloat16* src, float* dst, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                                _mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+        }
+        half_scalar::bf16_to_f32(src + i, dst + i, n - i);
+    }
+
+    // Same rounding as float_to_bfloat16_bits, eight lanes at a time.
+    inline void f32_to_bf16(const float* src, bfloat16* dst, size_t n) {
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i bias = _mm256_set1_epi32(0x7fff);
+        const __m256i quiet = _mm256_set1_epi32(0x40);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m256 v = _mm256_loadu_ps(src + i);
+            const __m256i x = _mm256_castps_si256(v);
+            const __m256i hi = _mm256_srli_epi32(x, 16);
+            const __m256i lsb = _mm256_and_si256(hi, one);
+            __m256i r = _mm256_srli_epi32(_mm256_add_epi32(x, _mm256_add_epi32(bias, lsb)), 16);
+            const __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+            r = _mm256_blendv_epi8(r, _mm256_or_si256(hi, quiet), nan);
+            // Every lane is below 0x10000, so the saturating pack is exact; it works per 128-bit half,
+            // and the permute gathers the two halves.
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(r, r), 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_castsi256_si128(packed));
+        }
+        half_scalar::f32_to_bf16(src + i, dst + i, n - i);
+    }
+}
+#pragma GCC pop_options
+
+// See simd_kernels.hpp: GCC's AVX-512 intrinsics trip -Wmaybe-uninitialized once inlined.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512bw,avx512vl,avx2,fma,f16c")
+namespace half_avx512 {
+    inline void f16_to_f32(const float16* src, float* dst, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(h));
+        }
+        half_scalar::f16_to_f32(src + i, dst + i, n - i);
+    }
+
+    inline void f32_to_f16(const float* src, float16* dst, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), h);
+        }
+        half_scalar::f32_to_f16(src + i, dst + i, n - i);
+    }
+
+    inline void bf16_to_f32(const bfloat16* src, float* dst, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            _mm512_storeu_si512(dst + i, _mm512_slli_epi32(_mm512_cvtepu16_epi32(h), 16));
+        }
+        half_scalar::bf16_to_f32(src + i, dst + i, n - i);
+    }
+
+    inline void f32_to_bf16(const float* src, bfloat16* dst, size_t n) {
+        const __m512i one = _mm512_set1_epi32(1);
+        const __m512i bias = _mm512_set1_epi32(0x7fff);
+        const __m512i quiet = _mm512_set1_epi32(0x40);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            const __m512 v = _mm512_loadu_ps(src + i);
+            const __m512i x = _mm512_castps_si512(v);
+            const __m512i hi = _mm512_srli_epi32(x, 16);
+            const __m512i lsb = _mm512_and_si512(hi, one);
+            __m512i r = _mm512_srli_epi32(_mm512_add_epi32(x, _mm512_add_epi32(bias, lsb)), 16);
+            const __mmask16 nan = _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q);
+            r = _mm512_mask_blend_epi32(nan, r, _mm512_or_si512(hi, quiet));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm512_cvtepi32_epi16(r));
+        }
+        half_scalar::f32_to_bf16(src + i, dst + i, n - i);
+    }
+}
+#pragma GCC pop_options
+#pragma GCC diagnostic pop
+#endif // TENSOR_X86_DISPATCH
+
+// Converters for `level`, or for the best level below it that the host supports. There is no SSE4.2
+// variant; that level uses the scalar routines.
+inline const HalfConverters& half_converters(SimdLevel level) {
+    static const HalfConverters scalar{SimdLevel::Scalar, half_scalar::f16_to_f32, half_scalar::f32_to_f16,
+                                       half_scalar::bf16_to_f32, half_scalar::f32_to_bf16};
+#if TENSOR_X86_DISPATCH
+    static const HalfConverters avx2{SimdLevel::AVX2, half_avx2::f16_to_f32, half_avx2::f32_to_f16,
+                                     half_avx2::bf16_to_f32, half_avx2::f32_to_bf16};
+    static const HalfConverters avx512{SimdLevel::AVX512, half_avx512::f16_to_f32, half_avx512::f32_to_f16,
+                                       half_avx512::bf16_to_f32, half_avx512::f32_to_bf16};
+    const SimdLevel use = std::min(level, detected_simd_level());
+    if (!cpu_features().f16c || use < SimdLevel::AVX2) {
+        return scalar;
+    }
+    return use == SimdLevel::AVX512 ? avx512 : avx2;
+#else
+    (void)level;
+    return scalar;
+#endif
+}
+
+// Converters for the active level (see simd_level()).
+inline const HalfConverters& half_converters() {
+    static const HalfConverters& active = half_converters(simd_level());
+    return active;
+}
+
+// n values from src to dst; the buffers must not overlap.
+inline void convert_half(const float16* src, float* dst, size_t n) { half_converters().f16_to_f32(src, dst, n); }
+inline void convert_half(const float* src, float16* dst, size_t n) { half_converters().f32_to_f16(src, dst, n); }
+inline void convert_half(const bfloat16* src, float* dst, size_t n) { half_converters().bf16_to_f32(src, dst, n); }
+inline void convert_half(const float* src, bfloat16* dst, size_t n) { half_converters().f32_to_bf16(src, dst, n); }
+
+namespace half_detail {
+    // Elements widened per step by the block helpers below; two blocks of floats stay on the stack.
+    constexpr size_t kBlock = 512;
+}
+
+// out = fn(a) over n 16-bit values, with fn(const float* in, float* out, size_t len) running on float
+// blocks. out may alias a.
+template <typename H, typename F>
+void map_as_float(const H* a, H* out, size_t n, F&& fn) {
+    float buf[half_detail::kBlock];
+    for (size_t i = 0; i < n; i += half_detail::kBlock) {
+        const size_t len = std::min(half_detail::kBlock, n - i);
+        convert_half(a + i, buf, len);
+        fn(buf, buf, len);
+        convert_half(buf, out + i, len);
+    }
+}
+
+// out = fn(a, b) with fn(const float*, const float*, float* out, size_t len). out may alias a or b.
+template <typename H, typename F>
+void map_as_float(const H* a, const H* b, H* out, size_t n, F&& fn) {
+    float fa[half_detail::kBlock], fb[half_detail::kBlock];
+    for (size_t i = 0; i < n; i += half_detail::kBlock) {
+        const size_t len = std::min(half_detail::kBlock, n - i);
+        convert_half(a + i, fa, len);
+        convert_half(b + i, fb, len);
+        fn(fa, fb, fa, len);
+        convert_half(fa, out + i, len);
+    }
+}
+
+// Calls fn(const float* block, size_t len) for consecutive widened blocks of a, e.g. to reduce them.
+template <typename H, typename F>
+void for_each_float_block(const H* a, size_t n, F&& fn) {
+    float buf[half_detail::kBlock];
+    for (size_t i = 0; i < n; i += half_detail::kBlock) {
+        const size_t len = std::min(half_detail::kBlock, n - i);
+        convert_half(a + i, buf, len);
+        fn(static_cast<const float*>(buf), len);
+    }
+}
+
+// Two-operand form: fn(const float* a_block, const float* b_block, size_t len).
+template <typename H, typename F>
+void for_each_float_block(const H* a, const H* b, size_t n, F&& fn) {
+    float fa[half_detail::kBlock], fb[half_detail::kBlock];
+    for (size_t i = 0; i < n; i += half_detail::kBlock) {
+        const size_t len = std::min(half_detail::kBlock, n - i);
+        convert_half(a + i, fa, len);
+        convert_half(b + i, fb, len);
+        fn(static_cast<const float*>(fa), static_cast<const float*>(fb), len);
+    }
+}
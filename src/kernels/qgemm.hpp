@@ -0,0 +1,400 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "cpu_features.hpp"
+#include "quantize.hpp"
+
+#if TENSOR_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// INT8 GEMM shared by QuantizedTensor::matmul and the Dot operator on a QuantizedMatrix.
+//
+// Computes C = A * B for row-major int8 A (m x k, one scale and zero point) and B (k x n, one scale and
+// zero point per column or for all of B). The loop nest is the blocked one of gemm.hpp. Panels are
+// packed in groups of four along k: A is shifted to unsigned (a + 128) so the micro-kernel can use
+// u8 x s8 dot products, and the shift and both zero points are removed afterwards with the row sums of
+// A and column sums of B gathered while packing. Accumulation is exact in int32 for k < 65536.
+//
+// Micro-kernels are chosen at run time: AVX-512 VNNI (vpdpbusd), AVX2, or scalar. The AVX2 kernel
+// splits bytes into 16-bit halves and uses vpmaddwd rather than the saturating vpmaddubsw, so every
+// level gives identical results.
+
+// Scale and zero point of each column of B (output channel), or one pair for all of B.
+struct QuantChannels {
+    const float* scales;
+    const int32_t* zero_points;
+    bool per_channel;
+
+    QuantScale operator[](size_t j) const {
+        const size_t i = per_channel ? j : 0;
+        return {scales[i], zero_points[i]};
+    }
+};
+
+namespace qgemm_detail {
+    constexpr size_t NR = 16;
+    constexpr size_t MC = 96;    // a multiple of every MR
+    constexpr size_t KC = 256;   // a multiple of 4
+    constexpr size_t NC = 4096;
+
+    // Accumulates (or, if !accumulate, stores) the mr x nr corner of an int32 tile with rows of NR
+    // into C.
+    inline void store_tile(const int32_t* acc, size_t mr, size_t nr, int32_t* c, size_t ldc, bool accumulate) {
+        for (size_t i = 0; i < mr; ++i) {
+            for (size_t j = 0; j < nr; ++j) {
+                c[i * ldc + j] = accumulate ? c[i * ldc + j] + acc[i * NR + j] : acc[i * NR + j];
+            }
+        }
+    }
+
+    // Packs an mc x kc block of A into panels of MR rows: per group of four columns, the four bytes
+    // of each row are adjacent, shifted to unsigned. Rows past mc and columns past kc are zero.
+    // row_sums, if given, accumulates the signed sum of each row.
+    inline void pack_a(size_t mc, size_t kc, const int8_t* a, size_t lda, size_t MR, uint8_t* buf,
+                       int32_t* row_sums) {
+        const size_t kq = (kc + 3) / 4;
+        for (size_t i = 0; i < mc; i += MR) {
+            const size_t mr = std::min(MR, mc - i);
+            for (size_t q = 0; q < kq; ++q) {
+                for (size_t r = 0; r < MR; ++r) {
+                    for (size_t t = 0; t < 4; ++t) {
+                        const size_t p = q * 4 + t;
+                        if (r < mr && p < kc) {
+                            const int8_t v = a[(i + r) * lda + p];
+                            *buf++ = static_cast<uint8_t>(v + 128);
+                            if (row_sums) {
+                                row_sums[i + r] += v;
+                            }
+                        } else {
+                            *buf++ = 0;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Packs a kc x nc block of B into panels of NR columns: per group of four rows, the four bytes of
+    // each column are adjacent. Padding is zero, so it adds nothing whatever A holds. col_sums
+    // accumulates the sum of each column.
+    inline void pack_b(size_t kc, size_t nc, const int8_t* b, size_t ldb, int8_t* buf, int32_t* col_sums) {
+        const size_t kq = (kc + 3) / 4;
+        const size_t full_nc = nc / NR * NR, full_kq = kc / 4;
+        // Full groups of full panels, a group of rows at a time so that B is read sequentially; each
+        // group of a panel is one 64-byte line of buf. This dominates products with few rows.
+        for (size_t q = 0; q < full_kq; ++q) {
+            const int8_t* r0 = b + q * 4 * ldb;
+            const int8_t* r1 = r0 + ldb;
+            const int8_t* r2 = r1 + ldb;
+            const int8_t* r3 = r2 + ldb;
+            for (size_t j = 0; j < full_nc; j += NR) {
+                int8_t* dst = buf + j * kq * 4 + q * NR * 4;
+                for (size_t c = 0; c < NR; ++c) {
+                    dst[c * 4 + 0] = r0[j + c];
+                    dst[c * 4 + 1] = r1[j + c];
+                    dst[c * 4 + 2] = r2[j + c];
+                    dst[c * 4 + 3] = r3[j + c];
+                    col_sums[j + c] += r0[j + c] + r1[j + c] + r2[j + c] + r3[j + c];
+                }
+            }
+        }
+        // The rest: the last group of each panel and the whole of a last partial panel.
+        for (size_t j = 0; j < nc; j += NR) {
+            const size_t nr = std::min(NR, nc - j);
+            for (size_t q = (nr == NR ? full_kq : 0); q < kq; ++q) {
+                int8_t* dst = buf + j * kq * 4 + q * NR * 4;
+                for (size_t c = 0; c < NR; ++c) {
+                    for (size_t t = 0; t < 4; ++t) {
+                        const size_t p = q * 4 + t;
+                        const int8_t v = (c < nr && p < kc) ? b[p * ldb + j + c] : int8_t(0);
+                        *dst++ = v;
+                        if (c < nr) {
+                            col_sums[j + c] += v;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // kq groups of four along k; pa is an MR-row panel, pb an NR-column panel.
+    using MicroKernel = void (*)(size_t kq, const uint8_t* pa, const int8_t* pb, int32_t* c, size_t ldc,
+                                 size_t mr, size_t nr, bool accumulate);
+
+    inline void micro_kernel_scalar(size_t kq, const uint8_t* pa, const int8_t* pb, int32_t* c, size_t ldc,
+                                    size_t mr, size_t nr, bool accumulate) {
+        constexpr size_t MR = 4;
+        int32_t acc[MR * NR] = {};
+        for (size_t q = 0; q < kq; ++q) {
+            for (size_t r = 0; r < MR; ++r) {
+                const uint8_t* ar = pa + r * 4;
+                for (size_t j = 0; j < NR; ++j) {
+                    const int8_t* bj = pb + j * 4;
+                    acc[r * NR + j] += ar[0] * bj[0] + ar[1] * bj[1] + ar[2] * bj[2] + ar[3] * bj[3];
+                }
+            }
+            pa += MR * 4;
+            pb += NR * 4;
+        }
+        store_tile(acc, mr, nr, c, ldc, accumulate);
+    }
+}
+
+#if TENSOR_X86_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace qgemm_avx2 {
+    using qgemm_detail::NR;
+
+    // 4 x 16 tile in eight registers. Each 32-bit lane of a B register holds four k values of one
+    // column; the even and odd bytes are sign-extended to 16 bits and multiplied with the matching
+    // bytes of A by vpmaddwd, whose pair sums cannot overflow.
+    inline void micro_kernel(size_t kq, const uint8_t* pa, const int8_t* pb, int32_t* c, size_t ldc,
+                             size_t mr, size_t nr, bool accumulate) {
+        constexpr size_t MR = 4;
+        const __m256i low_bytes = _mm256_set1_epi16(0x00ff);
+        __m256i acc[MR][2];
+        for (size_t r = 0; r < MR; ++r) {
+            acc[r][0] = _mm256_setzero_si256();
+            acc[r][1] = _mm256_setzero_si256();
+        }
+        for (size_t q = 0; q < kq; ++q) {
+            const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pb));
+            const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pb + 32));
+            const __m256i b0e = _mm256_srai_epi16(_mm256_slli_epi16(b0, 8), 8);
+            const __m256i b0o = _mm256_srai_epi16(b0, 8);
+            const __m256i b1e = _mm256_srai_epi16(_mm256_slli_epi16(b1, 8), 8);
+            const __m256i b1o = _mm256_srai_epi16(b1, 8);
+            for (size_t r = 0; r < MR; ++r) {
+                int32_t quad;
+                std::memcpy(&quad, pa + r * 4, sizeof(quad));
+                const __m256i av = _mm256_set1_epi32(quad);
+                const __m256i ae = _mm256_and_si256(av, low_bytes);
+                const __m256i ao = _mm256_srli_epi16(av, 8);
+                acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_add_epi32(_mm256_madd_epi16(ae, b0e),
+                                                                          _mm256_madd_epi16(ao, b0o)));
+                acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_add_epi32(_mm256_madd_epi16(ae, b1e),
+                                                                          _mm256_madd_epi16(ao, b1o)));
+            }
+            pa += MR * 4;
+            pb += NR * 4;
+        }
+
+        if (mr == MR && nr == NR) {
+            for (size_t r = 0; r < MR; ++r) {
+                __m256i* dst = reinterpret_cast<__m256i*>(c + r * ldc);
+                __m256i lo = acc[r][0], hi = acc[r][1];
+                if (accumulate) {
+                    lo = _mm256_add_epi32(lo, _mm256_loadu_si256(dst));
+                    hi = _mm256_add_epi32(hi, _mm256_loadu_si256(dst + 1));
+                }
+                _mm256_storeu_si256(dst, lo);
+                _mm256_storeu_si256(dst + 1, hi);
+            }
+            return;
+        }
+        int32_t tile[MR * NR];
+        for (size_t r = 0; r < MR; ++r) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(tile + r * NR), acc[r][0]);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(tile + r * NR + 8), acc[r][1]);
+        }
+        qgemm_detail::store_tile(tile, mr, nr, c, ldc, accumulate);
+    }
+}
+#pragma GCC pop_options
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512bw,avx512vl,avx512vnni,avx2,fma")
+namespace qgemm_vnni {
+    using qgemm_detail::NR;
+
+    // 8 x 16 tile, one register per row; vpdpbusd adds four u8 x s8 products into each int32 lane.
+    inline void micro_kernel(size_t kq, const uint8_t* pa, const int8_t* pb, int32_t* c, size_t ldc,
+                             size_t mr, size_t nr, bool accumulate) {
+        constexpr size_t MR = 8;
+        __m512i acc[MR];
+        for (size_t r = 0; r < MR; ++r) {
+            acc[r] = _mm512_setzero_si512();
+        }
+        for (size_t q = 0; q < kq; ++q) {
+            const __m512i b = _mm512_loadu_si512(pb);
+            for (size_t r = 0; r < MR; ++r) {
+                int32_t quad;
+                std::memcpy(&quad, pa + r * 4, sizeof(quad));
+                acc[r] = _mm512_dpbusd_epi32(acc[r], _mm512_set1_epi32(quad), b);
+            }
+            pa += MR * 4;
+            pb += NR * 4;
+        }
+
+        const __mmask16 cols = static_cast<__mmask16>((1u << nr) - 1);
+        for (size_t r = 0; r < mr; ++r) {
+            int32_t* dst = c + r * ldc;
+            __m512i v = acc[r];
+            if (accumulate) {
+                v = _mm512_add_epi32(v, _mm512_maskz_loadu_epi32(cols, dst));
+            }
+            _mm512_mask_storeu_epi32(dst, cols, v);
+        }
+    }
+}
+#pragma GCC pop_options
+#pragma GCC diagnostic pop
+#endif // TENSOR_X86_DISPATCH
+
+// A micro-kernel and the panel height it was written for.
+struct QGemmKernel {
+    SimdLevel level;
+    const char* name;
+    size_t MR;
+    qgemm_detail::MicroKernel kernel;
+};
+
+// Kernel for `level`, or for the best level below it that the host supports. AVX-512 without VNNI
+// uses the AVX2 kernel.
+inline const QGemmKernel& qgemm_kernel(SimdLevel level) {
+    static const QGemmKernel scalar{SimdLevel::Scalar, "scalar", 4, qgemm_detail::micro_kernel_scalar};
+#if TENSOR_X86_DISPATCH
+    static const QGemmKernel avx2{SimdLevel::AVX2, "avx2", 4, qgemm_avx2::micro_kernel};
+    static const QGemmKernel vnni{SimdLevel::AVX512, "avx512-vnni", 8, qgemm_vnni::micro_kernel};
+    const SimdLevel use = std::min(level, detected_simd_level());
+    if (use == SimdLevel::AVX512 && cpu_features().avx512vnni) {
+        return vnni;
+    }
+    return use >= SimdLevel::AVX2 ? avx2 : scalar;
+#else
+    (void)level;
+    return scalar;
+#endif
+}
+
+// Kernel for the active level (see simd_level()).
+inline const QGemmKernel& qgemm_kernel() {
+    static const QGemmKernel& active = qgemm_kernel(simd_level());
+    return active;
+}
+
+// Integer core: c[i * ldc + j] = sum_p (a[i, p] - a_zero) * (b[p, j] - b_zero(j)).
+inline void qgemm_s32(size_t m, size_t n, size_t k,
+                      const int8_t* a, size_t lda, int32_t a_zero,
+                      const int8_t* b, size_t ldb, QuantChannels b_quant,
+                      int32_t* c, size_t ldc,
+                      const QGemmKernel& kernel = qgemm_kernel()) {
+    using namespace qgemm_detail;
+    if (m == 0 || n == 0) {
+        return;
+    }
+    static thread_local std::vector<uint8_t> pa;
+    static thread_local std::vector<int8_t> pb;
+    static thread_local std::vector<int32_t> row_sums, col_sums;
+    pa.resize(MC * KC);
+    pb.resize(KC * NC);
+    row_sums.assign(m, 0);
+    col_sums.assign(n, 0);
+
+    const size_t MR = kernel.MR;
+    if (k == 0) {
+        for (size_t i = 0; i < m; ++i) {
+            std::fill(c + i * ldc, c + i * ldc + n, 0);
+        }
+    }
+    for (size_t jc = 0; jc < n; jc += NC) {
+        const size_t nc = std::min(NC, n - jc);
+        for (size_t pc = 0; pc < k; pc += KC) {
+            const size_t kc = std::min(KC, k - pc);
+            const size_t kq = (kc + 3) / 4;
+            const bool accumulate = pc != 0;
+            pack_b(kc, nc, b + pc * ldb + jc, ldb, pb.data(), col_sums.data() + jc);
+
+            for (size_t ic = 0; ic < m; ic += MC) {
+                const size_t mc = std::min(MC, m - ic);
+                pack_a(mc, kc, a + ic * lda + pc, lda, MR, pa.data(), jc == 0 ? row_sums.data() + ic : nullptr);
+
+                for (size_t jr = 0; jr < nc; jr += NR) {
+                    const size_t nr = std::min(NR, nc - jr);
+                    for (size_t ir = 0; ir < mc; ir += MR) {
+                        const size_t mr = std::min(MR, mc - ir);
+                        kernel.kernel(kq, pa.data() + ir * kq * 4, pb.data() + jr * kq * 4,
+                                      c + (ic + ir) * ldc + jc + jr, ldc, mr, nr, accumulate);
+                    }
+                }
+            }
+        }
+    }
+
+    // The kernel summed (a + 128) * b; remove the shift and both zero points.
+    for (size_t j = 0; j < n; ++j) {
+        const int64_t zb = b_quant[j].zero_point;
+        const int64_t col = col_sums[j];
+        const int64_t base = -(128 + static_cast<int64_t>(a_zero)) * col + static_cast<int64_t>(k) * a_zero * zb;
+        for (size_t i = 0; i < m; ++i) {
+            c[i * ldc + j] = static_cast<int32_t>(c[i * ldc + j] + base - zb * row_sums[i]);
+        }
+    }
+}
+
+namespace qgemm_detail {
+    inline std::vector<int32_t>& accumulators(size_t size) {
+        static thread_local std::vector<int32_t> acc;
+        acc.resize(size);
+        return acc;
+    }
+}
+
+// Dequantised product: c[i, j] = a_scale * b_scale(j) * sum_p (a - a_zero) * (b - b_zero(j)).
+inline void qgemm(size_t m, size_t n, size_t k,
+                  const int8_t* a, size_t lda, QuantScale a_quant,
+                  const int8_t* b, size_t ldb, QuantChannels b_quant,
+                  float* c, size_t ldc) {
+    std::vector<int32_t>& acc = qgemm_detail::accumulators(m * n);
+    qgemm_s32(m, n, k, a, lda, a_quant.zero_point, b, ldb, b_quant, acc.data(), n);
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            c[i * ldc + j] = a_quant.scale * b_quant[j].scale * static_cast<float>(acc[i * n + j]);
+        }
+    }
+}
+
+// Requantised product: the dequantised value above, quantised with c_quant.
+inline void qgemm(size_t m, size_t n, size_t k,
+                  const int8_t* a, size_t lda, QuantScale a_quant,
+                  const int8_t* b, size_t ldb, QuantChannels b_quant,
+                  int8_t* c, size_t ldc, QuantScale c_quant) {
+    std::vector<int32_t>& acc = qgemm_detail::accumulators(m * n);
+    qgemm_s32(m, n, k, a, lda, a_quant.zero_point, b, ldb, b_quant, acc.data(), n);
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            const float real = a_quant.scale * b_quant[j].scale * static_cast<float>(acc[i * n + j]);
+            c[i * ldc + j] = quantize_value(real, c_quant);
+        }
+    }
+}
+
+// Float A quantised on the fly with asymmetric parameters from its own range, times quantised B.
+inline void qgemm(size_t m, size_t n, size_t k,
+                  const float* a, size_t lda,
+                  const int8_t* b, size_t ldb, QuantChannels b_quant,
+                  float* c, size_t ldc) {
+    float lo = 0, hi = 0;
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t p = 0; p < k; ++p) {
+            lo = std::min(lo, a[i * lda + p]);
+            hi = std::max(hi, a[i * lda + p]);
+        }
+    }
+    const QuantScale a_quant = choose_quant_scale(lo, hi, false);
+    static thread_local std::vector<int8_t> qa;
+    qa.resize(m * k);
+    for (size_t i = 0; i < m; ++i) {
+        quantize_int8(a + i * lda, qa.data() + i * k, k, a_quant);
+    }
+    qgemm(m, n, k, qa.data(), k, a_quant, b, ldb, b_quant, c, ldc);
+}
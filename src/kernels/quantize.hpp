@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Affine int8 quantisation: a real value x is stored as q = round(x / scale) + zero_point, clamped to
+// [-128, 127], and read back as scale * (q - zero_point). Rounding is to nearest, ties to even.
+struct QuantScale {
+    float scale = 1.0f;
+    int32_t zero_point = 0;
+};
+
+// Parameters covering [lo, hi]. The range is widened to include 0 so that zero (padding, ReLU output)
+// is represented exactly. Symmetric parameters have zero point 0 and use [-127, 127], as weights
+// usually do; asymmetric ones spread [lo, hi] over all 256 levels, as suits activations.
+inline QuantScale choose_quant_scale(float lo, float hi, bool symmetric) {
+    lo = std::min(lo, 0.0f);
+    hi = std::max(hi, 0.0f);
+    if (symmetric) {
+        const float mag = std::max(-lo, hi);
+        return {mag > 0 ? mag / 127 : 1.0f, 0};
+    }
+    if (hi == lo) {
+        return {1.0f, 0};
+    }
+    const float scale = (hi - lo) / 255;
+    const float zero = std::nearbyint(-128 - lo / scale);
+    return {scale, static_cast<int32_t>(std::min(std::max(zero, -128.0f), 127.0f))};
+}
+
+// NaN quantises to the zero point.
+inline int8_t quantize_value(float x, QuantScale s) {
+    float r = std::nearbyint(x / s.scale) + static_cast<float>(s.zero_point);
+    r = r < -128 ? -128 : (r > 127 ? 127 : r);
+    return r == r ? static_cast<int8_t>(r) : static_cast<int8_t>(s.zero_point);
+}
+
+inline float dequantize_value(int8_t q, QuantScale s) {
+    return s.scale * static_cast<float>(static_cast<int32_t>(q) - s.zero_point);
+}
+
+inline void quantize_int8(const float* x, int8_t* q, size_t n, QuantScale s) {
+    for (size_t i = 0; i < n; ++i) {
+        q[i] = quantize_value(x[i], s);
+    }
+}
+
+inline void dequantize_int8(const int8_t* q, float* x, size_t n, QuantScale s) {
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = dequantize_value(q[i], s);
+    }
+}
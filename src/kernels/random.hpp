@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "cpu_features.hpp"
+#include "half.hpp"
+#include "simd_kernels.hpp"
+#include "../tensor/thread_pool.hpp"
+
+#if TENSOR_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// Counter-based random numbers (Philox4x32-10, Salmon et al., "Parallel random numbers: as easy as
+// 1, 2, 3") and the parallel fills built on them.
+//
+// Philox is a keyed bijection of a 128-bit counter, so the numbers of a stream are a pure function of
+// (seed, stream, element index): any range can be generated without producing what precedes it. The
+// fills below split a buffer over the ThreadPool and give the same result for any number of threads,
+// any chunking and every instruction set (scalar, AVX2+FMA and AVX-512 kernels produce identical bits),
+// so a model initialised on a laptop and on a 64-core server starts from the same weights.
+//
+// Element e of a stream belongs to group g = e / 64 and takes word (e % 64) / 16 of block
+// g * 16 + e % 16, whose counter is {block low, block high, stream, round}; the key is the seed. Uniform
+// numbers use the top 24 bits of a word, normal numbers pair words 0-1 and 2-3 of a block through
+// Box-Muller. Numbers are generated in float and converted to the element type.
+
+// A seed and a stream number: the identity of one sequence of random numbers.
+struct RandomStream {
+    uint64_t seed;
+    uint32_t stream;
+};
+
+// Hands out consecutive streams of one seed, so that fills made in the same order from the same seed
+// repeat exactly while no two fills share numbers.
+class Philox {
+public:
+    explicit Philox(uint64_t seed, uint32_t first_stream = 0) : seed_(seed), stream_(first_stream) {}
+
+    RandomStream next() { return RandomStream{seed_, stream_++}; }
+
+    uint64_t seed() const { return seed_; }
+    uint32_t stream() const { return stream_; }
+
+private:
+    uint64_t seed_;
+    uint32_t stream_;
+};
+
+namespace random_detail {
+    constexpr uint32_t kPhiloxM0 = 0xD2511F53u;
+    constexpr uint32_t kPhiloxM1 = 0xCD9E8D57u;
+    constexpr uint32_t kPhiloxW0 = 0x9E3779B9u;
+    constexpr uint32_t kPhiloxW1 = 0xBB67AE85u;
+    // Blocks per group and elements per group: a group is the unit every kernel computes.
+    constexpr size_t kGroupBlocks = 16;
+    constexpr size_t kGroupSize = 4 * kGroupBlocks;
+    // Groups per parallel task (64K elements).
+    constexpr size_t kGrainGroups = 1024;
+    // Elements converted at a time for element types other than float.
+    constexpr size_t kConvertBatch = 1024;
+    // Truncated normals are redrawn until within this many standard deviations of the mean.
+    constexpr float kTruncation = 2.0f;
+}
+
+// Fills out[0, n) with elements [first, first + n) of a stream, mapped to shift + scale * x for x
+// uniform in [0, 1) or standard normal. `round` selects an independent draw of the same elements.
+struct RandomKernel {
+    using Fill = void (*)(const RandomStream& s, uint32_t round, uint64_t first, size_t n, float scale,
+                          float shift, float* out);
+
+    SimdLevel level;
+    const char* name;
+    Fill uniform, normal;
+};
+
+// Scalar variant, also the fallback on non-x86 targets.
+namespace random_scalar {
+    struct Vec {
+        using U = uint32_t;
+        using F = float;
+        static constexpr size_t W = 1;
+
+        static U set1(uint32_t x) { return x; }
+        static U lanes(uint32_t base) { return base; }
+        static U add(U a, U b) { return a + b; }
+        static U sub(U a, U b) { return a - b; }
+        static U and_(U a, U b) { return a & b; }
+        static U or_(U a, U b) { return a | b; }
+        static U xor_(U a, U b) { return a ^ b; }
+        template<int N> static U srl(U a) { return a >> N; }
+        template<int N> static U sll(U a) { return a << N; }
+        static U less(U a, uint32_t c) { return static_cast<int32_t>(a) < static_cast<int32_t>(c) ? ~0u : 0u; }
+        static void mulhilo(U a, uint32_t m, U& hi, U& lo) {
+            const uint64_t p = static_cast<uint64_t>(a) * m;
+            hi = static_cast<uint32_t>(p >> 32);
+            lo = static_cast<uint32_t>(p);
+        }
+
+        static F set1f(float x) { return x; }
+        static F cvt(U a) { return static_cast<float>(static_cast<int32_t>(a)); }
+        static F as_f(U a) { F f; std::memcpy(&f, &a, sizeof(f)); return f; }
+        static U as_u(F a) { U u; std::memcpy(&u, &a, sizeof(u)); return u; }
+        static F add(F a, F b) { return a + b; }
+        static F sub(F a, F b) { return a - b; }
+        static F mul(F a, F b) { return a * b; }
+        static F fmadd(F a, F b, F c) { return std::fma(a, b, c); }
+        static F sqrt(F a) { return std::sqrt(a); }
+        static void store(float* p, F v) { *p = v; }
+    };
+
+#include "random_impl.hpp"
+}
+
+#if TENSOR_X86_DISPATCH
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace random_avx2 {
+    struct Vec {
+        using U = __m256i;
+        using F = __m256;
+        static constexpr size_t W = 8;
+
+        static U set1(uint32_t x) { return _mm256_set1_epi32(static_cast<int>(x)); }
+        static U lanes(uint32_t base) { return _mm256_add_epi32(set1(base), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+        static U add(U a, U b) { return _mm256_add_epi32(a, b); }
+        static U sub(U a, U b) { return _mm256_sub_epi32(a, b); }
+        static U and_(U a, U b) { return _mm256_and_si256(a, b); }
+        static U or_(U a, U b) { return _mm256_or_si256(a, b); }
+        static U xor_(U a, U b) { return _mm256_xor_si256(a, b); }
+        template<int N> static U srl(U a) { return _mm256_srli_epi32(a, N); }
+        template<int N> static U sll(U a) { return _mm256_slli_epi32(a, N); }
+        static U less(U a, uint32_t c) { return _mm256_cmpgt_epi32(set1(c), a); }
+        // 32x32 -> 64-bit products of the even lanes, then of the odd lanes shifted down.
+        static void mulhilo(U a, uint32_t m, U& hi, U& lo) {
+            const U mv = set1(m);
+            const U even = _mm256_mul_epu32(a, mv);
+            const U odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), mv);
+            hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+            lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+        }
+
+        static F set1f(float x) { return _mm256_set1_ps(x); }
+        static F cvt(U a) { return _mm256_cvtepi32_ps(a); }
+        static F as_f(U a) { return _mm256_castsi256_ps(a); }
+        static U as_u(F a) { return _mm256_castps_si256(a); }
+        static F add(F a, F b) { return _mm256_add_ps(a, b); }
+        static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+        static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+        static F fmadd(F a, F b, F c) { return _mm256_fmadd_ps(a, b, c); }
+        static F sqrt(F a) { return _mm256_sqrt_ps(a); }
+        static void store(float* p, F v) { _mm256_storeu_ps(p, v); }
+    };
+
+#include "random_impl.hpp"
+}
+#pragma GCC pop_options
+
+// See simd_kernels.hpp for why -Wuninitialized is silenced around the AVX-512 intrinsics.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512bw,avx512vl,avx2,fma")
+namespace random_avx512 {
+    struct Vec {
+        using U = __m512i;
+        using F = __m512;
+        static constexpr size_t W = 16;
+
+        static U set1(uint32_t x) { return _mm512_set1_epi32(static_cast<int>(x)); }
+        static U lanes(uint32_t base) {
+            return _mm512_add_epi32(set1(base), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        }
+        static U add(U a, U b) { return _mm512_add_epi32(a, b); }
+        static U sub(U a, U b) { return _mm512_sub_epi32(a, b); }
+        static U and_(U a, U b) { return _mm512_and_si512(a, b); }
+        static U or_(U a, U b) { return _mm512_or_si512(a, b); }
+        static U xor_(U a, U b) { return _mm512_xor_si512(a, b); }
+        template<int N> static U srl(U a) { return _mm512_srli_epi32(a, N); }
+        template<int N> static U sll(U a) { return _mm512_slli_epi32(a, N); }
+        static U less(U a, uint32_t c) { return _mm512_movm_epi32(_mm512_cmplt_epi32_mask(a, set1(c))); }
+        static void mulhilo(U a, uint32_t m, U& hi, U& lo) {
+            const U mv = set1(m);
+            const U even = _mm512_mul_epu32(a, mv);
+            const U odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), mv);
+            hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+            lo = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+        }
+
+        static F set1f(float x) { return _mm512_set1_ps(x); }
+        static F cvt(U a) { return _mm512_cvtepi32_ps(a); }
+        static F as_f(U a) { return _mm512_castsi512_ps(a); }
+        static U as_u(F a) { return _mm512_castps_si512(a); }
+        static F add(F a, F b) { return _mm512_add_ps(a, b); }
+        static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+        static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+        static F fmadd(F a, F b, F c) { return _mm512_fmadd_ps(a, b, c); }
+        static F sqrt(F a) { return _mm512_sqrt_ps(a); }
+        static void store(float* p, F v) { _mm512_storeu_ps(p, v); }
+    };
+
+#include "random_impl.hpp"
+}
+#pragma GCC pop_options
+#pragma GCC diagnostic pop
+
+#endif // TENSOR_X86_DISPATCH
+
+// Kernel for `level`, or for the best level below it that the host supports. SSE4.2 has no FMA and
+// uses the scalar kernel.
+inline const RandomKernel& random_kernel(SimdLevel level) {
+    static const RandomKernel scalar{SimdLevel::Scalar, "scalar", random_scalar::uniform, random_scalar::normal};
+#if TENSOR_X86_DISPATCH
+    static const RandomKernel avx2{SimdLevel::AVX2, "avx2", random_avx2::uniform, random_avx2::normal};
+    static const RandomKernel avx512{SimdLevel::AVX512, "avx512", random_avx512::uniform, random_avx512::normal};
+    const SimdLevel best = std::min(level, detected_simd_level());
+    return best == SimdLevel::AVX512 ? avx512 : best == SimdLevel::AVX2 ? avx2 : scalar;
+#else
+    (void)level;
+    return scalar;
+#endif
+}
+
+// Kernel for the active level (see simd_level()).
+inline const RandomKernel& random_kernel() {
+    static const RandomKernel& active = random_kernel(simd_level());
+    return active;
+}
+
+namespace random_detail {
+    template<typename T>
+    constexpr bool random_element = std::is_floating_point<T>::value || std::is_same<T, float16>::value ||
+                                    std::is_same<T, bfloat16>::value;
+
+    // Runs gen(first, n, float* out) over [0, n) on the ThreadPool in whole groups, converting from
+    // float when T is another type.
+    template<typename T, typename Gen>
+    void parallel_generate(T* out, size_t n, Gen&& gen) {
+        static_assert(random_element<T>, "Random fills are provided for floating-point element types");
+        const size_t groups = (n + kGroupSize - 1) / kGroupSize;
+        parallel_for(0, groups, [&](size_t g0, size_t g1) {
+            const size_t first = g0 * kGroupSize, last = std::min(g1 * kGroupSize, n);
+            if constexpr (std::is_same<T, float>::value) {
+                gen(first, last - first, out + first);
+            } else {
+                float buf[kConvertBatch];
+                for (size_t i = first; i < last; i += kConvertBatch) {
+                    const size_t m = std::min(kConvertBatch, last - i);
+                    gen(i, m, buf);
+                    for (size_t j = 0; j < m; ++j) {
+                        out[i + j] = static_cast<T>(buf[j]);
+                    }
+                }
+            }
+        }, kGrainGroups);
+    }
+}
+
+// out[i] uniform in [lo, hi] (hi itself only through rounding), for i in [0, n).
+template<typename T>
+void random_uniform(T* out, size_t n, const RandomStream& s, float lo, float hi,
+                    const RandomKernel& kernel = random_kernel()) {
+    random_detail::parallel_generate(out, n, [&](size_t first, size_t count, float* dst) {
+        kernel.uniform(s, 0, first, count, hi - lo, lo, dst);
+    });
+}
+
+// out[i] normal with the given mean and standard deviation.
+template<typename T>
+void random_normal(T* out, size_t n, const RandomStream& s, float mean, float stddev,
+                   const RandomKernel& kernel = random_kernel()) {
+    random_detail::parallel_generate(out, n, [&](size_t first, size_t count, float* dst) {
+        kernel.normal(s, 0, first, count, stddev, mean, dst);
+    });
+}
+
+// out[i] normal, redrawn while more than two standard deviations from the mean. About 4.6% of the
+// elements are out of range; they are replaced by the same elements of further rounds, a group of
+// elements at a time, so the result still depends only on the element index.
+template<typename T>
+void random_truncated_normal(T* out, size_t n, const RandomStream& s, float mean, float stddev,
+                             const RandomKernel& kernel = random_kernel()) {
+    using namespace random_detail;
+    const float bound = kTruncation * stddev;
+    auto outside = [mean, bound](float x) { return !(std::fabs(x - mean) <= bound); };
+    parallel_generate(out, n, [&](size_t first, size_t count, float* dst) {
+        kernel.normal(s, 0, first, count, stddev, mean, dst);
+        float redraw[kGroupSize];
+        for (size_t g = 0; g < count; g += kGroupSize) {
+            const size_t m = std::min(kGroupSize, count - g);
+            for (uint32_t round = 1; std::any_of(dst + g, dst + g + m, outside); ++round) {
+                kernel.normal(s, round, first + g, m, stddev, mean, redraw);
+                for (size_t i = 0; i < m; ++i) {
+                    if (outside(dst[g + i])) {
+                        dst[g + i] = redraw[i];
+                    }
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,142 @@
+// Body of the Philox generator and the uniform / normal transforms, included once per instruction set
+// (see random.hpp) inside a namespace that defines `Vec`: W lanes of uint32 (`U`) and float (`F`).
+// Every floating-point step is a single correctly rounded operation or a fused multiply-add, in the
+// same order for every Vec, so all instruction sets produce bit-identical numbers.
+
+using U = typename Vec::U;
+using F = typename Vec::F;
+
+// Philox4x32-10 on the W consecutive blocks starting at block `first`: x[k] holds word k of each.
+inline void philox(const RandomStream& s, uint32_t round, uint64_t first, U x[4]) {
+    U c0 = Vec::lanes(static_cast<uint32_t>(first));
+    U c1 = Vec::set1(static_cast<uint32_t>(first >> 32));
+    U c2 = Vec::set1(s.stream);
+    U c3 = Vec::set1(round);
+    uint32_t k0 = static_cast<uint32_t>(s.seed), k1 = static_cast<uint32_t>(s.seed >> 32);
+    for (int r = 0; r < 10; ++r) {
+        U hi0, lo0, hi1, lo1;
+        Vec::mulhilo(c0, random_detail::kPhiloxM0, hi0, lo0);
+        Vec::mulhilo(c2, random_detail::kPhiloxM1, hi1, lo1);
+        c0 = Vec::xor_(Vec::xor_(hi1, c1), Vec::set1(k0));
+        c1 = lo1;
+        c2 = Vec::xor_(Vec::xor_(hi0, c3), Vec::set1(k1));
+        c3 = lo0;
+        k0 += random_detail::kPhiloxW0;
+        k1 += random_detail::kPhiloxW1;
+    }
+    x[0] = c0;
+    x[1] = c1;
+    x[2] = c2;
+    x[3] = c3;
+}
+
+// The top 24 bits of x as a float in [0, 1).
+inline F unit(U x) {
+    return Vec::mul(Vec::cvt(Vec::template srl<8>(x)), Vec::set1f(0x1p-24f));
+}
+
+// sqrt(-2 log u) for the top 24 bits of x mapped to (0, 1]; log as in simd_kernels (cephes logf).
+inline F radius(U x) {
+    using C = simd_detail::LogConstants<float>;
+    const F u = Vec::mul(Vec::cvt(Vec::add(Vec::template srl<8>(x), Vec::set1(1))), Vec::set1f(0x1p-24f));
+    const U bits = Vec::as_u(u);
+    U e = Vec::sub(Vec::template srl<23>(bits), Vec::set1(126));
+    const U mbits = Vec::or_(Vec::and_(bits, Vec::set1(0x007fffff)), Vec::set1(0x3f000000));
+    const U small = Vec::less(mbits, 0x3f3504f3);   // m < sqrt(1/2): use 2m - 1 and e - 1
+    e = Vec::add(e, small);
+    const F m = Vec::as_f(mbits);
+    const F v = Vec::add(Vec::sub(m, Vec::set1f(1.0f)), Vec::as_f(Vec::and_(mbits, small)));
+    const F ef = Vec::cvt(e);
+    const F z = Vec::mul(v, v);
+    F y = Vec::set1f(C::p[0]);
+    for (int i = 1; i < 9; ++i) {
+        y = Vec::fmadd(y, v, Vec::set1f(C::p[i]));
+    }
+    y = Vec::mul(Vec::mul(y, v), z);
+    y = Vec::fmadd(ef, Vec::set1f(C::ln2_lo), y);
+    y = Vec::fmadd(z, Vec::set1f(-0.5f), y);
+    const F log_u = Vec::fmadd(ef, Vec::set1f(C::ln2_hi), Vec::add(v, y));
+    return Vec::sqrt(Vec::mul(log_u, Vec::set1f(-2.0f)));
+}
+
+// sin and cos of 2 pi t for the top 24 bits of x mapped to t in [0, 1). The quadrant is split off
+// exactly in integers, leaving |angle| <= pi / 4 for the cephes sinf / cosf polynomials.
+inline void sincos_2pi(U x, F& sin_out, F& cos_out) {
+    const U t = Vec::template srl<8>(x);
+    const U q = Vec::template srl<22>(Vec::add(t, Vec::set1(1u << 21)));
+    const F a = Vec::mul(Vec::cvt(Vec::sub(t, Vec::template sll<22>(q))), Vec::set1f(6.28318530717958647692f * 0x1p-24f));
+    const F z = Vec::mul(a, a);
+    F s = Vec::fmadd(Vec::set1f(-1.9515295891e-4f), z, Vec::set1f(8.3321608736e-3f));
+    s = Vec::fmadd(s, z, Vec::set1f(-1.6666654611e-1f));
+    s = Vec::fmadd(s, Vec::mul(z, a), a);
+    F c = Vec::fmadd(Vec::set1f(2.443315711809948e-5f), z, Vec::set1f(-1.388731625493765e-3f));
+    c = Vec::fmadd(c, z, Vec::set1f(4.166664568298827e-2f));
+    c = Vec::fmadd(c, Vec::mul(z, z), Vec::fmadd(z, Vec::set1f(-0.5f), Vec::set1f(1.0f)));
+    // Odd quadrants swap sin and cos; quadrants 2, 3 negate sin and 1, 2 negate cos.
+    const U swap = Vec::and_(Vec::xor_(Vec::as_u(s), Vec::as_u(c)), Vec::sub(Vec::set1(0), Vec::and_(q, Vec::set1(1))));
+    const U sin_sign = Vec::template sll<30>(Vec::and_(q, Vec::set1(2)));
+    const U cos_sign = Vec::template sll<30>(Vec::and_(Vec::add(q, Vec::set1(1)), Vec::set1(2)));
+    sin_out = Vec::as_f(Vec::xor_(Vec::xor_(Vec::as_u(s), swap), sin_sign));
+    cos_out = Vec::as_f(Vec::xor_(Vec::xor_(Vec::as_u(c), swap), cos_sign));
+}
+
+// Standard normals from the words of W blocks (Box-Muller): words 0 and 1 give z[0] and z[1],
+// words 2 and 3 give z[2] and z[3].
+inline void box_muller(const U x[4], F z[4]) {
+    for (int p = 0; p < 4; p += 2) {
+        const F r = radius(x[p]);
+        F sin_t, cos_t;
+        sincos_2pi(x[p + 1], sin_t, cos_t);
+        z[p] = Vec::mul(r, cos_t);
+        z[p + 1] = Vec::mul(r, sin_t);
+    }
+}
+
+// Element k * 16 + j of `group` (64 elements) comes from word k of block group * 16 + j.
+template<bool Normal>
+void fill_group(const RandomStream& s, uint32_t round, uint64_t group, float scale, float shift, float* out) {
+    for (size_t h = 0; h < random_detail::kGroupBlocks; h += Vec::W) {
+        U x[4];
+        F v[4];
+        philox(s, round, group * random_detail::kGroupBlocks + h, x);
+        if constexpr (Normal) {
+            box_muller(x, v);
+        } else {
+            for (int k = 0; k < 4; ++k) {
+                v[k] = unit(x[k]);
+            }
+        }
+        for (int k = 0; k < 4; ++k) {
+            Vec::store(out + k * random_detail::kGroupBlocks + h,
+                       Vec::fmadd(v[k], Vec::set1f(scale), Vec::set1f(shift)));
+        }
+    }
+}
+
+// Elements [first, first + n) of the stream: shift + scale * (uniform [0, 1) or standard normal).
+template<bool Normal>
+void generate(const RandomStream& s, uint32_t round, uint64_t first, size_t n, float scale, float shift,
+              float* out) {
+    constexpr size_t G = random_detail::kGroupSize;
+    const uint64_t end = first + n;
+    for (uint64_t g = first / G; g * G < end; ++g) {
+        const uint64_t lo = std::max<uint64_t>(g * G, first), hi = std::min<uint64_t>(g * G + G, end);
+        if (hi - lo == G) {
+            fill_group<Normal>(s, round, g, scale, shift, out + (lo - first));
+        } else {
+            float tmp[G];
+            fill_group<Normal>(s, round, g, scale, shift, tmp);
+            std::copy(tmp + (lo - g * G), tmp + (hi - g * G), out + (lo - first));
+        }
+    }
+}
+
+inline void uniform(const RandomStream& s, uint32_t round, uint64_t first, size_t n, float scale, float shift,
+                    float* out) {
+    generate<false>(s, round, first, n, scale, shift, out);
+}
+
+inline void normal(const RandomStream& s, uint32_t round, uint64_t first, size_t n, float scale, float shift,
+                   float* out) {
+    generate<true>(s, round, first, n, scale, shift, out);
+}
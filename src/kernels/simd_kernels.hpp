@@ -0,0 +1,507 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "cpu_features.hpp"
+
+#if TENSOR_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// Runtime-dispatched element-wise, reduction and activation kernels for float and double.
+//
+// Every kernel is compiled once per instruction set (scalar, SSE4.2, AVX2+FMA, AVX-512) from the
+// same body in simd_kernels_impl.hpp, using `#pragma GCC target` regions instead of global -m flags,
+// so a binary built for baseline x86-64 still runs the widest variant the host supports. The CPU is
+// probed once; simd_kernels<T>() returns the table for the active level.
+//
+// Binary kernels take (a, b, out, n) and allow out to alias a or b. All pointers may be unaligned.
+//
+// Accuracy of the transcendental kernels, as maximum error against a long double reference over their
+// whole finite domain (identical bounds for every level and for float and double):
+//   exp      <= 2 ulp, including denormal results; +inf above log(max), 0 once the result underflows
+//   log      <= 1 ulp, including denormal inputs; log(0) = -inf, log(x < 0) = NaN
+//   tanh     <= 2 ulp
+//   sigmoid  <= 4 ulp (1 / (1 + exp(-x)))
+//   softmax  <= 4 + sqrt(n) ulp against exp(x - max) / sum, the sqrt(n) term being the sum's rounding
+// NaN inputs give NaN. Measured with benchmark/transcendental_benchmark.cpp and checked in
+// test/simd_kernels_test.cpp.
+template <typename T>
+struct SimdKernels {
+    using Binary = void (*)(const T*, const T*, T*, size_t);
+    using Unary = void (*)(const T*, T*, size_t);
+    using Reduce = T (*)(const T*, size_t);
+
+    SimdLevel level;
+    Binary add, sub, mul, div, min, max;
+    Reduce sum;
+    Reduce reduce_max, reduce_min;  // n must be non-zero
+    T (*dot)(const T*, const T*, size_t);
+    Unary exp, log, relu, sigmoid, tanh;
+    Unary softmax;                                       // exp(x - max) / sum over the n elements
+    T (*neg_log_likelihood)(const T*, const T*, size_t);  // -sum(target * log(pred))
+};
+
+namespace simd_detail {
+    template <typename T>
+    struct ExpConstants;
+
+    template <>
+    struct ExpConstants<float> {
+        static constexpr float log2e = 1.44269504088896341f;
+        static constexpr float ln2_hi = 0.693359375f;
+        static constexpr float ln2_lo = -2.12194440e-4f;
+        static constexpr float max_arg = 88.72283905206835f;   // log(FLT_MAX)
+        static constexpr float min_arg = -103.972077083991796f;  // log(FLT_TRUE_MIN / 2)
+        static constexpr float p[6] = {1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+                                       4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+    };
+
+    template <>
+    struct ExpConstants<double> {
+        static constexpr double log2e = 1.4426950408889634073599;
+        static constexpr double ln2_hi = 6.93145751953125e-1;
+        static constexpr double ln2_lo = 1.42860682030941723212e-6;
+        static constexpr double max_arg = 709.782712893383996843;   // log(DBL_MAX)
+        static constexpr double min_arg = -745.1332191019411;       // log(DBL_TRUE_MIN / 2)
+        static constexpr double p[3] = {1.26177193074810590878e-4, 3.02994407707441961300e-2,
+                                        9.99999999999999999910e-1};
+        static constexpr double q[4] = {3.00198505138664455042e-6, 2.52448340349684104192e-3,
+                                        2.27265548208155028766e-1, 2.00000000000000000009e0};
+    };
+
+    template <typename T>
+    struct LogConstants;
+
+    template <>
+    struct LogConstants<float> {
+        static constexpr float ln2_hi = 0.693359375f;
+        static constexpr float ln2_lo = -2.12194440e-4f;
+        static constexpr float denorm_scale = 8388608.0f;  // 2^23
+        static constexpr float denorm_bits = 23.0f;
+        static constexpr float p[9] = {7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f,
+                                       -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f,
+                                       2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f};
+    };
+
+    template <>
+    struct LogConstants<double> {
+        static constexpr double ln2_hi = 0.693359375;
+        static constexpr double ln2_lo = -2.121944400546905827679e-4;
+        static constexpr double denorm_scale = 4503599627370496.0;  // 2^52
+        static constexpr double denorm_bits = 52.0;
+        static constexpr double p[6] = {1.01875663804580931796e-4, 4.97494994976747001425e-1,
+                                        4.70579119878881725854e0, 1.44989225341610930846e1,
+                                        1.79368678507819816313e1, 7.70838733755885391666e0};
+        static constexpr double q[5] = {1.12873587189167450590e1, 4.52279145837532221105e1,
+                                        8.29875266912776603211e1, 7.11544750618563894466e1,
+                                        2.31251620126765340583e1};
+    };
+
+    template <typename T>
+    struct TanhConstants;
+
+    template <>
+    struct TanhConstants<float> {
+        static constexpr float p[5] = {-5.70498872745e-3f, 2.06390887954e-2f, -5.37397155531e-2f,
+                                       1.33314422036e-1f, -3.33332819422e-1f};
+    };
+
+    template <>
+    struct TanhConstants<double> {
+        static constexpr double p[3] = {-9.64399179425052238628e-1, -9.92877231001918586564e1,
+                                        -1.61468768441708447952e3};
+        static constexpr double q[3] = {1.12811678491632931402e2, 2.23548839060100448583e3,
+                                        4.84406305325125486048e3};
+    };
+}
+
+// Scalar variant: one lane, plain arithmetic. Also the fallback on non-x86 targets.
+namespace simd_scalar {
+    using namespace simd_detail;
+
+    template <typename T>
+    struct Vec {
+        using reg = T;
+        using mask = bool;
+        static constexpr size_t W = 1;
+
+        static reg load(const T* p) { return *p; }
+        static void store(T* p, reg v) { *p = v; }
+        static reg set1(T x) { return x; }
+        static reg add(reg a, reg b) { return a + b; }
+        static reg sub(reg a, reg b) { return a - b; }
+        static reg mul(reg a, reg b) { return a * b; }
+        static reg div(reg a, reg b) { return a / b; }
+        static reg min(reg a, reg b) { return a < b ? a : b; }
+        static reg max(reg a, reg b) { return a > b ? a : b; }
+        static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+        static reg round(reg v) { return std::nearbyint(v); }
+        static reg abs(reg v) { return std::fabs(v); }
+        static reg copysign(reg mag, reg sgn) { return std::copysign(mag, sgn); }
+        static mask lt(reg a, reg b) { return a < b; }
+        static reg blend(mask m, reg t, reg f) { return m ? t : f; }
+        static reg pow2n(reg n) { return std::ldexp(T(1), static_cast<int>(n)); }
+        static reg frexp(reg x, reg& e) {
+            int ei;
+            reg m = std::frexp(x, &ei);
+            e = static_cast<T>(ei);
+            return m;
+        }
+        static T reduce_add(reg v) { return v; }
+        static T reduce_max(reg v) { return v; }
+        static T reduce_min(reg v) { return v; }
+    };
+
+#include "simd_kernels_impl.hpp"
+}
+
+#if TENSOR_X86_DISPATCH
+
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+namespace simd_sse42 {
+    using namespace simd_detail;
+
+    template <typename T>
+    struct Vec;
+
+    template <>
+    struct Vec<float> {
+        using reg = __m128;
+        using mask = __m128;
+        static constexpr size_t W = 4;
+
+        static reg load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, reg v) { _mm_storeu_ps(p, v); }
+        static reg set1(float x) { return _mm_set1_ps(x); }
+        static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+        static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+        static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+        static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+        static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+        static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        static reg round(reg v) { return _mm_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static reg abs(reg v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+        static reg copysign(reg mag, reg sgn) {
+            const reg sign = _mm_set1_ps(-0.0f);
+            return _mm_or_ps(_mm_andnot_ps(sign, mag), _mm_and_ps(sign, sgn));
+        }
+        static mask lt(reg a, reg b) { return _mm_cmplt_ps(a, b); }
+        static reg blend(mask m, reg t, reg f) { return _mm_blendv_ps(f, t, m); }
+        static reg pow2n(reg n) {
+            __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+            return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+        }
+        static reg frexp(reg x, reg& e) {
+            __m128i bits = _mm_castps_si128(x);
+            e = _mm_sub_ps(_mm_cvtepi32_ps(_mm_srli_epi32(bits, 23)), _mm_set1_ps(126.0f));
+            bits = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x807fffff)), _mm_set1_epi32(0x3f000000));
+            return _mm_castsi128_ps(bits);
+        }
+        static float reduce_add(reg v) {
+            reg s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+        static float reduce_max(reg v) {
+            reg s = _mm_max_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_max_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+        static float reduce_min(reg v) {
+            reg s = _mm_min_ps(v, _mm_movehl_ps(v, v));
+            return _mm_cvtss_f32(_mm_min_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+    };
+
+    template <>
+    struct Vec<double> {
+        using reg = __m128d;
+        using mask = __m128d;
+        static constexpr size_t W = 2;
+
+        static reg load(const double* p) { return _mm_loadu_pd(p); }
+        static void store(double* p, reg v) { _mm_storeu_pd(p, v); }
+        static reg set1(double x) { return _mm_set1_pd(x); }
+        static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+        static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+        static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+        static reg div(reg a, reg b) { return _mm_div_pd(a, b); }
+        static reg min(reg a, reg b) { return _mm_min_pd(a, b); }
+        static reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+        static reg round(reg v) { return _mm_round_pd(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static reg abs(reg v) { return _mm_andnot_pd(_mm_set1_pd(-0.0), v); }
+        static reg copysign(reg mag, reg sgn) {
+            const reg sign = _mm_set1_pd(-0.0);
+            return _mm_or_pd(_mm_andnot_pd(sign, mag), _mm_and_pd(sign, sgn));
+        }
+        static mask lt(reg a, reg b) { return _mm_cmplt_pd(a, b); }
+        static reg blend(mask m, reg t, reg f) { return _mm_blendv_pd(f, t, m); }
+        // n + 1.5 * 2^52 puts n in the low mantissa bits; subtracting the bias pattern leaves it as an int64.
+        static reg pow2n(reg n) {
+            const reg magic = _mm_set1_pd(6755399441055744.0);
+            __m128i i = _mm_sub_epi64(_mm_castpd_si128(_mm_add_pd(n, magic)), _mm_castpd_si128(magic));
+            return _mm_castsi128_pd(_mm_slli_epi64(_mm_add_epi64(i, _mm_set1_epi64x(1023)), 52));
+        }
+        // The biased exponent is converted by planting it in the mantissa of 2^52.
+        static reg frexp(reg x, reg& e) {
+            __m128i bits = _mm_castpd_si128(x);
+            const __m128i two52 = _mm_set1_epi64x(0x4330000000000000LL);
+            e = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(bits, 52), two52)),
+                           _mm_set1_pd(4503599627370496.0 + 1022.0));
+            bits = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi64x(static_cast<long long>(0x800fffffffffffffULL))),
+                                _mm_set1_epi64x(0x3fe0000000000000LL));
+            return _mm_castsi128_pd(bits);
+        }
+        static double reduce_add(reg v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+        static double reduce_max(reg v) { return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v))); }
+        static double reduce_min(reg v) { return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v))); }
+    };
+
+#include "simd_kernels_impl.hpp"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace simd_avx2 {
+    using namespace simd_detail;
+
+    template <typename T>
+    struct Vec;
+
+    template <>
+    struct Vec<float> {
+        using reg = __m256;
+        using mask = __m256;
+        static constexpr size_t W = 8;
+
+        static reg load(const float* p) { return _mm256_loadu_ps(p); }
+        static void store(float* p, reg v) { _mm256_storeu_ps(p, v); }
+        static reg set1(float x) { return _mm256_set1_ps(x); }
+        static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+        static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+        static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+        static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+        static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+        static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+        static reg round(reg v) { return _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static reg abs(reg v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+        static reg copysign(reg mag, reg sgn) {
+            const reg sign = _mm256_set1_ps(-0.0f);
+            return _mm256_or_ps(_mm256_andnot_ps(sign, mag), _mm256_and_ps(sign, sgn));
+        }
+        static mask lt(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static reg blend(mask m, reg t, reg f) { return _mm256_blendv_ps(f, t, m); }
+        static reg pow2n(reg n) {
+            __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+            return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+        }
+        static reg frexp(reg x, reg& e) {
+            __m256i bits = _mm256_castps_si256(x);
+            e = _mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 23)), _mm256_set1_ps(126.0f));
+            bits = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x807fffff)),
+                                   _mm256_set1_epi32(0x3f000000));
+            return _mm256_castsi256_ps(bits);
+        }
+        static float reduce_add(reg v) {
+            __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+            return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+        static float reduce_max(reg v) {
+            __m128 s = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+            return _mm_cvtss_f32(_mm_max_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+        static float reduce_min(reg v) {
+            __m128 s = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            s = _mm_min_ps(s, _mm_movehl_ps(s, s));
+            return _mm_cvtss_f32(_mm_min_ss(s, _mm_shuffle_ps(s, s, 1)));
+        }
+    };
+
+    template <>
+    struct Vec<double> {
+        using reg = __m256d;
+        using mask = __m256d;
+        static constexpr size_t W = 4;
+
+        static reg load(const double* p) { return _mm256_loadu_pd(p); }
+        static void store(double* p, reg v) { _mm256_storeu_pd(p, v); }
+        static reg set1(double x) { return _mm256_set1_pd(x); }
+        static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+        static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+        static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+        static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+        static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+        static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+        static reg round(reg v) { return _mm256_round_pd(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static reg abs(reg v) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), v); }
+        static reg copysign(reg mag, reg sgn) {
+            const reg sign = _mm256_set1_pd(-0.0);
+            return _mm256_or_pd(_mm256_andnot_pd(sign, mag), _mm256_and_pd(sign, sgn));
+        }
+        static mask lt(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+        static reg blend(mask m, reg t, reg f) { return _mm256_blendv_pd(f, t, m); }
+        static reg pow2n(reg n) {
+            const reg magic = _mm256_set1_pd(6755399441055744.0);
+            __m256i i = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(n, magic)), _mm256_castpd_si256(magic));
+            return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(i, _mm256_set1_epi64x(1023)), 52));
+        }
+        static reg frexp(reg x, reg& e) {
+            __m256i bits = _mm256_castpd_si256(x);
+            const __m256i two52 = _mm256_set1_epi64x(0x4330000000000000LL);
+            e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), two52)),
+                              _mm256_set1_pd(4503599627370496.0 + 1022.0));
+            bits = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(static_cast<long long>(0x800fffffffffffffULL))),
+                                   _mm256_set1_epi64x(0x3fe0000000000000LL));
+            return _mm256_castsi256_pd(bits);
+        }
+        static double reduce_add(reg v) {
+            __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+        static double reduce_max(reg v) {
+            __m128d s = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+            return _mm_cvtsd_f64(_mm_max_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+        static double reduce_min(reg v) {
+            __m128d s = _mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+            return _mm_cvtsd_f64(_mm_min_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+    };
+
+#include "simd_kernels_impl.hpp"
+}
+#pragma GCC pop_options
+
+// GCC 12's AVX-512 intrinsics pass a self-initialised _mm512_undefined_*() as the merge source, which
+// trips -Wuninitialized once they are inlined here.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512bw,avx512vl,avx2,fma")
+namespace simd_avx512 {
+    using namespace simd_detail;
+
+    template <typename T>
+    struct Vec;
+
+    template <>
+    struct Vec<float> {
+        using reg = __m512;
+        using mask = __mmask16;
+        static constexpr size_t W = 16;
+
+        static reg load(const float* p) { return _mm512_loadu_ps(p); }
+        static void store(float* p, reg v) { _mm512_storeu_ps(p, v); }
+        static reg set1(float x) { return _mm512_set1_ps(x); }
+        static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+        static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+        static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+        static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+        static reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+        static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+        static reg round(reg v) { return _mm512_roundscale_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static reg abs(reg v) { return _mm512_abs_ps(v); }
+        static reg copysign(reg mag, reg sgn) {
+            const __m512i sign = _mm512_set1_epi32(INT32_MIN);
+            return _mm512_castsi512_ps(_mm512_or_si512(_mm512_andnot_si512(sign, _mm512_castps_si512(mag)),
+                                                       _mm512_and_si512(sign, _mm512_castps_si512(sgn))));
+        }
+        static mask lt(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+        static reg blend(mask m, reg t, reg f) { return _mm512_mask_blend_ps(m, f, t); }
+        static reg pow2n(reg n) { return _mm512_scalef_ps(_mm512_set1_ps(1.0f), n); }
+        static reg frexp(reg x, reg& e) {
+            e = _mm512_add_ps(_mm512_getexp_ps(x), _mm512_set1_ps(1.0f));
+            return _mm512_getmant_ps(x, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_src);
+        }
+        static float reduce_add(reg v) { return _mm512_reduce_add_ps(v); }
+        static float reduce_max(reg v) { return _mm512_reduce_max_ps(v); }
+        static float reduce_min(reg v) { return _mm512_reduce_min_ps(v); }
+    };
+
+    template <>
+    struct Vec<double> {
+        using reg = __m512d;
+        using mask = __mmask8;
+        static constexpr size_t W = 8;
+
+        static reg load(const double* p) { return _mm512_loadu_pd(p); }
+        static void store(double* p, reg v) { _mm512_storeu_pd(p, v); }
+        static reg set1(double x) { return _mm512_set1_pd(x); }
+        static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+        static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+        static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+        static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+        static reg min(reg a, reg b) { return _mm512_min_pd(a, b); }
+        static reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+        static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+        static reg round(reg v) { return _mm512_roundscale_pd(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static reg abs(reg v) { return _mm512_abs_pd(v); }
+        static reg copysign(reg mag, reg sgn) {
+            const __m512i sign = _mm512_set1_epi64(INT64_MIN);
+            return _mm512_castsi512_pd(_mm512_or_si512(_mm512_andnot_si512(sign, _mm512_castpd_si512(mag)),
+                                                       _mm512_and_si512(sign, _mm512_castpd_si512(sgn))));
+        }
+        static mask lt(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+        static reg blend(mask m, reg t, reg f) { return _mm512_mask_blend_pd(m, f, t); }
+        static reg pow2n(reg n) { return _mm512_scalef_pd(_mm512_set1_pd(1.0), n); }
+        static reg frexp(reg x, reg& e) {
+            e = _mm512_add_pd(_mm512_getexp_pd(x), _mm512_set1_pd(1.0));
+            return _mm512_getmant_pd(x, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_src);
+        }
+        static double reduce_add(reg v) { return _mm512_reduce_add_pd(v); }
+        static double reduce_max(reg v) { return _mm512_reduce_max_pd(v); }
+        static double reduce_min(reg v) { return _mm512_reduce_min_pd(v); }
+    };
+
+#include "simd_kernels_impl.hpp"
+}
+#pragma GCC pop_options
+#pragma GCC diagnostic pop
+
+#endif // TENSOR_X86_DISPATCH
+
+// Kernel table for `level`, or for the best level below it that the host supports.
+template <typename T>
+const SimdKernels<T>& simd_kernels(SimdLevel level) {
+    static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                  "SIMD kernels are provided for float and double");
+#if TENSOR_X86_DISPATCH
+    static const SimdKernels<T> tables[] = {
+        simd_scalar::Kernels<T>::table(SimdLevel::Scalar),
+        simd_sse42::Kernels<T>::table(SimdLevel::SSE42),
+        simd_avx2::Kernels<T>::table(SimdLevel::AVX2),
+        simd_avx512::Kernels<T>::table(SimdLevel::AVX512),
+    };
+    const SimdLevel best = detected_simd_level();
+    return tables[static_cast<int>(std::min(level, best))];
+#else
+    static const SimdKernels<T> table = simd_scalar::Kernels<T>::table(SimdLevel::Scalar);
+    (void)level;
+    return table;
+#endif
+}
+
+// Kernel table for the active level (see simd_level()).
+template <typename T>
+const SimdKernels<T>& simd_kernels() {
+    static const SimdKernels<T>& active = simd_kernels<T>(simd_level());
+    return active;
+}
+
+// True for element types that have a kernel table.
+template <typename T>
+constexpr bool has_simd_kernels = std::is_same<T, float>::value || std::is_same<T, double>::value;
@@ -0,0 +1,328 @@
+// Kernel bodies shared by every instruction set. simd_kernels.hpp includes this file once per variant,
+// inside that variant's namespace and `#pragma GCC target` region, after defining Vec<float> and
+// Vec<double> for the variant. There is deliberately no include guard.
+//
+// Vec<T> provides: T, reg, mask, W (lanes), load/store (unaligned), set1, add/sub/mul/div/min/max,
+// fmadd(a, b, c) = a * b + c, round (to nearest), abs, copysign, lt, blend(m, if_true, if_false),
+// pow2n(n) = 2^n for integral n in the normal exponent range, frexp(x, e) (mantissa in [0.5, 1) for
+// positive normal x, exponent as a float value), and reduce_add/reduce_max/reduce_min.
+
+template <typename T>
+struct Kernels {
+    using V = Vec<T>;
+    using reg = typename V::reg;
+    static constexpr size_t W = V::W;
+
+    // The tail goes through a W-wide scratch block, so every element sees the same instruction
+    // sequence and results do not depend on where an element falls in the buffer.
+    template <typename Op>
+    static inline __attribute__((always_inline)) void map1(const T* in, T* out, size_t n) {
+        size_t i = 0;
+        for (; i + W <= n; i += W) {
+            V::store(out + i, Op::apply(V::load(in + i)));
+        }
+        if (i < n) {
+            T buf[W] = {};
+            std::copy(in + i, in + n, buf);
+            V::store(buf, Op::apply(V::load(buf)));
+            std::copy(buf, buf + (n - i), out + i);
+        }
+    }
+
+    template <typename Op>
+    static inline __attribute__((always_inline)) void map2(const T* a, const T* b, T* out, size_t n) {
+        size_t i = 0;
+        for (; i + W <= n; i += W) {
+            V::store(out + i, Op::apply(V::load(a + i), V::load(b + i)));
+        }
+        if (i < n) {
+            T ba[W] = {}, bb[W] = {};
+            std::copy(a + i, a + n, ba);
+            std::copy(b + i, b + n, bb);
+            V::store(ba, Op::apply(V::load(ba), V::load(bb)));
+            std::copy(ba, ba + (n - i), out + i);
+        }
+    }
+
+    // Per-element operations. These are member structs rather than lambdas: a lambda's call operator
+    // does not inherit the enclosing target region, so its vector arguments would cross an ABI boundary.
+    struct AddOp { static reg apply(reg x, reg y) { return V::add(x, y); } };
+    struct SubOp { static reg apply(reg x, reg y) { return V::sub(x, y); } };
+    struct MulOp { static reg apply(reg x, reg y) { return V::mul(x, y); } };
+    struct DivOp { static reg apply(reg x, reg y) { return V::div(x, y); } };
+    struct MinOp { static reg apply(reg x, reg y) { return V::min(x, y); } };
+    struct MaxOp { static reg apply(reg x, reg y) { return V::max(x, y); } };
+
+    static void add(const T* a, const T* b, T* out, size_t n) { map2<AddOp>(a, b, out, n); }
+    static void sub(const T* a, const T* b, T* out, size_t n) { map2<SubOp>(a, b, out, n); }
+    static void mul(const T* a, const T* b, T* out, size_t n) { map2<MulOp>(a, b, out, n); }
+    static void div(const T* a, const T* b, T* out, size_t n) { map2<DivOp>(a, b, out, n); }
+    static void min(const T* a, const T* b, T* out, size_t n) { map2<MinOp>(a, b, out, n); }
+    static void max(const T* a, const T* b, T* out, size_t n) { map2<MaxOp>(a, b, out, n); }
+
+    // Four independent accumulators hide the add latency; the tail is folded in scalar order.
+    static T sum(const T* in, size_t n) {
+        reg acc0 = V::set1(T(0)), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        size_t i = 0;
+        for (; i + 4 * W <= n; i += 4 * W) {
+            acc0 = V::add(acc0, V::load(in + i));
+            acc1 = V::add(acc1, V::load(in + i + W));
+            acc2 = V::add(acc2, V::load(in + i + 2 * W));
+            acc3 = V::add(acc3, V::load(in + i + 3 * W));
+        }
+        for (; i + W <= n; i += W) {
+            acc0 = V::add(acc0, V::load(in + i));
+        }
+        T total = V::reduce_add(V::add(V::add(acc0, acc1), V::add(acc2, acc3)));
+        for (; i < n; ++i) {
+            total += in[i];
+        }
+        return total;
+    }
+
+    // n must be non-zero.
+    static T reduce_max(const T* in, size_t n) {
+        reg acc = V::set1(in[0]);
+        size_t i = 0;
+        for (; i + W <= n; i += W) {
+            acc = V::max(acc, V::load(in + i));
+        }
+        T best = V::reduce_max(acc);
+        for (; i < n; ++i) {
+            best = in[i] > best ? in[i] : best;
+        }
+        return best;
+    }
+
+    static T reduce_min(const T* in, size_t n) {
+        reg acc = V::set1(in[0]);
+        size_t i = 0;
+        for (; i + W <= n; i += W) {
+            acc = V::min(acc, V::load(in + i));
+        }
+        T best = V::reduce_min(acc);
+        for (; i < n; ++i) {
+            best = in[i] < best ? in[i] : best;
+        }
+        return best;
+    }
+
+    static T dot(const T* a, const T* b, size_t n) {
+        reg acc0 = V::set1(T(0)), acc1 = acc0;
+        size_t i = 0;
+        for (; i + 2 * W <= n; i += 2 * W) {
+            acc0 = V::fmadd(V::load(a + i), V::load(b + i), acc0);
+            acc1 = V::fmadd(V::load(a + i + W), V::load(b + i + W), acc1);
+        }
+        for (; i + W <= n; i += W) {
+            acc0 = V::fmadd(V::load(a + i), V::load(b + i), acc0);
+        }
+        T total = V::reduce_add(V::add(acc0, acc1));
+        for (; i < n; ++i) {
+            total += a[i] * b[i];
+        }
+        return total;
+    }
+
+    // exp with Cody-Waite range reduction x = n ln2 + r, |r| <= ln2 / 2, then 2^n * exp(r). Float uses
+    // the Cephes expf polynomial, double the Cephes exp Pade form. 2^n is applied as two half-size powers
+    // so results near the overflow threshold and in the denormal range come out right. Inputs above
+    // log(max) give +inf and inputs whose result underflows completely give 0.
+    static inline __attribute__((always_inline)) reg exp_reg(reg x) {
+        using C = ExpConstants<T>;
+        const reg hi = V::set1(C::max_arg), lo = V::set1(C::min_arg);
+        const reg overflow = V::set1(std::numeric_limits<T>::infinity());
+        const auto too_big = V::lt(hi, x);
+        const auto too_small = V::lt(x, lo);
+        reg xc = V::min(V::max(x, lo), hi);
+
+        reg n = V::round(V::mul(xc, V::set1(C::log2e)));
+        reg r = V::fmadd(n, V::set1(-C::ln2_hi), xc);
+        r = V::fmadd(n, V::set1(-C::ln2_lo), r);
+
+        reg p;
+        if constexpr (sizeof(T) == 4) {
+            const reg r2 = V::mul(r, r);
+            p = V::set1(C::p[0]);
+            for (size_t k = 1; k < 6; ++k) {
+                p = V::fmadd(p, r, V::set1(C::p[k]));
+            }
+            p = V::fmadd(p, r2, V::add(r, V::set1(T(1))));
+        } else {
+            const reg r2 = V::mul(r, r);
+            reg pp = V::fmadd(V::fmadd(V::set1(C::p[0]), r2, V::set1(C::p[1])), r2, V::set1(C::p[2]));
+            reg qq = V::fmadd(V::fmadd(V::fmadd(V::set1(C::q[0]), r2, V::set1(C::q[1])), r2,
+                                       V::set1(C::q[2])), r2, V::set1(C::q[3]));
+            pp = V::mul(pp, r);
+            p = V::div(pp, V::sub(qq, pp));
+            p = V::fmadd(p, V::set1(T(2)), V::set1(T(1)));
+        }
+        const reg n1 = V::round(V::mul(n, V::set1(T(0.5))));
+        reg res = V::mul(V::mul(p, V::pow2n(n1)), V::pow2n(V::sub(n, n1)));
+        res = V::fmadd(x, V::set1(T(0)), res);  // NaN in, NaN out (the clamp above would drop it)
+        res = V::blend(too_big, overflow, res);
+        return V::blend(too_small, V::set1(T(0)), res);
+    }
+
+    // log with x = 2^e * m, m folded into [sqrt(1/2), sqrt(2)), then log(m) = f - f^2 / 2 + f^3 P(f) with
+    // f = m - 1: the Cephes logf polynomial for float, the Cephes log rational P/Q for double. Denormals
+    // are scaled into the normal range first. log(0) = -inf, log(x < 0) = NaN, log(inf) = inf.
+    static inline __attribute__((always_inline)) reg log_reg(reg x) {
+        using C = LogConstants<T>;
+        const reg one = V::set1(T(1));
+        const auto denormal = V::lt(x, V::set1(std::numeric_limits<T>::min()));
+        reg e;
+        reg m = V::frexp(V::blend(denormal, V::mul(x, V::set1(C::denorm_scale)), x), e);
+        e = V::blend(denormal, V::sub(e, V::set1(C::denorm_bits)), e);
+
+        const auto low = V::lt(m, V::set1(T(0.70710678118654752440)));
+        e = V::blend(low, V::sub(e, one), e);
+        const reg f = V::sub(V::blend(low, V::add(m, m), m), one);
+        const reg z = V::mul(f, f);
+
+        reg y;
+        if constexpr (sizeof(T) == 4) {
+            y = V::set1(C::p[0]);
+            for (size_t k = 1; k < 9; ++k) {
+                y = V::fmadd(y, f, V::set1(C::p[k]));
+            }
+            y = V::mul(V::mul(y, f), z);
+        } else {
+            reg pp = V::set1(C::p[0]);
+            for (size_t k = 1; k < 6; ++k) {
+                pp = V::fmadd(pp, f, V::set1(C::p[k]));
+            }
+            reg qq = V::add(f, V::set1(C::q[0]));
+            for (size_t k = 1; k < 5; ++k) {
+                qq = V::fmadd(qq, f, V::set1(C::q[k]));
+            }
+            y = V::mul(f, V::div(V::mul(z, pp), qq));
+        }
+        y = V::fmadd(e, V::set1(C::ln2_lo), y);
+        y = V::fmadd(z, V::set1(T(-0.5)), y);
+        reg res = V::fmadd(e, V::set1(C::ln2_hi), V::add(f, y));
+
+        res = V::fmadd(x, V::set1(T(0)), res);  // NaN in, NaN out; inf is fixed up below
+        res = V::blend(V::lt(V::set1(std::numeric_limits<T>::max()), x),
+                       V::set1(std::numeric_limits<T>::infinity()), res);
+        res = V::blend(V::lt(x, V::set1(std::numeric_limits<T>::denorm_min())),
+                       V::set1(-std::numeric_limits<T>::infinity()), res);
+        return V::blend(V::lt(x, V::set1(T(0))), V::set1(std::numeric_limits<T>::quiet_NaN()), res);
+    }
+
+    struct ExpOp { static reg apply(reg x) { return exp_reg(x); } };
+    struct LogOp { static reg apply(reg x) { return log_reg(x); } };
+    struct ReluOp { static reg apply(reg x) { return V::max(x, V::set1(T(0))); } };
+    struct SigmoidOp {
+        static reg apply(reg x) {
+            const reg one = V::set1(T(1));
+            return V::div(one, V::add(one, exp_reg(V::sub(V::set1(T(0)), x))));
+        }
+    };
+
+    // Cephes tanh: an odd minimax polynomial (rational for double) below |x| = 0.625, where
+    // 1 - 2 / (exp(2|x|) + 1) would cancel, and the exp form above it.
+    struct TanhOp {
+        static reg apply(reg x) {
+            using C = TanhConstants<T>;
+            const reg ax = V::abs(x);
+            const reg one = V::set1(T(1));
+            reg big = V::sub(one, V::div(V::set1(T(2)), V::add(exp_reg(V::add(ax, ax)), one)));
+            big = V::copysign(big, x);
+
+            const reg z = V::mul(x, x);
+            reg small;
+            if constexpr (sizeof(T) == 4) {
+                small = V::set1(C::p[0]);
+                for (size_t k = 1; k < 5; ++k) {
+                    small = V::fmadd(small, z, V::set1(C::p[k]));
+                }
+            } else {
+                reg pp = V::fmadd(V::fmadd(V::set1(C::p[0]), z, V::set1(C::p[1])), z, V::set1(C::p[2]));
+                reg qq = V::fmadd(V::fmadd(V::add(z, V::set1(C::q[0])), z, V::set1(C::q[1])), z,
+                                  V::set1(C::q[2]));
+                small = V::div(pp, qq);
+            }
+            small = V::fmadd(V::mul(small, z), x, x);
+            return V::blend(V::lt(ax, V::set1(T(0.625))), small, big);
+        }
+    };
+
+    static void exp(const T* in, T* out, size_t n) { map1<ExpOp>(in, out, n); }
+    static void log(const T* in, T* out, size_t n) { map1<LogOp>(in, out, n); }
+    static void relu(const T* in, T* out, size_t n) { map1<ReluOp>(in, out, n); }
+    static void sigmoid(const T* in, T* out, size_t n) { map1<SigmoidOp>(in, out, n); }
+    static void tanh(const T* in, T* out, size_t n) { map1<TanhOp>(in, out, n); }
+
+    // out = exp(in - max(in)) / sum. The tail is padded with -inf, which contributes exp(-inf) = 0.
+    static void softmax(const T* in, T* out, size_t n) {
+        if (n == 0) {
+            return;
+        }
+        const reg shift = V::set1(reduce_max(in, n));
+        reg acc = V::set1(T(0));
+        size_t i = 0;
+        for (; i + W <= n; i += W) {
+            const reg e = exp_reg(V::sub(V::load(in + i), shift));
+            V::store(out + i, e);
+            acc = V::add(acc, e);
+        }
+        if (i < n) {
+            T buf[W];
+            std::fill(buf, buf + W, -std::numeric_limits<T>::infinity());
+            std::copy(in + i, in + n, buf);
+            const reg e = exp_reg(V::sub(V::load(buf), shift));
+            V::store(buf, e);
+            std::copy(buf, buf + (n - i), out + i);
+            acc = V::add(acc, e);
+        }
+        const T inv = T(1) / V::reduce_add(acc);
+        const reg scale = V::set1(inv);
+        for (i = 0; i + W <= n; i += W) {
+            V::store(out + i, V::mul(V::load(out + i), scale));
+        }
+        for (; i < n; ++i) {
+            out[i] *= inv;
+        }
+    }
+
+    // -sum(target * log(pred)). The tail is padded with target 0, pred 1.
+    static T neg_log_likelihood(const T* target, const T* pred, size_t n) {
+        reg acc = V::set1(T(0));
+        size_t i = 0;
+        for (; i + W <= n; i += W) {
+            acc = V::fmadd(V::load(target + i), log_reg(V::load(pred + i)), acc);
+        }
+        if (i < n) {
+            T bt[W] = {}, bp[W];
+            std::fill(bp, bp + W, T(1));
+            std::copy(target + i, target + n, bt);
+            std::copy(pred + i, pred + n, bp);
+            acc = V::fmadd(V::load(bt), log_reg(V::load(bp)), acc);
+        }
+        return -V::reduce_add(acc);
+    }
+
+    static SimdKernels<T> table(SimdLevel level) {
+        SimdKernels<T> k;
+        k.level = level;
+        k.add = &add;
+        k.sub = &sub;
+        k.mul = &mul;
+        k.div = &div;
+        k.min = &min;
+        k.max = &max;
+        k.sum = &sum;
+        k.reduce_max = &reduce_max;
+        k.reduce_min = &reduce_min;
+        k.dot = &dot;
+        k.exp = &exp;
+        k.log = &log;
+        k.relu = &relu;
+        k.sigmoid = &sigmoid;
+        k.tanh = &tanh;
+        k.softmax = &softmax;
+        k.neg_log_likelihood = &neg_log_likelihood;
+        return k;
+    }
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "../tensor/thread_pool.hpp"
+
+// Sparse x dense and dense x sparse products shared by the Dot operator on a SparseMatrix.
+//
+// Sparse operands are stored as block compressed sparse rows (BSR): the matrix is cut into br x bc
+// blocks and only blocks holding a non-zero are kept. The blocks of block row I are block_ptr[I] up to
+// block_ptr[I + 1]; block b lies in block column block_col[b] and its br * bc values, row major, start
+// at values[b * br * bc]. 1 x 1 blocks give plain CSR. Blocks on the right and bottom edges are zero
+// padded past the matrix.
+//
+// Both products take time proportional to the stored values times the dense dimension, and split
+// their output rows over the ThreadPool.
+
+template <typename T>
+struct BsrMatrix
+{
+    size_t rows = 0, cols = 0;
+    size_t br = 1, bc = 1;
+    std::vector<size_t> block_ptr{0};
+    std::vector<size_t> block_col;
+    std::vector<T> values;
+
+    size_t block_row_count() const { return (rows + br - 1) / br; }
+    size_t block_count() const { return block_col.size(); }
+
+    // Compresses a dense row-major matrix, keeping every block that holds a non-zero.
+    static BsrMatrix from_dense(size_t rows, size_t cols, const T* a, size_t lda, size_t br = 1, size_t bc = 1)
+    {
+        if (br == 0 || bc == 0) {
+            throw std::invalid_argument("Sparse blocks must not be empty");
+        }
+        BsrMatrix res;
+        res.rows = rows;
+        res.cols = cols;
+        res.br = br;
+        res.bc = bc;
+        res.block_ptr.reserve(res.block_row_count() + 1);
+        for (size_t row0 = 0; row0 < rows; row0 += br) {
+            const size_t mr = std::min(br, rows - row0);
+            for (size_t col0 = 0; col0 < cols; col0 += bc) {
+                const size_t nc = std::min(bc, cols - col0);
+                bool nonzero = false;
+                for (size_t r = 0; r < mr && !nonzero; ++r) {
+                    for (size_t p = 0; p < nc && !nonzero; ++p) {
+                        nonzero = a[(row0 + r) * lda + col0 + p] != T();
+                    }
+                }
+                if (!nonzero) {
+                    continue;
+                }
+                res.block_col.push_back(col0 / bc);
+                for (size_t r = 0; r < br; ++r) {
+                    for (size_t p = 0; p < bc; ++p) {
+                        res.values.push_back(r < mr && p < nc ? a[(row0 + r) * lda + col0 + p] : T());
+                    }
+                }
+            }
+            res.block_ptr.push_back(res.block_col.size());
+        }
+        return res;
+    }
+
+    // Takes CSR arrays as they are; column indices need not be sorted within a row.
+    static BsrMatrix from_csr(size_t rows, size_t cols, std::vector<size_t> row_ptr,
+                              std::vector<size_t> col_idx, std::vector<T> values)
+    {
+        if (row_ptr.size() != rows + 1 || row_ptr.front() != 0 ||
+            row_ptr.back() != col_idx.size() || col_idx.size() != values.size()) {
+            throw std::invalid_argument("Inconsistent CSR arrays");
+        }
+        if (!std::is_sorted(row_ptr.begin(), row_ptr.end()) ||
+            std::any_of(col_idx.begin(), col_idx.end(), [cols](size_t j) { return j >= cols; })) {
+            throw std::invalid_argument("Invalid CSR row pointers or column indices");
+        }
+        BsrMatrix res;
+        res.rows = rows;
+        res.cols = cols;
+        res.block_ptr = std::move(row_ptr);
+        res.block_col = std::move(col_idx);
+        res.values = std::move(values);
+        return res;
+    }
+};
+
+namespace spmm_detail
+{
+    // Output rows handed to one thread at a time: enough for about this many multiply-adds.
+    constexpr size_t kWorkPerChunk = 1 << 15;
+
+    inline size_t row_grain(size_t work_per_row)
+    {
+        return std::max<size_t>(1, kWorkPerChunk / std::max<size_t>(1, work_per_row));
+    }
+
+    // Rows of a dense left operand handled together by the dense x sparse product.
+    constexpr size_t kPanelRows = 16;
+
+    template <typename T>
+    void axpy_panel(T alpha, const T* __restrict x, T* __restrict y)
+    {
+        for (size_t t = 0; t < kPanelRows; ++t) {
+            y[t] += alpha * x[t];
+        }
+    }
+
+    // y += alpha * x. The fixed-length inner loop lets the compiler vectorise it for the build target.
+    template <typename T>
+    void axpy(size_t n, T alpha, const T* __restrict x, T* __restrict y)
+    {
+        constexpr size_t W = 16;
+        size_t j = 0;
+        for (; j + W <= n; j += W) {
+            for (size_t t = 0; t < W; ++t) {
+                y[j + t] += alpha * x[j + t];
+            }
+        }
+        for (; j < n; ++j) {
+            y[j] += alpha * x[j];
+        }
+    }
+}
+
+// C = A * B with sparse A (a.rows x a.cols) and dense row-major B (a.cols x n); C is a.rows x n.
+template <typename T>
+void spmm(const BsrMatrix<T>& a, size_t n, const T* b, size_t ldb, T* c, size_t ldc)
+{
+    static_assert(std::is_arithmetic<T>::value, "Sparse products need an arithmetic element type");
+    const size_t br = a.br, bc = a.bc;
+    const size_t block_rows = a.block_row_count();
+    const size_t work = block_rows ? a.values.size() / block_rows * n : 0;
+    parallel_for(0, block_rows, [&](size_t first, size_t last) {
+        for (size_t bi = first; bi < last; ++bi) {
+            const size_t row0 = bi * br;
+            const size_t mr = std::min(br, a.rows - row0);
+            for (size_t r = 0; r < mr; ++r) {
+                std::fill(c + (row0 + r) * ldc, c + (row0 + r) * ldc + n, T());
+            }
+            for (size_t blk = a.block_ptr[bi]; blk < a.block_ptr[bi + 1]; ++blk) {
+                const size_t col0 = a.block_col[blk] * bc;
+                const size_t kc = std::min(bc, a.cols - col0);
+                const T* v = a.values.data() + blk * br * bc;
+                for (size_t r = 0; r < mr; ++r) {
+                    for (size_t p = 0; p < kc; ++p) {
+                        if (v[r * bc + p] != T()) {
+                            spmm_detail::axpy(n, v[r * bc + p], b + (col0 + p) * ldb, c + (row0 + r) * ldc);
+                        }
+                    }
+                }
+            }
+        }
+    }, spmm_detail::row_grain(work * br));
+}
+
+// C = A * B with dense row-major A (m x b.rows) and sparse B; C is m x b.cols. A is taken PR rows at a
+// time, transposed into a panel so that each stored value of B multiplies a contiguous PR-vector of A
+// into a PR-vector of the (likewise transposed) output panel. Rows of B whose panel of A is all zero
+// are skipped, which keeps a one-hot A cheap.
+template <typename T>
+void spmm(size_t m, const T* a, size_t lda, const BsrMatrix<T>& b, T* c, size_t ldc)
+{
+    static_assert(std::is_arithmetic<T>::value, "Sparse products need an arithmetic element type");
+    constexpr size_t PR = spmm_detail::kPanelRows;
+    const size_t br = b.br, bc = b.bc;
+    const size_t k = b.rows, n = b.cols;
+    const size_t block_rows = b.block_row_count();
+    parallel_for(0, (m + PR - 1) / PR, [&](size_t first, size_t last) {
+        static thread_local std::vector<T> a_panel, c_panel;
+        static thread_local std::vector<char> live;
+        a_panel.resize(k * PR);
+        c_panel.resize(n * PR);
+        live.resize(k);
+        for (size_t panel = first; panel < last; ++panel) {
+            const size_t i0 = panel * PR;
+            const size_t mr = std::min(PR, m - i0);
+            for (size_t p = 0; p < k; ++p) {
+                bool any = false;
+                for (size_t r = 0; r < PR; ++r) {
+                    const T x = r < mr ? a[(i0 + r) * lda + p] : T();
+                    a_panel[p * PR + r] = x;
+                    any = any || x != T();
+                }
+                live[p] = any;
+            }
+            std::fill(c_panel.begin(), c_panel.end(), T());
+
+            for (size_t bi = 0; bi < block_rows; ++bi) {
+                const size_t row0 = bi * br;
+                const size_t kr = std::min(br, k - row0);
+                for (size_t blk = b.block_ptr[bi]; blk < b.block_ptr[bi + 1]; ++blk) {
+                    const size_t col0 = b.block_col[blk] * bc;
+                    const size_t nc = std::min(bc, n - col0);
+                    const T* v = b.values.data() + blk * br * bc;
+                    for (size_t r = 0; r < kr; ++r) {
+                        if (!live[row0 + r]) {
+                            continue;
+                        }
+                        const T* ap = a_panel.data() + (row0 + r) * PR;
+                        for (size_t q = 0; q < nc; ++q) {
+                            spmm_detail::axpy_panel(v[r * bc + q], ap, c_panel.data() + (col0 + q) * PR);
+                        }
+                    }
+                }
+            }
+
+            for (size_t r = 0; r < mr; ++r) {
+                T* ci = c + (i0 + r) * ldc;
+                for (size_t j = 0; j < n; ++j) {
+                    ci[j] = c_panel[j * PR + r];
+                }
+            }
+        }
+    }, spmm_detail::row_grain(b.values.size() * PR));
+}
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "cpu_features.hpp"
+#include "../tensor/thread_pool.hpp"
+
+#if TENSOR_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// Blocked out-of-place matrix transpose shared by Tensor (copying transposed views) and MetaNN's
+// Transpose operator.
+//
+// dst (cols x rows, leading dimension ldd) = transpose of src (rows x cols, leading dimension lds).
+// A plain double loop writes dst with a stride of ldd, so on large matrices nearly every store misses
+// the cache. Here the matrix is halved along its longer side, recursively, until a block fits in L1
+// (cache-oblivious blocking). Each leaf block is moved in square micro blocks transposed in registers:
+// 8x8 with AVX shuffles for 4-byte elements, 4x4 with AVX for 8-byte ones and 8x8 with SSE2 unpacks
+// for 2-byte ones (float16, bfloat16). Block edges and other element types are copied one element at
+// a time. Large or batched inputs are split into bands of dst rows across the ThreadPool.
+namespace transpose_detail {
+    // A leaf is at most kLeaf x kLeaf elements: 64 KB of source and destination for 4-byte elements.
+    constexpr size_t kLeaf = 64;
+    // Source columns (dst rows) per parallel task.
+    constexpr size_t kBand = 256;
+    // Elements below which a transpose stays on the calling thread.
+    constexpr size_t kParallelMin = size_t(1) << 16;
+
+    // Moves the rows x cols block, both multiples of the micro block size. lds and ldd in elements.
+    using Leaf = void (*)(const void* src, size_t lds, void* dst, size_t ldd, size_t rows, size_t cols);
+
+    template<typename T>
+    void scalar_block(const T* src, size_t lds, T* dst, size_t ldd, size_t rows, size_t cols) {
+        for (size_t i = 0; i < rows; ++i) {
+            for (size_t j = 0; j < cols; ++j) {
+                dst[j * ldd + i] = src[i * lds + j];
+            }
+        }
+    }
+
+    template<typename T>
+    void scalar_leaf(const void* src, size_t lds, void* dst, size_t ldd, size_t rows, size_t cols) {
+        scalar_block(static_cast<const T*>(src), lds, static_cast<T*>(dst), ldd, rows, cols);
+    }
+
+    // Elements that the SIMD leaves may move as raw bits.
+    template<typename T>
+    constexpr bool simd_element = std::is_trivially_copyable<T>::value &&
+                                  (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+    template<typename T>
+    constexpr size_t micro_size() {
+        return sizeof(T) == 8 ? 4 : 8;
+    }
+}
+
+#if TENSOR_X86_DISPATCH
+#pragma GCC push_options
+#pragma GCC target("avx")
+namespace transpose_avx {
+    // 8x8 block of 4-byte elements: unpack pairs of rows, shuffle pairs of pairs, then swap 128-bit
+    // halves across the two groups of four rows.
+    inline void micro32(const float* src, size_t lds, float* dst, size_t ldd) {
+        __m256 r[8], t[8];
+        for (size_t i = 0; i < 8; ++i) {
+            r[i] = _mm256_loadu_ps(src + i * lds);
+        }
+        for (size_t i = 0; i < 8; i += 2) {
+            t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+            t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+        }
+        for (size_t i = 0; i < 8; i += 4) {
+            r[i] = _mm256_shuffle_ps(t[i], t[i + 2], 0x44);
+            r[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], 0xee);
+            r[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], 0x44);
+            r[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], 0xee);
+        }
+        for (size_t i = 0; i < 4; ++i) {
+            _mm256_storeu_ps(dst + i * ldd, _mm256_permute2f128_ps(r[i], r[i + 4], 0x20));
+            _mm256_storeu_ps(dst + (i + 4) * ldd, _mm256_permute2f128_ps(r[i], r[i + 4], 0x31));
+        }
+    }
+
+    // 4x4 block of 8-byte elements.
+    inline void micro64(const double* src, size_t lds, double* dst, size_t ldd) {
+        const __m256d r0 = _mm256_loadu_pd(src), r1 = _mm256_loadu_pd(src + lds);
+        const __m256d r2 = _mm256_loadu_pd(src + 2 * lds), r3 = _mm256_loadu_pd(src + 3 * lds);
+        const __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+        const __m256d t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+        _mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(dst + ldd, _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(dst + 2 * ldd, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(dst + 3 * ldd, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+
+    // 8x8 block of 2-byte elements: interleave 16-, 32- and then 64-bit lanes.
+    inline void micro16(const uint16_t* src, size_t lds, uint16_t* dst, size_t ldd) {
+        __m128i a[8], b[8];
+        for (size_t i = 0; i < 8; ++i) {
+            a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * lds));
+        }
+        for (size_t i = 0; i < 8; i += 2) {
+            b[i] = _mm_unpacklo_epi16(a[i], a[i + 1]);
+            b[i + 1] = _mm_unpackhi_epi16(a[i], a[i + 1]);
+        }
+        for (size_t i = 0; i < 8; i += 4) {
+            a[i] = _mm_unpacklo_epi32(b[i], b[i + 2]);
+            a[i + 1] = _mm_unpackhi_epi32(b[i], b[i + 2]);
+            a[i + 2] = _mm_unpacklo_epi32(b[i + 1], b[i + 3]);
+            a[i + 3] = _mm_unpackhi_epi32(b[i + 1], b[i + 3]);
+        }
+        for (size_t i = 0; i < 4; ++i) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i * ldd), _mm_unpacklo_epi64(a[i], a[i + 4]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (2 * i + 1) * ldd), _mm_unpackhi_epi64(a[i], a[i + 4]));
+        }
+    }
+
+    template<typename E, size_t M, void (*Micro)(const E*, size_t, E*, size_t)>
+    void leaf(const void* src, size_t lds, void* dst, size_t ldd, size_t rows, size_t cols) {
+        const E* s = static_cast<const E*>(src);
+        E* d = static_cast<E*>(dst);
+        for (size_t i = 0; i < rows; i += M) {
+            for (size_t j = 0; j < cols; j += M) {
+                Micro(s + i * lds + j, lds, d + j * ldd + i, ldd);
+            }
+        }
+    }
+}
+#pragma GCC pop_options
+#endif // TENSOR_X86_DISPATCH
+
+// Leaf kernels for each element size, and the level they were written for. A null leaf means the
+// element-wise loop, run on the element type itself.
+struct TransposeKernel {
+    SimdLevel level;
+    const char* name;
+    transpose_detail::Leaf leaf16;
+    transpose_detail::Leaf leaf32;
+    transpose_detail::Leaf leaf64;
+};
+
+// Kernel for `level`, or the scalar one if the host (or `level`) is below AVX2. The SIMD leaves only
+// need AVX, but SimdLevel has no step between SSE4.2 and AVX2.
+inline const TransposeKernel& transpose_kernel(SimdLevel level) {
+    static const TransposeKernel scalar{SimdLevel::Scalar, "scalar", nullptr, nullptr, nullptr};
+#if TENSOR_X86_DISPATCH
+    static const TransposeKernel avx{SimdLevel::AVX2, "avx",
+                                     transpose_avx::leaf<uint16_t, 8, transpose_avx::micro16>,
+                                     transpose_avx::leaf<float, 8, transpose_avx::micro32>,
+                                     transpose_avx::leaf<double, 4, transpose_avx::micro64>};
+    return std::min(level, detected_simd_level()) >= SimdLevel::AVX2 ? avx : scalar;
+#else
+    (void)level;
+    return scalar;
+#endif
+}
+
+// Kernel for the active level (see simd_level()).
+inline const TransposeKernel& transpose_kernel() {
+    static const TransposeKernel& active = transpose_kernel(simd_level());
+    return active;
+}
+
+namespace transpose_detail {
+    template<typename T>
+    Leaf leaf_for(const TransposeKernel& kernel) {
+        Leaf leaf = nullptr;
+        if constexpr (simd_element<T>) {
+            leaf = sizeof(T) == 2 ? kernel.leaf16 : sizeof(T) == 4 ? kernel.leaf32 : kernel.leaf64;
+        }
+        return leaf ? leaf : scalar_leaf<T>;
+    }
+
+    // Transposes one leaf: whole micro blocks through `leaf`, the ragged right and bottom edges
+    // element by element.
+    template<typename T>
+    void leaf_block(const T* src, size_t lds, T* dst, size_t ldd, size_t rows, size_t cols, Leaf leaf) {
+        constexpr size_t M = micro_size<T>();
+        const bool whole = leaf == scalar_leaf<T>;
+        const size_t r = whole ? rows : rows / M * M;
+        const size_t c = whole ? cols : cols / M * M;
+        if (r && c) {
+            leaf(src, lds, dst, ldd, r, c);
+        }
+        scalar_block(src + c, lds, dst + c * ldd, ldd, r, cols - c);
+        scalar_block(src + r * lds, lds, dst + r, ldd, rows - r, cols);
+    }
+
+    // Halves the longer side, at a multiple of the micro block size, until a block fits a leaf.
+    template<typename T>
+    void recurse(const T* src, size_t lds, T* dst, size_t ldd, size_t rows, size_t cols, Leaf leaf) {
+        constexpr size_t M = micro_size<T>();
+        while (rows > kLeaf || cols > kLeaf) {
+            if (rows >= cols) {
+                const size_t half = std::max(M, rows / 2 / M * M);
+                recurse(src, lds, dst, ldd, half, cols, leaf);
+                src += half * lds;
+                dst += half;
+                rows -= half;
+            } else {
+                const size_t half = std::max(M, cols / 2 / M * M);
+                recurse(src, lds, dst, ldd, rows, half, leaf);
+                src += half;
+                dst += half * ldd;
+                cols -= half;
+            }
+        }
+        leaf_block(src, lds, dst, ldd, rows, cols, leaf);
+    }
+}
+
+// Transposes `batch` matrices of the same shape: dst(b) (cols x rows, leading dimension ldd) =
+// transpose of src(b) (rows x cols, leading dimension lds), where src(b) and dst(b) return a
+// matrix's first element. Work is split into bands of kBand dst rows across the ThreadPool once the
+// total reaches kParallelMin elements.
+template<typename T, typename SrcAt, typename DstAt>
+void transpose_batched(size_t batch, size_t rows, size_t cols, SrcAt&& src, size_t lds, DstAt&& dst, size_t ldd,
+                       const TransposeKernel& kernel = transpose_kernel()) {
+    using namespace transpose_detail;
+    if (batch == 0 || rows == 0 || cols == 0) {
+        return;
+    }
+    const Leaf leaf = leaf_for<T>(kernel);
+    const size_t bands = (cols + kBand - 1) / kBand;
+    auto run = [&](size_t task) {
+        const size_t b = task / bands;
+        const size_t c0 = task % bands * kBand;
+        const size_t width = std::min(kBand, cols - c0);
+        recurse<T>(src(b) + c0, lds, dst(b) + c0 * ldd, ldd, rows, width, leaf);
+    };
+    const size_t tasks = batch * bands;
+    if (batch * rows * cols < kParallelMin || tasks == 1) {
+        for (size_t task = 0; task < tasks; ++task) {
+            run(task);
+        }
+        return;
+    }
+    const size_t grain = std::max<size_t>(1, kParallelMin / (rows * kBand));
+    parallel_for(0, tasks, [&](size_t begin, size_t end) {
+        for (size_t task = begin; task < end; ++task) {
+            run(task);
+        }
+    }, grain);
+}
+
+template<typename T>
+void transpose(const T* src, size_t lds, T* dst, size_t ldd, size_t rows, size_t cols,
+               const TransposeKernel& kernel = transpose_kernel()) {
+    transpose_batched<T>(1, rows, cols, [src](size_t) { return src; }, lds, [dst](size_t) { return dst; }, ldd,
+                         kernel);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <future>
+#include <string>
+#include <data/facilities/tags.h>
+#include <model_rel/param_initializer/param_initializer.h>
+#include <tensor/checkpoint.hpp>
+
+// Stages the parameter matrices of a ParamInitializer into a TensorFileWriter, one Tensor<TElem, 2> per
+// matrix, under the matrix's name. Matrix buffers are shared rather than copy-on-write, so the rows are
+// copied here (without the row padding); this copy is all that SaveParams leaves on the calling thread.
+template <typename TElem, typename TPolicyCont, typename TFillers>
+TensorFileWriter SnapshotParams(const ParamInitializer<TElem, TPolicyCont, TFillers>& p_init)
+{
+    TensorFileWriter res;
+    p_init.ForEachMatrix([&res](const std::string& name, const Matrix<TElem, DeviceTags::CPU>& mat)
+    {
+        const size_t rowNum = mat.RowNum();
+        const size_t colNum = mat.ColNum();
+        Tensor<TElem, 2> staged(std::array<size_t, 2>{rowNum, colNum});
+
+        auto mem = LowerAccess(mat);
+        const TElem* src = mem.RawMemory();
+        TElem* dst = staged.data();
+        for (size_t i = 0; i < rowNum; ++i)
+        {
+            std::copy(src + i * mem.RowLen(), src + i * mem.RowLen() + colNum, dst + i * colNum);
+        }
+        res.add(name, staged);
+    });
+    return res;
+}
+
+// Snapshots the parameters and queues them on p_writer; the returned future is ready once the
+// checkpoint file is on disk.
+template <typename TElem, typename TPolicyCont, typename TFillers>
+std::future<void> SaveParams(CheckpointWriter& p_writer,
+                             const ParamInitializer<TElem, TPolicyCont, TFillers>& p_init,
+                             const std::string& p_fileName)
+{
+    return p_writer.save(SnapshotParams(p_init), p_fileName);
+}
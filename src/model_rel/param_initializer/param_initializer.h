@@ -71,6 +71,16 @@ public:
         auto it = m_params.find(name);
         return it != m_params.end();
     }
+
+    // Calls fun(name, matrix) for every stored parameter matrix, in name order.
+    template <typename TFun>
+    void ForEachMatrix(TFun&& fun) const
+    {
+        for (const auto& p : m_params)
+        {
+            fun(p.first, p.second);
+        }
+    }
     
 private:
     TFillers m_filler;
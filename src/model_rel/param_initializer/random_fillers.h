@@ -0,0 +1,183 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include <data/facilities/tags.h>
+#include <kernels/random.hpp>
+
+// Random fillers for ParamInitializer, registered under a tag with SetFiller and applied as
+//     init.GetFiller<WeightTag>().Fill(matrix, fanIn, fanOut);
+// Each filler owns a Philox generator and gives every Fill call the next stream of its seed, so the
+// same seed and the same sequence of Fill calls reproduce the same parameters. The numbers are drawn in
+// parallel over the whole matrix and do not depend on the thread count, the SIMD level or the matrix
+// row padding: element (i, j) is element i * ColNum() + j of its stream.
+
+namespace NSRandomFiller
+{
+// Runs p_fill(TElem* out, size_t n, const RandomStream&) over the RowNum() x ColNum()
+// elements of p_mat. A padded matrix is filled through a gap-free staging buffer.
+template <typename TElem, typename TFill>
+void FillMatrix(Matrix<TElem, DeviceTags::CPU>& p_mat, Philox& p_gen, TFill&& p_fill)
+{
+    const RandomStream stream = p_gen.next();
+    const size_t rowNum = p_mat.RowNum();
+    const size_t colNum = p_mat.ColNum();
+    auto mem = LowerAccess(p_mat);
+    TElem* dst = mem.MutableRawMemory();
+    if (mem.RowLen() == colNum)
+    {
+        p_fill(dst, rowNum * colNum, stream);
+        return;
+    }
+
+    std::vector<TElem> staged(rowNum * colNum);
+    p_fill(staged.data(), staged.size(), stream);
+    for (size_t i = 0; i < rowNum; ++i)
+    {
+        std::copy(staged.begin() + i * colNum, staged.begin() + (i + 1) * colNum, dst + i * mem.RowLen());
+    }
+}
+}
+
+// Uniform in [min, max].
+class UniformFiller
+{
+public:
+    UniformFiller(double p_min, double p_max, uint64_t p_seed)
+        : m_gen(p_seed)
+        , m_min(static_cast<float>(p_min))
+        , m_max(static_cast<float>(p_max))
+    {
+        if (p_min > p_max)
+        {
+            throw std::runtime_error("UniformFiller: min > max");
+        }
+    }
+
+    template <typename TElem>
+    void Fill(Matrix<TElem, DeviceTags::CPU>& p_mat, size_t, size_t)
+    {
+        NSRandomFiller::FillMatrix(p_mat, m_gen, [this](TElem* out, size_t n, const RandomStream& s)
+        {
+            random_uniform(out, n, s, m_min, m_max);
+        });
+    }
+
+private:
+    Philox m_gen;
+    float m_min;
+    float m_max;
+};
+
+class GaussianFiller
+{
+public:
+    GaussianFiller(double p_mean, double p_std, uint64_t p_seed)
+        : m_gen(p_seed)
+        , m_mean(static_cast<float>(p_mean))
+        , m_std(static_cast<float>(p_std))
+    {
+        if (p_std < 0)
+        {
+            throw std::runtime_error("GaussianFiller: negative standard deviation");
+        }
+    }
+
+    template <typename TElem>
+    void Fill(Matrix<TElem, DeviceTags::CPU>& p_mat, size_t, size_t)
+    {
+        NSRandomFiller::FillMatrix(p_mat, m_gen, [this](TElem* out, size_t n, const RandomStream& s)
+        {
+            random_normal(out, n, s, m_mean, m_std);
+        });
+    }
+
+private:
+    Philox m_gen;
+    float m_mean;
+    float m_std;
+};
+
+// Gaussian, redrawn while more than two standard deviations from the mean.
+class TruncatedGaussianFiller
+{
+public:
+    TruncatedGaussianFiller(double p_mean, double p_std, uint64_t p_seed)
+        : m_gen(p_seed)
+        , m_mean(static_cast<float>(p_mean))
+        , m_std(static_cast<float>(p_std))
+    {
+        if (p_std < 0)
+        {
+            throw std::runtime_error("TruncatedGaussianFiller: negative standard deviation");
+        }
+    }
+
+    template <typename TElem>
+    void Fill(Matrix<TElem, DeviceTags::CPU>& p_mat, size_t, size_t)
+    {
+        NSRandomFiller::FillMatrix(p_mat, m_gen, [this](TElem* out, size_t n, const RandomStream& s)
+        {
+            random_truncated_normal(out, n, s, m_mean, m_std);
+        });
+    }
+
+private:
+    Philox m_gen;
+    float m_mean;
+    float m_std;
+};
+
+// Glorot & Bengio: uniform in +-sqrt(6 / (fanIn + fanOut)).
+class XavierFiller
+{
+public:
+    explicit XavierFiller(uint64_t p_seed)
+        : m_gen(p_seed)
+    {}
+
+    template <typename TElem>
+    void Fill(Matrix<TElem, DeviceTags::CPU>& p_mat, size_t p_fanIn, size_t p_fanOut)
+    {
+        if (p_fanIn + p_fanOut == 0)
+        {
+            throw std::runtime_error("XavierFiller: fanIn + fanOut is zero");
+        }
+        const float limit = static_cast<float>(std::sqrt(6.0 / static_cast<double>(p_fanIn + p_fanOut)));
+        NSRandomFiller::FillMatrix(p_mat, m_gen, [limit](TElem* out, size_t n, const RandomStream& s)
+        {
+            random_uniform(out, n, s, -limit, limit);
+        });
+    }
+
+private:
+    Philox m_gen;
+};
+
+// He et al., for ReLU layers: Gaussian with standard deviation sqrt(2 / fanIn).
+class HeFiller
+{
+public:
+    explicit HeFiller(uint64_t p_seed)
+        : m_gen(p_seed)
+    {}
+
+    template <typename TElem>
+    void Fill(Matrix<TElem, DeviceTags::CPU>& p_mat, size_t p_fanIn, size_t)
+    {
+        if (p_fanIn == 0)
+        {
+            throw std::runtime_error("HeFiller: fanIn is zero");
+        }
+        const float stdDev = static_cast<float>(std::sqrt(2.0 / static_cast<double>(p_fanIn)));
+        NSRandomFiller::FillMatrix(p_mat, m_gen, [stdDev](TElem* out, size_t n, const RandomStream& s)
+        {
+            random_normal(out, n, s, 0.0f, stdDev);
+        });
+    }
+
+private:
+    Philox m_gen;
+};
@@ -3,111 +3,35 @@
 #include <data/facilities/traits.h>
 #include <evaluate/facilities/eval_plan.h>
 #include <operators/facilities/tags.h>
+#include <evaluate/facilities/eval_fusion.h>
 #include <operators/operators.h>
 #include <cassert>
 #include <type_traits>
 #include <utility>
 
-template <typename TOperHandle, typename TElement, typename TDevice, typename TCategory>
-class EvalUnit;
-
-template <typename TOperHandle, typename TElem>
-class EvalUnit<TOperHandle, TElem, DeviceTags::CPU, CategoryTags::Matrix> : public BaseEvalUnit<DeviceTags::CPU>
+namespace NSAbs
 {
-public:
-    using ElementType = TElem;
-    using DeviceType = DeviceTags::CPU;
-
-    EvalUnit(TOperHandle oper,
-             EvalHandle<Matrix<ElementType, DeviceType>> evalOutput)
-        : m_oper(std::move(oper))
-        , m_evalOutput(evalOutput) { }
-
-    void Eval() override
-    {
-        const auto& p_v = m_oper.Data();
-        const size_t rowNum = p_v.RowNum();
-        const size_t colNum = p_v.ColNum();
-        
-        m_evalOutput.Allocate(rowNum, colNum);
-        auto& res = m_evalOutput.MutableData();
-        
-        auto mem_v1 = LowerAccess(p_v);
-        auto mem_res = LowerAccess(res);
-
-        const size_t src1PackNum = mem_v1.RowLen();
-        const size_t tgtPackNum = mem_res.RowLen();
-
-        const ElementType* r1 = mem_v1.RawMemory();
-        ElementType* r = mem_res.MutableRawMemory();
-
-        constexpr auto zeroValue = ElementType();
-        for (size_t i = 0; i < rowNum; ++i)
-        {
-            for (size_t j = 0; j < colNum; ++j)
-            {
-                r[j] = (r1[j] > zeroValue) ? r1[j] : -r1[j];
-            }
-            r1 += src1PackNum;
-            r += tgtPackNum;
-        }
-        m_evalOutput.SetEval();
-    }
-
-private:
-    TOperHandle m_oper;
-    EvalHandle<Matrix<ElementType, DeviceType>> m_evalOutput;
-};
+namespace NSCaseGen
+{
+template <typename TOperHandle, typename TElem, typename TDevice, typename TCategory>
+class EvalUnit;
 
-template <typename TOperHandle, typename TElem>
-class EvalUnit<TOperHandle, TElem, DeviceTags::CPU, CategoryTags::BatchMatrix> : public BaseEvalUnit<DeviceTags::CPU>
+template <typename TOperHandle, typename TElem, typename TCategory>
+class EvalUnit<TOperHandle, TElem, DeviceTags::CPU, TCategory>
+    : public ElementwiseEvalUnit<TElem, TCategory, TOperHandle>
 {
 public:
-    using ElementType = TElem;
-    using DeviceType = DeviceTags::CPU;
-
-    EvalUnit(TOperHandle oper,
-             EvalHandle<Batch<ElementType, DeviceType, CategoryTags::Matrix>> evalOutput)
-        : m_oper(std::move(oper))
-        , m_evalOutput(evalOutput) { }
+    using ElementwiseEvalUnit<TElem, TCategory, TOperHandle>::ElementwiseEvalUnit;
 
-    void Eval() override
+    void Apply(const TElem* const* operands, TElem* out, size_t n) const override
     {
-        const auto& p_v = m_oper.Data();
-        const size_t rowNum = p_v.RowNum();
-        const size_t colNum = p_v.ColNum();
-        const size_t batchNum = p_v.BatchNum();
-        
-        m_evalOutput.Allocate(batchNum, rowNum, colNum);
-        auto& res = m_evalOutput.MutableData();
-        constexpr auto zeroValue = ElementType();
-        for (size_t curBatch = 0; curBatch < batchNum; ++curBatch)
+        const TElem* r1 = operands[0];
+        constexpr auto zeroValue = TElem();
+        for (size_t j = 0; j < n; ++j)
         {
-            auto mem_v1 = LowerAccess(p_v[curBatch]);
-            auto mem_res = LowerAccess(res[curBatch]);
-            
-            const size_t src1PackNum = mem_v1.RowLen();
-            const size_t tgtPackNum = mem_res.RowLen();
-            
-            const ElementType* r1 = mem_v1.RawMemory();
-            ElementType* r = mem_res.MutableRawMemory();
-            
-            for (size_t i = 0; i < rowNum; ++i)
-            {
-                for (size_t j = 0; j < colNum; ++j)
-                {
-                    r[j] = (r1[j] > zeroValue) ? r1[j] : -r1[j];
-                }
-                r1 += src1PackNum;
-                r += tgtPackNum;
-            }
+            out[j] = (r1[j] > zeroValue) ? r1[j] : -r1[j];
         }
-        m_evalOutput.SetEval();
     }
-
-private:
-    TOperHandle m_oper;
-    EvalHandle<Batch<TElem, DeviceTags::CPU, CategoryTags::Matrix>> m_evalOutput;
 };
 
 struct Calculator
@@ -133,11 +57,13 @@ struct Calculator
         EvalPlan<DeviceType>::template Register<GroupType>(std::move(unit), dataPtr, {depVec});
     }
 };
+}
+}
 
 template <>
 struct OperSeq_<UnaryOpTags::Abs>
 {
-    using type = OperSeqContainer<Calculator>;
+    using type = OperSeqContainer<NSAbs::NSCaseGen::Calculator>;
 };
 
 template <typename TP>
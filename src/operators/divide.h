@@ -1,130 +1,32 @@
 #pragma once
 
 #include <operators/facilities/tags.h>
+#include <evaluate/facilities/eval_fusion.h>
 #include <operators/operators.h>
 #include <type_traits>
-template <typename TOperHandle1, typename TOperHandle2, typename TElem, typename TDevice, typename TCate>
-class EvalUnit;
-
-template <typename TOperHandle1, typename TOperHandle2, typename TElem>
-class EvalUnit<TOperHandle1, TOperHandle2, TElem, DeviceTags::CPU, CategoryTags::Matrix>
-    : public BaseEvalUnit<DeviceTags::CPU>
+namespace NSDivide
 {
-public:
-    using ElementType = TElem;
-    using DeviceType = DeviceTags::CPU;
-
-    EvalUnit(TOperHandle1&& oper1,
-             TOperHandle2&& oper2,
-             EvalHandle<Matrix<ElementType, DeviceType>> evalOutput)
-        : m_oper1(std::move(oper1))
-        , m_oper2(std::move(oper2))
-        , m_evalOutput(evalOutput) { }
-
-    void Eval() override
-    {
-        const auto& p_v1 = m_oper1.Data();
-        const auto& p_v2 = m_oper2.Data();
-        const size_t rowNum = p_v1.RowNum();
-        const size_t colNum = p_v1.ColNum();
-        assert(p_v2.RowNum() == rowNum);
-        assert(p_v2.ColNum() == colNum);
-
-        m_evalOutput.Allocate(rowNum, colNum);
-        auto& res = m_evalOutput.MutableData();
-
-        const auto mem_v1 = LowerAccess(p_v1);
-        const auto mem_v2 = LowerAccess(p_v2);
-        auto mem_res = LowerAccess(res);
-
-        const size_t src1PackNum = mem_v1.RowLen();
-        const size_t src2PackNum = mem_v2.RowLen();
-        const size_t tgtPackNum = mem_res.RowLen();
-
-        const TElem* r1 = mem_v1.RawMemory();
-        const TElem* r2 = mem_v2.RawMemory();
-        TElem* r = mem_res.MutableRawMemory();
-
-        for (size_t i = 0; i < rowNum; ++i)
-        {
-            for (size_t j = 0; j < colNum; ++j)
-            {
-                r[j] = r1[j] / r2[j];
-            }
-            r1 += src1PackNum;
-            r2 += src2PackNum;
-            r += tgtPackNum;
-        }
-        m_evalOutput.SetEval();
-    }
-
-private:
-    TOperHandle1 m_oper1;
-    TOperHandle2 m_oper2;
-    EvalHandle<Matrix<ElementType, DeviceType>> m_evalOutput;
-};
+namespace NSCaseGen
+{
+template <typename TOperHandle1, typename TOperHandle2, typename TElem, typename TDevice, typename TCategory>
+class EvalUnit;
 
-template <typename TOperHandle1, typename TOperHandle2, typename TElem>
-class EvalUnit<TOperHandle1, TOperHandle2, TElem, DeviceTags::CPU, CategoryTags::BatchMatrix>
-    : public BaseEvalUnit<DeviceTags::CPU>
+template <typename TOperHandle1, typename TOperHandle2, typename TElem, typename TCategory>
+class EvalUnit<TOperHandle1, TOperHandle2, TElem, DeviceTags::CPU, TCategory>
+    : public ElementwiseEvalUnit<TElem, TCategory, TOperHandle1, TOperHandle2>
 {
 public:
-    using ElementType = TElem;
-    using DeviceType = DeviceTags::CPU;
-
-    EvalUnit(TOperHandle1&& oper1,
-             TOperHandle2&& oper2,
-             EvalHandle<Batch<ElementType, DeviceType, CategoryTags::Matrix>> evalOutput)
-        : m_oper1(std::move(oper1))
-        , m_oper2(std::move(oper2))
-        , m_evalOutput(evalOutput) { }
+    using ElementwiseEvalUnit<TElem, TCategory, TOperHandle1, TOperHandle2>::ElementwiseEvalUnit;
 
-    void Eval() override
+    void Apply(const TElem* const* operands, TElem* out, size_t n) const override
     {
-        const auto& p_v1 = m_oper1.Data();
-        const auto& p_v2 = m_oper2.Data();
-        const size_t rowNum = p_v1.RowNum();
-        const size_t colNum = p_v1.ColNum();
-        const size_t batchNum = p_v1.BatchNum();
-        assert(p_v2.RowNum() == rowNum);
-        assert(p_v2.ColNum() == colNum);
-        assert(p_v2.BatchNum() == batchNum);
-
-        m_evalOutput.Allocate(batchNum, rowNum, colNum);
-        auto& res = m_evalOutput.MutableData();
-
-        for (size_t curBatch = 0; curBatch < batchNum; ++curBatch)
+        const TElem* r1 = operands[0];
+        const TElem* r2 = operands[1];
+        for (size_t j = 0; j < n; ++j)
         {
-            const auto mem_v1 = LowerAccess(p_v1[curBatch]);
-            const auto mem_v2 = LowerAccess(p_v2[curBatch]);
-            auto mem_res = LowerAccess(res[curBatch]);
-
-            const size_t src1PackNum = mem_v1.RowLen();
-            const size_t src2PackNum = mem_v2.RowLen();
-            const size_t tgtPackNum = mem_res.RowLen();
-
-            const TElem* r1 = mem_v1.RawMemory();
-            const TElem* r2 = mem_v2.RawMemory();
-            TElem* r = mem_res.MutableRawMemory();
-
-            for (size_t i = 0; i < rowNum; ++i)
-            {
-                for (size_t j = 0; j < colNum; ++j)
-                {
-                    r[j] = r1[j] / r2[j];
-                }
-                r1 += src1PackNum;
-                r2 += src2PackNum;
-                r += tgtPackNum;
-            }
+            out[j] = r1[j] / r2[j];
         }
-        m_evalOutput.SetEval();
     }
-
-private:
-    TOperHandle1 m_oper1;
-    TOperHandle2 m_oper2;
-    EvalHandle<Batch<ElementType, DeviceType, CategoryTags::Matrix>> m_evalOutput;
 };
 
 struct Calculator
@@ -152,11 +54,13 @@ struct Calculator
         EvalPlan<DeviceType>::template Register<GroupType>(std::move(unit), dataPtr, std::move(depVec));
     }
 };
+}
+}
 
 template <>
 struct OperSeq_<BinaryOpTags::Divide>
 {
-    using type = OperSeqContainer<Calculator>;
+    using type = OperSeqContainer<NSDivide::NSCaseGen::Calculator>;
 };
 
 template <typename TP1, typename TP2>
@@ -1,5 +1,8 @@
 #pragma once
 #include "operators/operators.h"
+#include <kernels/gemm.hpp>
+#include <kernels/qgemm.hpp>
+#include <kernels/spmm.hpp>
 
 template <>
 class OperOrganizer<BinaryOpTags::Dot, CategoryTags::Matrix>
@@ -45,6 +48,10 @@ private:
     size_t m_batchNum;
 };
 
+namespace NSDot
+{
+namespace NSCaseGen
+{
 template <typename TOperHandle1, typename TOperHandle2, typename TElem, typename TDevice, typename TCate>
 class EvalUnit;
 
@@ -76,23 +83,36 @@ public:
         m_evalOutput.Allocate(rowNum, colNum);
         auto& res = m_evalOutput.MutableData();
         
+        auto mem_v1 = LowerAccess(p_v1);
+        auto mem_v2 = LowerAccess(p_v2);
         auto mem_res = LowerAccess(res);
-        const size_t tgtPackNum = mem_res.RowLen();
-        
-        TElem* r = mem_res.MutableRawMemory();
 
-        for (size_t i = 0; i < rowNum; ++i)
+        if constexpr (IsSparseMatrix<decltype(p_v1)>)
         {
-            for (size_t j = 0; j < colNum; ++j)
-            {
-                *r = TElem();
-                for (size_t k = 0; k < midNum; ++k)
-                {
-                    *r += p_v1(i, k) * p_v2(k, j);
-                }
-                ++r;
-            }
-            r += tgtPackNum - colNum;
+            spmm(mem_v1.Storage(), colNum,
+                 mem_v2.RawMemory(), mem_v2.RowLen(),
+                 mem_res.MutableRawMemory(), mem_res.RowLen());
+        }
+        else if constexpr (IsSparseMatrix<decltype(p_v2)>)
+        {
+            spmm(rowNum, mem_v1.RawMemory(), mem_v1.RowLen(),
+                 mem_v2.Storage(),
+                 mem_res.MutableRawMemory(), mem_res.RowLen());
+        }
+        else if constexpr (IsQuantizedMatrix<decltype(p_v2)>)
+        {
+            // int8 weights: the left operand is quantised on the fly from its own range
+            qgemm(rowNum, colNum, midNum,
+                  mem_v1.RawMemory(), mem_v1.RowLen(),
+                  mem_v2.RawMemory(), mem_v2.RowLen(), mem_v2.Channels(),
+                  mem_res.MutableRawMemory(), mem_res.RowLen());
+        }
+        else
+        {
+            gemm(rowNum, colNum, midNum,
+                 mem_v1.RawMemory(), mem_v1.RowLen(),
+                 mem_v2.RawMemory(), mem_v2.RowLen(),
+                 mem_res.MutableRawMemory(), mem_res.RowLen());
         }
         m_evalOutput.SetEval();
     }
@@ -136,26 +156,14 @@ public:
         
         for (size_t cur_batch = 0; cur_batch < batchNum; ++cur_batch)
         {
+            auto mem_v1 = LowerAccess(p_v1[cur_batch]);
+            auto mem_v2 = LowerAccess(p_v2[cur_batch]);
             auto mem_res = LowerAccess(res[cur_batch]);
-            const size_t tgtPackNum = mem_res.RowLen();
-        
-            TElem* r = mem_res.MutableRawMemory();
-            auto cur_v1 = p_v1[cur_batch];
-            auto cur_v2 = p_v2[cur_batch];
 
-            for (size_t i = 0; i < rowNum; ++i)
-            {
-                for (size_t j = 0; j < colNum; ++j)
-                {
-                    *r = TElem();
-                    for (size_t k = 0; k < midNum; ++k)
-                    {
-                        *r += cur_v1(i, k) * cur_v2(k, j);
-                    }
-                    ++r;
-                }
-                r += tgtPackNum - colNum;
-            }
+            gemm(rowNum, colNum, midNum,
+                 mem_v1.RawMemory(), mem_v1.RowLen(),
+                 mem_v2.RawMemory(), mem_v2.RowLen(),
+                 mem_res.MutableRawMemory(), mem_res.RowLen());
         }
         m_evalOutput.SetEval();
     }
@@ -191,11 +199,13 @@ struct Calculator
         EvalPlan<DeviceType>::template Register<GroupType>(std::move(unit), dataPtr, std::move(depVec));
     }
 };
+}
+}
 
 template <>
 struct OperSeq_<BinaryOpTags::Dot>
 {
-    using type = OperSeqContainer<Calculator>;
+    using type = OperSeqContainer<NSDot::NSCaseGen::Calculator>;
 };
 
 template <typename TP1, typename TP2>
@@ -206,8 +216,15 @@ private:
     using rawM1 = RemConstRef<TP1>;
     using rawM2 = RemConstRef<TP2>;
 
+    // Quantised matrices only appear as the right operand of a single (non-batch) product, and
+    // sparse ones as either operand of a single product with a dense matrix. Neither is IsMatrix, so
+    // they are admitted here explicitly.
+    static constexpr bool special = (IsMatrix<rawM1> && (IsQuantizedMatrix<rawM2> || IsSparseMatrix<rawM2>)) ||
+                                    (IsSparseMatrix<rawM1> && IsMatrix<rawM2>);
+
 public:
-    static constexpr bool valid = (IsMatrix<rawM1> && IsMatrix<rawM2>) ||
+    static constexpr bool valid = special ||
+                                  (IsMatrix<rawM1> && IsMatrix<rawM2>) ||
                                   (IsBatchMatrix<rawM1> && IsMatrix<rawM2>) ||
                                   (IsMatrix<rawM1> && IsBatchMatrix<rawM2>) ||
                                   (IsBatchMatrix<rawM1> && IsBatchMatrix<rawM2>);
@@ -262,5 +279,6 @@ template <typename TP1, typename TP2,
 auto Dot(TP1&& p_m1, TP2&& p_m2)
 {
     return OperDot_<TP1, TP2>::
-            template Eval<DataCategory<TP1>, DataCategory<TP2>>(std::forward<TP1>(p_m1), std::forward<TP2>(p_m2));
+            template Eval<DataCategory<RemConstRef<TP1>>, DataCategory<RemConstRef<TP2>>>(std::forward<TP1>(p_m1),
+                                                                                          std::forward<TP2>(p_m2));
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <type_traits>
 #include <vector>
 #include <cmath>
+#include <kernels/half.hpp>
+#include <kernels/simd_kernels.hpp>
 #include <operators/operators.h>
 
 template <>
@@ -24,6 +26,35 @@ namespace NSNegativeLogLikelihood
 {
 namespace NSCaseGen
 {
+// -sum(tar * log(pre)) over one row of colNum elements, accumulated in float for 16-bit elements.
+template <typename TElem>
+accum_t<TElem> RowLoss(const TElem* tar, const TElem* pre, size_t colNum)
+{
+    if constexpr (has_simd_kernels<TElem>)
+    {
+        return simd_kernels<TElem>().neg_log_likelihood(tar, pre, colNum);
+    }
+    else if constexpr (is_half_float_v<TElem>)
+    {
+        float res = 0;
+        for_each_float_block(tar, pre, colNum,
+                             [&](const float* t, const float* p, size_t n)
+                             {
+                                 res += simd_kernels<float>().neg_log_likelihood(t, p, n);
+                             });
+        return res;
+    }
+    else
+    {
+        auto res = accum_t<TElem>();
+        for (size_t j = 0; j < colNum; ++j)
+        {
+            res -= tar[j] * log(pre[j]);
+        }
+        return res;
+    }
+}
+
 template <typename TOperHandle1, typename TOperHandle2, typename TElem, typename TDevice, typename TCate>
 class EvalUnit;
 
@@ -53,7 +84,7 @@ public:
         assert(p_pre.RowNum() == rowNum);
         assert(p_pre.ColNum() == colNum);
 
-        auto res = TElem();
+        auto res = accum_t<TElem>();
 
         auto mem_v1 = LowerAccess(p_tar);
         auto mem_v2 = LowerAccess(p_pre);
@@ -66,10 +97,7 @@ public:
 
         for (size_t i = 0; i < rowNum; ++i)
         {
-            for (size_t j = 0; j < colNum; ++j)
-            {
-                res -= r1[j] * log(r2[j]);
-            }
+            res += RowLoss(r1, r2, colNum);
             r1 += src1PackNum;
             r2 += src2PackNum;
         }
@@ -116,7 +144,7 @@ public:
 
         for (size_t curBatch = 0; curBatch < batchNum; ++curBatch)
         {
-            auto res = TElem();
+            auto res = accum_t<TElem>();
 
             auto mem_v1 = LowerAccess(p_tar[curBatch]);
             auto mem_v2 = LowerAccess(p_pre[curBatch]);
@@ -129,10 +157,7 @@ public:
 
             for (size_t i = 0; i < rowNum; ++i)
             {
-                for (size_t j = 0; j < colNum; ++j)
-                {
-                    res -= r1[j] * log(r2[j]);
-                }
+                res += RowLoss(r1, r2, colNum);
                 r1 += src1PackNum;
                 r2 += src2PackNum;
             }
@@ -1,9 +1,52 @@
 #pragma once
 
 #include <type_traits>
+#include <kernels/half.hpp>
+#include <kernels/simd_kernels.hpp>
 #include <operators/operators.h>
 #include <cmath>
 #include <algorithm>
+#include <vector>
+
+namespace NSVecSoftmax
+{
+namespace NSCaseGen
+{
+// r = exp(r1 - max(r1)) / sum over one row of colNum (> 0) elements. A 16-bit row is widened as a
+// whole, since the max and the sum span it.
+template <typename TElem>
+void SoftmaxRow(const TElem* r1, TElem* r, size_t colNum)
+{
+    if constexpr (has_simd_kernels<TElem>)
+    {
+        simd_kernels<TElem>().softmax(r1, r, colNum);
+    }
+    else if constexpr (is_half_float_v<TElem>)
+    {
+        static thread_local std::vector<float> buf;
+        buf.resize(colNum);
+        convert_half(r1, buf.data(), colNum);
+        simd_kernels<float>().softmax(buf.data(), buf.data(), colNum);
+        convert_half(buf.data(), r, colNum);
+    }
+    else
+    {
+        auto maxElem = *std::max_element(r1, r1 + colNum);
+
+        TElem sum = TElem();
+
+        for (size_t i = 0; i < colNum; ++i)
+        {
+            r[i] = exp(r1[i] - maxElem);
+            sum += r[i];
+        }
+
+        for (size_t i = 0; i < colNum; ++i)
+        {
+            r[i] /= sum;
+        }
+    }
+}
 
 template <typename TOperHandle, typename TElem, typename TDevice, typename TCate>
 class EvalUnit;
@@ -36,21 +79,7 @@ public:
 
         const ElementType* r1 = mem_v1.RawMemory();
         ElementType* r = mem_res.MutableRawMemory();
-        
-        auto maxElem = *std::max_element(r1, r1 + colNum);
-
-        ElementType sum = ElementType();
-
-        for (size_t i = 0; i < colNum; ++i)
-        {
-            r[i] = exp(r1[i] - maxElem);
-            sum += r[i];
-        }
-
-        for (size_t i = 0; i < colNum; ++i)
-        {
-            r[i] /= sum;
-        }
+        SoftmaxRow(r1, r, colNum);
         m_evalOutput.SetEval();
     }
 
@@ -90,21 +119,7 @@ public:
 
             const ElementType* r1 = mem_v1.RawMemory();
             ElementType* r = mem_res.MutableRawMemory();
-        
-            auto maxElem = *std::max_element(r1, r1 + colNum);
-
-            ElementType sum = ElementType();
-
-            for (size_t i = 0; i < colNum; ++i)
-            {
-                r[i] = exp(r1[i] - maxElem);
-                sum += r[i];
-            }
-
-            for (size_t i = 0; i < colNum; ++i)
-            {
-                r[i] /= sum;
-            }
+            SoftmaxRow(r1, r, colNum);
         }
         m_evalOutput.SetEval();
     }
@@ -137,11 +152,13 @@ struct Calculator
         EvalPlan<DeviceType>::template Register<GroupType>(std::move(unit), dataPtr, {depVec});
     }
 };
+}
+}
 
 template <>
 struct OperSeq_<UnaryOpTags::VecSoftmax>
 {
-    using type = OperSeqContainer<Calculator>;
+    using type = OperSeqContainer<NSVecSoftmax::NSCaseGen::Calculator>;
 };
 
 template <typename TP>
@@ -1,110 +1,45 @@
 #pragma once
 
 #include <type_traits>
+#include <evaluate/facilities/eval_fusion.h>
+#include <kernels/half.hpp>
+#include <kernels/simd_kernels.hpp>
 #include <operators/operators.h>
 #include <cmath>
 
-template <typename TOperHandle, typename TElem, typename TDevice, typename TCate>
+namespace NSTanh
+{
+namespace NSCaseGen
+{
+template <typename TOperHandle, typename TElem, typename TDevice, typename TCategory>
 class EvalUnit;
 
-template <typename TOperHandle, typename TElem>
-class EvalUnit<TOperHandle, TElem, DeviceTags::CPU, CategoryTags::Matrix>
-    : public BaseEvalUnit<DeviceTags::CPU>
+template <typename TOperHandle, typename TElem, typename TCategory>
+class EvalUnit<TOperHandle, TElem, DeviceTags::CPU, TCategory>
+    : public ElementwiseEvalUnit<TElem, TCategory, TOperHandle>
 {
 public:
-    using ElementType = TElem;
-    using DeviceType = DeviceTags::CPU;
-    
-    EvalUnit(TOperHandle oper,
-             EvalHandle<Matrix<ElementType, DeviceType>> evalOutput)
-        : m_oper(std::move(oper))
-        , m_evalOutput(evalOutput) { }
+    using ElementwiseEvalUnit<TElem, TCategory, TOperHandle>::ElementwiseEvalUnit;
 
-    void Eval() override
+    void Apply(const TElem* const* operands, TElem* out, size_t n) const override
     {
-        const auto& p_v = m_oper.Data();
-        const size_t rowNum = p_v.RowNum();
-        const size_t colNum = p_v.ColNum();
-        
-        m_evalOutput.Allocate(rowNum, colNum);
-        auto& res = m_evalOutput.MutableData();
-        
-        auto mem_v1 = LowerAccess(p_v);
-        auto mem_res = LowerAccess(res);
-
-        const size_t src1PackNum = mem_v1.RowLen();
-        const size_t tgtPackNum = mem_res.RowLen();
-
-        const ElementType* r1 = mem_v1.RawMemory();
-        ElementType* r = mem_res.MutableRawMemory();
-
-        for (size_t i = 0; i < rowNum; ++i)
+        const TElem* r1 = operands[0];
+        if constexpr (has_simd_kernels<TElem>)
         {
-            for (size_t j = 0; j < colNum; ++j)
-            {
-                r[j] = (ElementType)(tanh(r1[j]));
-            }
-            r1 += src1PackNum;
-            r += tgtPackNum;
+            simd_kernels<TElem>().tanh(r1, out, n);
         }
-        m_evalOutput.SetEval();
-    }
-
-private:
-    TOperHandle m_oper;
-    EvalHandle<Matrix<ElementType, DeviceType>> m_evalOutput;
-};
-
-template <typename TOperHandle, typename TElem>
-class EvalUnit<TOperHandle, TElem, DeviceTags::CPU, CategoryTags::BatchMatrix>
-    : public BaseEvalUnit<DeviceTags::CPU>
-{
-public:
-    using ElementType = TElem;
-    using DeviceType = DeviceTags::CPU;
-    
-    EvalUnit(TOperHandle oper,
-             EvalHandle<Batch<ElementType, DeviceType, CategoryTags::Matrix>> evalOutput)
-        : m_oper(std::move(oper))
-        , m_evalOutput(std::move(evalOutput)) { }
-
-    void Eval() override
-    {
-        const auto& p_v = m_oper.Data();
-        const size_t rowNum = p_v.RowNum();
-        const size_t colNum = p_v.ColNum();
-        const size_t batchNum = p_v.BatchNum();
-        
-        m_evalOutput.Allocate(batchNum, rowNum, colNum);
-        auto& res = m_evalOutput.MutableData();
-        
-        for (size_t cur_batch = 0; cur_batch < batchNum; ++cur_batch)
+        else if constexpr (is_half_float_v<TElem>)
         {
-            auto mem_v1 = LowerAccess(p_v[cur_batch]);
-            auto mem_res = LowerAccess(res[cur_batch]);
-
-            const size_t src1PackNum = mem_v1.RowLen();
-            const size_t tgtPackNum = mem_res.RowLen();
-
-            const ElementType* r1 = mem_v1.RawMemory();
-            ElementType* r = mem_res.MutableRawMemory();
-
-            for (size_t i = 0; i < rowNum; ++i)
+            map_as_float(r1, out, n, simd_kernels<float>().tanh);
+        }
+        else
+        {
+            for (size_t j = 0; j < n; ++j)
             {
-                for (size_t j = 0; j < colNum; ++j)
-                {
-                    r[j] = (ElementType)(tanh(r1[j]));
-                }
-                r1 += src1PackNum;
-                r += tgtPackNum;
+                out[j] = (TElem)(tanh(r1[j]));
             }
         }
-        m_evalOutput.SetEval();
     }
-
-private:
-    TOperHandle m_oper;
-    EvalHandle<Batch<ElementType, DeviceType, CategoryTags::Matrix>> m_evalOutput;
 };
 
 struct Calculator
@@ -130,11 +65,13 @@ struct Calculator
         EvalPlan<DeviceType>::template Register<GroupType>(std::move(unit), dataPtr, {depVec});
     }
 };
+}
+}
 
 template <>
 struct OperSeq_<UnaryOpTags::Tanh>
 {
-    using type = OperSeqContainer<Calculator>;
+    using type = OperSeqContainer<NSTanh::NSCaseGen::Calculator>;
 };
 
 template <typename TP>
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <operators/operators.h>
+#include <kernels/transpose.hpp>
 
 template <>
 class OperOrganizer<UnaryOpTags::Transpose, CategoryTags::Matrix>
@@ -64,21 +65,9 @@ public:
         auto& res = m_evalOutput.MutableData();
 
         auto mem_v1 = LowerAccess(p_v);
-        const size_t src1PackNum = mem_v1.RowLen();
-        const ElementType* r1 = mem_v1.RawMemory();
-
         auto mem_res = LowerAccess(res);
-        const size_t resPackNum = mem_res.RowLen();
-        ElementType* r = mem_res.MutableRawMemory();
-
-        for (size_t i = 0; i < rowNum; ++i)
-        {
-            for (size_t j = 0; j < colNum; ++j)
-            {
-                r[j * resPackNum + i] = r1[j];
-            }
-            r1 += src1PackNum;
-        }
+        transpose(mem_v1.RawMemory(), mem_v1.RowLen(), mem_res.MutableRawMemory(), mem_res.RowLen(),
+                  rowNum, colNum);
         m_evalOutput.SetEval();
     }
 
@@ -110,23 +99,43 @@ public:
         m_evalOutput.Allocate(batchNum, colNum, rowNum);
         auto& res = m_evalOutput.MutableData();
 
+        if (batchNum == 0)
+        {
+            m_evalOutput.SetEval();
+            return;
+        }
+
+        // One kernel call covers the batch when its matrices share their row lengths, as those of
+        // a Batch do; the matrices of other batch containers are transposed one by one.
+        std::vector<const ElementType*> srcs(batchNum);
+        std::vector<ElementType*> dsts(batchNum);
+        std::vector<size_t> srcPackNums(batchNum);
+        std::vector<size_t> resPackNums(batchNum);
+        bool uniform = true;
         for (size_t curBatch = 0; curBatch < batchNum; ++curBatch)
         {
             auto mem_v1 = LowerAccess(p_v[curBatch]);
-            const size_t src1PackNum = mem_v1.RowLen();
-            const ElementType* r1 = mem_v1.RawMemory();
+            srcs[curBatch] = mem_v1.RawMemory();
+            srcPackNums[curBatch] = mem_v1.RowLen();
 
             auto mem_res = LowerAccess(res[curBatch]);
-            const size_t resPackNum = mem_res.RowLen();
-            ElementType* r = mem_res.MutableRawMemory();
+            dsts[curBatch] = mem_res.MutableRawMemory();
+            resPackNums[curBatch] = mem_res.RowLen();
+            uniform = uniform && srcPackNums[curBatch] == srcPackNums[0] && resPackNums[curBatch] == resPackNums[0];
+        }
 
-            for (size_t i = 0; i < rowNum; ++i)
+        if (uniform)
+        {
+            transpose_batched<ElementType>(batchNum, rowNum, colNum,
+                                           [&srcs](size_t b) { return srcs[b]; }, srcPackNums[0],
+                                           [&dsts](size_t b) { return dsts[b]; }, resPackNums[0]);
+        }
+        else
+        {
+            for (size_t curBatch = 0; curBatch < batchNum; ++curBatch)
             {
-                for (size_t j = 0; j < colNum; ++j)
-                {
-                    r[j * resPackNum + i] = r1[j];
-                }
-                r1 += src1PackNum;
+                transpose(srcs[curBatch], srcPackNums[curBatch], dsts[curBatch], resPackNums[curBatch],
+                          rowNum, colNum);
             }
         }
         m_evalOutput.SetEval();
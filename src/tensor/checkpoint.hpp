@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include "tensor_io.hpp"
+
+// Writes checkpoints on a background thread, so saving does not stall the training step.
+//
+// The caller snapshots its parameters into a TensorFileWriter. TensorFileWriter::add takes a
+// copy-on-write snapshot, which is O(1) per tensor. save() queues the snapshot and returns right away.
+// The background thread then writes it with TensorFileWriter::write(filename, sync = true), one
+// checkpoint at a time in the order they were queued, and reports completion or the error through the
+// returned future.
+//
+//     CheckpointWriter checkpoints;
+//     TensorFileWriter snapshot;
+//     snapshot.add("weight", weight);
+//     std::future<void> done = checkpoints.save(std::move(snapshot), "step_1000.tnsr");
+//     weight.sub_(grad);   // copies the buffer once; the checkpoint keeps the old values
+//
+// A tensor updated while its checkpoint is pending pays for one copy of its elements, on its first
+// write. Updates must go through the Tensor. A raw pointer taken from data() before the snapshot
+// writes into the shared buffer, and therefore into the checkpoint.
+//
+// At most `max_queued` (at least one) checkpoints wait behind the one being written. When the queue is
+// full, save() blocks, so a slow disk cannot pile up snapshots without bound. The destructor finishes
+// every queued checkpoint before it returns.
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(size_t max_queued = 2)
+        : max_queued_(std::max<size_t>(max_queued, 1)), thread_([this] { run(); }) {}
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    ~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_.notify_one();
+        thread_.join();
+    }
+
+    std::future<void> save(TensorFileWriter tensors, const std::string& filename) {
+        Job job{std::move(tensors), filename, {}};
+        std::future<void> done = job.done.get_future();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            space_.wait(lock, [&] { return queue_.size() < max_queued_; });
+            queue_.push_back(std::move(job));
+        }
+        work_.notify_one();
+        return done;
+    }
+
+    // The single-tensor form, writing the same file as Tensor::save.
+    template<typename T, size_t Dim>
+    std::future<void> save(const Tensor<T, Dim>& tensor, const std::string& filename) {
+        TensorFileWriter tensors;
+        tensors.add("tensor", tensor);
+        return save(std::move(tensors), filename);
+    }
+
+    // Checkpoints queued or being written.
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size() + (busy_ ? 1 : 0);
+    }
+
+    // Blocks until every checkpoint queued so far has been written (or has failed).
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_.wait(lock, [&] { return queue_.empty() && !busy_; });
+    }
+
+private:
+    struct Job {
+        TensorFileWriter tensors;
+        std::string filename;
+        std::promise<void> done;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            work_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            Job job = std::move(queue_.front());
+            queue_.pop_front();
+            busy_ = true;
+            lock.unlock();
+            space_.notify_all();
+
+            std::exception_ptr error;
+            try {
+                job.tensors.write(job.filename, true);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            // Release the snapshot first, so a tensor written once the future is ready is not copied.
+            job.tensors = TensorFileWriter();
+            if (error) {
+                job.done.set_exception(error);
+            } else {
+                job.done.set_value();
+            }
+
+            lock.lock();
+            busy_ = false;
+            space_.notify_all();
+        }
+    }
+
+    const size_t max_queued_;
+    mutable std::mutex mutex_;
+    std::condition_variable work_;
+    std::condition_variable space_;
+    std::deque<Job> queue_;
+    bool busy_ = false;
+    bool stop_ = false;
+    std::thread thread_;   // last, so it starts after the members it uses
+};
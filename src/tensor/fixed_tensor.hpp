@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "tensor.hpp"
+
+// A tensor whose extents are part of its type, for the tiny fixed-size matrices and vectors of geometry
+// code (3x3 rotations, 4x4 transforms). The elements live inside the object, with no heap buffer,
+// reference count or stored shape, and every loop has a compile-time trip count. Element-wise
+// operations are expanded over an index_sequence, and matmul unrolls its inner two loops the same way,
+// so the compiler vectorises and keeps small operands in registers.
+//
+// Unlike Tensor, a FixedTensor is a plain value: copies copy the elements and there are no views.
+// to_tensor() and the explicit FixedTensor(const Tensor&) constructor convert between the two; the
+// latter checks the shape and accepts strided views.
+namespace fixed_detail {
+    template<size_t... Dims>
+    constexpr std::array<size_t, sizeof...(Dims)> contiguous_strides() {
+        std::array<size_t, sizeof...(Dims)> shape{Dims...}, strides{};
+        size_t stride = 1;
+        for (size_t i = sizeof...(Dims); i-- > 0;) {
+            strides[i] = stride;
+            stride *= shape[i];
+        }
+        return strides;
+    }
+
+    // Extent I of Dims, or 0 past the last dimension.
+    template<size_t I, size_t... Dims>
+    constexpr size_t extent_v = I < sizeof...(Dims) ? std::array<size_t, sizeof...(Dims)>{Dims...}[I] : 0;
+
+    template<typename F, size_t... I>
+    void unroll(F&& fn, std::index_sequence<I...>) {
+        (fn(std::integral_constant<size_t, I>()), ...);
+    }
+
+    // Calls fn(std::integral_constant<size_t, i>) for i < N as straight-line code.
+    template<size_t N, typename F>
+    void unroll(F&& fn) {
+        unroll(fn, std::make_index_sequence<N>());
+    }
+}
+
+template<typename T, size_t... Dims>
+class FixedTensor {
+    static_assert(sizeof...(Dims) > 0, "A FixedTensor needs at least one dimension");
+    static_assert(((Dims > 0) && ...), "FixedTensor extents must be positive");
+
+    template<typename, size_t...> friend class FixedTensor;
+
+    // Rows and columns of a matrix; only meaningful when rank == 2.
+    static constexpr size_t kRows = fixed_detail::extent_v<0, Dims...>;
+    static constexpr size_t kCols = fixed_detail::extent_v<1, Dims...>;
+
+public:
+    static constexpr size_t rank = sizeof...(Dims);
+
+    FixedTensor() : data_{} {}
+
+    // Elements in row-major order.
+    FixedTensor(const std::array<T, (Dims * ...)>& values) {
+        std::copy(values.begin(), values.end(), data_);
+    }
+
+    explicit FixedTensor(const Tensor<T, rank>& tensor) {
+        if (tensor.shape() != shape()) {
+            throw std::invalid_argument("Tensor shape does not match the FixedTensor");
+        }
+        const Tensor<T, rank> src = tensor.is_contiguous() ? tensor.view() : tensor.contiguous();
+        std::copy(src.data(), src.data() + size(), data_);
+    }
+
+    static FixedTensor filled(const T& value) {
+        FixedTensor result;
+        fixed_detail::unroll<size()>([&](auto i) { result.data_[i] = value; });
+        return result;
+    }
+
+    static FixedTensor identity() {
+        static_assert(rank == 2 && kRows == kCols, "identity() is only defined for square matrices");
+        FixedTensor result;
+        fixed_detail::unroll<kRows>([&](auto i) { result.data_[i * (kRows + 1)] = T(1); });
+        return result;
+    }
+
+    static constexpr std::array<size_t, rank> shape() { return {Dims...}; }
+    static constexpr std::array<size_t, rank> strides() { return fixed_detail::contiguous_strides<Dims...>(); }
+    static constexpr size_t size() { return (Dims * ...); }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+
+    T& operator()(const std::array<size_t, rank>& indices) { return data_[flat_index(indices)]; }
+    const T& operator()(const std::array<size_t, rank>& indices) const { return data_[flat_index(indices)]; }
+
+    // A fresh row-major Tensor holding a copy of the elements.
+    Tensor<T, rank> to_tensor() const {
+        Tensor<T, rank> result(shape());
+        std::copy(data_, data_ + size(), result.data());
+        return result;
+    }
+
+    FixedTensor& operator+=(const FixedTensor& other) { return apply(other, [](T& a, T b) { a += b; }); }
+    FixedTensor& operator-=(const FixedTensor& other) { return apply(other, [](T& a, T b) { a -= b; }); }
+    FixedTensor& operator*=(const FixedTensor& other) { return apply(other, [](T& a, T b) { a *= b; }); }
+    FixedTensor& operator/=(const FixedTensor& other) { return apply(other, [](T& a, T b) { a /= b; }); }
+    FixedTensor& operator+=(const T& value) { return apply(value, [](T& a, T b) { a += b; }); }
+    FixedTensor& operator-=(const T& value) { return apply(value, [](T& a, T b) { a -= b; }); }
+    FixedTensor& operator*=(const T& value) { return apply(value, [](T& a, T b) { a *= b; }); }
+    FixedTensor& operator/=(const T& value) { return apply(value, [](T& a, T b) { a /= b; }); }
+
+    FixedTensor<T, kCols, kRows> transpose() const {
+        static_assert(rank == 2, "transpose() is only defined for matrices");
+        FixedTensor<T, kCols, kRows> result;
+        fixed_detail::unroll<kRows>([&](auto i) {
+            fixed_detail::unroll<kCols>([&](auto j) { result.data_[j * kRows + i] = data_[i * kCols + j]; });
+        });
+        return result;
+    }
+
+    // (M x K) * (K x N). Each result row is accumulated in a local array, which stays in registers,
+    // as a sum of rank-1 updates with the loops over K and N unrolled.
+    template<size_t N>
+    FixedTensor<T, kRows, N> matmul(const FixedTensor<T, kCols, N>& other) const {
+        static_assert(rank == 2, "matmul() is only defined for matrices");
+        FixedTensor<T, kRows, N> result;
+        for (size_t i = 0; i < kRows; ++i) {
+            T row[N] = {};
+            fixed_detail::unroll<kCols>([&](auto k) {
+                const T a = data_[i * kCols + k];
+                const T* b = other.data_ + k * N;
+                fixed_detail::unroll<N>([&](auto j) { row[j] += a * b[j]; });
+            });
+            fixed_detail::unroll<N>([&](auto j) { result.data_[i * N + j] = row[j]; });
+        }
+        return result;
+    }
+
+    // Matrix-vector product: (M x K) * (K).
+    FixedTensor<T, kRows> matmul(const FixedTensor<T, kCols>& vector) const {
+        static_assert(rank == 2, "matmul() is only defined for matrices");
+        FixedTensor<T, kRows> result;
+        fixed_detail::unroll<kRows>([&](auto i) {
+            T sum = T(0);
+            fixed_detail::unroll<kCols>([&](auto k) { sum += data_[i * kCols + k] * vector.data_[k]; });
+            result.data_[i] = sum;
+        });
+        return result;
+    }
+
+private:
+    static size_t flat_index(const std::array<size_t, rank>& indices) {
+        constexpr std::array<size_t, rank> s = strides();
+        size_t index = 0;
+        fixed_detail::unroll<rank>([&](auto d) { index += indices[d] * s[d]; });
+        return index;
+    }
+
+    template<typename Op>
+    FixedTensor& apply(const FixedTensor& other, Op op) {
+        fixed_detail::unroll<size()>([&](auto i) { op(data_[i], other.data_[i]); });
+        return *this;
+    }
+
+    template<typename Op>
+    FixedTensor& apply(const T& value, Op op) {
+        fixed_detail::unroll<size()>([&](auto i) { op(data_[i], value); });
+        return *this;
+    }
+
+    T data_[(Dims * ...)];
+};
+
+template<typename T, size_t... Dims>
+FixedTensor<T, Dims...> operator+(FixedTensor<T, Dims...> a, const FixedTensor<T, Dims...>& b) { return a += b; }
+
+template<typename T, size_t... Dims>
+FixedTensor<T, Dims...> operator-(FixedTensor<T, Dims...> a, const FixedTensor<T, Dims...>& b) { return a -= b; }
+
+template<typename T, size_t... Dims>
+FixedTensor<T, Dims...> operator*(FixedTensor<T, Dims...> a, const FixedTensor<T, Dims...>& b) { return a *= b; }
+
+template<typename T, size_t... Dims>
+FixedTensor<T, Dims...> operator/(FixedTensor<T, Dims...> a, const FixedTensor<T, Dims...>& b) { return a /= b; }
+
+template<typename T, size_t... Dims>
+FixedTensor<T, Dims...> operator*(FixedTensor<T, Dims...> a, const T& s) { return a *= s; }
+
+template<typename T, size_t... Dims>
+FixedTensor<T, Dims...> operator*(const T& s, FixedTensor<T, Dims...> a) { return a *= s; }
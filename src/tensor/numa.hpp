@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+#include "numa_placement.hpp"
+#include "tensor_storage.hpp"
+#include "thread_pool.hpp"
+
+// NUMA-placed tensor storage. The topology, the placements and the placement helpers are in
+// numa_placement.hpp.
+
+// A zero-filled storage of n elements placed as asked. Default and small buffers come from
+// make_tensor_storage. The others are page-aligned anonymous mappings, held like a mapped file
+// (is_external()). Parallel placement touches elements rather than bytes, so the pages of element range
+// [a, b) go to the thread that parallel_for gives [a, b) to. A copy-on-write copy of the storage is an
+// ordinary buffer, written by the thread that detaches it, and does not keep the placement.
+template<typename T>
+std::shared_ptr<TensorStorage<T>> make_numa_storage(size_t n, NumaPlacement placement) {
+    static_assert(std::is_trivially_copyable<T>::value, "NUMA-placed storage holds trivially copyable elements");
+    const size_t bytes = n * sizeof(T);
+    if (placement == NumaPlacement::Default || bytes < numa_detail::page_size()) {
+        return make_tensor_storage<T>(n);
+    }
+    void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    std::shared_ptr<const void> owner(p, [bytes](const void* q) { ::munmap(const_cast<void*>(q), bytes); });
+    T* data = static_cast<T*>(p);
+    if (placement == NumaPlacement::Interleave) {
+        numa_interleave(p, bytes);
+    } else {
+        parallel_for(0, n, [data](size_t begin, size_t end) {
+            std::memset(static_cast<void*>(data + begin), 0, (end - begin) * sizeof(T));
+        });
+    }
+    return make_tensor_storage<T>(std::move(owner), data, n);
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "thread_pool.hpp"
+
+// NUMA topology and memory placement, read from /sys and applied with raw system calls (no libnuma).
+//
+// A fresh page lands on the node of the thread that first writes it. A buffer zero-filled by the main
+// thread therefore sits on one node, and on a multi-socket host half of every parallel op over it runs
+// across the inter-socket link. Two placements avoid that:
+//
+//   NumaPlacement::Parallel    the pages are first touched by the ThreadPool with parallel_for's
+//                              partitioning. Once the pool is pinned (pin_thread_pool), each thread
+//                              then finds its share of every range on its own node.
+//   NumaPlacement::Interleave  the pages are spread round-robin over the nodes (mbind MPOL_INTERLEAVE).
+//                              Use it for data that every thread reads, such as the weights of a
+//                              GEMM, or whose access pattern does not follow parallel_for.
+//
+// NumaPlacement::Default leaves placement to first touch by whoever writes first. Tensor takes a
+// placement through its constructor (make_numa_storage, numa.hpp), and MetaNN's
+// Allocator<DeviceTags::CPU> through SetNumaPlacement(). On a single-node machine every placement
+// behaves like Default.
+//
+// This header does not depend on TensorStorage, so the MetaNN allocator can include it alone.
+enum class NumaPlacement {
+    Default,
+    Parallel,
+    Interleave,
+};
+
+namespace numa_detail {
+    constexpr int kMpolInterleave = 3;
+    constexpr unsigned kMpolMfMove = 1u << 1;
+    constexpr size_t kMaxNodes = 1024;
+
+    // Parses a kernel CPU list such as "0-3,8,10-11".
+    inline std::vector<int> parse_cpu_list(const std::string& text) {
+        std::vector<int> cpus;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            if (!std::isdigit(static_cast<unsigned char>(text[pos]))) {
+                ++pos;
+                continue;
+            }
+            size_t used = 0;
+            const int first = std::stoi(text.substr(pos), &used);
+            pos += used;
+            int last = first;
+            if (pos < text.size() && text[pos] == '-') {
+                last = std::stoi(text.substr(pos + 1), &used);
+                pos += used + 1;
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    // The CPUs this process may run on.
+    inline std::vector<int> allowed_cpus() {
+        std::vector<int> cpus;
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        return cpus;
+    }
+
+    inline size_t page_size() {
+        static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+}
+
+// The NUMA nodes that have CPUs this process may use, and those CPUs.
+class NumaTopology {
+public:
+    struct Node {
+        int id;                  // the kernel's node number
+        std::vector<int> cpus;   // ascending
+    };
+
+    // The topology of this machine, read once.
+    static const NumaTopology& system() {
+        static const NumaTopology topology =
+            from_sysfs("/sys/devices/system/node", numa_detail::allowed_cpus());
+        return topology;
+    }
+
+    // Reads root/node<N>/cpulist, keeping the CPUs in `allowed` (all of them if it is empty). Without
+    // any node directory, e.g. in a kernel built without NUMA, the result is one node 0 with `allowed`.
+    static NumaTopology from_sysfs(const std::string& root, const std::vector<int>& allowed) {
+        NumaTopology topology;
+        if (DIR* dir = ::opendir(root.c_str())) {
+            while (const dirent* entry = ::readdir(dir)) {
+                const char* name = entry->d_name;
+                if (std::strncmp(name, "node", 4) != 0 || !std::isdigit(static_cast<unsigned char>(name[4]))) {
+                    continue;
+                }
+                std::ifstream file(root + "/" + name + "/cpulist");
+                std::string list;
+                std::getline(file, list);
+                Node node{std::atoi(name + 4), {}};
+                for (int cpu : numa_detail::parse_cpu_list(list)) {
+                    if (allowed.empty() || std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                        node.cpus.push_back(cpu);
+                    }
+                }
+                if (!node.cpus.empty()) {
+                    topology.nodes_.push_back(std::move(node));
+                }
+            }
+            ::closedir(dir);
+        }
+        if (topology.nodes_.empty()) {
+            topology.nodes_.push_back(Node{0, allowed});
+        }
+        std::sort(topology.nodes_.begin(), topology.nodes_.end(),
+                  [](const Node& a, const Node& b) { return a.id < b.id; });
+        return topology;
+    }
+
+    size_t node_count() const { return nodes_.size(); }
+    const Node& node(size_t i) const { return nodes_[i]; }
+
+    // All CPUs, node by node: the order in which pin_thread_pool hands them to the pool's threads.
+    std::vector<int> cpu_order() const {
+        std::vector<int> cpus;
+        for (const Node& node : nodes_) {
+            cpus.insert(cpus.end(), node.cpus.begin(), node.cpus.end());
+        }
+        return cpus;
+    }
+
+    // The index (not the id) of the node holding `cpu`, or -1.
+    int node_of_cpu(int cpu) const {
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            if (std::binary_search(nodes_[i].cpus.begin(), nodes_[i].cpus.end(), cpu)) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+private:
+    std::vector<Node> nodes_;
+};
+
+// Pins the ThreadPool's threads to the topology's CPUs, node by node (see ThreadPool::pin_threads).
+// Pinning also affects the calling thread, which stands in for the pool's first thread: block 0 of a
+// range runs on the thread that submits it, so pages placed with NumaPlacement::Parallel only line up
+// with the threads that process them when the calling thread submits the parallel work. The calling
+// thread stays pinned until it calls unpin_thread_pool().
+inline bool pin_thread_pool(const NumaTopology& topology = NumaTopology::system()) {
+    return ThreadPool::instance().pin_threads(topology.cpu_order());
+}
+
+// Undoes pin_thread_pool, from the thread that called it (see ThreadPool::unpin_threads).
+inline bool unpin_thread_pool() {
+    return ThreadPool::instance().unpin_threads();
+}
+
+// Interleaves the whole pages inside [p, p + bytes) over the topology's nodes, moving pages that are
+// already resident. Returns false if the kernel refused; with a single node it does nothing.
+inline bool numa_interleave(void* p, size_t bytes, const NumaTopology& topology = NumaTopology::system()) {
+    if (topology.node_count() < 2) {
+        return true;
+    }
+    const size_t page = numa_detail::page_size();
+    const uintptr_t begin = (reinterpret_cast<uintptr_t>(p) + page - 1) & ~(page - 1);
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(p) + bytes) & ~(page - 1);
+    if (end <= begin) {
+        return true;
+    }
+    unsigned long mask[numa_detail::kMaxNodes / (8 * sizeof(unsigned long))] = {};
+    constexpr size_t kBits = 8 * sizeof(unsigned long);
+    for (size_t i = 0; i < topology.node_count(); ++i) {
+        const size_t id = static_cast<size_t>(topology.node(i).id);
+        if (id < numa_detail::kMaxNodes) {
+            mask[id / kBits] |= 1ul << (id % kBits);
+        }
+    }
+    // The kernel reads maxnode - 1 bits of the mask.
+    return ::syscall(SYS_mbind, begin, end - begin, numa_detail::kMpolInterleave, mask,
+                     numa_detail::kMaxNodes + 1, numa_detail::kMpolMfMove) == 0;
+}
+
+// Zero-fills [p, p + bytes) with parallel_for, so each page is first touched by the pool thread that
+// owns it in parallel_for's partitioning of the same range.
+inline void numa_first_touch(void* p, size_t bytes, size_t grain = ThreadPool::DEFAULT_GRAIN) {
+    char* bytes_ptr = static_cast<char*>(p);
+    parallel_for(0, bytes, [bytes_ptr](size_t begin, size_t end) {
+        std::memset(bytes_ptr + begin, 0, end - begin);
+    }, grain);
+}
+
+// Places a buffer that has not been written yet.
+inline void numa_place(void* p, size_t bytes, NumaPlacement placement) {
+    if (placement == NumaPlacement::Interleave) {
+        numa_interleave(p, bytes);
+    } else if (placement == NumaPlacement::Parallel) {
+        numa_first_touch(p, bytes);
+    }
+}
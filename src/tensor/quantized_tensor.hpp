@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "tensor.hpp"
+#include "../kernels/qgemm.hpp"
+
+// Quantisation parameters of a QuantizedTensor: one scale and zero point for the whole tensor, or one
+// per index along `axis` (per channel). See kernels/quantize.hpp for the mapping.
+struct QuantParams {
+    std::vector<float> scales;
+    std::vector<int32_t> zero_points;
+    bool per_channel = false;
+    size_t axis = 0;
+
+    static QuantParams per_tensor(QuantScale s) {
+        return {{s.scale}, {s.zero_point}, false, 0};
+    }
+
+    static QuantParams per_axis(size_t axis, std::vector<float> scales, std::vector<int32_t> zero_points) {
+        if (scales.size() != zero_points.size()) {
+            throw std::invalid_argument("One zero point is needed per scale");
+        }
+        return {std::move(scales), std::move(zero_points), true, axis};
+    }
+
+    QuantScale at(size_t channel) const {
+        const size_t i = per_channel ? channel : 0;
+        return {scales[i], zero_points[i]};
+    }
+};
+
+// Records the range of the tensors it is shown, e.g. the activations of a layer over calibration
+// batches, and turns it into quantisation parameters. With averaging = 0 the range is the overall
+// min / max; otherwise each batch's min / max is folded into an exponential moving average with that
+// weight, which ignores rare outliers.
+class MinMaxObserver {
+public:
+    explicit MinMaxObserver(float averaging = 0) : averaging_(averaging) {}
+
+    template<size_t Dim>
+    void observe(const Tensor<float, Dim>& t) {
+        if (t.size() == 0) {
+            return;
+        }
+        const Tensor<float, Dim> flat = t.is_contiguous() ? t.view() : t.contiguous();
+        const auto range = std::minmax_element(flat.data(), flat.data() + flat.size());
+        const float lo = *range.first, hi = *range.second;
+        if (!seen_) {
+            min_ = lo;
+            max_ = hi;
+            seen_ = true;
+        } else if (averaging_ > 0) {
+            min_ += averaging_ * (lo - min_);
+            max_ += averaging_ * (hi - max_);
+        } else {
+            min_ = std::min(min_, lo);
+            max_ = std::max(max_, hi);
+        }
+    }
+
+    float min() const { return min_; }
+    float max() const { return max_; }
+
+    // Per-tensor parameters for the observed range; asymmetric by default, as suits activations.
+    QuantParams params(bool symmetric = false) const {
+        if (!seen_) {
+            throw std::logic_error("MinMaxObserver has not observed any values");
+        }
+        return QuantParams::per_tensor(choose_quant_scale(min_, max_, symmetric));
+    }
+
+private:
+    float averaging_;
+    float min_ = 0, max_ = 0;
+    bool seen_ = false;
+};
+
+namespace quant_detail {
+    template<size_t Dim>
+    void check_params(const std::array<size_t, Dim>& shape, const QuantParams& params) {
+        if (params.per_channel && params.axis >= Dim) {
+            throw std::invalid_argument("Invalid quantisation axis");
+        }
+        const size_t expected = params.per_channel ? shape[params.axis] : 1;
+        if (params.scales.size() != expected || params.zero_points.size() != expected) {
+            throw std::invalid_argument("Quantisation parameters do not match the tensor");
+        }
+        for (size_t i = 0; i < expected; ++i) {
+            if (!(params.scales[i] > 0) || params.zero_points[i] < -128 || params.zero_points[i] > 127) {
+                throw std::invalid_argument("Invalid scale or zero point");
+            }
+        }
+    }
+
+    // Weight parameters in the form qgemm takes: per tensor, or per output column (axis 1).
+    inline QuantChannels weight_channels(const QuantParams& params) {
+        if (params.per_channel && params.axis != 1) {
+            throw std::invalid_argument("Weights must be quantised per tensor or per output column (axis 1)");
+        }
+        return {params.scales.data(), params.zero_points.data(), params.per_channel};
+    }
+
+    // Calls fn(index, row-major position) for every element of shape.
+    template<size_t Dim, typename F>
+    void for_each_index(const std::array<size_t, Dim>& shape, F&& fn) {
+        const size_t size = std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+        std::array<size_t, Dim> index{};
+        for (size_t i = 0; i < size; ++i) {
+            fn(static_cast<const std::array<size_t, Dim>&>(index), i);
+            for (size_t d = Dim; d-- > 0;) {
+                if (++index[d] < shape[d]) {
+                    break;
+                }
+                index[d] = 0;
+            }
+        }
+    }
+}
+
+// Symmetric per-channel parameters for weights: one scale per index along axis, from the largest
+// magnitude in that slice, and zero points of 0.
+template<size_t Dim>
+QuantParams calibrate_per_channel(const Tensor<float, Dim>& weights, size_t axis) {
+    if (axis >= Dim) {
+        throw std::invalid_argument("Invalid quantisation axis");
+    }
+    const size_t channels = weights.shape()[axis];
+    std::vector<float> lo(channels, 0.0f), hi(channels, 0.0f);
+    quant_detail::for_each_index(weights.shape(), [&](const std::array<size_t, Dim>& index, size_t) {
+        const float v = weights(index);
+        const size_t c = index[axis];
+        lo[c] = std::min(lo[c], v);
+        hi[c] = std::max(hi[c], v);
+    });
+    std::vector<float> scales(channels);
+    for (size_t c = 0; c < channels; ++c) {
+        scales[c] = choose_quant_scale(lo[c], hi[c], true).scale;
+    }
+    return QuantParams::per_axis(axis, std::move(scales), std::vector<int32_t>(channels, 0));
+}
+
+// An int8 tensor together with the parameters that map it back to float. Weights quantised this way
+// take a quarter of the memory of float ones; matmul multiplies in int8 (kernels/qgemm.hpp).
+template<size_t Dim>
+class QuantizedTensor {
+public:
+    QuantizedTensor(Tensor<int8_t, Dim> values, QuantParams params)
+        : values_(std::move(values)), params_(std::move(params)) {
+        quant_detail::check_params(values_.shape(), params_);
+    }
+
+    static QuantizedTensor quantize(const Tensor<float, Dim>& t, QuantParams params) {
+        quant_detail::check_params(t.shape(), params);
+        Tensor<int8_t, Dim> values(t.shape());
+        quant_detail::for_each_index(t.shape(), [&](const std::array<size_t, Dim>& index, size_t flat) {
+            values.data()[flat] = quantize_value(t(index), params.at(index[params.axis]));
+        });
+        return QuantizedTensor(std::move(values), std::move(params));
+    }
+
+    Tensor<float, Dim> dequantize() const {
+        Tensor<float, Dim> result(values_.shape());
+        quant_detail::for_each_index(values_.shape(), [&](const std::array<size_t, Dim>& index, size_t flat) {
+            result.data()[flat] = dequantize_value(values_(index), params_.at(index[params_.axis]));
+        });
+        return result;
+    }
+
+    const Tensor<int8_t, Dim>& values() const { return values_; }
+    const QuantParams& params() const { return params_; }
+    const std::array<size_t, Dim>& shape() const { return values_.shape(); }
+
+    // this (quantised per tensor) times weights (per tensor, or per channel along axis 1), dequantised.
+    Tensor<float, 2> matmul(const QuantizedTensor<2>& weights) const {
+        Tensor<float, 2> result({shape()[0], weights.shape()[1]});
+        const auto a = lhs_values(weights);
+        const Tensor<int8_t, 2> b = weights.values().is_contiguous() ? weights.values().view() : weights.values().contiguous();
+        qgemm(result.shape()[0], result.shape()[1], shape()[1], a.data(), shape()[1], params_.at(0),
+              b.data(), result.shape()[1], quant_detail::weight_channels(weights.params()),
+              result.data(), result.shape()[1]);
+        return result;
+    }
+
+    // As above, requantised with the per-tensor parameters `out`.
+    QuantizedTensor<2> matmul(const QuantizedTensor<2>& weights, const QuantParams& out) const {
+        if (out.per_channel) {
+            throw std::invalid_argument("The output of a quantised matmul is quantised per tensor");
+        }
+        Tensor<int8_t, 2> result({shape()[0], weights.shape()[1]});
+        quant_detail::check_params(result.shape(), out);
+        const auto a = lhs_values(weights);
+        const Tensor<int8_t, 2> b = weights.values().is_contiguous() ? weights.values().view() : weights.values().contiguous();
+        qgemm(result.shape()[0], result.shape()[1], shape()[1], a.data(), shape()[1], params_.at(0),
+              b.data(), result.shape()[1], quant_detail::weight_channels(weights.params()),
+              result.data(), result.shape()[1], out.at(0));
+        return QuantizedTensor<2>(std::move(result), out);
+    }
+
+private:
+    Tensor<int8_t, Dim> values_;
+    QuantParams params_;
+
+    // Contiguous values of the left operand, after checking both operands.
+    Tensor<int8_t, Dim> lhs_values(const QuantizedTensor<2>& weights) const {
+        static_assert(Dim == 2, "matmul is only defined for 2D tensors");
+        if (params_.per_channel) {
+            throw std::invalid_argument("The left operand of a quantised matmul is quantised per tensor");
+        }
+        if (shape()[1] != weights.shape()[0]) {
+            throw std::invalid_argument("Invalid dimensions for matrix multiplication");
+        }
+        return values_.is_contiguous() ? values_.view() : values_.contiguous();
+    }
+};
+
+// Float activations times quantised weights: the activations are quantised on the fly, per tensor,
+// with parameters from their own range.
+template<typename T, size_t Dim>
+Tensor<T, 2> Tensor<T, Dim>::matmul(const QuantizedTensor<2>& weights) const {
+    static_assert(std::is_same<T, float>::value && Dim == 2, "Only 2D float tensors multiply quantised weights");
+    if (shape_[1] != weights.shape()[0]) {
+        throw std::invalid_argument("Invalid dimensions for matrix multiplication");
+    }
+    const Tensor<float, 2> a = is_contiguous() ? view() : contiguous();
+    const Tensor<int8_t, 2> b = weights.values().is_contiguous() ? weights.values().view() : weights.values().contiguous();
+    Tensor<float, 2> result({shape_[0], b.shape()[1]});
+    qgemm(shape_[0], b.shape()[1], shape_[1], a.data(), shape_[1], b.data(), b.shape()[1],
+          quant_detail::weight_channels(weights.params()), result.data(), b.shape()[1]);
+    return result;
+}
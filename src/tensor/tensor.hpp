@@ -1,3 +1,5 @@
+#pragma once
+
 #include <vector>
 #include <array>
 #include <numeric>
@@ -6,141 +8,394 @@
 #include <stdexcept>
 #include <memory>
 #include <initializer_list>
-#include <fstream>
+#include <string>
+#include "../kernels/gemm.hpp"
+#include "../kernels/transpose.hpp"
+#include "tensor_expr.hpp"
+#include "tensor_storage.hpp"
+#include "numa.hpp"
+
+namespace tensor_detail {
+    template<size_t Dim>
+    std::array<size_t, Dim> contiguous_strides(const std::array<size_t, Dim>& shape) {
+        std::array<size_t, Dim> strides{};
+        size_t stride = 1;
+        for (size_t i = Dim; i-- > 0;) {
+            strides[i] = stride;
+            stride *= shape[i];
+        }
+        return strides;
+    }
+
+    // Walks every row (all dimensions but the last) of `shape` for N operands laid out with the given
+    // strides, calling fn(offsets) with each operand's element offset at the start of the row. Rows
+    // [row_begin, row_end) are visited in row-major order.
+    template<size_t Dim, size_t N, typename F>
+    void for_each_row(const std::array<size_t, Dim>& shape,
+                      const std::array<std::array<size_t, Dim>, N>& strides,
+                      std::array<size_t, N> offsets,
+                      size_t row_begin, size_t row_end, F&& fn) {
+        if (row_begin >= row_end) {
+            return;
+        }
+        std::array<size_t, Dim> index{};
+        size_t temp = row_begin;
+        for (size_t d = Dim - 1; d-- > 0;) {
+            index[d] = temp % shape[d];
+            temp /= shape[d];
+            for (size_t t = 0; t < N; ++t) {
+                offsets[t] += index[d] * strides[t][d];
+            }
+        }
 
+        for (size_t row = row_begin; row < row_end; ++row) {
+            fn(static_cast<const std::array<size_t, N>&>(offsets));
+            for (size_t d = Dim - 1; d-- > 0;) {
+                for (size_t t = 0; t < N; ++t) {
+                    offsets[t] += strides[t][d];
+                }
+                if (++index[d] < shape[d]) {
+                    break;
+                }
+                for (size_t t = 0; t < N; ++t) {
+                    offsets[t] -= index[d] * strides[t][d];
+                }
+                index[d] = 0;
+            }
+        }
+    }
+
+    template<size_t Dim>
+    size_t row_count(const std::array<size_t, Dim>& shape) {
+        return std::accumulate(shape.begin(), shape.end() - 1, size_t(1), std::multiplies<size_t>());
+    }
+}
+
+template<size_t Dim> class QuantizedTensor;
+
+// A Tensor is a view over a shared buffer (a TensorStorage): element (i0, ..., iN) lives at
+// data_ptr_[offset_ + i0 * strides_[0] + ... + iN * strides_[N]]. Tensors created from a shape own a
+// fresh row-major buffer; view, transpose, permute, slice, reshape and broadcast_to return views that
+// share the buffer of their source (a broadcast dimension has stride 0), so writes through one are seen
+// by the others. Copying a Tensor is O(1) too, but the copy behaves as a separate value: the elements
+// are duplicated only when the copy or the original is first written (see TensorStorage::share).
 template<typename T, size_t Dim>
 class Tensor {
+    template<typename, size_t> friend class Tensor;
+
 public:
-    Tensor() : shape_(), data_ptr_(std::make_shared<std::vector<T>>()) {}
+    Tensor() : data_ptr_(make_tensor_storage<T>()), shape_(),
+               strides_(tensor_detail::contiguous_strides(shape_)), offset_(0) {}
 
 protected:
-    std::shared_ptr<std::vector<T>> data_ptr_;
+    std::shared_ptr<TensorStorage<T>> data_ptr_;
+
+    // The whole buffer, from which offset() and strides() pick this tensor's elements. Reads go through
+    // the const overload, which never triggers a copy-on-write.
+    const TensorStorage<T>& storage() const { return *data_ptr_; }
+    TensorStorage<T>& storage() { return *data_ptr_; }
 
 private:
     std::array<size_t, Dim> shape_;
+    std::array<size_t, Dim> strides_;
+    size_t offset_;
 
     size_t get_flat_index(const std::array<size_t, Dim>& indices) const {
-        size_t flat_index = 0;
-        size_t multiplier = 1;
-        for (int i = Dim - 1; i >= 0; --i) {
-            flat_index += indices[i] * multiplier;
-            multiplier *= shape_[i];
+        size_t flat_index = offset_;
+        for (size_t i = 0; i < Dim; ++i) {
+            flat_index += indices[i] * strides_[i];
         }
         return flat_index;
     }
 
+    Tensor(std::shared_ptr<TensorStorage<T>> data_ptr, const std::array<size_t, Dim>& shape,
+           const std::array<size_t, Dim>& strides, size_t offset)
+        : data_ptr_(std::move(data_ptr)), shape_(shape), strides_(strides), offset_(offset) {}
+
 public:
-    Tensor(const std::array<size_t, Dim>& shape) : shape_(shape) {
-        size_t total_size = std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<size_t>());
-        data_ptr_ = std::make_shared<std::vector<T>>(total_size);
+    Tensor(const Tensor& other)
+        : data_ptr_(other.data_ptr_->share()), shape_(other.shape_), strides_(other.strides_),
+          offset_(other.offset_) {}
+
+    Tensor(Tensor&& other) noexcept = default;
+
+    Tensor& operator=(const Tensor& other) {
+        if (this != &other) {
+            *this = Tensor(other);
+        }
+        return *this;
+    }
+
+    Tensor& operator=(Tensor&& other) noexcept = default;
+
+    Tensor(const std::array<size_t, Dim>& shape)
+        : shape_(shape), strides_(tensor_detail::contiguous_strides(shape)), offset_(0) {
+        size_t total_size = std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+        data_ptr_ = make_tensor_storage<T>(total_size);
+    }
+
+    // A zero-filled tensor whose pages are placed on NUMA nodes as asked (see numa.hpp).
+    Tensor(const std::array<size_t, Dim>& shape, NumaPlacement placement)
+        : shape_(shape), strides_(tensor_detail::contiguous_strides(shape)), offset_(0) {
+        size_t total_size = std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+        data_ptr_ = make_numa_storage<T>(total_size, placement);
     }
 
-    Tensor(const std::array<size_t, Dim>& shape, const std::vector<T>& data) : shape_(shape), data_ptr_(std::make_shared<std::vector<T>>(data)) {
-        if (data.size() != std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<size_t>())) {
+    Tensor(const std::array<size_t, Dim>& shape, const std::vector<T>& data)
+        : data_ptr_(make_tensor_storage<T>(data)), shape_(shape),
+          strides_(tensor_detail::contiguous_strides(shape)), offset_(0) {
+        if (data.size() != std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>())) {
             throw std::invalid_argument("Data size does not match shape");
         }
     }
 
+    // A row-major tensor over an existing buffer, e.g. one backed by a mapped file (see tensor_io.hpp).
+    Tensor(const std::array<size_t, Dim>& shape, std::shared_ptr<TensorStorage<T>> storage)
+        : data_ptr_(std::move(storage)), shape_(shape),
+          strides_(tensor_detail::contiguous_strides(shape)), offset_(0) {
+        if (data_ptr_->size() != std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>())) {
+            throw std::invalid_argument("Data size does not match shape");
+        }
+    }
+
+    // Evaluates a lazy element-wise expression (see tensor_expr.hpp) in one fused loop.
+    template<typename E>
+    Tensor(const TensorExpr<E>& expr) : Tensor(expr.derived().shape()) {
+        static_assert(std::is_same<typename E::value_type, T>::value && E::rank == Dim,
+                      "Expression type does not match the tensor");
+        tensor_detail::eval_expr(expr.derived(), data(), size());
+    }
+
+    // Writes into the current buffer when it is contiguous, of the right shape, and not shared with
+    // another tensor or with the expression; otherwise the tensor is rebound to a fresh buffer.
+    template<typename E>
+    Tensor& operator=(const TensorExpr<E>& expr) {
+        const E& e = expr.derived();
+        if (shape_ == e.shape() && is_contiguous() && data_ptr_.use_count() == 1 && !data_ptr_->is_shared() &&
+            !e.shares(*data_ptr_)) {
+            tensor_detail::eval_expr(e, data(), size());
+        } else {
+            *this = Tensor<T, Dim>(expr);
+        }
+        return *this;
+    }
+
     Tensor<T, 2> matmul(const Tensor<T, 2>& other) const {
         if (shape_[1] != other.shape_[0]) {
             throw std::invalid_argument("Invalid dimensions for matrix multiplication");
         }
         Tensor<T, 2> result({shape_[0], other.shape_[1]});
-        for (size_t i = 0; i < shape_[0]; ++i) {
-            for (size_t j = 0; j < other.shape_[1]; ++j) {
-                T sum = 0;
-                for (size_t k = 0; k < shape_[1]; ++k) {
-                    sum += (*this)({i, k}) * other({k, j});
-                }
-                result({i, j}) = sum;
-            }
-        }
+        gemm(shape_[0], other.shape_[1], shape_[1],
+             data(), strides_[0], strides_[1],
+             other.data(), other.strides_[0], other.strides_[1],
+             result.data(), other.shape_[1]);
         return result;
     }
 
+    // Multiplies by int8 weights, quantising this tensor on the fly (see quantized_tensor.hpp).
+    Tensor<T, 2> matmul(const QuantizedTensor<2>& weights) const;
+
+    // In-place arithmetic without allocating; `other` is broadcast to this tensor's shape (see
+    // tensor_ops.hpp for add_out and friends, which write into a separate output).
+    template<size_t D> Tensor& add_(const Tensor<T, D>& other);
+    template<size_t D> Tensor& sub_(const Tensor<T, D>& other);
+    template<size_t D> Tensor& mul_(const Tensor<T, D>& other);
+    template<size_t D> Tensor& div_(const Tensor<T, D>& other);
+    Tensor& add_(const T& value);
+    Tensor& sub_(const T& value);
+    Tensor& mul_(const T& value);
+    Tensor& div_(const T& value);
+
+    // A view of the whole tensor: unlike a copy, it shares the buffer for writes as well.
+    Tensor<T, Dim> view() const {
+        return Tensor<T, Dim>(data_ptr_, shape_, strides_, offset_);
+    }
+
     Tensor<T, 2> transpose() const {
-        Tensor<T, 2> result({shape_[1], shape_[0]});
-        for (size_t i = 0; i < shape_[0]; ++i) {
-            for (size_t j = 0; j < shape_[1]; ++j) {
-                result({j, i}) = (*this)({i, j});
+        static_assert(Dim == 2, "transpose() is only defined for 2D tensors, use permute()");
+        return permute({1, 0});
+    }
+
+    Tensor<T, Dim> permute(const std::array<size_t, Dim>& axes) const {
+        std::array<size_t, Dim> shape, strides;
+        std::array<bool, Dim> used{};
+        for (size_t i = 0; i < Dim; ++i) {
+            if (axes[i] >= Dim || used[axes[i]]) {
+                throw std::invalid_argument("Invalid permutation");
             }
+            used[axes[i]] = true;
+            shape[i] = shape_[axes[i]];
+            strides[i] = strides_[axes[i]];
         }
-        return result;
+        return Tensor<T, Dim>(data_ptr_, shape, strides, offset_);
     }
 
-    T& operator()(const std::array<size_t, Dim>& indices) {
-        return (*data_ptr_)[get_flat_index(indices)];
+    Tensor<T, Dim> slice(size_t dim, size_t start, size_t end, size_t step = 1) const {
+        if (dim >= Dim || step == 0 || start > end || end > shape_[dim]) {
+            throw std::out_of_range("Invalid slice");
+        }
+        std::array<size_t, Dim> shape = shape_, strides = strides_;
+        shape[dim] = (end - start + step - 1) / step;
+        strides[dim] = strides_[dim] * step;
+        return Tensor<T, Dim>(data_ptr_, shape, strides, offset_ + start * strides_[dim]);
     }
 
-    const T& operator()(const std::array<size_t, Dim>& indices) const {
-        return (*data_ptr_)[get_flat_index(indices)];
+    // O(1) for contiguous tensors; anything else is copied into a contiguous buffer first.
+    template<size_t NewDim>
+    Tensor<T, NewDim> reshape(const std::array<size_t, NewDim>& shape) const {
+        if (std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>()) != size()) {
+            throw std::invalid_argument("Reshape must preserve the number of elements");
+        }
+        Tensor<T, Dim> src = is_contiguous() ? view() : contiguous();
+        return Tensor<T, NewDim>(src.data_ptr_, shape, tensor_detail::contiguous_strides(shape), src.offset_);
     }
 
-    const std::array<size_t, Dim>& shape() const {
-        return shape_;
+    // Numpy-style broadcast: dimensions are aligned from the right, and size-1 or missing
+    // dimensions are stretched with a zero stride.
+    template<size_t NewDim>
+    Tensor<T, NewDim> broadcast_to(const std::array<size_t, NewDim>& shape) const {
+        static_assert(NewDim >= Dim, "Cannot broadcast to a lower rank");
+        std::array<size_t, NewDim> strides{};
+        for (size_t i = 0; i < Dim; ++i) {
+            const size_t src = Dim - 1 - i;
+            const size_t dst = NewDim - 1 - i;
+            if (shape_[src] == shape[dst]) {
+                strides[dst] = strides_[src];
+            } else if (shape_[src] == 1) {
+                strides[dst] = 0;
+            } else {
+                throw std::invalid_argument("Shapes are not broadcastable");
+            }
+        }
+        return Tensor<T, NewDim>(data_ptr_, shape, strides, offset_);
     }
 
-    const std::shared_ptr<std::vector<T>>& data_ptr() const { return data_ptr_; }
+    Tensor<T, Dim> contiguous() const {
+        Tensor<T, Dim> result(shape_);
+        copy_to(result.data());
+        return result;
+    }
 
-    void save(const std::string& filename) const {
-        std::ofstream file(filename, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Unable to open file for writing");
+    // Row-major and gap free; the stride of a size-1 dimension does not matter.
+    bool is_contiguous() const {
+        size_t expected = 1;
+        for (size_t i = Dim; i-- > 0;) {
+            if (shape_[i] != 1 && strides_[i] != expected) {
+                return false;
+            }
+            expected *= shape_[i];
         }
+        return true;
+    }
 
-        file.write(reinterpret_cast<const char*>(shape_.data()), sizeof(size_t) * Dim);
-        file.write(reinterpret_cast<const char*>(data_ptr_->data()), sizeof(T) * data_ptr_->size());
+    size_t size() const {
+        return std::accumulate(shape_.begin(), shape_.end(), size_t(1), std::multiplies<size_t>());
     }
 
-    static Tensor<T, Dim> load(const std::string& filename) {
-        std::ifstream file(filename, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Unable to open file for reading");
-        }
+    T* data() { return storage().data() + offset_; }
 
-        std::array<size_t, Dim> shape;
-        file.read(reinterpret_cast<char*>(shape.data()), sizeof(size_t) * Dim);
+    const T* data() const { return storage().data() + offset_; }
 
-        Tensor<T, Dim> result(shape);
-        file.read(reinterpret_cast<char*>(result.data_ptr_->data()), sizeof(T) * result.data_ptr_->size());
+    T& operator()(const std::array<size_t, Dim>& indices) {
+        return storage()[get_flat_index(indices)];
+    }
 
-        return result;
+    const T& operator()(const std::array<size_t, Dim>& indices) const {
+        return storage()[get_flat_index(indices)];
     }
 
-    Tensor<T, Dim> operator+(const Tensor<T, Dim>& other) const {
-        if (shape_ != other.shape_) {
-            throw std::invalid_argument("Tensor shapes do not match");
-        }
-        Tensor<T, Dim> result(shape_);
-        std::transform(data_ptr_->begin(), data_ptr_->end(), other.data_ptr_->begin(), result.data_ptr_->begin(), std::plus<T>());
-        return result;
+    const std::array<size_t, Dim>& shape() const {
+        return shape_;
     }
 
-    Tensor<T, Dim> operator-(const Tensor<T, Dim>& other) const {
-        if (shape_ != other.shape_) {
-            throw std::invalid_argument("Tensor shapes do not match");
-        }
-        Tensor<T, Dim> result(shape_);
-        std::transform(data_ptr_->begin(), data_ptr_->end(), other.data_ptr_->begin(), result.data_ptr_->begin(), std::minus<T>());
-        return result;
+    const std::array<size_t, Dim>& strides() const {
+        return strides_;
     }
 
-    Tensor<T, Dim> operator*(const Tensor<T, Dim>& other) const {
-        if (shape_ != other.shape_) {
-            throw std::invalid_argument("Tensor shapes do not match");
+    size_t offset() const {
+        return offset_;
+    }
+
+    // The buffer, for inspection; views of one tensor return the same storage.
+    std::shared_ptr<const TensorStorage<T>> data_ptr() const { return data_ptr_; }
+
+    // Writes the tensor to a single-entry tensor file (see tensor_io.hpp). Element types the file format
+    // has no dtype for (e.g. char, long long, structs) are written in the earlier raw shape-then-data
+    // format instead.
+    void save(const std::string& filename) const;
+
+    // Reads a tensor written by save(): the tensor is backed by a private mapping of the file, so no
+    // payload is copied up front. Files from the earlier raw shape-then-data format, and every file of
+    // an element type without a dtype, are read as before.
+    static Tensor<T, Dim> load(const std::string& filename);
+
+protected:
+    // Copies the logical contents in row-major order into dst.
+    void copy_to(T* dst) const {
+        if (is_contiguous()) {
+            std::copy(data(), data() + size(), dst);
+            return;
         }
-        Tensor<T, Dim> result(shape_);
-        std::transform(data_ptr_->begin(), data_ptr_->end(), other.data_ptr_->begin(), result.data_ptr_->begin(), std::multiplies<T>());
-        return result;
+        if constexpr (Dim >= 2) {
+            if (strides_[Dim - 2] == 1 && shape_[Dim - 2] > 1 && shape_[Dim - 1] > 1) {
+                copy_transposed(dst);
+                return;
+            }
+        }
+        const size_t len = shape_[Dim - 1];
+        const size_t step = strides_[Dim - 1];
+        const T* src = storage().data();
+        tensor_detail::for_each_row<Dim, 1>(shape_, {strides_}, {offset_}, 0, tensor_detail::row_count(shape_),
+            [&](const std::array<size_t, 1>& off) {
+                for (size_t j = 0; j < len; ++j) {
+                    *dst++ = src[off[0] + j * step];
+                }
+            });
     }
 
-    Tensor<T, Dim> operator/(const Tensor<T, Dim>& other) const {
-        if (shape_ != other.shape_) {
-            throw std::invalid_argument("Tensor shapes do not match");
+    // copy_to for a tensor whose last two axes are a transposed view of row-major matrices, such as
+    // transpose() or permute() of a contiguous tensor: each matrix goes through the blocked transpose
+    // of kernels/transpose.hpp instead of being read down its columns.
+    void copy_transposed(T* dst) const {
+        const size_t rows = shape_[Dim - 2], cols = shape_[Dim - 1];
+        std::vector<size_t> offsets;
+        if constexpr (Dim == 2) {
+            offsets.push_back(offset_);
+        } else {
+            // One row per matrix: the leading dimensions plus a dummy last one.
+            std::array<size_t, Dim - 1> outer_shape{}, outer_strides{};
+            std::copy(shape_.begin(), shape_.end() - 2, outer_shape.begin());
+            std::copy(strides_.begin(), strides_.end() - 2, outer_strides.begin());
+            outer_shape[Dim - 2] = 1;
+            tensor_detail::for_each_row<Dim - 1, 1>(outer_shape, {outer_strides}, {offset_}, 0,
+                tensor_detail::row_count(outer_shape),
+                [&](const std::array<size_t, 1>& off) { offsets.push_back(off[0]); });
         }
-        Tensor<T, Dim> result(shape_);
-        std::transform(data_ptr_->begin(), data_ptr_->end(), other.data_ptr_->begin(), result.data_ptr_->begin(), std::divides<T>());
-        return result;
+        const T* src = storage().data();
+        transpose_batched<T>(offsets.size(), cols, rows, [&](size_t b) { return src + offsets[b]; }, strides_[Dim - 1],
+                             [&](size_t b) { return dst + b * rows * cols; }, cols);
+    }
+
+    // Applies op(element of this, element of other) in place; either side may be strided.
+    template<typename Op>
+    void apply_inplace(const Tensor<T, Dim>& other, Op op) {
+        const size_t len = shape_[Dim - 1];
+        const size_t sa = strides_[Dim - 1], sb = other.strides_[Dim - 1];
+        T* a = storage().data();
+        const T* b = other.storage().data();
+        tensor_detail::for_each_row<Dim, 2>(shape_, {strides_, other.strides_}, {offset_, other.offset_},
+            0, tensor_detail::row_count(shape_),
+            [&](const std::array<size_t, 2>& off) {
+                for (size_t j = 0; j < len; ++j) {
+                    op(a[off[0] + j * sa], b[off[1] + j * sb]);
+                }
+            });
     }
 
 };
+
+#include "tensor_io.hpp"
+#include "quantized_tensor.hpp"
+#include "tensor_reduce.hpp"
+#include "tensor_ops.hpp"
+#include "tensor_random.hpp"
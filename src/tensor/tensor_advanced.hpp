@@ -1,7 +1,11 @@
+#pragma once
+
 #include <algorithm>
+#include <cmath>
 #include <numeric>
-#include <immintrin.h>
 #include "tensor.hpp"
+#include "../kernels/half.hpp"
+#include "../kernels/simd_kernels.hpp"
 
 template <typename T, size_t Dim>
 class AdvancedTensor : public Tensor<T,Dim>{
@@ -10,48 +14,62 @@ public:
 
 public:
     using Tensor<T, Dim>::Tensor;
-    using Tensor<T, Dim>::operator+;
-    using Tensor<T, Dim>::operator-;
-    using Tensor<T, Dim>::operator*;
-    using Tensor<T, Dim>::operator/;
 
     AdvancedTensor(const std::array<size_t, Dim>& shape) : Tensor<T, Dim>(shape) {}
     AdvancedTensor(const std::array<size_t, Dim>& shape, const std::vector<T>& data) : Tensor<T, Dim>(shape, data) {}
+    // Wraps the same buffer, so a view converted to an AdvancedTensor stays a view. Copying an
+    // AdvancedTensor is copy-on-write, as for Tensor.
+    AdvancedTensor(const Tensor<T, Dim>& tensor) : Tensor<T, Dim>(tensor.view()) {}
 
     template<size_t OtherDim>
     AdvancedTensor<T, std::max(Dim, OtherDim)> broadcast_add(const Tensor<T, OtherDim>& other) const {
-        std::array<size_t, std::max(Dim, OtherDim)> new_shape;
+        constexpr size_t ResDim = std::max(Dim, OtherDim);
+        std::array<size_t, ResDim> new_shape;
         compute_broadcast_shape(this->shape(), other.shape(), new_shape);
-        
-        AdvancedTensor<T, std::max(Dim, OtherDim)> result(new_shape);
-        
-        broadcast_add_impl(*this, other, result, std::array<size_t, std::max(Dim, OtherDim)>(), 0);
-        
+
+        AdvancedTensor<T, ResDim> result(new_shape);
+        add_out(*this, other, result);
         return result;
     }
 
+    // Out-of-place counterparts of optimize_add and friends; add_out (tensor_ops.hpp) and the other
+    // *_out functions write into an existing tensor instead.
     AdvancedTensor<T, Dim> optimized_add(const AdvancedTensor<T, Dim>& other) const {
+        if (this->shape() != other.shape()) {
+            throw std::invalid_argument("Tensors must have the same shape for optimized_add");
+        }
         AdvancedTensor<T, Dim> result(this->shape());
-        optimize_add(*this, other, result);
+        add_out(*this, other, result);
         return result;
     }
 
     AdvancedTensor<T, Dim> optimized_sub(const AdvancedTensor<T, Dim>& other) const {
+        if (this->shape() != other.shape()) {
+            throw std::invalid_argument("Tensors must have the same shape for optimized_sub");
+        }
         AdvancedTensor<T, Dim> result(this->shape());
-        optimize_sub(*this, other, result);
+        sub_out(*this, other, result);
         return result;
     }
 
     AdvancedTensor<T, Dim> optimized_mul(const AdvancedTensor<T, Dim>& other) const {
+        if (this->shape() != other.shape()) {
+            throw std::invalid_argument("Tensors must have the same shape for optimized_mul");
+        }
         AdvancedTensor<T, Dim> result(this->shape());
-        optimize_mul(*this, other, result);
+        mul_out(*this, other, result);
         return result;
     }
+
     AdvancedTensor<T, Dim> optimized_div(const AdvancedTensor<T, Dim>& other) const {
+        if (this->shape() != other.shape()) {
+            throw std::invalid_argument("Tensors must have the same shape for optimized_div");
+        }
+        check_divisor(other);
         AdvancedTensor<T, Dim> result(this->shape());
-        optimize_div(*this, other, result);
+        div_out(*this, other, result);
         return result;
-    } 
+    }
 
 protected:
     template<size_t D1, size_t D2>
@@ -66,181 +84,215 @@ protected:
         }
     }
 
-    template<size_t D1, size_t D2, size_t ResD>
-    static void broadcast_add_impl(const Tensor<T, D1>& t1, 
-                                   const Tensor<T, D2>& t2, 
-                                   AdvancedTensor<T, ResD>& result, 
-                                   std::array<size_t, ResD> current_index, 
-                                   size_t current_dim) {
-        if (current_dim == ResD) {
-            result(current_index) = get_value(t1, current_index, D1) + get_value(t2, current_index, D2);
+    // Runs the registry kernel chosen by pick(kernels) over both buffers when they are contiguous and T
+    // has a kernel table (float16 and bfloat16 borrow the float one, block by block), and op element by
+    // element otherwise.
+    template<typename Pick, typename Op>
+    void binary_inplace(const AdvancedTensor<T, Dim>& other, Pick pick, Op op) {
+        if (!this->is_contiguous() || !other.is_contiguous()) {
+            this->apply_inplace(other, op);
             return;
         }
+        T* dst = this->data();
+        const T* src = other.data();
+        const size_t size = this->size();
+        if constexpr (has_simd_kernels<T>) {
+            pick(simd_kernels<T>())(dst, src, dst, size);
+        } else if constexpr (is_half_float_v<T>) {
+            map_as_float(dst, src, dst, size, pick(simd_kernels<float>()));
+        } else {
+            for (size_t i = 0; i < size; ++i) {
+                op(dst[i], src[i]);
+            }
+        }
+    }
 
-        for (size_t i = 0; i < result.shape()[current_dim]; ++i) {
-            current_index[current_dim] = i;
-            broadcast_add_impl(t1, t2, result, current_index, current_dim + 1);
+    // Unary counterpart of binary_inplace. A strided view is processed one row at a time through a
+    // contiguous scratch row, so it goes through the same kernel as a contiguous tensor.
+    template<typename Pick, typename Op>
+    void unary_inplace(Pick pick, Op op) {
+        auto run = [&](T* p, size_t n) {
+            if constexpr (has_simd_kernels<T>) {
+                pick(simd_kernels<T>())(p, p, n);
+            } else if constexpr (is_half_float_v<T>) {
+                map_as_float(p, p, n, pick(simd_kernels<float>()));
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    p[i] = op(p[i]);
+                }
+            }
+        };
+        if (this->is_contiguous()) {
+            run(this->data(), this->size());
+            return;
         }
+        const size_t len = this->shape()[Dim - 1];
+        const size_t step = this->strides()[Dim - 1];
+        T* base = this->storage().data();
+        std::vector<T> row(len);
+        tensor_detail::for_each_row<Dim, 1>(this->shape(), {this->strides()}, {this->offset()},
+            0, tensor_detail::row_count(this->shape()),
+            [&](const std::array<size_t, 1>& off) {
+                T* r = base + off[0];
+                for (size_t j = 0; j < len; ++j) {
+                    row[j] = r[j * step];
+                }
+                run(row.data(), len);
+                for (size_t j = 0; j < len; ++j) {
+                    r[j * step] = row[j];
+                }
+            });
     }
 
-    template<size_t D1, size_t D2>
-    static T get_value(const Tensor<T, D1>& t, const std::array<size_t, D2>& index, size_t dim) {
-        std::array<size_t, D1> adjusted_index;
-        for (size_t i = 0; i < D1; ++i) {
-            adjusted_index[i] = (i < dim) ? index[D2 - dim + i] % t.shape()[i] : 0;
+    static void check_divisor(const AdvancedTensor<T, Dim>& divisor) {
+        const Tensor<T, Dim> flat = divisor.flat();
+        if (std::find(flat.data(), flat.data() + flat.size(), T(0)) != flat.data() + flat.size()) {
+            throw std::runtime_error("Division by zero encountered");
         }
-        return t(adjusted_index);
+    }
+
+    // Contiguous copy of the logical contents, or a view of this tensor if it already is contiguous.
+    Tensor<T, Dim> flat() const {
+        return this->is_contiguous() ? this->view() : this->contiguous();
     }
 
 public:
+    // Element-wise in-place ops. Contiguous float and double tensors go through the SIMD kernel registry
+    // (kernels/simd_kernels.hpp), which picks the widest instruction set the CPU supports at run time;
+    // float16 and bfloat16 tensors run the float kernels and round each result once.
     void optimize_add(const AdvancedTensor<T, Dim>& other) {
         if (this->shape() != other.shape()) {
             throw std::invalid_argument("Tensors must have the same shape for optimize_add");
         }
-
-        size_t size = this->data_ptr_->size();
-        size_t i = 0;
-
-        if constexpr (std::is_same<T, float>::value) {
-            for (; i + 7 < size; i += 8) {
-                __m256 a = _mm256_loadu_ps(&((*this->data_ptr_)[i]));
-                __m256 b = _mm256_loadu_ps(&((*other.data_ptr_)[i]));
-                __m256 sum = _mm256_add_ps(a, b);
-                _mm256_storeu_ps(&((*this->data_ptr_)[i]), sum);
-            }
-        } else if constexpr (std::is_same<T, double>::value) {
-            for (; i + 3 < size; i += 4) {
-                __m256d a = _mm256_loadu_pd(&((*this->data_ptr_)[i]));
-                __m256d b = _mm256_loadu_pd(&((*other.data_ptr_)[i]));
-                __m256d sum = _mm256_add_pd(a, b);
-                _mm256_storeu_pd(&((*this->data_ptr_)[i]), sum);
-            }
-        } else if constexpr (std::is_same<T, int>::value) {
-            for (; i + 3 < size; i += 4) {
-                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&((*this->data_ptr_)[i])));
-                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&((*other.data_ptr_)[i])));
-                __m128i sum = _mm_add_epi32(a, b);
-                _mm_storeu_si128(reinterpret_cast<__m128i*>(&((*this->data_ptr_)[i])), sum);
-            }
-        }
-
-        for (; i < size; ++i) {
-            (*this->data_ptr_)[i] += (*other.data_ptr_)[i];
-        }
+        binary_inplace(other, [](const auto& k) { return k.add; }, [](T& a, const T& b) { a += b; });
     }
 
     void optimize_sub(const AdvancedTensor<T, Dim>& other) {
         if (this->shape() != other.shape()) {
             throw std::invalid_argument("Tensors must have the same shape for optimize_sub");
         }
+        binary_inplace(other, [](const auto& k) { return k.sub; }, [](T& a, const T& b) { a -= b; });
+    }
 
-        size_t size = this->data_ptr_->size();
-        size_t i = 0;
+    void optimize_mul(const AdvancedTensor<T, Dim>& other) {
+        if (this->shape() != other.shape()) {
+            throw std::invalid_argument("Tensors must have the same shape for optimize_mul");
+        }
+        binary_inplace(other, [](const auto& k) { return k.mul; }, [](T& a, const T& b) { a *= b; });
+    }
 
-        if constexpr (std::is_same<T, float>::value) {
-            for (; i + 7 < size; i += 8) {
-                __m256 a = _mm256_loadu_ps(&((*this->data_ptr_)[i]));
-                __m256 b = _mm256_loadu_ps(&((*other.data_ptr_)[i]));
-                __m256 diff = _mm256_sub_ps(a, b);
-                _mm256_storeu_ps(&((*this->data_ptr_)[i]), diff);
-            }
-        } else if constexpr (std::is_same<T, double>::value) {
-            for (; i + 3 < size; i += 4) {
-                __m256d a = _mm256_loadu_pd(&((*this->data_ptr_)[i]));
-                __m256d b = _mm256_loadu_pd(&((*other.data_ptr_)[i]));
-                __m256d diff = _mm256_sub_pd(a, b);
-                _mm256_storeu_pd(&((*this->data_ptr_)[i]), diff);
-            }
-        } else if constexpr (std::is_same<T, int>::value) {
-            for (; i + 3 < size; i += 4) {
-                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&((*this->data_ptr_)[i])));
-                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&((*other.data_ptr_)[i])));
-                __m128i diff = _mm_sub_epi32(a, b);
-                _mm_storeu_si128(reinterpret_cast<__m128i*>(&((*this->data_ptr_)[i])), diff);
-            }
+    // Throws before modifying anything if a divisor is zero.
+    void optimize_div(const AdvancedTensor<T, Dim>& other) {
+        if (this->shape() != other.shape()) {
+            throw std::invalid_argument("Tensors must have the same shape for optimize_div");
         }
+        check_divisor(other);
+        binary_inplace(other, [](const auto& k) { return k.div; }, [](T& a, const T& b) { a /= b; });
+    }
 
-        for (; i < size; ++i) {
-            (*this->data_ptr_)[i] -= (*other.data_ptr_)[i];
+    void optimize_minimum(const AdvancedTensor<T, Dim>& other) {
+        if (this->shape() != other.shape()) {
+            throw std::invalid_argument("Tensors must have the same shape for optimize_minimum");
         }
-    }    
+        binary_inplace(other, [](const auto& k) { return k.min; }, [](T& a, const T& b) { a = b < a ? b : a; });
+    }
 
-    void optimize_mul(const AdvancedTensor<T, Dim>& other) {
+    void optimize_maximum(const AdvancedTensor<T, Dim>& other) {
         if (this->shape() != other.shape()) {
-            throw std::invalid_argument("Tensors must have the same shape for optimize_mul");
+            throw std::invalid_argument("Tensors must have the same shape for optimize_maximum");
         }
+        binary_inplace(other, [](const auto& k) { return k.max; }, [](T& a, const T& b) { a = b > a ? b : a; });
+    }
 
-        size_t size = this->data_ptr_->size();
-        size_t i = 0;
+    // Activations, in place.
+    void optimize_exp() {
+        unary_inplace([](const auto& k) { return k.exp; }, [](T x) { return static_cast<T>(std::exp(x)); });
+    }
 
-        if constexpr (std::is_same<T, float>::value) {
-            for (; i + 7 < size; i += 8) {
-                __m256 a = _mm256_loadu_ps(&((*this->data_ptr_)[i]));
-                __m256 b = _mm256_loadu_ps(&((*other.data_ptr_)[i]));
-                __m256 prod = _mm256_mul_ps(a, b);
-                _mm256_storeu_ps(&((*this->data_ptr_)[i]), prod);
-            }
-        } else if constexpr (std::is_same<T, double>::value) {
-            for (; i + 3 < size; i += 4) {
-                __m256d a = _mm256_loadu_pd(&((*this->data_ptr_)[i]));
-                __m256d b = _mm256_loadu_pd(&((*other.data_ptr_)[i]));
-                __m256d prod = _mm256_mul_pd(a, b);
-                _mm256_storeu_pd(&((*this->data_ptr_)[i]), prod);
-            }
-        } else if constexpr (std::is_same<T, int>::value) {
-            for (; i + 3 < size; i += 4) {
-                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&((*this->data_ptr_)[i])));
-                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&((*other.data_ptr_)[i])));
-                __m128i prod = _mm_mullo_epi32(a, b);
-                _mm_storeu_si128(reinterpret_cast<__m128i*>(&((*this->data_ptr_)[i])), prod);
-            }
-        }
+    void optimize_log() {
+        unary_inplace([](const auto& k) { return k.log; }, [](T x) { return static_cast<T>(std::log(x)); });
+    }
 
-        for (; i < size; ++i) {
-            (*this->data_ptr_)[i] *= (*other.data_ptr_)[i];
-        }
-    }    
+    void optimize_relu() {
+        unary_inplace([](const auto& k) { return k.relu; }, [](T x) { return x > T(0) ? x : T(0); });
+    }
 
-    void optimize_div(const AdvancedTensor<T, Dim>& other) {
-        if (this->shape() != other.shape()) {
-            throw std::invalid_argument("Tensors must have the same shape for optimize_div");
+    void optimize_sigmoid() {
+        unary_inplace([](const auto& k) { return k.sigmoid; },
+                      [](T x) { return static_cast<T>(1 / (1 + std::exp(-x))); });
+    }
+
+    void optimize_tanh() {
+        unary_inplace([](const auto& k) { return k.tanh; }, [](T x) { return static_cast<T>(std::tanh(x)); });
+    }
+
+    // Reductions over all elements. Sums and dot products of 16-bit tensors are accumulated and returned
+    // in float (accum_t<T>).
+    accum_t<T> optimize_sum() const {
+        const Tensor<T, Dim> src = flat();
+        if constexpr (has_simd_kernels<T>) {
+            return simd_kernels<T>().sum(src.data(), src.size());
+        } else if constexpr (is_half_float_v<T>) {
+            float sum = 0;
+            for_each_float_block(src.data(), src.size(),
+                                 [&](const float* p, size_t n) { sum += simd_kernels<float>().sum(p, n); });
+            return sum;
+        } else {
+            return std::accumulate(src.data(), src.data() + src.size(), T(0));
         }
+    }
 
-        size_t size = this->data_ptr_->size();
-        size_t i = 0;
+    T optimize_max() const {
+        const Tensor<T, Dim> src = flat();
+        if (src.size() == 0) {
+            throw std::invalid_argument("optimize_max of an empty tensor");
+        }
+        if constexpr (has_simd_kernels<T>) {
+            return simd_kernels<T>().reduce_max(src.data(), src.size());
+        } else if constexpr (is_half_float_v<T>) {
+            float best = src.data()[0];
+            for_each_float_block(src.data(), src.size(),
+                                 [&](const float* p, size_t n) { best = std::max(best, simd_kernels<float>().reduce_max(p, n)); });
+            return T(best);
+        } else {
+            return *std::max_element(src.data(), src.data() + src.size());
+        }
+    }
 
-        if constexpr (std::is_same<T, float>::value) {
-            for (; i + 7 < size; i += 8) {
-                __m256 a = _mm256_loadu_ps(&((*this->data_ptr_)[i]));
-                __m256 b = _mm256_loadu_ps(&((*other.data_ptr_)[i]));
-                __m256 quot = _mm256_div_ps(a, b);
-                _mm256_storeu_ps(&((*this->data_ptr_)[i]), quot);
-            }
-        } else if constexpr (std::is_same<T, double>::value) {
-            for (; i + 3 < size; i += 4) {
-                __m256d a = _mm256_loadu_pd(&((*this->data_ptr_)[i]));
-                __m256d b = _mm256_loadu_pd(&((*other.data_ptr_)[i]));
-                __m256d quot = _mm256_div_pd(a, b);
-                _mm256_storeu_pd(&((*this->data_ptr_)[i]), quot);
-            }
-        } else if constexpr (std::is_same<T, int>::value) {
-            for (; i < size; ++i) {
-                if ((*other.data_ptr_)[i] != 0) {
-                    (*this->data_ptr_)[i] /= (*other.data_ptr_)[i];
-                } else {
-                    throw std::runtime_error("Division by zero encountered");
-                }
-            }
-            return;
+    T optimize_min() const {
+        const Tensor<T, Dim> src = flat();
+        if (src.size() == 0) {
+            throw std::invalid_argument("optimize_min of an empty tensor");
+        }
+        if constexpr (has_simd_kernels<T>) {
+            return simd_kernels<T>().reduce_min(src.data(), src.size());
+        } else if constexpr (is_half_float_v<T>) {
+            float best = src.data()[0];
+            for_each_float_block(src.data(), src.size(),
+                                 [&](const float* p, size_t n) { best = std::min(best, simd_kernels<float>().reduce_min(p, n)); });
+            return T(best);
+        } else {
+            return *std::min_element(src.data(), src.data() + src.size());
         }
+    }
 
-        for (; i < size; ++i) {
-            if ((*other.data_ptr_)[i] != 0) {
-                (*this->data_ptr_)[i] /= (*other.data_ptr_)[i];
-            } else {
-                throw std::runtime_error("Division by zero encountered");
-            }
+    accum_t<T> optimize_dot(const AdvancedTensor<T, Dim>& other) const {
+        if (this->shape() != other.shape()) {
+            throw std::invalid_argument("Tensors must have the same shape for optimize_dot");
+        }
+        const Tensor<T, Dim> a = flat(), b = other.flat();
+        if constexpr (has_simd_kernels<T>) {
+            return simd_kernels<T>().dot(a.data(), b.data(), a.size());
+        } else if constexpr (is_half_float_v<T>) {
+            float dot = 0;
+            for_each_float_block(a.data(), b.data(), a.size(),
+                                 [&](const float* pa, const float* pb, size_t n) {
+                                     dot += simd_kernels<float>().dot(pa, pb, n);
+                                 });
+            return dot;
+        } else {
+            return std::inner_product(a.data(), a.data() + a.size(), b.data(), T(0));
         }
     }
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+template<typename T, size_t Dim>
+class Tensor;
+
+template<typename T>
+class TensorStorage;
+
+// Lazy element-wise expressions.
+//
+// operator+ - * / on tensors build a tree of expression nodes instead of computing a result. The tree
+// is evaluated in a single loop when it is converted or assigned to a Tensor, so `a + b * c - d` makes
+// one pass over memory and allocates only the final result. Nodes hold their operands by value (a leaf
+// holds a Tensor, i.e. a reference-counted view), so an expression stays valid after the tensors it was
+// built from go out of scope.
+template<typename E>
+class TensorExpr {
+public:
+    const E& derived() const { return static_cast<const E&>(*this); }
+
+    auto eval() const {
+        return Tensor<typename E::value_type, E::rank>(derived());
+    }
+};
+
+// Leaf node. Strided operands are made contiguous once, so evaluation is always a flat indexed loop.
+// The element pointer is read from the storage on every access rather than cached: a write to a shared
+// operand detaches its storage onto a new buffer, and the leaf must follow it there.
+template<typename T, size_t Dim>
+class TensorLeaf : public TensorExpr<TensorLeaf<T, Dim>> {
+public:
+    using value_type = T;
+    static constexpr size_t rank = Dim;
+
+    explicit TensorLeaf(const Tensor<T, Dim>& tensor)
+        : tensor_(tensor.is_contiguous() ? tensor.view() : tensor.contiguous()) {}
+
+    TensorLeaf(const TensorLeaf& other) : tensor_(other.tensor_.view()) {}
+
+    const std::array<size_t, Dim>& shape() const { return tensor_.shape(); }
+
+    T operator[](size_t i) const { return tensor_.data()[i]; }
+
+    bool shares(const TensorStorage<T>& storage) const { return tensor_.data_ptr()->shares_elements(storage); }
+
+private:
+    const Tensor<T, Dim> tensor_;
+};
+
+template<typename Op, typename L, typename R>
+class BinaryExpr : public TensorExpr<BinaryExpr<Op, L, R>> {
+    static_assert(std::is_same<typename L::value_type, typename R::value_type>::value,
+                  "Tensor expressions must have the same element type");
+    static_assert(L::rank == R::rank, "Tensor expressions must have the same rank");
+
+public:
+    using value_type = typename L::value_type;
+    static constexpr size_t rank = L::rank;
+
+    BinaryExpr(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {
+        if (lhs_.shape() != rhs_.shape()) {
+            throw std::invalid_argument("Tensor shapes do not match");
+        }
+    }
+
+    const std::array<size_t, rank>& shape() const { return lhs_.shape(); }
+
+    value_type operator[](size_t i) const { return Op()(lhs_[i], rhs_[i]); }
+
+    bool shares(const TensorStorage<value_type>& storage) const { return lhs_.shares(storage) || rhs_.shares(storage); }
+
+private:
+    L lhs_;
+    R rhs_;
+};
+
+namespace tensor_detail {
+    template<typename T, size_t Dim>
+    TensorLeaf<T, Dim> as_expr(const Tensor<T, Dim>& tensor) {
+        return TensorLeaf<T, Dim>(tensor);
+    }
+
+    template<typename E>
+    const E& as_expr(const TensorExpr<E>& expr) {
+        return expr.derived();
+    }
+
+    template<typename E>
+    using expr_type = std::decay_t<decltype(as_expr(std::declval<const E&>()))>;
+
+    template<template<typename> class Op, typename L, typename R>
+    using binary_expr = BinaryExpr<Op<typename expr_type<L>::value_type>, expr_type<L>, expr_type<R>>;
+
+    // Fused evaluation loop. `out` never overlaps a leaf (callers guarantee it), so blocks of
+    // EVAL_BLOCK elements are written without alias checks and vectorise at -O2.
+    constexpr size_t EVAL_BLOCK = 16;
+
+    template<typename E, typename T>
+    void eval_expr(const E& expr, T* __restrict out, size_t size) {
+        size_t i = 0;
+        for (; i + EVAL_BLOCK <= size; i += EVAL_BLOCK) {
+#pragma GCC ivdep
+            for (size_t j = 0; j < EVAL_BLOCK; ++j) {
+                out[i + j] = expr[i + j];
+            }
+        }
+        for (; i < size; ++i) {
+            out[i] = expr[i];
+        }
+    }
+}
+
+template<typename L, typename R>
+auto operator+(const L& lhs, const R& rhs) -> tensor_detail::binary_expr<std::plus, L, R> {
+    return {tensor_detail::as_expr(lhs), tensor_detail::as_expr(rhs)};
+}
+
+template<typename L, typename R>
+auto operator-(const L& lhs, const R& rhs) -> tensor_detail::binary_expr<std::minus, L, R> {
+    return {tensor_detail::as_expr(lhs), tensor_detail::as_expr(rhs)};
+}
+
+template<typename L, typename R>
+auto operator*(const L& lhs, const R& rhs) -> tensor_detail::binary_expr<std::multiplies, L, R> {
+    return {tensor_detail::as_expr(lhs), tensor_detail::as_expr(rhs)};
+}
+
+template<typename L, typename R>
+auto operator/(const L& lhs, const R& rhs) -> tensor_detail::binary_expr<std::divides, L, R> {
+    return {tensor_detail::as_expr(lhs), tensor_detail::as_expr(rhs)};
+}
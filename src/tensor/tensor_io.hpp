@@ -0,0 +1,453 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tensor.hpp"
+
+// Tensor file format, version 1: many named tensors in one file, laid out so they can be mapped.
+//
+//   offset 0       FileHeader: magic "TNSRFILE", version, byte-order mark, entry count, index size
+//   offset 64      index: per entry an EntryHeader (dtype, rank, name length, payload offset and size),
+//                  the shape as rank uint64s and the name, padded to 8 bytes
+//   payloads       row-major elements, each payload starting on a 4096-byte boundary
+//
+// Integers are stored in the writer's byte order. Since payloads are used in place, a reader rejects a
+// file written with the other byte order instead of swapping it.
+enum class TensorDType : uint32_t {
+    Float32 = 1,
+    Float64 = 2,
+    Int8 = 3,
+    UInt8 = 4,
+    Int16 = 5,
+    UInt16 = 6,
+    Int32 = 7,
+    UInt32 = 8,
+    Int64 = 9,
+    UInt64 = 10,
+    Float16 = 11,   // IEEE binary16
+    BFloat16 = 12,
+};
+
+namespace tensor_io_detail {
+    constexpr char kMagic[8] = {'T', 'N', 'S', 'R', 'F', 'I', 'L', 'E'};
+    constexpr uint32_t kVersion = 1;
+    constexpr uint32_t kByteOrderMark = 0x01020304;
+    constexpr uint64_t kPayloadAlignment = 4096;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t entry_count;
+        uint64_t index_bytes;
+        uint64_t reserved[4];
+    };
+    static_assert(sizeof(FileHeader) == 64, "FileHeader must stay 64 bytes");
+
+    struct EntryHeader {
+        uint32_t dtype;
+        uint32_t rank;
+        uint64_t name_bytes;
+        uint64_t payload_offset;
+        uint64_t payload_bytes;
+    };
+    static_assert(sizeof(EntryHeader) == 32, "EntryHeader must stay 32 bytes");
+
+    // The TensorDType of T as an integer, or 0 if T has none.
+    template<typename T>
+    constexpr uint32_t dtype_code() {
+        if constexpr (std::is_same<T, float>::value) return uint32_t(TensorDType::Float32);
+        else if constexpr (std::is_same<T, double>::value) return uint32_t(TensorDType::Float64);
+        else if constexpr (std::is_same<T, int8_t>::value) return uint32_t(TensorDType::Int8);
+        else if constexpr (std::is_same<T, uint8_t>::value) return uint32_t(TensorDType::UInt8);
+        else if constexpr (std::is_same<T, int16_t>::value) return uint32_t(TensorDType::Int16);
+        else if constexpr (std::is_same<T, uint16_t>::value) return uint32_t(TensorDType::UInt16);
+        else if constexpr (std::is_same<T, int32_t>::value) return uint32_t(TensorDType::Int32);
+        else if constexpr (std::is_same<T, uint32_t>::value) return uint32_t(TensorDType::UInt32);
+        else if constexpr (std::is_same<T, int64_t>::value) return uint32_t(TensorDType::Int64);
+        else if constexpr (std::is_same<T, uint64_t>::value) return uint32_t(TensorDType::UInt64);
+        else if constexpr (std::is_same<T, float16>::value) return uint32_t(TensorDType::Float16);
+        else if constexpr (std::is_same<T, bfloat16>::value) return uint32_t(TensorDType::BFloat16);
+        else return 0;
+    }
+
+    // True if tensors of T can be stored in a tensor file. Tensor::save/load keep the earlier raw
+    // format for the other trivially copyable types.
+    template<typename T>
+    constexpr bool has_dtype = dtype_code<T>() != 0;
+
+    template<typename T>
+    constexpr TensorDType dtype_of() {
+        static_assert(has_dtype<T>, "Element type has no tensor file dtype");
+        return static_cast<TensorDType>(dtype_code<T>());
+    }
+
+    inline size_t dtype_size(TensorDType dtype) {
+        switch (dtype) {
+            case TensorDType::Int8: case TensorDType::UInt8: return 1;
+            case TensorDType::Int16: case TensorDType::UInt16: return 2;
+            case TensorDType::Float16: case TensorDType::BFloat16: return 2;
+            case TensorDType::Float32: case TensorDType::Int32: case TensorDType::UInt32: return 4;
+            case TensorDType::Float64: case TensorDType::Int64: case TensorDType::UInt64: return 8;
+        }
+        return 0;
+    }
+
+    inline uint64_t align_up(uint64_t n, uint64_t alignment) {
+        return (n + alignment - 1) / alignment * alignment;
+    }
+
+    inline uint64_t entry_bytes(size_t rank, size_t name_bytes) {
+        return sizeof(EntryHeader) + rank * sizeof(uint64_t) + align_up(name_bytes, 8);
+    }
+
+    // A read-only file mapped privately: pages written through it are copied, the file never changes.
+    class Mapping {
+    public:
+        explicit Mapping(const std::string& filename) {
+            const int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Unable to open file for reading: " + filename);
+            }
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+                ::close(fd);
+                throw std::runtime_error("Not a tensor file: " + filename);
+            }
+            size_ = static_cast<size_t>(st.st_size);
+            void* base = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (base == MAP_FAILED) {
+                throw std::runtime_error("Unable to map file: " + filename);
+            }
+            base_ = static_cast<char*>(base);
+        }
+
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+
+        ~Mapping() { ::munmap(base_, size_); }
+
+        char* data() const { return base_; }
+        size_t size() const { return size_; }
+
+    private:
+        char* base_ = nullptr;
+        size_t size_ = 0;
+    };
+}
+
+// Name, element type and shape of one tensor in a tensor file.
+struct TensorFileEntry {
+    std::string name;
+    TensorDType dtype;
+    std::vector<uint64_t> shape;
+};
+
+// Collects named tensors and writes them as one tensor file. add() takes a copy-on-write snapshot (see
+// TensorStorage::share), so a tensor is written with the contents it had when it was added, at the cost
+// of one copy of its elements if it is modified before write() runs. Strided views are copied right away.
+class TensorFileWriter {
+public:
+    template<typename T, size_t Dim>
+    void add(const std::string& name, const Tensor<T, Dim>& tensor) {
+        if (!names_.insert(name).second) {
+            throw std::invalid_argument("Duplicate tensor name: " + name);
+        }
+        const Tensor<T, Dim> src = tensor.is_contiguous() ? tensor : tensor.contiguous();
+        Pending entry;
+        entry.info.name = name;
+        entry.info.dtype = tensor_io_detail::dtype_of<T>();
+        entry.info.shape.assign(src.shape().begin(), src.shape().end());
+        entry.owner = src.data_ptr();
+        entry.bytes = reinterpret_cast<const char*>(src.data());
+        entry.size = src.size() * sizeof(T);
+        entries_.push_back(std::move(entry));
+    }
+
+    // Writes to a temporary file next to `filename` and renames it over `filename`, so readers never see
+    // a partly written file. With `sync`, the file is flushed to disk before the rename and the rename
+    // itself after it, so a crash leaves either the old file or the complete new one.
+    void write(const std::string& filename, bool sync = false) const {
+        using namespace tensor_io_detail;
+
+        uint64_t index_bytes = 0;
+        for (const Pending& e : entries_) {
+            index_bytes += entry_bytes(e.info.shape.size(), e.info.name.size());
+        }
+        std::vector<uint64_t> offsets;
+        uint64_t offset = align_up(sizeof(FileHeader) + index_bytes, kPayloadAlignment);
+        for (const Pending& e : entries_) {
+            offsets.push_back(offset);
+            offset = align_up(offset + e.size, kPayloadAlignment);
+        }
+
+        const std::string tmp = filename + ".tmp";
+        {
+            std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                throw std::runtime_error("Unable to open file for writing: " + tmp);
+            }
+
+            FileHeader header{};
+            std::memcpy(header.magic, kMagic, sizeof(kMagic));
+            header.version = kVersion;
+            header.byte_order = kByteOrderMark;
+            header.entry_count = entries_.size();
+            header.index_bytes = index_bytes;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            const char zeros[8] = {};
+            for (size_t i = 0; i < entries_.size(); ++i) {
+                const TensorFileEntry& info = entries_[i].info;
+                EntryHeader entry{};
+                entry.dtype = static_cast<uint32_t>(info.dtype);
+                entry.rank = static_cast<uint32_t>(info.shape.size());
+                entry.name_bytes = info.name.size();
+                entry.payload_offset = offsets[i];
+                entry.payload_bytes = entries_[i].size;
+                file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+                file.write(reinterpret_cast<const char*>(info.shape.data()), info.shape.size() * sizeof(uint64_t));
+                file.write(info.name.data(), info.name.size());
+                file.write(zeros, align_up(info.name.size(), 8) - info.name.size());
+            }
+
+            for (size_t i = 0; i < entries_.size(); ++i) {
+                pad_to(file, offsets[i]);
+                file.write(entries_[i].bytes, entries_[i].size);
+            }
+            if (!file) {
+                throw std::runtime_error("Error writing file: " + tmp);
+            }
+        }
+        if (sync && !sync_path(tmp, O_RDONLY)) {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("Unable to flush file: " + tmp);
+        }
+        if (std::rename(tmp.c_str(), filename.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            throw std::runtime_error("Unable to replace file: " + filename);
+        }
+        if (sync) {
+            const size_t slash = filename.find_last_of('/');
+            const std::string dir = slash == std::string::npos ? "." : filename.substr(0, slash + 1);
+            if (!sync_path(dir, O_RDONLY | O_DIRECTORY)) {
+                throw std::runtime_error("Unable to flush directory of " + filename);
+            }
+        }
+    }
+
+private:
+    static bool sync_path(const std::string& path, int flags) {
+        const int fd = ::open(path.c_str(), flags);
+        if (fd < 0) {
+            return false;
+        }
+        const bool ok = ::fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+    }
+
+    struct Pending {
+        TensorFileEntry info;
+        std::shared_ptr<const void> owner;
+        const char* bytes;
+        size_t size;
+    };
+
+    static void pad_to(std::ofstream& file, uint64_t offset) {
+        static const char zeros[4096] = {};
+        for (uint64_t pos = static_cast<uint64_t>(file.tellp()); pos < offset; ) {
+            const uint64_t n = std::min<uint64_t>(sizeof(zeros), offset - pos);
+            file.write(zeros, n);
+            pos += n;
+        }
+    }
+
+    std::vector<Pending> entries_;
+    std::unordered_set<std::string> names_;
+};
+
+// A tensor file opened by mapping it into memory. get() returns tensors whose storage points into the
+// mapping, so opening a file costs no copy of its payloads; pages are read on first access. Tensors keep
+// the mapping alive after the TensorFile is gone. All tensors of one entry share a single storage, so
+// writing to one of them copies its elements rather than changing the mapped pages the others read.
+class TensorFile {
+public:
+    explicit TensorFile(const std::string& filename)
+        : mapping_(std::make_shared<tensor_io_detail::Mapping>(filename)) {
+        using namespace tensor_io_detail;
+
+        const char* base = mapping_->data();
+        const uint64_t file_size = mapping_->size();
+        FileHeader header;
+        if (file_size < sizeof(header)) {
+            throw std::runtime_error("Not a tensor file: " + filename);
+        }
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+            throw std::runtime_error("Not a tensor file: " + filename);
+        }
+        if (header.byte_order != kByteOrderMark) {
+            throw std::runtime_error("Tensor file has the wrong byte order: " + filename);
+        }
+        if (header.version != kVersion) {
+            throw std::runtime_error("Unsupported tensor file version " + std::to_string(header.version));
+        }
+        if (header.index_bytes > file_size - sizeof(header)) {
+            throw std::runtime_error("Truncated tensor file: " + filename);
+        }
+
+        std::unordered_set<std::string> names;
+        uint64_t pos = sizeof(header);
+        const uint64_t index_end = pos + header.index_bytes;
+        for (uint64_t i = 0; i < header.entry_count; ++i) {
+            EntryHeader entry;
+            if (index_end - pos < sizeof(entry)) {
+                throw std::runtime_error("Corrupt tensor file index: " + filename);
+            }
+            std::memcpy(&entry, base + pos, sizeof(entry));
+            if (entry.rank > (index_end - pos) / sizeof(uint64_t) ||
+                entry.name_bytes > index_end - pos ||
+                entry_bytes(entry.rank, entry.name_bytes) > index_end - pos) {
+                throw std::runtime_error("Corrupt tensor file index: " + filename);
+            }
+
+            Stored stored;
+            stored.info.dtype = static_cast<TensorDType>(entry.dtype);
+            stored.info.shape.resize(entry.rank);
+            std::memcpy(stored.info.shape.data(), base + pos + sizeof(entry), entry.rank * sizeof(uint64_t));
+            stored.info.name.assign(base + pos + sizeof(entry) + entry.rank * sizeof(uint64_t), entry.name_bytes);
+            pos += entry_bytes(entry.rank, entry.name_bytes);
+
+            const size_t elem_size = dtype_size(stored.info.dtype);
+            uint64_t count = 1;
+            for (uint64_t d : stored.info.shape) {
+                if (d != 0 && count > UINT64_MAX / d) {
+                    throw std::runtime_error("Corrupt tensor file entry: " + stored.info.name);
+                }
+                count *= d;
+            }
+            if (elem_size == 0 || count > UINT64_MAX / elem_size || count * elem_size != entry.payload_bytes ||
+                entry.payload_offset % kPayloadAlignment != 0 || entry.payload_offset > file_size ||
+                entry.payload_bytes > file_size - entry.payload_offset) {
+                throw std::runtime_error("Corrupt tensor file entry: " + stored.info.name);
+            }
+            if (!names.insert(stored.info.name).second) {
+                throw std::runtime_error("Duplicate tensor name in file: " + stored.info.name);
+            }
+            stored.offset = entry.payload_offset;
+            stored.count = count;
+            entries_.push_back(std::move(stored));
+        }
+    }
+
+    size_t size() const { return entries_.size(); }
+
+    const TensorFileEntry& entry(size_t i) const { return entries_.at(i).info; }
+
+    bool contains(const std::string& name) const { return find(name) != nullptr; }
+
+    // The tensor called `name`, backed by the mapping. Throws std::out_of_range if there is none and
+    // std::runtime_error if it was stored with another element type or rank.
+    template<typename T, size_t Dim>
+    Tensor<T, Dim> get(const std::string& name) const {
+        const Stored* stored = find(name);
+        if (!stored) {
+            throw std::out_of_range("No tensor named " + name);
+        }
+        if (stored->info.dtype != tensor_io_detail::dtype_of<T>() || stored->info.shape.size() != Dim) {
+            throw std::runtime_error("Tensor " + name + " has a different element type or rank");
+        }
+        std::array<size_t, Dim> shape{};
+        std::copy(stored->info.shape.begin(), stored->info.shape.end(), shape.begin());
+        if (stored->count == 0) {
+            return Tensor<T, Dim>(shape, make_tensor_storage<T>());
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stored->storage) {
+            T* data = reinterpret_cast<T*>(mapping_->data() + stored->offset);
+            stored->storage = make_tensor_storage<T>(mapping_, data, stored->count);
+        }
+        return Tensor<T, Dim>(shape, std::static_pointer_cast<TensorStorage<T>>(stored->storage)->share());
+    }
+
+private:
+    struct Stored {
+        TensorFileEntry info;
+        uint64_t offset;
+        uint64_t count;
+        mutable std::shared_ptr<void> storage;  // TensorStorage<T> over the payload, made by the first get()
+    };
+
+    const Stored* find(const std::string& name) const {
+        for (const Stored& s : entries_) {
+            if (s.info.name == name) {
+                return &s;
+            }
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<tensor_io_detail::Mapping> mapping_;
+    std::vector<Stored> entries_;
+    mutable std::mutex mutex_;
+};
+
+template<typename T, size_t Dim>
+void Tensor<T, Dim>::save(const std::string& filename) const {
+    if constexpr (tensor_io_detail::has_dtype<T>) {
+        TensorFileWriter writer;
+        writer.add("tensor", *this);
+        writer.write(filename);
+    } else {
+        // Earlier format: the shape as Dim raw size_t values, then the raw elements.
+        std::ofstream file(filename, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Unable to open file for writing");
+        }
+        const Tensor<T, Dim> src = is_contiguous() ? view() : contiguous();
+        file.write(reinterpret_cast<const char*>(shape_.data()), sizeof(size_t) * Dim);
+        file.write(reinterpret_cast<const char*>(src.data()), sizeof(T) * size());
+    }
+}
+
+template<typename T, size_t Dim>
+Tensor<T, Dim> Tensor<T, Dim>::load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open file for reading");
+    }
+    if constexpr (tensor_io_detail::has_dtype<T>) {
+        char magic[sizeof(tensor_io_detail::kMagic)] = {};
+        file.read(magic, sizeof(magic));
+        if (file && std::memcmp(magic, tensor_io_detail::kMagic, sizeof(magic)) == 0) {
+            file.close();
+            TensorFile tensors(filename);
+            return tensors.get<T, Dim>(tensors.size() == 1 ? tensors.entry(0).name : "tensor");
+        }
+        file.clear();
+        file.seekg(0);
+    }
+
+    // Earlier format: the shape as Dim raw size_t values, then the raw elements.
+    std::array<size_t, Dim> shape;
+    file.read(reinterpret_cast<char*>(shape.data()), sizeof(size_t) * Dim);
+
+    Tensor<T, Dim> result(shape);
+    file.read(reinterpret_cast<char*>(result.data_ptr_->data()), sizeof(T) * result.data_ptr_->size());
+
+    return result;
+}
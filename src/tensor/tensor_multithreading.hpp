@@ -1,12 +1,15 @@
+#pragma once
+
 #include <thread>
 #include <mutex>
 #include <vector>
 #include <functional>
 #include "tensor_advanced.hpp"
+#include "thread_pool.hpp"
 
 template<typename T, size_t Dim>
 class MultithreadedTensor : public AdvancedTensor<T, Dim>{
-    
+
 public:
     MultithreadedTensor() : AdvancedTensor<T, Dim>() {}
 
@@ -16,100 +19,60 @@ public:
 public:
     using AdvancedTensor<T,Dim>::AdvancedTensor;
 
-    void parallel_add(const MultithreadedTensor<T, Dim>& other) {
+    void parallel_add(const MultithreadedTensor<T, Dim>& other, size_t grain = MIN_ELEMENTS_PER_THREAD) {
         if (this->shape() != other.shape()) {
             throw std::invalid_argument("Tensors must have the same shape for parallel_add");
         }
 
-        size_t total_size = this->data_ptr_->size();
-        size_t num_threads = std::thread::hardware_concurrency();
-        size_t elements_per_thread = std::max(MIN_ELEMENTS_PER_THREAD, total_size / num_threads);
-        num_threads = std::min(num_threads, (total_size + elements_per_thread - 1) / elements_per_thread);
+        if (!this->is_contiguous() || !other.is_contiguous()) {
+            this->optimize_add(other);
+            return;
+        }
 
-        std::vector<std::thread> threads;
-        for (size_t t = 0; t < num_threads; ++t) {
-            size_t start = t * elements_per_thread;
-            size_t end = std::min(start + elements_per_thread, total_size);
-            threads.emplace_back([this, &other, start, end]() {
+        T* dst = this->data();
+        const T* src = other.data();
+        parallel_for(0, this->size(), [dst, src](size_t start, size_t end) {
+            if constexpr (has_simd_kernels<T>) {
+                simd_kernels<T>().add(dst + start, src + start, dst + start, end - start);
+            } else {
                 for (size_t i = start; i < end; ++i) {
-                    (*this->data_ptr_)[i] += (*other.data_ptr_)[i];
+                    dst[i] += src[i];
                 }
-            });
-        }
-
-        for (auto& thread : threads) {
-            thread.join();
-        }
+            }
+        }, grain);
     }
 
     template<size_t OtherDim>
-    MultithreadedTensor<T, std::max(Dim, OtherDim)> parallel_broadcast_add(const Tensor<T, OtherDim>& other) const {
-        std::array<size_t, std::max(Dim, OtherDim)> new_shape;
+    MultithreadedTensor<T, std::max(Dim, OtherDim)> parallel_broadcast_add(const Tensor<T, OtherDim>& other,
+                                                                            size_t grain = MIN_ELEMENTS_PER_THREAD) const {
+        constexpr size_t ResDim = std::max(Dim, OtherDim);
+        std::array<size_t, ResDim> new_shape;
         this->compute_broadcast_shape(this->shape(), other.shape(), new_shape);
-        
-        MultithreadedTensor<T, std::max(Dim, OtherDim)> result(new_shape);
-        
-        size_t total_size = result.data_ptr_->size();
-        size_t num_threads = std::thread::hardware_concurrency();
-        size_t elements_per_thread = std::max(MIN_ELEMENTS_PER_THREAD, total_size / num_threads);
-        num_threads = std::min(num_threads, (total_size + elements_per_thread - 1) / elements_per_thread);
 
-        std::vector<std::thread> threads;
-        for (size_t t = 0; t < num_threads; ++t) {
-            size_t start = t * elements_per_thread;
-            size_t end = std::min(start + elements_per_thread, total_size);
-            threads.emplace_back([this, &other, &result, start, end]() {
-                std::array<size_t, std::max(Dim, OtherDim)> index;
-                for (size_t i = start; i < end; ++i) {
-                    size_t temp = i;
-                    for (int j = std::max(Dim, OtherDim) - 1; j >= 0; --j) {
-                        index[j] = temp % result.shape()[j];
-                        temp /= result.shape()[j];
-                    }
-                    result(index) = this->get_value(*this, index, Dim) + this->get_value(other, index, OtherDim);
-                }
-            });
-        }
-
-        for (auto& thread : threads) {
-            thread.join();
-        }
+        // The broadcasting engine behind add_out, with the caller's grain.
+        MultithreadedTensor<T, ResDim> result(new_shape);
+        ops_detail::tensor_out<ops_detail::Add>(*this, other, result, grain);
 
         return result;
     }
 
-    T parallel_sum() const {
-        size_t total_size = this->data_ptr_->size();
-        size_t num_threads = std::thread::hardware_concurrency();
-        size_t elements_per_thread = std::max(MIN_ELEMENTS_PER_THREAD, total_size / num_threads);
-        num_threads = std::min(num_threads, (total_size + elements_per_thread - 1) / elements_per_thread);
-
-        std::vector<T> partial_sums(num_threads, 0);
-        std::vector<std::thread> threads;
-
-        for (size_t t = 0; t < num_threads; ++t) {
-            size_t start = t * elements_per_thread;
-            size_t end = std::min(start + elements_per_thread, total_size);
-            threads.emplace_back([this, &partial_sums, t, start, end]() {
+    T parallel_sum(size_t grain = MIN_ELEMENTS_PER_THREAD) const {
+        const Tensor<T, Dim> flat = this->flat();
+        const T* src = flat.data();
+        return parallel_reduce(0, flat.size(), T(0), [src](size_t start, size_t end) {
+            if constexpr (has_simd_kernels<T>) {
+                return simd_kernels<T>().sum(src + start, end - start);
+            } else {
                 T sum = 0;
                 for (size_t i = start; i < end; ++i) {
-                    sum += (*this->data_ptr_)[i];
+                    sum += src[i];
                 }
-                partial_sums[t] = sum;
-
-            });
-        }
-
-        for (auto& thread : threads) {
-            thread.join();
-        }
-
-        T total_sum = std::accumulate(partial_sums.begin(), partial_sums.end(), T(0));
-
-        return total_sum;
+                return sum;
+            }
+        }, std::plus<T>(), grain);
     }
 
 };
 
 template<typename T, size_t Dim>
-const size_t MultithreadedTensor<T, Dim>::MIN_ELEMENTS_PER_THREAD;
\ No newline at end of file
+const size_t MultithreadedTensor<T, Dim>::MIN_ELEMENTS_PER_THREAD;
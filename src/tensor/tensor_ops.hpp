@@ -0,0 +1,544 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include "tensor.hpp"
+#include "thread_pool.hpp"
+#include "../kernels/half.hpp"
+#include "../kernels/simd_kernels.hpp"
+
+// Element-wise arithmetic into caller-provided tensors: add_out, sub_out, mul_out, div_out, minimum_out
+// and maximum_out, and the in-place members Tensor::add_, sub_, mul_ and div_. Unlike operator+ - * /
+// they never allocate a result, so a loop that reuses its tensors runs without allocating:
+//
+//     add_out(x, bias, y);     // y = x + bias, bias broadcast to y's shape
+//     mul_out(y, 0.5f, y);     // y *= 0.5
+//     maximum_out(y, 0.0f, y); // relu
+//     y.sub_(x);               // y -= x
+//
+// The comparisons equal_out, not_equal_out, less_out, less_equal_out, greater_out and greater_equal_out
+// write 1 where the comparison holds and 0 elsewhere into a Tensor<uint8_t>.
+//
+// Tensor operands are broadcast numpy-style to the shape of `out`, and either operand may be a scalar.
+// `out` may be any view except a broadcast one, and may be one of the operands. An operand that
+// overlaps `out` in any other way is copied first, which is the only case that allocates. Writing to
+// `out` copies its elements if they are shared with a copy (see TensorStorage::share). Division follows
+// operator/ and does not check for zero divisors.
+//
+// All of them run on one broadcasting engine. Dimensions that are contiguous in every operand are
+// merged first, so a bias add over [N, C, H, W] with a [C, 1, 1] bias becomes N*C runs of H*W elements
+// each added to a single value. Unit-stride runs go through the SIMD kernel registry, with a broadcast
+// value repeated into a small stack buffer the kernel can stream. The runs are split across the thread
+// pool. float16 and bfloat16 are computed in float.
+
+namespace ops_detail {
+    template<typename T>
+    struct identity { using type = T; };
+
+    // Keeps a scalar parameter out of template argument deduction, so `mul_out(t, 2, out)` works for a
+    // float tensor.
+    template<typename T>
+    using scalar_t = typename identity<T>::type;
+
+    struct Add {
+        template<typename K> static auto kernel(const K& k) { return k.add; }
+        template<typename U> U operator()(U a, U b) const { return a + b; }
+    };
+
+    struct Sub {
+        template<typename K> static auto kernel(const K& k) { return k.sub; }
+        template<typename U> U operator()(U a, U b) const { return a - b; }
+    };
+
+    struct Mul {
+        template<typename K> static auto kernel(const K& k) { return k.mul; }
+        template<typename U> U operator()(U a, U b) const { return a * b; }
+    };
+
+    struct Div {
+        template<typename K> static auto kernel(const K& k) { return k.div; }
+        template<typename U> U operator()(U a, U b) const { return a / b; }
+    };
+
+    // Same NaN handling as the min/max kernels: the second operand wins unless the first compares smaller
+    // (larger).
+    struct Min {
+        template<typename K> static auto kernel(const K& k) { return k.min; }
+        template<typename U> U operator()(U a, U b) const { return a < b ? a : b; }
+    };
+
+    struct Max {
+        template<typename K> static auto kernel(const K& k) { return k.max; }
+        template<typename U> U operator()(U a, U b) const { return a > b ? a : b; }
+    };
+
+    struct Equal {
+        template<typename U> bool operator()(U a, U b) const { return a == b; }
+    };
+
+    struct NotEqual {
+        template<typename U> bool operator()(U a, U b) const { return a != b; }
+    };
+
+    struct Less {
+        template<typename U> bool operator()(U a, U b) const { return a < b; }
+    };
+
+    struct LessEqual {
+        template<typename U> bool operator()(U a, U b) const { return a <= b; }
+    };
+
+    struct Greater {
+        template<typename U> bool operator()(U a, U b) const { return a > b; }
+    };
+
+    struct GreaterEqual {
+        template<typename U> bool operator()(U a, U b) const { return a >= b; }
+    };
+
+    template<typename Op, typename T>
+    T apply(T a, T b) {
+        using Acc = accum_t<T>;
+        return static_cast<T>(Op()(static_cast<Acc>(a), static_cast<Acc>(b)));
+    }
+
+    // Elements per step of the scalar loops; a fixed trip count lets them vectorise.
+    constexpr size_t kBlock = 16;
+
+    // Elements a broadcast value is repeated to for the SIMD kernels.
+    constexpr size_t kSplat = 256;
+
+    // Minimum elements per parallel chunk. The loops are memory bound, so smaller chunks cost more in
+    // scheduling than they gain.
+    constexpr size_t kGrain = size_t(1) << 15;
+
+    // Calls fn(i) for i < n in blocks of kBlock.
+    template<typename F>
+    void blocked(size_t n, F&& fn) {
+        size_t i = 0;
+        for (; i + kBlock <= n; i += kBlock) {
+            for (size_t j = 0; j < kBlock; ++j) {
+                fn(i + j);
+            }
+        }
+        for (; i < n; ++i) {
+            fn(i);
+        }
+    }
+
+    // out[j * so] = a[j * sa] op b[j * sb] for j < n. A stride of 0 marks a broadcast operand.
+    template<typename Op, typename T>
+    void binary_run(const T* a, size_t sa, const T* b, size_t sb, T* out, size_t so, size_t n) {
+        if (so != 1 || sa > 1 || sb > 1) {
+            for (size_t j = 0; j < n; ++j) {
+                out[j * so] = apply<Op>(a[j * sa], b[j * sb]);
+            }
+        } else if (sa == 0 && sb == 0) {
+            std::fill(out, out + n, apply<Op>(*a, *b));
+        } else if constexpr (has_simd_kernels<T>) {
+            const auto kernel = Op::kernel(simd_kernels<T>());
+            if (sa == 1 && sb == 1) {
+                kernel(a, b, out, n);
+                return;
+            }
+            T splat[kSplat];
+            std::fill(splat, splat + std::min(n, kSplat), sa ? *b : *a);
+            for (size_t i = 0; i < n; i += kSplat) {
+                const size_t len = std::min(kSplat, n - i);
+                kernel(sa ? a + i : splat, sb ? b + i : splat, out + i, len);
+            }
+        } else if constexpr (is_half_float_v<T>) {
+            // The widened result goes to the buffer of a streamed operand, so a repeated value survives.
+            const auto kernel = Op::kernel(simd_kernels<float>());
+            float fa[kSplat], fb[kSplat];
+            if (sa == 0) {
+                std::fill(fa, fa + std::min(n, kSplat), static_cast<float>(*a));
+            }
+            if (sb == 0) {
+                std::fill(fb, fb + std::min(n, kSplat), static_cast<float>(*b));
+            }
+            float* res = sa ? fa : fb;
+            for (size_t i = 0; i < n; i += kSplat) {
+                const size_t len = std::min(kSplat, n - i);
+                if (sa) {
+                    convert_half(a + i, fa, len);
+                }
+                if (sb) {
+                    convert_half(b + i, fb, len);
+                }
+                kernel(fa, fb, res, len);
+                convert_half(res, out + i, len);
+            }
+        } else {
+            blocked(n, [&](size_t j) { out[j] = apply<Op>(a[j * sa], b[j * sb]); });
+        }
+    }
+
+    // out[j * so] = a[j * sa] cmp b[j * sb] ? 1 : 0 for j < n.
+    template<typename Cmp, typename T>
+    void compare_run(const T* a, size_t sa, const T* b, size_t sb, uint8_t* out, size_t so, size_t n) {
+        using Acc = accum_t<T>;
+        if (so == 1 && sa == 1 && sb == 1) {
+            blocked(n, [&](size_t j) { out[j] = Cmp()(static_cast<Acc>(a[j]), static_cast<Acc>(b[j])); });
+        } else if (so == 1 && sa == 1 && sb == 0) {
+            const Acc s = static_cast<Acc>(*b);
+            blocked(n, [&](size_t j) { out[j] = Cmp()(static_cast<Acc>(a[j]), s); });
+        } else if (so == 1 && sa == 0 && sb == 1) {
+            const Acc s = static_cast<Acc>(*a);
+            blocked(n, [&](size_t j) { out[j] = Cmp()(s, static_cast<Acc>(b[j])); });
+        } else {
+            for (size_t j = 0; j < n; ++j) {
+                out[j * so] = Cmp()(static_cast<Acc>(a[j * sa]), static_cast<Acc>(b[j * sb]));
+            }
+        }
+    }
+
+    // Shape and strides of an element-wise loop over operands a and b and the output, in that order.
+    template<size_t Dim>
+    struct Layout {
+        std::array<size_t, Dim> shape;
+        std::array<std::array<size_t, Dim>, 3> strides;
+    };
+
+    // Drops size-1 dimensions and merges each dimension into its inner neighbour where the two are
+    // contiguous in all three operands. A broadcast operand has stride 0 in both, so broadcast
+    // dimensions merge with each other. The result is padded on the left with size-1 dimensions.
+    template<size_t Dim>
+    Layout<Dim> collapse(const std::array<size_t, Dim>& shape, const std::array<std::array<size_t, Dim>, 3>& strides) {
+        Layout<Dim> res;
+        res.shape.fill(1);
+        for (auto& s : res.strides) {
+            s.fill(0);
+        }
+        size_t r = Dim;
+        for (size_t d = Dim; d-- > 0;) {
+            if (shape[d] == 1) {
+                continue;
+            }
+            bool merge = r < Dim;
+            for (size_t t = 0; t < 3 && merge; ++t) {
+                merge = strides[t][d] == res.strides[t][r] * res.shape[r];
+            }
+            if (merge) {
+                res.shape[r] *= shape[d];
+            } else {
+                --r;
+                res.shape[r] = shape[d];
+                for (size_t t = 0; t < 3; ++t) {
+                    res.strides[t][r] = strides[t][d];
+                }
+            }
+        }
+        return res;
+    }
+
+    // Calls run(a, sa, b, sb, out, so, n) over the innermost dimension of the collapsed loop, splitting
+    // the outer dimensions across the thread pool in chunks of at least `grain` elements. Runs longer
+    // than `grain` are split too, so a single long run is still parallel.
+    template<size_t Dim, typename A, typename B, typename O, typename Run>
+    void for_each_run(const std::array<size_t, Dim>& shape, const std::array<std::array<size_t, Dim>, 3>& strides,
+                      const A* a, const B* b, O* out, size_t grain, Run run) {
+        const Layout<Dim> l = collapse(shape, strides);
+        const size_t n = l.shape[Dim - 1];
+        const size_t rows = tensor_detail::row_count(l.shape);
+        const size_t sa = l.strides[0][Dim - 1], sb = l.strides[1][Dim - 1], so = l.strides[2][Dim - 1];
+        if (n == 0 || rows == 0) {
+            return;
+        }
+        grain = std::max<size_t>(grain, 1);
+        if (n <= grain) {
+            parallel_for(0, rows, [&](size_t first, size_t last) {
+                tensor_detail::for_each_row<Dim, 3>(l.shape, l.strides, {0, 0, 0}, first, last,
+                    [&](const std::array<size_t, 3>& off) {
+                        run(a + off[0], sa, b + off[1], sb, out + off[2], so, n);
+                    });
+            }, std::max<size_t>(1, grain / n));
+            return;
+        }
+        const size_t pieces = (n + grain - 1) / grain;
+        parallel_for(0, rows * pieces, [&](size_t first, size_t last) {
+            for (size_t p = first; p < last; ++p) {
+                const size_t row = p / pieces, begin = (p % pieces) * grain, len = std::min(grain, n - begin);
+                tensor_detail::for_each_row<Dim, 3>(l.shape, l.strides, {begin * sa, begin * sb, begin * so},
+                    row, row + 1,
+                    [&](const std::array<size_t, 3>& off) {
+                        run(a + off[0], sa, b + off[1], sb, out + off[2], so, len);
+                    });
+            }
+        }, 1);
+    }
+
+    // Several elements of a broadcast view are one element, so writing to it would race with itself.
+    template<typename U, size_t Dim>
+    void check_output(const Tensor<U, Dim>& out) {
+        for (size_t d = 0; d < Dim; ++d) {
+            if (out.strides()[d] == 0 && out.shape()[d] > 1) {
+                throw std::invalid_argument("Output tensor cannot be a broadcast view");
+            }
+        }
+    }
+
+    // A view of t broadcast to out's shape, or a contiguous copy of it if it overlaps out other than
+    // element for element.
+    template<typename T, size_t D, typename U, size_t Dim>
+    Tensor<T, Dim> operand(const Tensor<T, D>& t, const Tensor<U, Dim>& out) {
+        Tensor<T, Dim> v = t.broadcast_to(out.shape());
+        if constexpr (std::is_same<T, U>::value) {
+            if (v.data_ptr()->shares_elements(*out.data_ptr()) &&
+                (v.offset() != out.offset() || v.strides() != out.strides())) {
+                return v.contiguous();
+            }
+        }
+        return v;
+    }
+
+    template<typename Op, typename T, size_t Dim, size_t DA, size_t DB>
+    Tensor<T, Dim>& tensor_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<T, Dim>& out,
+                               size_t grain = kGrain) {
+        static_assert(DA <= Dim && DB <= Dim, "Operands cannot have a higher rank than the output");
+        check_output(out);
+        T* o = out.data();
+        const Tensor<T, Dim> va = operand(a, out), vb = operand(b, out);
+        for_each_run<Dim>(out.shape(), {va.strides(), vb.strides(), out.strides()}, va.data(), vb.data(), o,
+                          grain, binary_run<Op, T>);
+        return out;
+    }
+
+    // A scalar is an operand with all strides 0.
+    template<typename Op, bool ScalarLeft, typename T, size_t Dim, size_t DA>
+    Tensor<T, Dim>& scalar_out(const Tensor<T, DA>& a, T s, Tensor<T, Dim>& out) {
+        static_assert(DA <= Dim, "Operands cannot have a higher rank than the output");
+        check_output(out);
+        T* o = out.data();
+        const Tensor<T, Dim> va = operand(a, out);
+        const std::array<size_t, Dim> none{};
+        if (ScalarLeft) {
+            for_each_run<Dim>(out.shape(), {none, va.strides(), out.strides()}, &s, va.data(), o, kGrain,
+                              binary_run<Op, T>);
+        } else {
+            for_each_run<Dim>(out.shape(), {va.strides(), none, out.strides()}, va.data(), &s, o, kGrain,
+                              binary_run<Op, T>);
+        }
+        return out;
+    }
+
+    template<typename Cmp, typename T, size_t Dim, size_t DA, size_t DB>
+    Tensor<uint8_t, Dim>& compare_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<uint8_t, Dim>& out) {
+        static_assert(DA <= Dim && DB <= Dim, "Operands cannot have a higher rank than the output");
+        check_output(out);
+        uint8_t* o = out.data();
+        const Tensor<T, Dim> va = operand(a, out), vb = operand(b, out);
+        for_each_run<Dim>(out.shape(), {va.strides(), vb.strides(), out.strides()}, va.data(), vb.data(), o,
+                          kGrain, compare_run<Cmp, T>);
+        return out;
+    }
+
+    template<typename Cmp, typename T, size_t Dim, size_t DA>
+    Tensor<uint8_t, Dim>& compare_scalar_out(const Tensor<T, DA>& a, T s, Tensor<uint8_t, Dim>& out) {
+        static_assert(DA <= Dim, "Operands cannot have a higher rank than the output");
+        check_output(out);
+        uint8_t* o = out.data();
+        const Tensor<T, Dim> va = operand(a, out);
+        const std::array<size_t, Dim> none{};
+        for_each_run<Dim>(out.shape(), {va.strides(), none, out.strides()}, va.data(), &s, o, kGrain,
+                          compare_run<Cmp, T>);
+        return out;
+    }
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<T, Dim>& add_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::tensor_out<ops_detail::Add>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<T, Dim>& add_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Add, false>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DB>
+Tensor<T, Dim>& add_out(ops_detail::scalar_t<T> a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Add, true>(b, a, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<T, Dim>& sub_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::tensor_out<ops_detail::Sub>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<T, Dim>& sub_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Sub, false>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DB>
+Tensor<T, Dim>& sub_out(ops_detail::scalar_t<T> a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Sub, true>(b, a, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<T, Dim>& mul_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::tensor_out<ops_detail::Mul>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<T, Dim>& mul_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Mul, false>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DB>
+Tensor<T, Dim>& mul_out(ops_detail::scalar_t<T> a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Mul, true>(b, a, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<T, Dim>& div_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::tensor_out<ops_detail::Div>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<T, Dim>& div_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Div, false>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DB>
+Tensor<T, Dim>& div_out(ops_detail::scalar_t<T> a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Div, true>(b, a, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<T, Dim>& minimum_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::tensor_out<ops_detail::Min>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<T, Dim>& minimum_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Min, false>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DB>
+Tensor<T, Dim>& minimum_out(ops_detail::scalar_t<T> a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Min, true>(b, a, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<T, Dim>& maximum_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::tensor_out<ops_detail::Max>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<T, Dim>& maximum_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Max, false>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DB>
+Tensor<T, Dim>& maximum_out(ops_detail::scalar_t<T> a, const Tensor<T, DB>& b, Tensor<T, Dim>& out) {
+    return ops_detail::scalar_out<ops_detail::Max, true>(b, a, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<uint8_t, Dim>& equal_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_out<ops_detail::Equal>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<uint8_t, Dim>& equal_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_scalar_out<ops_detail::Equal>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<uint8_t, Dim>& not_equal_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_out<ops_detail::NotEqual>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<uint8_t, Dim>& not_equal_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_scalar_out<ops_detail::NotEqual>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<uint8_t, Dim>& less_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_out<ops_detail::Less>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<uint8_t, Dim>& less_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_scalar_out<ops_detail::Less>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<uint8_t, Dim>& less_equal_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_out<ops_detail::LessEqual>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<uint8_t, Dim>& less_equal_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_scalar_out<ops_detail::LessEqual>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<uint8_t, Dim>& greater_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_out<ops_detail::Greater>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<uint8_t, Dim>& greater_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_scalar_out<ops_detail::Greater>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA, size_t DB>
+Tensor<uint8_t, Dim>& greater_equal_out(const Tensor<T, DA>& a, const Tensor<T, DB>& b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_out<ops_detail::GreaterEqual>(a, b, out);
+}
+
+template<typename T, size_t Dim, size_t DA>
+Tensor<uint8_t, Dim>& greater_equal_out(const Tensor<T, DA>& a, ops_detail::scalar_t<T> b, Tensor<uint8_t, Dim>& out) {
+    return ops_detail::compare_scalar_out<ops_detail::GreaterEqual>(a, b, out);
+}
+
+template<typename T, size_t Dim>
+template<size_t D>
+Tensor<T, Dim>& Tensor<T, Dim>::add_(const Tensor<T, D>& other) {
+    return add_out(*this, other, *this);
+}
+
+template<typename T, size_t Dim>
+Tensor<T, Dim>& Tensor<T, Dim>::add_(const T& value) {
+    return add_out(*this, value, *this);
+}
+
+template<typename T, size_t Dim>
+template<size_t D>
+Tensor<T, Dim>& Tensor<T, Dim>::sub_(const Tensor<T, D>& other) {
+    return sub_out(*this, other, *this);
+}
+
+template<typename T, size_t Dim>
+Tensor<T, Dim>& Tensor<T, Dim>::sub_(const T& value) {
+    return sub_out(*this, value, *this);
+}
+
+template<typename T, size_t Dim>
+template<size_t D>
+Tensor<T, Dim>& Tensor<T, Dim>::mul_(const Tensor<T, D>& other) {
+    return mul_out(*this, other, *this);
+}
+
+template<typename T, size_t Dim>
+Tensor<T, Dim>& Tensor<T, Dim>::mul_(const T& value) {
+    return mul_out(*this, value, *this);
+}
+
+template<typename T, size_t Dim>
+template<size_t D>
+Tensor<T, Dim>& Tensor<T, Dim>::div_(const Tensor<T, D>& other) {
+    return div_out(*this, other, *this);
+}
+
+template<typename T, size_t Dim>
+Tensor<T, Dim>& Tensor<T, Dim>::div_(const T& value) {
+    return div_out(*this, value, *this);
+}
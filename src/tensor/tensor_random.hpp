@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include "tensor.hpp"
+#include "../kernels/random.hpp"
+
+// Random initialisation of a Tensor in place, in parallel and reproducibly (see kernels/random.hpp):
+// each fill takes the next stream of a Philox generator, so the same seed and the same sequence of
+// fills give the same tensors for any thread count and instruction set.
+//
+//     Philox gen(1234);
+//     Tensor<float, 2> w({1024, 4096});
+//     fill_xavier_uniform(w, gen);        // fan_in = 1024, fan_out = 4096
+//     fill_normal(b, gen, 0.0f, 0.02f);
+//
+// The tensor must be contiguous; a shared buffer is detached first, like any other write. For a 2D
+// tensor used as the right operand of matmul (rows = inputs, cols = outputs) the fans are taken from
+// its shape; other layouts pass them explicitly.
+
+namespace tensor_detail {
+    template<typename T, size_t Dim>
+    T* random_target(Tensor<T, Dim>& t) {
+        if (!t.is_contiguous()) {
+            throw std::invalid_argument("Random fills need a contiguous tensor");
+        }
+        return t.data();
+    }
+
+    template<typename T, size_t Dim>
+    std::array<size_t, 2> fans(const Tensor<T, Dim>& t) {
+        static_assert(Dim == 2, "Fans are only derived from 2D shapes, pass fan_in and fan_out");
+        return {t.shape()[0], t.shape()[1]};
+    }
+}
+
+template<typename T, size_t Dim>
+Tensor<T, Dim>& fill_uniform(Tensor<T, Dim>& t, Philox& gen, float lo, float hi) {
+    random_uniform(tensor_detail::random_target(t), t.size(), gen.next(), lo, hi);
+    return t;
+}
+
+template<typename T, size_t Dim>
+Tensor<T, Dim>& fill_normal(Tensor<T, Dim>& t, Philox& gen, float mean, float stddev) {
+    random_normal(tensor_detail::random_target(t), t.size(), gen.next(), mean, stddev);
+    return t;
+}
+
+// Normal, redrawn while more than two standard deviations from the mean.
+template<typename T, size_t Dim>
+Tensor<T, Dim>& fill_truncated_normal(Tensor<T, Dim>& t, Philox& gen, float mean, float stddev) {
+    random_truncated_normal(tensor_detail::random_target(t), t.size(), gen.next(), mean, stddev);
+    return t;
+}
+
+// Glorot & Bengio: uniform in +-sqrt(6 / (fan_in + fan_out)).
+template<typename T, size_t Dim>
+Tensor<T, Dim>& fill_xavier_uniform(Tensor<T, Dim>& t, Philox& gen, size_t fan_in, size_t fan_out) {
+    const float limit = static_cast<float>(std::sqrt(6.0 / static_cast<double>(fan_in + fan_out)));
+    return fill_uniform(t, gen, -limit, limit);
+}
+
+template<typename T, size_t Dim>
+Tensor<T, Dim>& fill_xavier_uniform(Tensor<T, Dim>& t, Philox& gen) {
+    const auto fans = tensor_detail::fans(t);
+    return fill_xavier_uniform(t, gen, fans[0], fans[1]);
+}
+
+// He et al., for ReLU layers: normal with standard deviation sqrt(2 / fan_in).
+template<typename T, size_t Dim>
+Tensor<T, Dim>& fill_he_normal(Tensor<T, Dim>& t, Philox& gen, size_t fan_in) {
+    return fill_normal(t, gen, 0.0f, static_cast<float>(std::sqrt(2.0 / static_cast<double>(fan_in))));
+}
+
+template<typename T, size_t Dim>
+Tensor<T, Dim>& fill_he_normal(Tensor<T, Dim>& t, Philox& gen) {
+    return fill_he_normal(t, gen, tensor_detail::fans(t)[0]);
+}
@@ -0,0 +1,517 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "tensor.hpp"
+#include "thread_pool.hpp"
+#include "../kernels/half.hpp"
+#include "../kernels/simd_kernels.hpp"
+
+// Reductions of a Tensor along any set of axes: reduce_sum, reduce_mean, reduce_max and reduce_min,
+// and reduce_argmax / reduce_argmin along one axis. The reduced axes are dropped from the result, or
+// kept with size 1 when KeepDims is true:
+//
+//     reduce_sum(t, 1);             // shape (A, B, C) -> (A, C)
+//     reduce_max<true>(t, {0, 2});  // (A, B, C) -> (1, B, 1)
+//
+// The source is made contiguous, and runs of adjacent reduced or kept axes are merged. When the last
+// axis is reduced, every output is a reduction of contiguous runs through the SIMD kernels; when it
+// is kept, whole rows are folded into output rows with the element-wise kernels. Either way the work
+// is split over the ThreadPool by output, and sums are pairwise (over blocks of a run, and over rows),
+// so their rounding error grows with the logarithm of the axis length rather than linearly. Sums of
+// float16 / bfloat16 tensors are accumulated and returned in float (accum_t<T>).
+
+namespace reduce_detail {
+    // Contiguous elements summed directly by the SIMD kernel at the leaves of the pairwise tree, and
+    // rows folded directly at the leaves of the row tree.
+    constexpr size_t kPairwiseBlock = 256;
+    constexpr size_t kPairwiseRows = 8;
+    // Output columns handled at once when the last axis is kept; sized like the half-float blocks so
+    // that 16-bit rows widen through one stack buffer.
+    constexpr size_t kColumnChunk = half_detail::kBlock;
+    // Elements read per ThreadPool chunk, roughly.
+    constexpr size_t kWorkPerChunk = 1 << 14;
+
+    template<size_t N>
+    std::array<size_t, N> to_array(const size_t (&axes)[N]) {
+        std::array<size_t, N> res;
+        std::copy(axes, axes + N, res.begin());
+        return res;
+    }
+
+    template<size_t Dim, size_t N>
+    std::array<bool, Dim> axis_mask(const std::array<size_t, N>& axes) {
+        std::array<bool, Dim> mask{};
+        for (size_t a : axes) {
+            if (a >= Dim || mask[a]) {
+                throw std::invalid_argument("Invalid reduction axis");
+            }
+            mask[a] = true;
+        }
+        return mask;
+    }
+
+    template<size_t Dim, size_t OutDim>
+    std::array<size_t, OutDim> output_shape(const std::array<size_t, Dim>& shape, const std::array<bool, Dim>& mask) {
+        std::array<size_t, OutDim> out{};
+        size_t o = 0;
+        for (size_t d = 0; d < Dim; ++d) {
+            if (OutDim == Dim) {
+                out[o++] = mask[d] ? 1 : shape[d];
+            } else if (!mask[d]) {
+                out[o++] = shape[d];
+            }
+        }
+        return out;
+    }
+
+    // Up to Dim dimensions of a contiguous buffer, outermost first.
+    template<size_t Dim>
+    struct Dims {
+        size_t n = 0;
+        std::array<size_t, Dim> shape{}, stride{};
+
+        size_t count() const {
+            size_t c = 1;
+            for (size_t i = 0; i < n; ++i) {
+                c *= shape[i];
+            }
+            return c;
+        }
+
+        // Offset of the flat row-major index i over these dimensions.
+        size_t offset(size_t i) const {
+            size_t off = 0;
+            for (size_t d = n; d-- > 0;) {
+                off += (i % shape[d]) * stride[d];
+                i /= shape[d];
+            }
+            return off;
+        }
+    };
+
+    // Splits a contiguous shape into kept and reduced dimensions. Size-1 dimensions are dropped and a
+    // dimension is merged into the previous one of its kind when the two are adjacent in memory.
+    template<size_t Dim>
+    void split_dims(const std::array<size_t, Dim>& shape, const std::array<bool, Dim>& mask,
+                    Dims<Dim>& kept, Dims<Dim>& reduced, bool& last_reduced) {
+        const auto strides = tensor_detail::contiguous_strides(shape);
+        bool prev = false, have_prev = false;
+        last_reduced = true;
+        for (size_t d = 0; d < Dim; ++d) {
+            if (shape[d] == 1) {
+                continue;
+            }
+            Dims<Dim>& dims = mask[d] ? reduced : kept;
+            if (have_prev && prev == mask[d]) {
+                dims.shape[dims.n - 1] *= shape[d];
+                dims.stride[dims.n - 1] = strides[d];
+            } else {
+                dims.shape[dims.n] = shape[d];
+                dims.stride[dims.n] = strides[d];
+                ++dims.n;
+            }
+            prev = mask[d];
+            have_prev = true;
+            last_reduced = mask[d];
+        }
+    }
+
+    // Combines n values in a balanced tree with op.
+    template<typename Acc, typename Op>
+    Acc pairwise(const Acc* v, size_t n, Op op) {
+        if (n <= kPairwiseRows) {
+            Acc r = v[0];
+            for (size_t i = 1; i < n; ++i) {
+                r = op(r, v[i]);
+            }
+            return r;
+        }
+        const size_t half = n / 2;
+        return op(pairwise(v, half, op), pairwise(v + half, n - half, op));
+    }
+
+    // Each Op reduces in accumulator type Acc and provides
+    //   run(p, n):          reduction of n contiguous elements (n > 0)
+    //   combine(a, b):      of two partial results
+    //   fold(out, x, n):    out[j] = combine(out[j], x[j]) for a row x of the source
+    //   merge(out, y, n):   out[j] = combine(out[j], y[j]) for a row of partial results
+    // plus the identity for empty reductions where one exists.
+
+    template<typename T>
+    struct SumOp {
+        using Acc = accum_t<T>;
+        static constexpr bool has_identity = true;
+        static Acc identity() { return Acc(0); }
+
+        static Acc block(const T* p, size_t n) {
+            if constexpr (has_simd_kernels<T>) {
+                return simd_kernels<T>().sum(p, n);
+            } else if constexpr (is_half_float_v<T>) {
+                float sum = 0;
+                for_each_float_block(p, n, [&](const float* f, size_t len) { sum += simd_kernels<float>().sum(f, len); });
+                return sum;
+            } else {
+                Acc sum = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    sum += p[i];
+                }
+                return sum;
+            }
+        }
+
+        static Acc run(const T* p, size_t n) {
+            if (n <= kPairwiseBlock) {
+                return block(p, n);
+            }
+            const size_t half = (n / 2 + kPairwiseBlock - 1) / kPairwiseBlock * kPairwiseBlock;
+            return run(p, half) + run(p + half, n - half);
+        }
+
+        static Acc combine(Acc a, Acc b) { return a + b; }
+
+        static void merge(Acc* out, const Acc* y, size_t n) {
+            if constexpr (has_simd_kernels<Acc>) {
+                simd_kernels<Acc>().add(out, y, out, n);
+            } else {
+                for (size_t j = 0; j < n; ++j) {
+                    out[j] += y[j];
+                }
+            }
+        }
+
+        static void fold(Acc* out, const T* x, size_t n) {
+            if constexpr (is_half_float_v<T>) {
+                float buf[kColumnChunk];
+                convert_half(x, buf, n);
+                merge(out, buf, n);
+            } else {
+                merge(out, x, n);
+            }
+        }
+    };
+
+    template<typename T, bool Max>
+    struct ExtremumOp {
+        using Acc = accum_t<T>;
+        static constexpr bool has_identity = false;
+        static Acc identity() { return Acc(); }
+
+        static Acc run(const T* p, size_t n) {
+            if constexpr (has_simd_kernels<T>) {
+                return Max ? simd_kernels<T>().reduce_max(p, n) : simd_kernels<T>().reduce_min(p, n);
+            } else if constexpr (is_half_float_v<T>) {
+                float best = p[0];
+                for_each_float_block(p, n, [&](const float* f, size_t len) {
+                    best = combine(best, Max ? simd_kernels<float>().reduce_max(f, len)
+                                             : simd_kernels<float>().reduce_min(f, len));
+                });
+                return best;
+            } else {
+                Acc best = p[0];
+                for (size_t i = 1; i < n; ++i) {
+                    best = combine(best, p[i]);
+                }
+                return best;
+            }
+        }
+
+        static Acc combine(Acc a, Acc b) { return Max ? (b > a ? b : a) : (b < a ? b : a); }
+
+        static void merge(Acc* out, const Acc* y, size_t n) {
+            if constexpr (has_simd_kernels<Acc>) {
+                Max ? simd_kernels<Acc>().max(out, y, out, n) : simd_kernels<Acc>().min(out, y, out, n);
+            } else {
+                for (size_t j = 0; j < n; ++j) {
+                    out[j] = combine(out[j], y[j]);
+                }
+            }
+        }
+
+        static void fold(Acc* out, const T* x, size_t n) {
+            if constexpr (is_half_float_v<T>) {
+                float buf[kColumnChunk];
+                convert_half(x, buf, n);
+                merge(out, buf, n);
+            } else {
+                merge(out, x, n);
+            }
+        }
+    };
+
+    // Last axis reduced: out[o] is the reduction of the reduced block of output o, whose innermost
+    // dimension is a contiguous run. The runs of a block are reduced separately and then pairwise.
+    template<typename Op, typename T, size_t Dim>
+    void reduce_inner(const T* src, const Dims<Dim>& kept, const Dims<Dim>& reduced, typename Op::Acc* out) {
+        using Acc = typename Op::Acc;
+        const size_t outputs = kept.count();
+        const size_t run = reduced.shape[reduced.n - 1];
+        Dims<Dim> rows = reduced;
+        rows.n -= 1;
+        const size_t row_count = rows.count();
+        parallel_for(0, outputs, [&](size_t first, size_t last) {
+            static thread_local std::vector<Acc> partial;
+            partial.resize(row_count);
+            for (size_t o = first; o < last; ++o) {
+                const T* base = src + kept.offset(o);
+                for (size_t r = 0; r < row_count; ++r) {
+                    partial[r] = Op::run(base + rows.offset(r), run);
+                }
+                out[o] = pairwise(partial.data(), row_count, Op::combine);
+            }
+        }, std::max<size_t>(1, kWorkPerChunk / (row_count * run)));
+    }
+
+    // Last axis kept: output row q (the last kept dimension, contiguous) is the fold of the matching
+    // rows of every reduced index. Work items are column chunks of output rows; rows are combined in a
+    // balanced tree through one scratch chunk per level.
+    template<typename Op, typename T, size_t Dim>
+    void reduce_outer(const T* src, const Dims<Dim>& kept, const Dims<Dim>& reduced, typename Op::Acc* out) {
+        using Acc = typename Op::Acc;
+        const size_t len = kept.shape[kept.n - 1];
+        Dims<Dim> out_rows = kept;
+        out_rows.n -= 1;
+        const size_t row_count = out_rows.count();
+        const size_t chunks = (len + kColumnChunk - 1) / kColumnChunk;
+        const size_t reduce_count = reduced.count();
+
+        parallel_for(0, row_count * chunks, [&](size_t first, size_t last) {
+            static thread_local std::vector<Acc> scratch;
+            scratch.resize(kColumnChunk * 64);
+            for (size_t item = first; item < last; ++item) {
+                const size_t q = item / chunks;
+                const size_t j0 = (item % chunks) * kColumnChunk;
+                const size_t n = std::min(kColumnChunk, len - j0);
+                const T* base = src + out_rows.offset(q) + j0;
+                Acc* dst = out + q * len + j0;
+
+                // dst = reduction over reduced indices [r0, r1), using scratch levels from `level` on.
+                auto tree = [&](auto&& self, size_t r0, size_t r1, Acc* acc, size_t level) -> void {
+                    if (r1 - r0 <= kPairwiseRows) {
+                        const T* x = base + reduced.offset(r0);
+                        if constexpr (std::is_same<Acc, T>::value) {
+                            std::copy(x, x + n, acc);
+                        } else {
+                            for (size_t j = 0; j < n; ++j) {
+                                acc[j] = static_cast<Acc>(x[j]);
+                            }
+                        }
+                        for (size_t r = r0 + 1; r < r1; ++r) {
+                            Op::fold(acc, base + reduced.offset(r), n);
+                        }
+                        return;
+                    }
+                    const size_t mid = r0 + (r1 - r0) / 2;
+                    Acc* tmp = scratch.data() + level * kColumnChunk;
+                    self(self, r0, mid, acc, level + 1);
+                    self(self, mid, r1, tmp, level + 1);
+                    Op::merge(acc, tmp, n);
+                };
+                tree(tree, 0, reduce_count, dst, 0);
+            }
+        }, std::max<size_t>(1, kWorkPerChunk / (reduce_count * std::min(len, kColumnChunk))));
+    }
+
+    // Reduces src over the axes in mask into out, row-major over the kept axes.
+    template<typename Op, typename T, size_t Dim>
+    void reduce(const Tensor<T, Dim>& t, const std::array<bool, Dim>& mask, typename Op::Acc* out) {
+        const Tensor<T, Dim> src = t.is_contiguous() ? t.view() : t.contiguous();
+        Dims<Dim> kept, reduced;
+        bool last_reduced = true;
+        split_dims(src.shape(), mask, kept, reduced, last_reduced);
+        const size_t outputs = kept.count();
+        if (outputs == 0 || src.size() == 0) {
+            if (outputs != 0 && !Op::has_identity) {
+                throw std::invalid_argument("Reduction over an empty axis");
+            }
+            std::fill(out, out + outputs, Op::identity());
+            return;
+        }
+        if (reduced.n == 0) {
+            for (size_t i = 0; i < outputs; ++i) {
+                out[i] = static_cast<typename Op::Acc>(src.data()[i]);
+            }
+        } else if (last_reduced) {
+            reduce_inner<Op>(src.data(), kept, reduced, out);
+        } else {
+            reduce_outer<Op>(src.data(), kept, reduced, out);
+        }
+    }
+
+    template<typename Op, bool KeepDims, typename T, size_t Dim, size_t N>
+    auto reduce_to_tensor(const Tensor<T, Dim>& t, const std::array<size_t, N>& axes) {
+        static_assert(N >= 1 && N <= Dim, "Invalid number of reduction axes");
+        static_assert(KeepDims || N < Dim, "Reducing every axis needs KeepDims (or AdvancedTensor::optimize_sum)");
+        constexpr size_t OutDim = KeepDims ? Dim : Dim - N;
+        const auto mask = axis_mask<Dim>(axes);
+        Tensor<typename Op::Acc, OutDim> result(output_shape<Dim, OutDim>(t.shape(), mask));
+        reduce<Op>(t, mask, result.data());
+        return result;
+    }
+
+    // Max and min return T; 16-bit results are computed in float and rounded once.
+    template<typename Acc, typename T, size_t Dim>
+    Tensor<T, Dim> narrow(const Tensor<Acc, Dim>& t) {
+        if constexpr (std::is_same<Acc, T>::value) {
+            return t;
+        } else {
+            Tensor<T, Dim> result(t.shape());
+            convert_half(t.data(), result.data(), t.size());
+            return result;
+        }
+    }
+
+    template<bool KeepDims, typename T, size_t Dim, size_t N>
+    auto mean(const Tensor<T, Dim>& t, const std::array<size_t, N>& axes) {
+        static_assert(!std::is_integral<T>::value, "reduce_mean needs a floating-point tensor");
+        using Acc = accum_t<T>;
+        auto result = reduce_to_tensor<SumOp<T>, KeepDims>(t, axes);
+        size_t count = 1;
+        for (size_t a : axes) {
+            count *= t.shape()[a];
+        }
+        const Acc scale = Acc(1) / static_cast<Acc>(count);
+        Acc* p = result.data();
+        for (size_t i = 0; i < result.size(); ++i) {
+            p[i] *= scale;
+        }
+        return result;
+    }
+
+    // Index of the first largest (Max) or smallest element along one axis. A NaN counts as larger and
+    // smaller than anything, so the first NaN is reported, as in numpy.
+    template<bool Max, bool KeepDims, typename T, size_t Dim>
+    auto arg_extremum(const Tensor<T, Dim>& t, size_t axis) {
+        static_assert(KeepDims || Dim > 1, "Reducing every axis needs KeepDims");
+        constexpr size_t OutDim = KeepDims ? Dim : Dim - 1;
+        const auto mask = axis_mask<Dim>(std::array<size_t, 1>{axis});
+        Tensor<size_t, OutDim> result(output_shape<Dim, OutDim>(t.shape(), mask));
+        const size_t outputs = result.size();
+        if (outputs == 0) {
+            return result;
+        }
+        if (t.shape()[axis] == 0) {
+            throw std::invalid_argument("Reduction over an empty axis");
+        }
+        const Tensor<T, Dim> src = t.is_contiguous() ? t.view() : t.contiguous();
+        const size_t len = src.shape()[axis];
+        const size_t stride = src.strides()[axis];
+        const size_t inner = stride;  // elements after the axis in each block
+        const T* p = src.data();
+        size_t* out = result.data();
+        auto better = [](auto v, auto best) {
+            if constexpr (Max) {
+                return v > best || (v != v && best == best);
+            } else {
+                return v < best || (v != v && best == best);
+            }
+        };
+        using Acc = accum_t<T>;
+        if (inner == 1) {
+            parallel_for(0, outputs, [&](size_t first, size_t last) {
+                for (size_t o = first; o < last; ++o) {
+                    const T* row = p + o * len;
+                    Acc best = row[0];
+                    size_t idx = 0;
+                    for (size_t i = 1; i < len; ++i) {
+                        const Acc v = row[i];
+                        if (better(v, best)) {
+                            best = v;
+                            idx = i;
+                        }
+                    }
+                    out[o] = idx;
+                }
+            }, std::max<size_t>(1, kWorkPerChunk / len));
+            return result;
+        }
+        // The axis is not last: sweep it for a chunk of the contiguous inner block at a time, comparing
+        // whole rows.
+        const size_t blocks = outputs / inner;
+        const size_t chunks = (inner + kColumnChunk - 1) / kColumnChunk;
+        parallel_for(0, blocks * chunks, [&](size_t first, size_t last) {
+            Acc best[kColumnChunk];
+            for (size_t item = first; item < last; ++item) {
+                const size_t b = item / chunks;
+                const size_t j0 = (item % chunks) * kColumnChunk;
+                const size_t n = std::min(kColumnChunk, inner - j0);
+                const T* base = p + b * len * inner + j0;
+                size_t* idx = out + b * inner + j0;
+                for (size_t j = 0; j < n; ++j) {
+                    best[j] = base[j];
+                    idx[j] = 0;
+                }
+                for (size_t i = 1; i < len; ++i) {
+                    const T* row = base + i * inner;
+                    for (size_t j = 0; j < n; ++j) {
+                        const Acc v = row[j];
+                        if (better(v, best[j])) {
+                            best[j] = v;
+                            idx[j] = i;
+                        }
+                    }
+                }
+            }
+        }, std::max<size_t>(1, kWorkPerChunk / (len * std::min(inner, kColumnChunk))));
+        return result;
+    }
+}
+
+template<bool KeepDims = false, typename T, size_t Dim, size_t N>
+auto reduce_sum(const Tensor<T, Dim>& t, const size_t (&axes)[N]) {
+    return reduce_detail::reduce_to_tensor<reduce_detail::SumOp<T>, KeepDims>(t, reduce_detail::to_array(axes));
+}
+
+template<bool KeepDims = false, typename T, size_t Dim>
+auto reduce_sum(const Tensor<T, Dim>& t, size_t axis) {
+    return reduce_detail::reduce_to_tensor<reduce_detail::SumOp<T>, KeepDims>(t, std::array<size_t, 1>{axis});
+}
+
+// The sum divided by the number of reduced elements; for floating-point (and 16-bit float) tensors.
+template<bool KeepDims = false, typename T, size_t Dim, size_t N>
+auto reduce_mean(const Tensor<T, Dim>& t, const size_t (&axes)[N]) {
+    return reduce_detail::mean<KeepDims>(t, reduce_detail::to_array(axes));
+}
+
+template<bool KeepDims = false, typename T, size_t Dim>
+auto reduce_mean(const Tensor<T, Dim>& t, size_t axis) {
+    return reduce_detail::mean<KeepDims>(t, std::array<size_t, 1>{axis});
+}
+
+template<bool KeepDims = false, typename T, size_t Dim, size_t N>
+auto reduce_max(const Tensor<T, Dim>& t, const size_t (&axes)[N]) {
+    return reduce_detail::narrow<accum_t<T>, T>(
+        reduce_detail::reduce_to_tensor<reduce_detail::ExtremumOp<T, true>, KeepDims>(t, reduce_detail::to_array(axes)));
+}
+
+template<bool KeepDims = false, typename T, size_t Dim>
+auto reduce_max(const Tensor<T, Dim>& t, size_t axis) {
+    return reduce_detail::narrow<accum_t<T>, T>(
+        reduce_detail::reduce_to_tensor<reduce_detail::ExtremumOp<T, true>, KeepDims>(t, std::array<size_t, 1>{axis}));
+}
+
+template<bool KeepDims = false, typename T, size_t Dim, size_t N>
+auto reduce_min(const Tensor<T, Dim>& t, const size_t (&axes)[N]) {
+    return reduce_detail::narrow<accum_t<T>, T>(
+        reduce_detail::reduce_to_tensor<reduce_detail::ExtremumOp<T, false>, KeepDims>(t, reduce_detail::to_array(axes)));
+}
+
+template<bool KeepDims = false, typename T, size_t Dim>
+auto reduce_min(const Tensor<T, Dim>& t, size_t axis) {
+    return reduce_detail::narrow<accum_t<T>, T>(
+        reduce_detail::reduce_to_tensor<reduce_detail::ExtremumOp<T, false>, KeepDims>(t, std::array<size_t, 1>{axis}));
+}
+
+template<bool KeepDims = false, typename T, size_t Dim>
+Tensor<size_t, KeepDims ? Dim : Dim - 1> reduce_argmax(const Tensor<T, Dim>& t, size_t axis) {
+    return reduce_detail::arg_extremum<true, KeepDims>(t, axis);
+}
+
+template<bool KeepDims = false, typename T, size_t Dim>
+Tensor<size_t, KeepDims ? Dim : Dim - 1> reduce_argmin(const Tensor<T, Dim>& t, size_t axis) {
+    return reduce_detail::arg_extremum<false, KeepDims>(t, axis);
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace storage_detail {
+    // Element bytes a TensorStorage keeps inside itself instead of in a heap buffer: a 4x4 float tensor.
+    constexpr size_t kInlineBytes = 64;
+
+    template<typename T>
+    constexpr size_t inline_capacity() {
+        return std::is_trivially_copyable<T>::value && sizeof(T) <= kInlineBytes ? kInlineBytes / sizeof(T) : 0;
+    }
+
+    template<typename T, size_t N>
+    struct InlineBuffer {
+        T values[N];
+        T* data() { return values; }
+        const T* data() const { return values; }
+    };
+
+    template<typename T>
+    struct InlineBuffer<T, 0> {
+        T* data() { return nullptr; }
+        const T* data() const { return nullptr; }
+    };
+
+    // Per-thread free list of the fixed-size blocks that hold a TensorStorage together with its
+    // shared_ptr control block. A block freed on another thread joins that thread's list; blocks freed
+    // while the thread is shutting down go straight back to operator delete.
+    class BlockCache {
+    public:
+        static constexpr size_t kBlockBytes = 256;
+        static constexpr size_t kMaxCached = 1024;
+
+        static void* allocate() {
+            BlockCache* cache = local();
+            if (cache && !cache->free_.empty()) {
+                void* p = cache->free_.back();
+                cache->free_.pop_back();
+                return p;
+            }
+            return ::operator new(kBlockBytes);
+        }
+
+        static void deallocate(void* p) {
+            BlockCache* cache = local();
+            if (cache && cache->free_.size() < kMaxCached) {
+                cache->free_.push_back(p);
+            } else {
+                ::operator delete(p);
+            }
+        }
+
+    private:
+        BlockCache() { free_.reserve(kMaxCached); }
+
+        ~BlockCache() {
+            destroyed() = true;
+            for (void* p : free_) {
+                ::operator delete(p);
+            }
+        }
+
+        static bool& destroyed() {
+            static thread_local bool flag = false;
+            return flag;
+        }
+
+        static BlockCache* local() {
+            if (destroyed()) {
+                return nullptr;
+            }
+            static thread_local BlockCache cache;
+            return &cache;
+        }
+
+        std::vector<void*> free_;
+    };
+
+    // Allocator for std::allocate_shared: single objects that fit a cache block come from the BlockCache.
+    template<typename U>
+    struct BlockAllocator {
+        using value_type = U;
+
+        BlockAllocator() = default;
+        template<typename V>
+        BlockAllocator(const BlockAllocator<V>&) noexcept {}
+
+        static constexpr bool cached(size_t n) {
+            return n == 1 && sizeof(U) <= BlockCache::kBlockBytes && alignof(U) <= alignof(std::max_align_t);
+        }
+
+        U* allocate(size_t n) {
+            if (cached(n)) {
+                return static_cast<U*>(BlockCache::allocate());
+            }
+            return std::allocator<U>().allocate(n);
+        }
+
+        void deallocate(U* p, size_t n) noexcept {
+            if (cached(n)) {
+                BlockCache::deallocate(p);
+            } else {
+                std::allocator<U>().deallocate(p, n);
+            }
+        }
+
+        template<typename V>
+        bool operator==(const BlockAllocator<V>&) const noexcept { return true; }
+        template<typename V>
+        bool operator!=(const BlockAllocator<V>&) const noexcept { return false; }
+    };
+}
+
+// Element buffer behind a Tensor. It either owns its elements or refers to memory owned by something
+// else, such as a file mapping, which it keeps alive. Either way it offers the subset of the std::vector
+// interface tensors use; copying it always produces an owning buffer.
+//
+// Owned buffers of up to storage_detail::kInlineBytes live inside the storage object itself, and larger
+// ones in a std::vector. Created through make_tensor_storage, a small tensor therefore costs no heap
+// allocation once the calling thread has freed a storage before.
+//
+// Heap and external buffers are copy-on-write: share() returns a second storage over the same elements
+// in O(1), and the first non-const access to a storage whose elements are shared copies them. Const
+// access never copies. The check is not synchronised, so a storage that may be shared must be written
+// once from a single thread before several threads write to it.
+template<typename T>
+class TensorStorage {
+    static constexpr size_t kInline = storage_detail::inline_capacity<T>();
+
+public:
+    TensorStorage() = default;
+
+    explicit TensorStorage(size_t n) {
+        if (n <= kInline) {
+            std::fill(inline_.data(), inline_.data() + n, T());
+            data_ = inline_.data();
+        } else {
+            data_ = own(std::vector<T>(n));
+        }
+        size_ = n;
+    }
+
+    explicit TensorStorage(const std::vector<T>& elements) {
+        if (elements.size() <= kInline) {
+            std::copy(elements.begin(), elements.end(), inline_.data());
+            data_ = inline_.data();
+        } else {
+            data_ = own(std::vector<T>(elements));
+        }
+        size_ = elements.size();
+    }
+
+    explicit TensorStorage(std::vector<T>&& elements) {
+        const size_t n = elements.size();
+        if (n <= kInline) {
+            std::copy(elements.begin(), elements.end(), inline_.data());
+            data_ = inline_.data();
+        } else {
+            data_ = own(std::move(elements));
+        }
+        size_ = n;
+    }
+
+    // n elements at `data`, valid for as long as `owner` is alive.
+    TensorStorage(std::shared_ptr<const void> owner, T* data, size_t n)
+        : buffer_(std::allocate_shared<std::shared_ptr<const void>>(
+              storage_detail::BlockAllocator<std::shared_ptr<const void>>(), std::move(owner))),
+          data_(data), size_(n), external_(true) {}
+
+    TensorStorage(const TensorStorage& other) {
+        if (other.size_ <= kInline) {
+            std::copy(other.begin(), other.end(), inline_.data());
+            data_ = inline_.data();
+        } else {
+            data_ = own(std::vector<T>(other.begin(), other.end()));
+        }
+        size_ = other.size_;
+    }
+
+    TensorStorage& operator=(const TensorStorage& other) {
+        if (this != &other) {
+            *this = TensorStorage(other);
+        }
+        return *this;
+    }
+
+    TensorStorage(TensorStorage&& other) noexcept { *this = std::move(other); }
+
+    TensorStorage& operator=(TensorStorage&& other) noexcept {
+        if (other.is_inline()) {
+            std::copy(other.inline_.data(), other.inline_.data() + other.size_, inline_.data());
+            data_ = inline_.data();
+            buffer_.reset();
+        } else {
+            buffer_ = std::move(other.buffer_);
+            data_ = other.data_;
+        }
+        size_ = other.size_;
+        external_ = other.external_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.external_ = false;
+        return *this;
+    }
+
+    // A storage over the same elements, copied lazily by whichever of the two is written first. Inline
+    // elements are copied right away.
+    std::shared_ptr<TensorStorage> share() const;
+
+    // True if the elements live in memory owned by someone else (e.g. a mapped file).
+    bool is_external() const { return external_; }
+
+    // True if the elements live inside this object rather than in a separate heap buffer.
+    bool is_inline() const { return kInline > 0 && data_ == inline_.data(); }
+
+    // True if another storage refers to the same elements, so the next write will copy them.
+    bool is_shared() const { return buffer_.use_count() > 1; }
+
+    // True if both storages refer to the same elements.
+    bool shares_elements(const TensorStorage& other) const {
+        return this == &other || (buffer_ && buffer_ == other.buffer_);
+    }
+
+    T* data() { detach(); return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T& operator[](size_t i) { detach(); return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+
+    T* begin() { return data(); }
+    T* end() { return data() + size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+
+private:
+    T* own(std::vector<T>&& elements) {
+        auto owned = std::allocate_shared<std::vector<T>>(storage_detail::BlockAllocator<std::vector<T>>(),
+                                                          std::move(elements));
+        T* data = owned->data();
+        buffer_ = std::move(owned);
+        return data;
+    }
+
+    void detach() {
+        if (is_shared()) {
+            *this = TensorStorage(static_cast<const TensorStorage&>(*this));
+        }
+    }
+
+    std::shared_ptr<const void> buffer_;  // keeps heap or external elements alive; shared by share()
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    bool external_ = false;
+    storage_detail::InlineBuffer<T, kInline> inline_;
+};
+
+// Creates a shared TensorStorage in one block from the calling thread's storage cache.
+template<typename T, typename... Args>
+std::shared_ptr<TensorStorage<T>> make_tensor_storage(Args&&... args) {
+    return std::allocate_shared<TensorStorage<T>>(storage_detail::BlockAllocator<TensorStorage<T>>(),
+                                                  std::forward<Args>(args)...);
+}
+
+template<typename T>
+std::shared_ptr<TensorStorage<T>> TensorStorage<T>::share() const {
+    if (!buffer_) {
+        return make_tensor_storage<T>(*this);
+    }
+    auto res = make_tensor_storage<T>();
+    res->buffer_ = buffer_;
+    res->data_ = data_;
+    res->size_ = size_;
+    res->external_ = external_;
+    return res;
+}
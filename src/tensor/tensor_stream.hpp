@@ -0,0 +1,424 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "tensor.hpp"
+
+// Chunked tensor files, for datasets larger than memory: one tensor split along its leading dimension
+// into slabs of a fixed number of rows, written incrementally and read back one slab at a time.
+//
+//   offset 0       ChunkHeader: magic "TNSRCHNK", version, byte-order mark, dtype, rank, row count,
+//                  rows per chunk and chunk stride, followed by the trailing extents as rank - 1 uint64s
+//   offset 4096    chunk k at 4096 + k * stride: the rows of the slab in row-major order, zero padded to
+//                  the stride (a multiple of 4096, so every chunk can be read with O_DIRECT)
+//
+// Integers are stored in the writer's byte order, as in tensor_io.hpp.
+namespace tensor_stream_detail {
+    constexpr char kMagic[8] = {'T', 'N', 'S', 'R', 'C', 'H', 'N', 'K'};
+    constexpr uint32_t kVersion = 1;
+    constexpr uint64_t kDataOffset = 4096;
+
+    struct ChunkHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t dtype;
+        uint32_t rank;
+        uint64_t rows;
+        uint64_t chunk_rows;
+        uint64_t chunk_stride;
+        uint64_t reserved[2];
+    };
+    static_assert(sizeof(ChunkHeader) == 64, "ChunkHeader must stay 64 bytes");
+
+    // Page-aligned buffers of one chunk stride each. A buffer handed out inside a Tensor comes back when
+    // the last tensor using it is destroyed; at most `max_free` of them are kept for reuse.
+    class BufferPool : public std::enable_shared_from_this<BufferPool> {
+    public:
+        BufferPool(size_t bytes, size_t max_free) : bytes_(bytes), max_free_(max_free) {}
+
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        ~BufferPool() {
+            for (char* p : free_) {
+                std::free(p);
+            }
+        }
+
+        char* acquire() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!free_.empty()) {
+                    char* p = free_.back();
+                    free_.pop_back();
+                    return p;
+                }
+            }
+            void* p = std::aligned_alloc(tensor_io_detail::kPayloadAlignment, bytes_);
+            if (!p) {
+                throw std::bad_alloc();
+            }
+            return static_cast<char*>(p);
+        }
+
+        void release(char* p) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (free_.size() < max_free_) {
+                    free_.push_back(p);
+                    return;
+                }
+            }
+            std::free(p);
+        }
+
+        // Keeps the pool alive and returns p to it once the last copy is gone.
+        std::shared_ptr<const void> owner(char* p) {
+            return std::shared_ptr<const void>(p, [pool = shared_from_this()](const void* q) {
+                pool->release(static_cast<char*>(const_cast<void*>(q)));
+            });
+        }
+
+    private:
+        size_t bytes_;
+        size_t max_free_;
+        std::mutex mutex_;
+        std::vector<char*> free_;
+    };
+}
+
+// Writes a chunked tensor file from slabs of rows appended in order. The file is built under a temporary
+// name and renamed into place by close(), so readers never see a partial file; a writer destroyed without
+// close() removes it instead.
+template<typename T, size_t Dim>
+class ChunkedTensorWriter {
+    static_assert(Dim >= 1, "A chunked tensor needs a leading dimension");
+    static_assert(sizeof(tensor_stream_detail::ChunkHeader) + (Dim - 1) * sizeof(uint64_t) <=
+                  tensor_stream_detail::kDataOffset, "The shape must fit in front of the first chunk");
+
+public:
+    // chunk_shape[0] is the number of rows per chunk, the other extents are those of every row.
+    ChunkedTensorWriter(const std::string& filename, const std::array<size_t, Dim>& chunk_shape)
+        : filename_(filename), tmp_(filename + ".tmp"), chunk_shape_(chunk_shape) {
+        if (chunk_shape[0] == 0) {
+            throw std::invalid_argument("Chunks need at least one row");
+        }
+        row_elems_ = std::accumulate(chunk_shape.begin() + 1, chunk_shape.end(), size_t(1),
+                                     std::multiplies<size_t>());
+        stride_ = tensor_io_detail::align_up(std::max<uint64_t>(1, chunk_shape[0] * row_elems_ * sizeof(T)),
+                                             tensor_io_detail::kPayloadAlignment);
+        stage_.resize(chunk_shape[0] * row_elems_);
+
+        file_.open(tmp_, std::ios::binary | std::ios::trunc);
+        if (!file_) {
+            throw std::runtime_error("Unable to open file for writing: " + tmp_);
+        }
+        pad(tensor_stream_detail::kDataOffset);
+    }
+
+    ChunkedTensorWriter(const ChunkedTensorWriter&) = delete;
+    ChunkedTensorWriter& operator=(const ChunkedTensorWriter&) = delete;
+
+    ~ChunkedTensorWriter() {
+        if (file_.is_open()) {
+            file_.close();
+            std::remove(tmp_.c_str());
+        }
+    }
+
+    // Appends any number of rows, which must have the chunk shape's trailing extents.
+    void append(const Tensor<T, Dim>& rows) {
+        if (!file_.is_open()) {
+            throw std::logic_error("ChunkedTensorWriter is closed");
+        }
+        if (!std::equal(rows.shape().begin() + 1, rows.shape().end(), chunk_shape_.begin() + 1)) {
+            throw std::invalid_argument("Rows do not match the chunk shape");
+        }
+        const Tensor<T, Dim> src = rows.is_contiguous() ? rows.view() : rows.contiguous();
+        const T* data = src.data();
+        size_t remaining = rows.shape()[0];
+        while (remaining > 0) {
+            const size_t n = std::min(remaining, chunk_shape_[0] - staged_);
+            std::copy(data, data + n * row_elems_, stage_.data() + staged_ * row_elems_);
+            data += n * row_elems_;
+            staged_ += n;
+            remaining -= n;
+            if (staged_ == chunk_shape_[0]) {
+                write_stage();
+            }
+        }
+    }
+
+    // Rows appended so far.
+    size_t rows() const { return rows_ + staged_; }
+
+    // Writes the last partial chunk and the header, and renames the file into place.
+    void close() {
+        using namespace tensor_stream_detail;
+        if (!file_.is_open()) {
+            throw std::logic_error("ChunkedTensorWriter is closed");
+        }
+        if (staged_ > 0) {
+            write_stage();
+        }
+
+        ChunkHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.byte_order = tensor_io_detail::kByteOrderMark;
+        header.dtype = static_cast<uint32_t>(tensor_io_detail::dtype_of<T>());
+        header.rank = static_cast<uint32_t>(Dim);
+        header.rows = rows_;
+        header.chunk_rows = chunk_shape_[0];
+        header.chunk_stride = stride_;
+        const std::vector<uint64_t> trailing(chunk_shape_.begin() + 1, chunk_shape_.end());
+        file_.seekp(0);
+        file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file_.write(reinterpret_cast<const char*>(trailing.data()), trailing.size() * sizeof(uint64_t));
+        file_.close();
+        if (!file_) {
+            std::remove(tmp_.c_str());
+            throw std::runtime_error("Error writing file: " + tmp_);
+        }
+        if (std::rename(tmp_.c_str(), filename_.c_str()) != 0) {
+            std::remove(tmp_.c_str());
+            throw std::runtime_error("Unable to replace file: " + filename_);
+        }
+    }
+
+private:
+    // Writes the staged rows as the next chunk, padded to the stride.
+    void write_stage() {
+        const uint64_t start = tensor_stream_detail::kDataOffset + rows_ / chunk_shape_[0] * stride_;
+        file_.write(reinterpret_cast<const char*>(stage_.data()), staged_ * row_elems_ * sizeof(T));
+        pad(start + stride_);
+        if (!file_) {
+            throw std::runtime_error("Error writing file: " + tmp_);
+        }
+        rows_ += staged_;
+        staged_ = 0;
+    }
+
+    void pad(uint64_t offset) {
+        static const char zeros[4096] = {};
+        for (uint64_t pos = static_cast<uint64_t>(file_.tellp()); pos < offset; ) {
+            const uint64_t n = std::min<uint64_t>(sizeof(zeros), offset - pos);
+            file_.write(zeros, n);
+            pos += n;
+        }
+    }
+
+    std::string filename_;
+    std::string tmp_;
+    std::array<size_t, Dim> chunk_shape_;
+    size_t row_elems_;
+    uint64_t stride_;
+    std::vector<T> stage_;
+    size_t staged_ = 0;
+    size_t rows_ = 0;
+    std::ofstream file_;
+};
+
+// Streams a chunked tensor file one chunk at a time. A background thread reads up to `prefetch` chunks
+// ahead of the consumer with large sequential reads (O_DIRECT ones if `direct_io` is set and the file
+// system supports it), so reading overlaps with whatever the consumer does with the previous chunk.
+//
+// next() hands out each chunk as a Tensor over the buffer it was read into, without a copy. The buffer
+// is recycled once every tensor using it is gone, so a consumer that drops each chunk before asking for
+// the next one keeps only prefetch + 1 chunks in memory; chunks may also be kept for longer.
+template<typename T, size_t Dim>
+class ChunkedTensorReader {
+    static_assert(Dim >= 1, "A chunked tensor needs a leading dimension");
+
+public:
+    explicit ChunkedTensorReader(const std::string& filename, size_t prefetch = 2, bool direct_io = false)
+        : prefetch_(std::max<size_t>(1, prefetch)) {
+        using namespace tensor_stream_detail;
+
+        // The whole header page is read into an aligned buffer, as O_DIRECT requires.
+        fd_ = open_file(filename, direct_io);
+        std::unique_ptr<char, decltype(&std::free)> page(
+            static_cast<char*>(std::aligned_alloc(tensor_io_detail::kPayloadAlignment, kDataOffset)), &std::free);
+        ChunkHeader header;
+        if (!page || ::pread(fd_, page.get(), kDataOffset, 0) != static_cast<ssize_t>(kDataOffset) ||
+            std::memcmp(page.get(), kMagic, sizeof(kMagic)) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("Not a chunked tensor file: " + filename);
+        }
+        std::memcpy(&header, page.get(), sizeof(header));
+        if (header.byte_order != tensor_io_detail::kByteOrderMark || header.version != kVersion ||
+            header.dtype != static_cast<uint32_t>(tensor_io_detail::dtype_of<T>()) || header.rank != Dim ||
+            header.chunk_rows == 0 || header.chunk_stride % tensor_io_detail::kPayloadAlignment != 0) {
+            ::close(fd_);
+            throw std::runtime_error("Chunked tensor file has a different element type, rank or format: " + filename);
+        }
+        uint64_t trailing[Dim > 1 ? Dim - 1 : 1];
+        std::memcpy(trailing, page.get() + sizeof(header), (Dim - 1) * sizeof(uint64_t));
+
+        shape_[0] = header.rows;
+        std::copy(trailing, trailing + Dim - 1, shape_.begin() + 1);
+        row_elems_ = std::accumulate(shape_.begin() + 1, shape_.end(), size_t(1), std::multiplies<size_t>());
+        chunk_rows_ = header.chunk_rows;
+        stride_ = header.chunk_stride;
+        if (chunk_rows_ * row_elems_ * sizeof(T) > stride_) {
+            ::close(fd_);
+            throw std::runtime_error("Corrupt chunked tensor file: " + filename);
+        }
+        chunk_count_ = (shape_[0] + chunk_rows_ - 1) / chunk_rows_;
+        pool_ = std::make_shared<tensor_stream_detail::BufferPool>(stride_, prefetch_ + 1);
+        thread_ = std::thread([this] { read_ahead(); });
+    }
+
+    ChunkedTensorReader(const ChunkedTensorReader&) = delete;
+    ChunkedTensorReader& operator=(const ChunkedTensorReader&) = delete;
+
+    ~ChunkedTensorReader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+        for (char* p : ready_) {
+            pool_->release(p);
+        }
+        ::close(fd_);
+    }
+
+    // Shape of the whole tensor.
+    const std::array<size_t, Dim>& shape() const { return shape_; }
+
+    size_t chunk_rows() const { return chunk_rows_; }
+    size_t chunk_count() const { return chunk_count_; }
+
+    // Sets `chunk` to the next slab of chunk_rows() rows (fewer for the last one) and returns true, or
+    // returns false after the last chunk. Read errors are rethrown here.
+    bool next(Tensor<T, Dim>& chunk) {
+        if (consumed_ == chunk_count_) {
+            return false;
+        }
+        char* buffer;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !ready_.empty() || error_; });
+            if (ready_.empty()) {
+                std::rethrow_exception(error_);
+            }
+            buffer = ready_.front();
+            ready_.pop_front();
+        }
+        cv_.notify_all();
+
+        std::array<size_t, Dim> shape = shape_;
+        shape[0] = rows_in(consumed_++);
+        chunk = Tensor<T, Dim>(shape, make_tensor_storage<T>(pool_->owner(buffer), reinterpret_cast<T*>(buffer),
+                                                             shape[0] * row_elems_));
+        return true;
+    }
+
+private:
+    static int open_file(const std::string& filename, bool direct_io) {
+#ifdef O_DIRECT
+        if (direct_io) {
+            const int fd = ::open(filename.c_str(), O_RDONLY | O_DIRECT);
+            if (fd >= 0) {
+                return fd;
+            }
+        }
+#endif
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Unable to open file for reading: " + filename);
+        }
+#ifdef POSIX_FADV_SEQUENTIAL
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        return fd;
+    }
+
+    size_t rows_in(size_t c) const { return std::min(chunk_rows_, shape_[0] - c * chunk_rows_); }
+
+    // Reads whole padded chunks, which keeps offset, length and buffer aligned for O_DIRECT.
+    void read_chunk(size_t c, char* buffer) const {
+        const uint64_t offset = tensor_stream_detail::kDataOffset + c * stride_;
+        const size_t needed = rows_in(c) * row_elems_ * sizeof(T);
+        size_t done = 0;
+        while (done < needed) {
+            const ssize_t n = ::pread(fd_, buffer + done, stride_ - done, offset + done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                throw std::runtime_error(n == 0 ? "Truncated chunked tensor file" : std::strerror(errno));
+            }
+            done += static_cast<size_t>(n);
+        }
+    }
+
+    void read_ahead() {
+        for (size_t c = 0; c < chunk_count_; ++c) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || ready_.size() < prefetch_; });
+                if (stop_) {
+                    return;
+                }
+            }
+            char* buffer = nullptr;
+            try {
+                buffer = pool_->acquire();
+                read_chunk(c, buffer);
+            } catch (...) {
+                if (buffer) {
+                    pool_->release(buffer);
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                error_ = std::current_exception();
+                cv_.notify_all();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ready_.push_back(buffer);
+            }
+            cv_.notify_all();
+        }
+    }
+
+    int fd_ = -1;
+    std::array<size_t, Dim> shape_{};
+    size_t row_elems_ = 0;
+    size_t chunk_rows_ = 0;
+    size_t chunk_count_ = 0;
+    uint64_t stride_ = 0;
+    size_t prefetch_;
+    size_t consumed_ = 0;
+    std::shared_ptr<tensor_stream_detail::BufferPool> pool_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<char*> ready_;
+    bool stop_ = false;
+    std::exception_ptr error_;
+    std::thread thread_;
+};
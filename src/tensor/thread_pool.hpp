@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+// Process-wide pool of persistent worker threads used by the parallel tensor kernels.
+//
+// A parallel_for call splits [begin, end) into chunks of at least `grain` elements, and the chunks into
+// one contiguous block per thread: the calling thread owns the first block and worker i block i + 1.
+// Each thread works through its own block, then helps with the others, pulling chunks from per-block
+// counters until none are left, so no thread is created or joined per call. Once the threads are
+// pinned (pin_threads), a thread therefore keeps touching the same part of a range call after call,
+// which is what makes first-touch NUMA placement (numa_placement.hpp) pay off. Calls made from inside a running
+// chunk are executed inline.
+class ThreadPool {
+public:
+    static constexpr size_t DEFAULT_GRAIN = 1000;
+    // parallel_reduce splits a range into at most this many chunks (fewer if `grain` is larger).
+    static constexpr size_t MAX_REDUCE_CHUNKS = 256;
+
+    static ThreadPool& instance() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // Worker threads plus the calling thread.
+    size_t num_threads() const { return workers_.size() + 1; }
+
+    // Pins the calling thread to cpus[0] and worker i to cpus[(i + 1) % cpus.size()], so block t of every
+    // range is processed on cpus[t]. List the CPUs of one NUMA node together (NumaTopology::cpu_order)
+    // to keep neighbouring blocks on one node. Returns false if some thread could not be pinned.
+    //
+    // Block 0 runs on whichever thread submits the range, not on a pool thread, so the mapping only
+    // holds for ranges submitted by the thread that called pin_threads. Submit parallel work from that
+    // thread, and undo the pin with unpin_threads() when done.
+    bool pin_threads(const std::vector<int>& cpus) {
+        if (cpus.empty()) {
+            return false;
+        }
+        if (saved_affinity_.empty()) {
+            saved_affinity_.resize(num_threads());
+            pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &saved_affinity_[0]);
+            for (size_t i = 0; i < workers_.size(); ++i) {
+                pthread_getaffinity_np(workers_[i].native_handle(), sizeof(cpu_set_t), &saved_affinity_[i + 1]);
+            }
+            pinned_caller_ = pthread_self();
+        }
+        bool ok = pin(pthread_self(), cpus[0]);
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            ok = pin(workers_[i].native_handle(), cpus[(i + 1) % cpus.size()]) && ok;
+        }
+        return ok;
+    }
+
+    // Gives every thread back the affinity it had before the first pin_threads(). Must be called from
+    // the thread that called pin_threads; returns false and changes nothing from any other thread or if
+    // the pool is not pinned.
+    bool unpin_threads() {
+        if (saved_affinity_.empty() || !pthread_equal(pthread_self(), pinned_caller_)) {
+            return false;
+        }
+        bool ok = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &saved_affinity_[0]) == 0;
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            ok = pthread_setaffinity_np(workers_[i].native_handle(), sizeof(cpu_set_t),
+                                        &saved_affinity_[i + 1]) == 0 && ok;
+        }
+        saved_affinity_.clear();
+        return ok;
+    }
+
+    // Invokes fn(chunk_begin, chunk_end) over disjoint chunks covering [begin, end).
+    template<typename F>
+    void parallel_for(size_t begin, size_t end, size_t grain, F&& fn) {
+        if (end <= begin) {
+            return;
+        }
+        const size_t chunk = chunk_size(end - begin, grain);
+        const size_t num_chunks = (end - begin + chunk - 1) / chunk;
+        if (num_chunks == 1 || in_parallel_region()) {
+            fn(begin, end);
+            return;
+        }
+
+        auto body = [&](size_t c) {
+            const size_t start = begin + c * chunk;
+            fn(start, std::min(start + chunk, end));
+        };
+        run(ChunkFn(body), num_chunks);
+    }
+
+    // Reduces map(chunk_begin, chunk_end) over the chunks of [begin, end) with `reduce`.
+    // The chunk boundaries depend only on the range and `grain` (see reduce_chunk_size), and partial
+    // results are combined in chunk order, so the result does not depend on the number of threads or
+    // on scheduling.
+    template<typename T, typename Map, typename Reduce>
+    T parallel_reduce(size_t begin, size_t end, size_t grain, T init, Map&& map, Reduce&& reduce) {
+        if (end <= begin) {
+            return init;
+        }
+        const size_t chunk = reduce_chunk_size(end - begin, grain);
+        const size_t num_chunks = (end - begin + chunk - 1) / chunk;
+
+        std::vector<T> partials(num_chunks, init);
+        parallel_for(0, num_chunks, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                const size_t start = begin + c * chunk;
+                partials[c] = map(start, std::min(start + chunk, end));
+            }
+        });
+
+        T result = init;
+        for (const T& p : partials) {
+            result = reduce(result, p);
+        }
+        return result;
+    }
+
+    // Length of the chunks parallel_reduce splits a range of `range` elements into: at least `grain`,
+    // and long enough that there are at most MAX_REDUCE_CHUNKS of them.
+    static size_t reduce_chunk_size(size_t range, size_t grain) {
+        const size_t per_chunk = (range + MAX_REDUCE_CHUNKS - 1) / MAX_REDUCE_CHUNKS;
+        return std::max<size_t>({grain, per_chunk, 1});
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_cv_.notify_all();
+        for (auto& w : workers_) {
+            w.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+    // Non-owning reference to the callable that runs one chunk: the object and a trampoline that calls
+    // it. Unlike std::function it never allocates; the callable lives on the caller's stack until run()
+    // returns.
+    class ChunkFn {
+    public:
+        template<typename F>
+        explicit ChunkFn(F& fn) : obj_(static_cast<void*>(std::addressof(fn))), call_(&invoke<F>) {}
+
+        void operator()(size_t c) const { call_(obj_, c); }
+
+    private:
+        template<typename F>
+        static void invoke(void* obj, size_t c) { (*static_cast<F*>(obj))(c); }
+
+        void* obj_;
+        void (*call_)(void*, size_t);
+    };
+
+    // The chunks [next, end) of one thread's block; padded so threads do not share counters.
+    struct alignas(64) Block {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+
+    ThreadPool() {
+        const size_t hc = std::max<size_t>(1, std::thread::hardware_concurrency());
+        blocks_.reset(new Block[hc]);
+        for (size_t i = 0; i + 1 < hc; ++i) {
+            workers_.emplace_back([this, i]() { worker_loop(i + 1); });
+        }
+    }
+
+    static bool pin(pthread_t thread, int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+    }
+
+    // Chunks are at least `grain` long, and no smaller than needed to give every thread a few of them.
+    size_t chunk_size(size_t range, size_t grain) const {
+        const size_t per_thread = (range + num_threads() * 4 - 1) / (num_threads() * 4);
+        return std::max<size_t>({grain, per_thread, 1});
+    }
+
+    static bool& in_parallel_region() {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    void run(const ChunkFn& body, size_t num_chunks) {
+        std::lock_guard<std::mutex> submit_lock(submit_mutex_);
+        {
+            // A worker that woke up late for the previous job may still be scanning its counter.
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_cv_.wait(lock, [this]() { return active_ == 0; });
+            body_ = &body;
+            const size_t n = num_threads();
+            for (size_t t = 0; t < n; ++t) {
+                blocks_[t].next.store(t * num_chunks / n, std::memory_order_relaxed);
+                blocks_[t].end = (t + 1) * num_chunks / n;
+            }
+            ++generation_;
+        }
+        wake_cv_.notify_all();
+
+        run_chunks(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this]() { return active_ == 0; });
+        body_ = nullptr;
+        if (error_) {
+            std::exception_ptr error = nullptr;
+            std::swap(error, error_);
+            lock.unlock();
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Runs the chunks of block `self`, then whatever is left of the following blocks.
+    void run_chunks(size_t self) {
+        in_parallel_region() = true;
+        const size_t n = num_threads();
+        for (size_t k = 0; k < n; ++k) {
+            Block& block = blocks_[(self + k) % n];
+            while (block.next.load(std::memory_order_relaxed) < block.end) {
+                const size_t c = block.next.fetch_add(1);
+                if (c >= block.end) {
+                    break;
+                }
+                try {
+                    (*body_)(c);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!error_) {
+                        error_ = std::current_exception();
+                    }
+                }
+            }
+        }
+        in_parallel_region() = false;
+    }
+
+    void worker_loop(size_t index) {
+        size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_cv_.wait(lock, [&]() { return stop_ || generation_ != seen; });
+                if (stop_) {
+                    return;
+                }
+                seen = generation_;
+                ++active_;
+            }
+            run_chunks(index);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--active_ == 0) {
+                    done_cv_.notify_all();
+                }
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex submit_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    const ChunkFn* body_ = nullptr;
+    std::unique_ptr<Block[]> blocks_;
+    size_t generation_ = 0;
+    size_t active_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+    std::vector<cpu_set_t> saved_affinity_;  // before pin_threads: the caller's, then each worker's
+    pthread_t pinned_caller_{};
+};
+
+template<typename F>
+void parallel_for(size_t begin, size_t end, F&& fn, size_t grain = ThreadPool::DEFAULT_GRAIN) {
+    ThreadPool::instance().parallel_for(begin, end, grain, std::forward<F>(fn));
+}
+
+template<typename T, typename Map, typename Reduce>
+T parallel_reduce(size_t begin, size_t end, T init, Map&& map, Reduce&& reduce,
+                  size_t grain = ThreadPool::DEFAULT_GRAIN) {
+    return ThreadPool::instance().parallel_reduce(begin, end, grain, init,
+                                                  std::forward<Map>(map), std::forward<Reduce>(reduce));
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <data/facilities/allocators.h>
+
+using CpuAllocator = Allocator<DeviceTags::CPU>;
+
+// Every test starts from an empty cache on the calling thread and in the depot.
+class AllocatorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        CpuAllocator::SetHighWaterMark(size_t(-1));
+        CpuAllocator::Trim(0);
+    }
+    void TearDown() override {
+        CpuAllocator::SetHighWaterMark(size_t(-1));
+        CpuAllocator::Trim(0);
+    }
+};
+
+static size_t in_use() {
+    return CpuAllocator::Statistics().bytesInUse;
+}
+
+TEST_F(AllocatorTest, BlocksAre64ByteAligned) {
+    std::vector<std::shared_ptr<char>> blocks;
+    for (size_t bytes : {1, 7, 63, 64, 65, 200, 257, 1000, 4097, 70000, 262144, 262145, 3000000}) {
+        blocks.push_back(CpuAllocator::Allocate<char>(bytes));
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(blocks.back().get()) % 64, 0u) << bytes << " bytes";
+        // The whole requested size is writable.
+        std::memset(blocks.back().get(), 0xab, bytes);
+    }
+    EXPECT_EQ(CpuAllocator::Allocate<float>(0), nullptr);
+}
+
+TEST_F(AllocatorTest, SizesAreRoundedToTheirClass) {
+    // {requested, block} in bytes: multiples of 64 up to 256, then four classes per power of two up
+    // to 256KB, then multiples of 4KB.
+    const size_t cases[][2] = {{1, 64}, {64, 64}, {65, 128}, {256, 256}, {257, 320}, {320, 320},
+                               {321, 384}, {449, 512}, {513, 640}, {1000, 1024}, {100000, 114688},
+                               {262144, 262144}, {262145, 266240}, {1000000, 1003520}};
+    for (const auto& c : cases) {
+        const size_t before = in_use();
+        auto block = CpuAllocator::Allocate<char>(c[0]);
+        EXPECT_EQ(in_use() - before, c[1]) << c[0] << " bytes";
+        block.reset();
+        EXPECT_EQ(in_use(), before) << c[0] << " bytes";
+    }
+
+    // The size is in elements.
+    const size_t before = in_use();
+    auto block = CpuAllocator::Allocate<double>(40);
+    EXPECT_EQ(in_use() - before, 320u);
+}
+
+TEST_F(AllocatorTest, FreedBlocksAreReused) {
+    const size_t before = CpuAllocator::Statistics().systemAllocations;
+    void* first = CpuAllocator::Allocate<float>(1000).get();
+    for (int i = 0; i < 100; ++i) {
+        auto block = CpuAllocator::Allocate<float>(1000);
+        EXPECT_EQ(block.get(), first);
+    }
+    EXPECT_EQ(CpuAllocator::Statistics().systemAllocations - before, 1u);
+}
+
+TEST_F(AllocatorTest, BlockFreedOnAnotherThread) {
+    const AllocatorStatistics start = CpuAllocator::Statistics();
+    auto block = CpuAllocator::Allocate<char>(3000);
+    void* raw = block.get();
+    const size_t blockBytes = in_use() - start.bytesInUse;
+
+    // The block joins the freeing thread's cache, which goes back to the depot when that thread exits.
+    std::thread([b = std::move(block)]() mutable { b.reset(); }).join();
+    EXPECT_EQ(block, nullptr);
+
+    const AllocatorStatistics freed = CpuAllocator::Statistics();
+    EXPECT_EQ(freed.bytesInUse, start.bytesInUse);
+    EXPECT_EQ(freed.bytesCached, start.bytesCached + blockBytes);
+
+    // ...from where this thread can take it again without a new system allocation.
+    auto again = CpuAllocator::Allocate<char>(3000);
+    EXPECT_EQ(again.get(), raw);
+    EXPECT_EQ(CpuAllocator::Statistics().systemAllocations, freed.systemAllocations);
+}
+
+TEST_F(AllocatorTest, ManyThreadsAllocateAndFreeEachOthersBlocks) {
+    constexpr size_t kThreads = 4;
+    constexpr size_t kBlocks = 500;
+    std::vector<std::vector<std::shared_ptr<int>>> blocks(kThreads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&blocks, t]() {
+            for (size_t i = 0; i < kBlocks; ++i) {
+                auto b = CpuAllocator::Allocate<int>(1 + (i * 37 + t) % 3000);
+                b.get()[0] = static_cast<int>(t * kBlocks + i);
+                blocks[t].push_back(std::move(b));
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    threads.clear();
+
+    // Every thread frees the blocks of the next one.
+    for (size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&blocks, t]() {
+            auto& mine = blocks[(t + 1) % kThreads];
+            for (size_t i = 0; i < mine.size(); ++i) {
+                EXPECT_EQ(mine[i].get()[0], static_cast<int>(((t + 1) % kThreads) * kBlocks + i));
+                mine[i].reset();
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    const AllocatorStatistics stats = CpuAllocator::Statistics();
+    EXPECT_EQ(stats.bytesInUse, 0u);
+    EXPECT_EQ(stats.bytesReserved, stats.bytesCached);
+}
+
+TEST_F(AllocatorTest, TrimAndHighWaterMarkRelease) {
+    constexpr size_t kBlockBytes = size_t(1) << 20;
+    std::vector<std::shared_ptr<char>> blocks;
+    for (int i = 0; i < 16; ++i) {
+        blocks.push_back(CpuAllocator::Allocate<char>(kBlockBytes));
+    }
+    blocks.clear();
+    EXPECT_EQ(CpuAllocator::Statistics().bytesCached, 16 * kBlockBytes);
+
+    // Setting the mark trims right away...
+    CpuAllocator::SetHighWaterMark(4 * kBlockBytes);
+    AllocatorStatistics stats = CpuAllocator::Statistics();
+    EXPECT_EQ(stats.bytesCached, 4 * kBlockBytes);
+    EXPECT_EQ(stats.bytesReserved, 4 * kBlockBytes);
+
+    // ...and whenever freed blocks push the depot past it.
+    for (int i = 0; i < 10; ++i) {
+        blocks.push_back(CpuAllocator::Allocate<char>(kBlockBytes));
+    }
+    blocks.clear();
+    EXPECT_LE(CpuAllocator::Statistics().bytesCached, 4 * kBlockBytes);
+
+    // Small blocks cached by this thread are flushed and released by Trim() as well.
+    auto small = CpuAllocator::Allocate<char>(500);
+    small.reset();
+    CpuAllocator::SetHighWaterMark(size_t(-1));
+    const size_t cached = CpuAllocator::Statistics().bytesCached;
+    EXPECT_GT(cached, 0u);
+    const size_t released = CpuAllocator::Trim(kBlockBytes);
+    const size_t left = CpuAllocator::Statistics().bytesCached;
+    EXPECT_LE(left, kBlockBytes);
+    EXPECT_EQ(released, cached - left);
+    EXPECT_EQ(CpuAllocator::Trim(0), left);
+
+    stats = CpuAllocator::Statistics();
+    EXPECT_EQ(stats.bytesCached, 0u);
+    EXPECT_EQ(stats.bytesReserved, 0u);
+    EXPECT_GE(stats.peakBytesReserved, 16 * kBlockBytes);
+}
+
+TEST_F(AllocatorTest, StatisticsStayConsistent) {
+    const AllocatorStatistics start = CpuAllocator::Statistics();
+    std::vector<std::shared_ptr<float>> live;
+    for (size_t i = 0; i < 200; ++i) {
+        auto block = CpuAllocator::Allocate<float>(1 + i * 13);
+        if (i % 3 == 0) live.push_back(std::move(block));
+
+        const AllocatorStatistics s = CpuAllocator::Statistics();
+        ASSERT_EQ(s.bytesReserved, s.bytesInUse + s.bytesCached);
+        ASSERT_GE(s.peakBytesReserved, s.bytesReserved);
+        ASSERT_LE(s.cacheHits, s.allocations);
+    }
+
+    const AllocatorStatistics end = CpuAllocator::Statistics();
+    EXPECT_EQ(end.allocations - start.allocations, 200u);
+    EXPECT_LE(end.systemAllocations - start.systemAllocations, 200u);
+    EXPECT_GT(end.cacheHits, start.cacheHits);
+
+    live.clear();
+    EXPECT_EQ(CpuAllocator::Statistics().bytesInUse, start.bytesInUse);
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/tensor/checkpoint.hpp"
+#include "tensor_test_util.h"
+
+TEST(CheckpointTest, WritesTheContentsAtSaveTime) {
+    TempFile file("checkpoint_test_snapshot.tnsr");
+    auto w = iota_matrix(64, 64);
+    Tensor<float, 1> bias(std::array<size_t, 1>{3}, std::vector<float>{1, 2, 3});
+    const float* before = std::as_const(w).data();
+
+    CheckpointWriter checkpoints;
+    TensorFileWriter snapshot;
+    snapshot.add("w", w);
+    snapshot.add("w.t", w.transpose());
+    snapshot.add("bias", bias);
+    EXPECT_EQ(std::as_const(w).data(), before);   // no copy until w is written
+    std::future<void> done = checkpoints.save(std::move(snapshot), file.path);
+
+    w.data()[0] = -1.0f;
+    w({{63, 63}}) = -2.0f;
+    bias({{0}}) = -3.0f;
+    done.get();
+    EXPECT_EQ(checkpoints.pending(), 0u);
+
+    TensorFile tensors(file.path);
+    auto w2 = tensors.get<float, 2>("w");
+    auto wt = tensors.get<float, 2>("w.t");
+    for (size_t i = 0; i < w2.size(); ++i) {
+        EXPECT_EQ(w2.data()[i], static_cast<float>(i));
+    }
+    EXPECT_EQ(wt({{5, 2}}), static_cast<float>(2 * 64 + 5));
+    EXPECT_EQ((tensors.get<float, 1>("bias")({{0}})), 1.0f);
+    EXPECT_EQ(w({{0, 0}}), -1.0f);
+}
+
+TEST(CheckpointTest, WritesInOrderAndDrainsOnDestruction) {
+    std::vector<TempFile> files;
+    files.reserve(6);
+    for (int i = 0; i < 6; ++i) {
+        files.emplace_back("checkpoint_test_step" + std::to_string(i) + ".tnsr");
+    }
+    auto w = iota_matrix(128, 128);
+    std::vector<std::future<void>> done;
+    {
+        CheckpointWriter checkpoints(1);
+        for (int i = 0; i < 6; ++i) {
+            done.push_back(checkpoints.save(w, files[i].path));
+            EXPECT_LE(checkpoints.pending(), 2u);
+            w.add_(1.0f);
+        }
+    }
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(done[i].wait_for(std::chrono::seconds(0)), std::future_status::ready);
+        done[i].get();
+        auto loaded = Tensor<float, 2>::load(files[i].path);
+        EXPECT_EQ(loaded({{1, 1}}), 129.0f + i);
+    }
+}
+
+TEST(CheckpointTest, ErrorsArriveThroughTheFuture) {
+    TempFile file("checkpoint_test_after_error.tnsr");
+    CheckpointWriter checkpoints;
+    auto failed = checkpoints.save(iota_matrix(4, 4), "no_such_directory/checkpoint.tnsr");
+    auto ok = checkpoints.save(iota_matrix(4, 4, 1.0f), file.path);
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    ok.get();
+    checkpoints.wait();
+    EXPECT_EQ(checkpoints.pending(), 0u);
+    EXPECT_EQ((Tensor<float, 2>::load(file.path)({{0, 0}})), 1.0f);
+}
+
+TEST(TensorIoTest, SyncedWriteReplacesTheFile) {
+    TempFile file("checkpoint_test_sync.tnsr");
+    TensorFileWriter first;
+    first.add("t", iota_matrix(2, 2));
+    first.write(file.path, true);
+    TensorFileWriter second;
+    second.add("t", iota_matrix(2, 2, 10.0f));
+    second.write(file.path, true);
+    EXPECT_FALSE(std::ifstream(file.path + ".tmp").good());
+    EXPECT_EQ((TensorFile(file.path).get<float, 2>("t")({{1, 1}})), 13.0f);
+}
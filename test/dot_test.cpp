@@ -0,0 +1,68 @@
+#include <type_traits>
+#include "metann_test_util.h"
+#include <data/matrics/quantized_matrix.h>
+#include <data/matrics/sparse_matrix.h>
+#include <operators/add.h>
+#include <operators/dot.h>
+#include <operators/element_mul.h>
+#include <operators/sigmoid.h>
+#include <operators/tanh.h>
+
+using CpuQuantizedMatrix = QuantizedMatrix<DeviceTags::CPU>;
+using CpuSparseMatrix = SparseMatrix<float, DeviceTags::CPU>;
+
+// Keeps every element of `m` whose row and column sum to a multiple of `every`.
+static CpuMatrix thin_out(const CpuMatrix& m, size_t every) {
+    CpuMatrix res(m.RowNum(), m.ColNum());
+    for (size_t i = 0; i < m.RowNum(); ++i) {
+        for (size_t j = 0; j < m.ColNum(); ++j) {
+            res.SetValue(i, j, (i + j) % every == 0 ? m(i, j) : 0.0f);
+        }
+    }
+    return res;
+}
+
+// Quantised and sparse matrices are read by Dot only: they are not IsMatrix, so element-wise operators reject them
+// at overload resolution instead of failing inside their evaluation units.
+static_assert(!IsMatrix<CpuQuantizedMatrix>, "a quantized matrix is not a dense matrix");
+static_assert(std::is_same<DataCategory<CpuQuantizedMatrix>, CategoryTags::Matrix>::value, "");
+static_assert(OperDot_<const CpuMatrix&, const CpuQuantizedMatrix&>::valid, "");
+static_assert(!OperDot_<const CpuQuantizedMatrix&, const CpuMatrix&>::valid, "");
+static_assert(!OperDot_<const CpuQuantizedMatrix&, const CpuQuantizedMatrix&>::valid, "");
+static_assert(!OperSigmoid_<const CpuQuantizedMatrix&>::valid, "");
+static_assert(!OperAdd_<const CpuMatrix&, const CpuQuantizedMatrix&>::valid, "");
+static_assert(!OperElementMul_<const CpuQuantizedMatrix&, const CpuMatrix&>::valid, "");
+
+static_assert(!IsMatrix<CpuSparseMatrix>, "a sparse matrix is not a dense matrix");
+static_assert(std::is_same<DataCategory<CpuSparseMatrix>, CategoryTags::Matrix>::value, "");
+static_assert(OperDot_<const CpuSparseMatrix&, const CpuMatrix&>::valid, "");
+static_assert(OperDot_<const CpuMatrix&, const CpuSparseMatrix&>::valid, "");
+static_assert(!OperDot_<const CpuSparseMatrix&, const CpuSparseMatrix&>::valid, "");
+static_assert(!OperDot_<const CpuSparseMatrix&, const CpuQuantizedMatrix&>::valid, "");
+static_assert(!OperSigmoid_<const CpuSparseMatrix&>::valid, "");
+static_assert(!OperTanh_<CpuSparseMatrix>::valid, "");
+static_assert(!OperAdd_<const CpuSparseMatrix&, const CpuMatrix&>::valid, "");
+static_assert(!OperElementMul_<const CpuMatrix&, const CpuSparseMatrix&>::valid, "");
+
+TEST(DotTest, QuantizedWeightsMatchFloatProduct) {
+    const auto x = make_matrix(9, 40, 1), w = make_matrix(40, 23, 2), b = make_matrix(9, 23, 3);
+    const CpuQuantizedMatrix q(w);
+    const CpuMatrix expected = Evaluate(Sigmoid(Dot(x, w) + b));
+
+    // The result of the int8 product is an ordinary matrix for the rest of the expression. x is
+    // quantised on the fly and w per column, so the product is only as close as the int8 steps allow.
+    const CpuMatrix res = Evaluate(Sigmoid(Dot(x, q) + b));
+    expect_matrix_eq(res, expected, 0.02f);
+}
+
+TEST(DotTest, SparseOperandsMatchDenseProduct) {
+    const auto x = thin_out(make_matrix(13, 40, 1), 3), w = thin_out(make_matrix(40, 29, 2), 4);
+    const auto b = make_matrix(13, 29, 3);
+    const CpuSparseMatrix sx(x), sw(w), bsw(w, 4, 4);
+
+    // The sparse kernels add the stored products in another order than the dense GEMM.
+    const CpuMatrix expected = Evaluate(Sigmoid(Dot(x, w) + b));
+    expect_matrix_eq(Evaluate(Sigmoid(Dot(sx, w) + b)), expected, 1e-5f);
+    expect_matrix_eq(Evaluate(Sigmoid(Dot(x, sw) + b)), expected, 1e-5f);
+    expect_matrix_eq(Evaluate(Sigmoid(Dot(x, bsw) + b)), expected, 1e-5f);
+}
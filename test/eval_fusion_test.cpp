@@ -0,0 +1,85 @@
+#include <stdexcept>
+#include "metann_test_util.h"
+#include <operators/add.h>
+#include <operators/dot.h>
+#include <operators/element_mul.h>
+#include <operators/sigmoid.h>
+#include <operators/substract.h>
+#include <operators/tanh.h>
+
+// Evaluates `make()` (which builds a fresh expression) with fusion off and on.
+template <typename TMake>
+static void expect_fusion_matches(TMake make) {
+    EvalPlan<DeviceTags::CPU>::SetFusion(false);
+    const auto unfused = Evaluate(make());
+    EvalPlan<DeviceTags::CPU>::SetFusion(true);
+    const auto fused = Evaluate(make());
+    EvalPlan<DeviceTags::CPU>::SetFusion(false);
+    expect_matrix_eq(fused, unfused);
+}
+
+class EvalFusionTest : public ::testing::Test {
+protected:
+    void TearDown() override { EvalPlan<DeviceTags::CPU>::SetFusion(false); }
+};
+
+TEST_F(EvalFusionTest, ArithmeticChainMatchesUnfused) {
+    // 300 columns: more than one tile per row, with a partial last tile.
+    auto a = make_matrix(17, 300, 1), b = make_matrix(17, 300, 2);
+    auto c = make_matrix(17, 300, 3), d = make_matrix(17, 300, 4);
+    expect_fusion_matches([&]() { return (a + b) * c - d; });
+    expect_fusion_matches([&]() { return a - (b - c) * (a + d); });
+}
+
+TEST_F(EvalFusionTest, ActivationChainsMatchUnfused) {
+    auto a = make_matrix(9, 40, 1), b = make_matrix(9, 40, 2), c = make_matrix(9, 40, 3);
+    expect_fusion_matches([&]() { return Tanh(Sigmoid(a + b) * c); });
+
+    auto x = make_matrix(9, 32, 4), w = make_matrix(32, 40, 5);
+    expect_fusion_matches([&]() { return Sigmoid(Dot(x, w) + b); });
+}
+
+TEST_F(EvalFusionTest, HeldIntermediatesAreMaterialized) {
+    auto a = make_matrix(6, 50, 1), b = make_matrix(6, 50, 2), c = make_matrix(6, 50, 3);
+    const CpuMatrix sum = Evaluate(a + b);
+    const CpuMatrix prod = Evaluate(sum * c);
+    const CpuMatrix res = Evaluate(Sigmoid(prod));
+
+    for (bool fuse : {false, true}) {
+        EvalPlan<DeviceTags::CPU>::SetFusion(fuse);
+        // The caller registers the intermediates itself and keeps only their handles: the operators
+        // that produce them are gone by the time the plan is evaluated.
+        auto hold = [&]() {
+            auto s = a + b;
+            auto p = s * c;
+            auto hs = s.EvalRegister();
+            auto hp = p.EvalRegister();
+            auto hr = Sigmoid(p).EvalRegister();
+            return std::make_tuple(hs, hp, hr);
+        };
+        auto [hs, hp, hr] = hold();
+        EvalPlan<DeviceTags::CPU>::Eval();
+
+        expect_matrix_eq(hs.Data(), sum);
+        expect_matrix_eq(hp.Data(), prod);
+        expect_matrix_eq(hr.Data(), res);
+    }
+}
+
+TEST_F(EvalFusionTest, UnheldIntermediatesAreNotMaterialized) {
+    auto a = make_matrix(6, 50, 1), b = make_matrix(6, 50, 2);
+    auto s = a + b;
+
+    EvalPlan<DeviceTags::CPU>::SetFusion(true);
+    const CpuMatrix fused = Evaluate(Sigmoid(s));
+
+    // Nothing but Sigmoid asked for `s`, so the fused pass kept it in a tile: asking for it now
+    // registers a new evaluation.
+    auto hs = s.EvalRegister();
+    EXPECT_THROW(hs.Data(), std::runtime_error);
+    EvalPlan<DeviceTags::CPU>::Eval();
+
+    EvalPlan<DeviceTags::CPU>::SetFusion(false);
+    expect_matrix_eq(hs.Data(), Evaluate(a + b));
+    expect_matrix_eq(fused, Evaluate(Sigmoid(a + b)));
+}
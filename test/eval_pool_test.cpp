@@ -0,0 +1,157 @@
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "metann_test_util.h"
+#include <operators/add.h>
+#include <operators/dot.h>
+#include <operators/sigmoid.h>
+
+// A unit with no operands that runs `m_fn` when evaluated. Every unit needs its own output pointer,
+// otherwise EvalPlan drops it as a duplicate registration.
+template <typename TFn>
+struct FnUnit : public BaseEvalUnit<DeviceTags::CPU> {
+    explicit FnUnit(TFn fn) : m_fn(std::move(fn)) {}
+    void Eval() override { m_fn(); }
+    TFn m_fn;
+};
+
+template <typename TFn>
+static void register_fn(const void* out, TFn fn) {
+    using UnitType = FnUnit<TFn>;
+    EvalPlan<DeviceTags::CPU>::Register<TrivalEvalGroup<UnitType>>(UnitType(std::move(fn)), out, {});
+}
+
+class EvalPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override { EvalPlan<DeviceTags::CPU>::SetEvalPool(EvalPoolEnum::WorkStealing); }
+    void TearDown() override { EvalPlan<DeviceTags::CPU>::SetEvalPool(EvalPoolEnum::Trival); }
+};
+
+TEST_F(EvalPoolTest, IndependentUnitsAllRun) {
+    constexpr size_t kUnits = 256;
+    std::vector<std::atomic<int>> runs(kUnits);
+    for (size_t i = 0; i < kUnits; ++i) {
+        register_fn(&runs[i], [&runs, i]() { runs[i].fetch_add(1); });
+    }
+    EvalPlan<DeviceTags::CPU>::Eval();
+    for (size_t i = 0; i < kUnits; ++i) {
+        EXPECT_EQ(runs[i].load(), 1) << "unit " << i;
+    }
+}
+
+TEST_F(EvalPoolTest, MatchesTrivalPool) {
+    std::vector<CpuMatrix> x, w, b;
+    for (size_t i = 0; i < 8; ++i) {
+        x.push_back(make_matrix(16, 32, i));
+        w.push_back(make_matrix(32, 24, i + 1));
+        b.push_back(make_matrix(16, 24, i + 2));
+    }
+
+    auto evaluate_all = [&]() {
+        // All handles are registered before Eval(), so the eight chains share each cluster.
+        std::vector<decltype(Sigmoid(Dot(x[0], w[0]) + b[0]).EvalRegister())> handles;
+        for (size_t i = 0; i < x.size(); ++i) {
+            handles.push_back(Sigmoid(Dot(x[i], w[i]) + b[i]).EvalRegister());
+        }
+        EvalPlan<DeviceTags::CPU>::Eval();
+        std::vector<CpuMatrix> res;
+        for (auto& h : handles) res.push_back(h.Data());
+        return res;
+    };
+
+    auto parallel = evaluate_all();
+    EvalPlan<DeviceTags::CPU>::SetEvalPool(EvalPoolEnum::Trival);
+    auto serial = evaluate_all();
+    for (size_t i = 0; i < serial.size(); ++i) {
+        expect_matrix_eq(parallel[i], serial[i]);
+    }
+}
+
+TEST_F(EvalPoolTest, ExceptionIsRethrownOnceByBarrier) {
+    std::vector<std::atomic<int>> runs(16);
+    for (size_t i = 0; i < runs.size(); ++i) {
+        register_fn(&runs[i], [&runs, i]() {
+            runs[i].fetch_add(1);
+            if (i == 5) throw std::runtime_error("unit failed");
+        });
+    }
+    EXPECT_THROW(EvalPlan<DeviceTags::CPU>::Eval(), std::runtime_error);
+    // The barrier still waits for the other units of the cluster.
+    for (size_t i = 0; i < runs.size(); ++i) {
+        EXPECT_EQ(runs[i].load(), 1) << "unit " << i;
+    }
+
+    // The error is consumed: the next evaluation succeeds.
+    auto a = make_matrix(4, 4, 1), b = make_matrix(4, 4, 2);
+    EXPECT_NO_THROW(Evaluate(a + b));
+}
+
+TEST_F(EvalPoolTest, NestedEvaluationRunsInline) {
+    auto a = make_matrix(8, 8, 1), b = make_matrix(8, 8, 2);
+    const CpuMatrix expected = Evaluate(a + b);
+
+    constexpr size_t kUnits = 32;
+    std::vector<CpuMatrix> results(kUnits);
+    for (size_t i = 0; i < kUnits; ++i) {
+        // Units run on the workers and on the thread in Barrier(); each evaluates its own plan.
+        register_fn(&results[i], [&, i]() { results[i] = Evaluate(Sigmoid(a + b)); });
+    }
+    EvalPlan<DeviceTags::CPU>::Eval();
+
+    const CpuMatrix sig = Evaluate(Sigmoid(expected));
+    for (auto& r : results) {
+        expect_matrix_eq(r, sig);
+    }
+}
+
+TEST_F(EvalPoolTest, ConcurrentPlansKeepTheirOwnBarriers) {
+    constexpr int kRounds = 200;
+    std::atomic<int> failing_throws{0};
+    std::atomic<int> clean_throws{0};
+    std::atomic<bool> clean_done{false};
+    std::atomic<int> slow_running{0};
+
+    // One thread's plan always fails and contains slow units; the other's never fails. Neither
+    // barrier may observe the other plan's exception or wait for its units.
+    std::thread failing([&]() {
+        int dummy[2];
+        for (int r = 0; r < kRounds && !clean_done.load(); ++r) {
+            register_fn(&dummy[0], [&]() {
+                slow_running.fetch_add(1);
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                slow_running.fetch_sub(1);
+            });
+            register_fn(&dummy[1], []() { throw std::runtime_error("failing plan"); });
+            try {
+                EvalPlan<DeviceTags::CPU>::Eval();
+            } catch (const std::runtime_error&) {
+                failing_throws.fetch_add(1);
+            }
+        }
+    });
+
+    std::thread clean([&]() {
+        auto a = make_matrix(16, 16, 3), b = make_matrix(16, 16, 4);
+        const CpuMatrix expected = Evaluate(a + b);
+        for (int r = 0; r < kRounds; ++r) {
+            int runs[4] = {0, 0, 0, 0};
+            for (auto& x : runs) register_fn(&x, [&x]() { ++x; });
+            try {
+                EvalPlan<DeviceTags::CPU>::Eval();
+                for (int x : runs) EXPECT_EQ(x, 1);
+                expect_matrix_eq(Evaluate(a + b), expected);
+            } catch (...) {
+                clean_throws.fetch_add(1);
+            }
+        }
+        clean_done = true;
+    });
+
+    clean.join();
+    failing.join();
+    EXPECT_EQ(clean_throws.load(), 0);
+    EXPECT_GT(failing_throws.load(), 0);
+    EXPECT_EQ(slow_running.load(), 0);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <type_traits>
+#include "../src/tensor/fixed_tensor.hpp"
+
+template<typename T, size_t M, size_t N>
+static FixedTensor<T, M, N> iota_fixed(T start = T(1)) {
+    FixedTensor<T, M, N> m;
+    for (size_t i = 0; i < m.size(); ++i) {
+        m[i] = start + static_cast<T>(i);
+    }
+    return m;
+}
+
+TEST(FixedTensorTest, IsAPlainValue) {
+    static_assert(sizeof(FixedTensor<float, 3, 3>) == 9 * sizeof(float), "no storage beyond the elements");
+    static_assert(std::is_trivially_copyable<FixedTensor<double, 4, 4>>::value, "copies are memcpy");
+    static_assert(FixedTensor<float, 2, 3, 4>::strides()[0] == 12, "row-major");
+
+    FixedTensor<float, 2, 2> a({1, 2, 3, 4});
+    FixedTensor<float, 2, 2> b = a;
+    b({{0, 1}}) = 7;
+    EXPECT_EQ(a({{0, 1}}), 2.0f);
+    EXPECT_EQ(b[1], 7.0f);
+    const FixedTensor<int, 3> zeros, fours = FixedTensor<int, 3>::filled(4);
+    EXPECT_EQ(zeros[2], 0);
+    EXPECT_EQ(fours[2], 4);
+}
+
+TEST(FixedTensorTest, MatmulMatchesTensor) {
+    const auto a = iota_fixed<double, 3, 5>();
+    const auto b = iota_fixed<double, 5, 4>(-6.0);
+    const FixedTensor<double, 3, 4> c = a.matmul(b);
+    const Tensor<double, 2> expected = a.to_tensor().matmul(b.to_tensor());
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+            EXPECT_EQ(c({{i, j}}), expected({{i, j}}));
+        }
+    }
+
+    const auto m = iota_fixed<float, 16, 16>(0.5f);
+    const auto id = FixedTensor<float, 16, 16>::identity();
+    const auto mm = m.matmul(id);
+    for (size_t i = 0; i < m.size(); ++i) {
+        EXPECT_EQ(mm[i], m[i]);
+    }
+
+    FixedTensor<float, 3> v({1, 0, -1});
+    const auto rotated = iota_fixed<float, 3, 3>().matmul(v);
+    EXPECT_EQ(rotated[0], 1.0f - 3.0f);
+    EXPECT_EQ(rotated[2], 7.0f - 9.0f);
+}
+
+TEST(FixedTensorTest, TransposeAndElementwise) {
+    const auto a = iota_fixed<int, 2, 3>();
+    const FixedTensor<int, 3, 2> t = a.transpose();
+    EXPECT_EQ(t({{2, 1}}), a({{1, 2}}));
+    EXPECT_EQ(t({{0, 1}}), 4);
+
+    auto b = iota_fixed<int, 2, 3>(10);
+    EXPECT_EQ((a + b)({{1, 1}}), 5 + 14);
+    EXPECT_EQ((b - a)[0], 9);
+    EXPECT_EQ((a * b)[5], 6 * 15);
+    EXPECT_EQ((b / a)[1], 11 / 2);
+    EXPECT_EQ((2 * a)[4], 10);
+    b *= 3;
+    b -= a;
+    EXPECT_EQ(b[2], 36 - 3);
+}
+
+TEST(FixedTensorTest, ConvertsToAndFromTensor) {
+    Tensor<float, 2> t(std::array<size_t, 2>{3, 2}, {1, 2, 3, 4, 5, 6});
+    const FixedTensor<float, 2, 3> ft(t.transpose());
+    EXPECT_EQ(ft({{1, 2}}), 6.0f);
+    EXPECT_EQ(ft({{0, 1}}), 3.0f);
+
+    const Tensor<float, 2> back = ft.to_tensor();
+    EXPECT_EQ(back.shape(), (std::array<size_t, 2>{2, 3}));
+    EXPECT_TRUE(back.is_contiguous());
+    EXPECT_EQ(back({{1, 0}}), 2.0f);
+
+    EXPECT_THROW((FixedTensor<float, 3, 2>(t.transpose())), std::invalid_argument);
+}
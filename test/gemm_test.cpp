@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "../src/tensor/tensor.hpp"
+
+template <typename T>
+static std::vector<T> reference_matmul(size_t m, size_t n, size_t k, const std::vector<T>& a, const std::vector<T>& b) {
+    std::vector<T> c(m * n, T(0));
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t p = 0; p < k; ++p) {
+            for (size_t j = 0; j < n; ++j) {
+                c[i * n + j] += a[i * k + p] * b[p * n + j];
+            }
+        }
+    }
+    return c;
+}
+
+template <typename T>
+static std::vector<T> random_vector(size_t size, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<T> v(size);
+    for (auto& x : v) {
+        x = static_cast<T>(dist(gen));
+    }
+    return v;
+}
+
+TEST(GemmTest, FloatOddShapes) {
+    const size_t shapes[][3] = {{1, 1, 1}, {7, 5, 3}, {6, 16, 256}, {37, 53, 29}, {150, 70, 300}, {13, 4100, 9}};
+    for (const auto& s : shapes) {
+        const size_t m = s[0], n = s[1], k = s[2];
+        auto a = random_vector<float>(m * k, 1);
+        auto b = random_vector<float>(k * n, 2);
+        std::vector<float> c(m * n, 42.0f);
+        gemm(m, n, k, a.data(), k, b.data(), n, c.data(), n);
+        auto expected = reference_matmul(m, n, k, a, b);
+        for (size_t i = 0; i < m * n; ++i) {
+            ASSERT_NEAR(c[i], expected[i], 1e-4f * k) << "m=" << m << " n=" << n << " k=" << k << " i=" << i;
+        }
+    }
+}
+
+// Every level up to the detected one.
+static std::vector<SimdLevel> levels() {
+    std::vector<SimdLevel> res;
+    for (int l = 0; l <= static_cast<int>(detected_simd_level()); ++l) {
+        res.push_back(static_cast<SimdLevel>(l));
+    }
+    return res;
+}
+
+TEST(GemmTest, EveryKernelMatchesReference) {
+    const size_t m = 37, n = 53, k = 300;
+    auto af = random_vector<float>(m * k, 7), bf = random_vector<float>(k * n, 8);
+    auto ad = random_vector<double>(m * k, 9), bd = random_vector<double>(k * n, 10);
+    const auto expected_f = reference_matmul(m, n, k, af, bf);
+    const auto expected_d = reference_matmul(m, n, k, ad, bd);
+
+    for (SimdLevel level : levels()) {
+        const GemmKernel<float>& kf = gemm_kernel<float>(level);
+        const GemmKernel<double>& kd = gemm_kernel<double>(level);
+        EXPECT_LE(kf.level, level);
+        EXPECT_LE(kd.level, level);
+
+        std::vector<float> cf(m * n);
+        gemm(m, n, k, af.data(), k, 1, bf.data(), n, 1, cf.data(), n, kf);
+        for (size_t i = 0; i < m * n; ++i) {
+            ASSERT_NEAR(cf[i], expected_f[i], 1e-4f * k) << kf.name << " i=" << i;
+        }
+
+        std::vector<double> cd(m * n);
+        gemm(m, n, k, ad.data(), k, 1, bd.data(), n, 1, cd.data(), n, kd);
+        for (size_t i = 0; i < m * n; ++i) {
+            ASSERT_NEAR(cd[i], expected_d[i], 1e-10) << kd.name << " i=" << i;
+        }
+    }
+
+    // Without -mavx2 the AVX2 kernels are still chosen on a host that has them.
+    if (detected_simd_level() >= SimdLevel::AVX2) {
+        EXPECT_EQ(gemm_kernel<float>(SimdLevel::AVX2).level, SimdLevel::AVX2);
+        EXPECT_EQ(gemm_kernel<double>(SimdLevel::AVX2).level, SimdLevel::AVX2);
+    }
+}
+
+TEST(GemmTest, DoubleMatchesReference) {
+    const size_t m = 65, n = 33, k = 513;
+    auto a = random_vector<double>(m * k, 3);
+    auto b = random_vector<double>(k * n, 4);
+    std::vector<double> c(m * n);
+    gemm(m, n, k, a.data(), k, b.data(), n, c.data(), n);
+    auto expected = reference_matmul(m, n, k, a, b);
+    for (size_t i = 0; i < m * n; ++i) {
+        EXPECT_NEAR(c[i], expected[i], 1e-10);
+    }
+}
+
+TEST(GemmTest, IntUsesGenericKernel) {
+    const size_t m = 9, n = 11, k = 10;
+    std::vector<int> a(m * k), b(k * n);
+    for (size_t i = 0; i < a.size(); ++i) a[i] = static_cast<int>(i % 7) - 3;
+    for (size_t i = 0; i < b.size(); ++i) b[i] = static_cast<int>(i % 5) - 2;
+    std::vector<int> c(m * n);
+    gemm(m, n, k, a.data(), k, b.data(), n, c.data(), n);
+    EXPECT_EQ(c, reference_matmul(m, n, k, a, b));
+}
+
+TEST(GemmTest, StridedOperandAndPaddedOutput) {
+    const size_t m = 20, n = 18, k = 31, ldc = 24;
+    auto a = random_vector<float>(m * k, 5);
+    auto b = random_vector<float>(k * n, 6);
+    std::vector<float> bt(n * k);
+    for (size_t p = 0; p < k; ++p) {
+        for (size_t j = 0; j < n; ++j) {
+            bt[j * k + p] = b[p * n + j];
+        }
+    }
+    std::vector<float> c(m * ldc, -1.0f);
+    gemm(m, n, k, a.data(), k, 1, bt.data(), 1, k, c.data(), ldc);
+    auto expected = reference_matmul(m, n, k, a, b);
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            EXPECT_NEAR(c[i * ldc + j], expected[i * n + j], 1e-4f);
+        }
+        for (size_t j = n; j < ldc; ++j) {
+            EXPECT_EQ(c[i * ldc + j], -1.0f);
+        }
+    }
+}
+
+TEST(GemmTest, TensorMatmul) {
+    Tensor<float, 2> a({{2, 3}}, {1, 2, 3, 4, 5, 6});
+    Tensor<float, 2> b({{3, 2}}, {7, 8, 9, 10, 11, 12});
+    auto c = a.matmul(b);
+    ASSERT_EQ(c.shape()[0], 2);
+    ASSERT_EQ(c.shape()[1], 2);
+    EXPECT_FLOAT_EQ(c({{0, 0}}), 58);
+    EXPECT_FLOAT_EQ(c({{0, 1}}), 64);
+    EXPECT_FLOAT_EQ(c({{1, 0}}), 139);
+    EXPECT_FLOAT_EQ(c({{1, 1}}), 154);
+    EXPECT_THROW(a.matmul(a), std::invalid_argument);
+}
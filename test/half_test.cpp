@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include "../src/tensor/tensor_advanced.hpp"
+
+static uint32_t bits_of(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    return x;
+}
+
+static float float_of(uint32_t x) {
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+// Every level up to the detected one.
+static std::vector<SimdLevel> levels() {
+    std::vector<SimdLevel> res;
+    for (int l = 0; l <= static_cast<int>(detected_simd_level()); ++l) {
+        res.push_back(static_cast<SimdLevel>(l));
+    }
+    return res;
+}
+
+template <typename H>
+static std::vector<H> random_half_vector(size_t n, float lo, float hi, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(lo, hi);
+    std::vector<H> v(n);
+    for (auto& x : v) {
+        x = H(dist(gen));
+    }
+    return v;
+}
+
+TEST(HalfTest, Float16RoundsToNearestEven) {
+    EXPECT_EQ(float16(1.0f).bits, 0x3c00);
+    EXPECT_EQ(float16(-2.0f).bits, 0xc000);
+    EXPECT_EQ(float16(-0.0f).bits, 0x8000);
+    EXPECT_EQ(float16(65504.0f).bits, 0x7bff);
+    EXPECT_EQ(float16(65519.0f).bits, 0x7bff);
+    EXPECT_EQ(float16(65520.0f).bits, 0x7c00);  // the halfway point rounds to even, which is inf
+    EXPECT_EQ(float16(std::numeric_limits<float>::infinity()).bits, 0x7c00);
+    EXPECT_EQ(float16(1.0f + std::ldexp(1.0f, -11)).bits, 0x3c00);      // tie, down to even
+    EXPECT_EQ(float16(1.0f + 3 * std::ldexp(1.0f, -11)).bits, 0x3c02);  // tie, up to even
+    EXPECT_EQ(float16(std::ldexp(1.0f, -24)).bits, 0x0001);             // smallest subnormal
+    EXPECT_EQ(float16(std::ldexp(1.0f, -25)).bits, 0x0000);             // tie, down to zero
+    EXPECT_EQ(float16(std::ldexp(1.5f, -25)).bits, 0x0001);
+    EXPECT_EQ(float16(std::ldexp(1.0f, -14)).bits, 0x0400);             // smallest normal
+    EXPECT_TRUE(std::isnan(float(float16(std::numeric_limits<float>::quiet_NaN()))));
+    EXPECT_EQ(float(float16::from_bits(0x0001)), std::ldexp(1.0f, -24));
+    EXPECT_EQ(float(-float16(3.0f)), -3.0f);
+}
+
+TEST(HalfTest, BFloat16RoundsToNearestEven) {
+    EXPECT_EQ(bfloat16(1.0f).bits, 0x3f80);
+    EXPECT_EQ(bfloat16(1.0f + std::ldexp(1.0f, -8)).bits, 0x3f80);
+    EXPECT_EQ(bfloat16(1.0f + 3 * std::ldexp(1.0f, -8)).bits, 0x3f82);
+    EXPECT_EQ(bfloat16(std::numeric_limits<float>::max()).bits, 0x7f80);
+    EXPECT_EQ(bfloat16(std::numeric_limits<float>::denorm_min()).bits, 0x0000);
+    EXPECT_EQ(bfloat16(float_of(0x00018000)).bits, 0x0002);  // subnormals round like normals
+    EXPECT_TRUE(std::isnan(float(bfloat16(float_of(0x7f800001)))));  // no NaN is truncated to inf
+    EXPECT_EQ(float(bfloat16::from_bits(0x4049)), 3.140625f);
+}
+
+TEST(HalfTest, EveryFiniteValueRoundTrips) {
+    for (uint32_t b = 0; b < 0x10000; ++b) {
+        const float16 h = float16::from_bits(static_cast<uint16_t>(b));
+        const bfloat16 g = bfloat16::from_bits(static_cast<uint16_t>(b));
+        if (!std::isnan(float(h))) {
+            ASSERT_EQ(float16(float(h)).bits, b);
+        }
+        if (!std::isnan(float(g))) {
+            ASSERT_EQ(bfloat16(float(g)).bits, b);
+        }
+    }
+}
+
+// The vector converters must give the same bits as the scalar ones: all 2^16 inputs one way, and
+// random bit patterns (every exponent, NaNs included) plus every rounding boundary the other way.
+TEST(HalfTest, BulkConvertersMatchScalarAtEveryLevel) {
+    std::vector<float16> h(0x10000);
+    std::vector<bfloat16> g(0x10000);
+    for (uint32_t b = 0; b < 0x10000; ++b) {
+        h[b] = float16::from_bits(static_cast<uint16_t>(b));
+        g[b] = bfloat16::from_bits(static_cast<uint16_t>(b));
+    }
+    std::mt19937 gen(5);
+    std::vector<float> f(1 << 18);
+    for (size_t i = 0; i < f.size(); ++i) {
+        f[i] = float_of(i % 2 ? static_cast<uint32_t>(gen()) : static_cast<uint32_t>(gen() & 0x3fffffff) | 0x30000000);
+    }
+    for (uint32_t b = 0; b < 0x10000; ++b) {
+        f.push_back(float_of((b << 16) | 0x8000));  // bfloat16 ties
+        f.push_back(float_of((b << 13) | 0x1000));  // float16 ties, for the low exponents
+    }
+
+    for (SimdLevel level : levels()) {
+        const HalfConverters& cv = half_converters(level);
+        SCOPED_TRACE(simd_level_name(cv.level));
+        std::vector<float> wide(0x10000);
+        cv.f16_to_f32(h.data(), wide.data(), h.size());
+        for (uint32_t b = 0; b < 0x10000; ++b) {
+            ASSERT_EQ(bits_of(wide[b]), bits_of(half_detail::half_bits_to_float(static_cast<uint16_t>(b)))) << b;
+        }
+        cv.bf16_to_f32(g.data(), wide.data(), g.size());
+        for (uint32_t b = 0; b < 0x10000; ++b) {
+            ASSERT_EQ(bits_of(wide[b]), b << 16);
+        }
+
+        std::vector<float16> nh(f.size());
+        std::vector<bfloat16> ng(f.size());
+        cv.f32_to_f16(f.data(), nh.data(), f.size());
+        cv.f32_to_bf16(f.data(), ng.data(), f.size());
+        for (size_t i = 0; i < f.size(); ++i) {
+            ASSERT_EQ(nh[i].bits, half_detail::float_to_half_bits(f[i])) << std::hex << bits_of(f[i]);
+            ASSERT_EQ(ng[i].bits, half_detail::float_to_bfloat16_bits(f[i])) << std::hex << bits_of(f[i]);
+        }
+    }
+}
+
+template <typename H>
+class HalfTensorTest : public ::testing::Test {};
+
+using HalfTypes = ::testing::Types<float16, bfloat16>;
+TYPED_TEST_SUITE(HalfTensorTest, HalfTypes);
+
+// 4096 products of one: a 16-bit accumulator would stop growing at 2048 (float16) or 256 (bfloat16).
+TYPED_TEST(HalfTensorTest, GemmAccumulatesInFloat) {
+    using H = TypeParam;
+    const size_t k = 4096;
+    Tensor<H, 2> a(std::array<size_t, 2>{3, k}, std::vector<H>(3 * k, H(1.0f)));
+    Tensor<H, 2> b(std::array<size_t, 2>{k, 5}, std::vector<H>(k * 5, H(1.0f)));
+    auto c = a.matmul(b);
+    for (size_t i = 0; i < c.size(); ++i) {
+        EXPECT_EQ(float(c.data()[i]), 4096.0f);
+    }
+}
+
+// Against a float GEMM of the same (already rounded) inputs: the only extra error is the final rounding
+// of C, including for transposed operands, shapes that leave edge tiles, and C larger than one MC x NC
+// accumulator block in both directions.
+TYPED_TEST(HalfTensorTest, GemmMatchesFloatOnRoundedInputs) {
+    using H = TypeParam;
+    const size_t shapes[][3] = {{37, 41, 300}, {150, 4100, 260}};
+    for (const auto& shape : shapes) {
+        const size_t m = shape[0], n = shape[1], k = shape[2];
+        SCOPED_TRACE(std::to_string(m) + "x" + std::to_string(n) + "x" + std::to_string(k));
+        Tensor<H, 2> a(std::array<size_t, 2>{m, k}, random_half_vector<H>(m * k, -1, 1, 1));
+        Tensor<H, 2> bt(std::array<size_t, 2>{n, k}, random_half_vector<H>(n * k, -1, 1, 2));
+        const Tensor<H, 2> b = bt.transpose();
+
+        Tensor<float, 2> af(std::array<size_t, 2>{m, k}), bf(std::array<size_t, 2>{k, n});
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t p = 0; p < k; ++p) {
+                af({{i, p}}) = a({{i, p}});
+            }
+        }
+        for (size_t p = 0; p < k; ++p) {
+            for (size_t j = 0; j < n; ++j) {
+                bf({{p, j}}) = b({{p, j}});
+            }
+        }
+        auto c = a.matmul(b);
+        auto expected = af.matmul(bf);
+        for (size_t i = 0; i < c.size(); ++i) {
+            ASSERT_EQ(c.data()[i].bits, H(expected.data()[i]).bits) << i;
+        }
+    }
+}
+
+TYPED_TEST(HalfTensorTest, ElementwiseOpsRoundOnce) {
+    using H = TypeParam;
+    const size_t n = 1037;
+    auto va = random_half_vector<H>(n, -4, 4, 3);
+    auto vb = random_half_vector<H>(n, 0.5f, 4, 4);
+    AdvancedTensor<H, 1> a(std::array<size_t, 1>{n}, va);
+    AdvancedTensor<H, 1> b(std::array<size_t, 1>{n}, vb);
+    a.optimize_mul(b);
+    a.optimize_div(b);
+    for (size_t i = 0; i < n; ++i) {
+        const float prod = H(float(va[i]) * float(vb[i]));
+        ASSERT_EQ(a({{i}}).bits, H(prod / float(vb[i])).bits) << i;
+    }
+
+    AdvancedTensor<H, 1> s(std::array<size_t, 1>{n}, va);
+    s.optimize_sigmoid();
+    std::vector<float> wide(n);
+    for (size_t i = 0; i < n; ++i) {
+        wide[i] = va[i];
+    }
+    simd_kernels<float>().sigmoid(wide.data(), wide.data(), n);
+    for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(s({{i}}).bits, H(wide[i]).bits) << i;
+    }
+}
+
+TYPED_TEST(HalfTensorTest, ReductionsAccumulateInFloat) {
+    using H = TypeParam;
+    const size_t n = 10000;
+    AdvancedTensor<H, 1> ones(std::array<size_t, 1>{n}, std::vector<H>(n, H(1.0f)));
+    EXPECT_EQ(ones.optimize_sum(), 10000.0f);
+    EXPECT_EQ(ones.optimize_dot(ones), 10000.0f);
+    static_assert(std::is_same<decltype(ones.optimize_sum()), float>::value, "sums are returned in float");
+
+    auto v = random_half_vector<H>(n, -3, 3, 6);
+    v[4321] = H(7.5f);
+    v[1234] = H(-7.5f);
+    AdvancedTensor<H, 2> t(std::array<size_t, 2>{100, 100}, v);
+    AdvancedTensor<H, 2> view(t.transpose());
+    EXPECT_EQ(float(view.optimize_max()), 7.5f);
+    EXPECT_EQ(float(view.optimize_min()), -7.5f);
+    double sum = 0;
+    for (const H& x : v) {
+        sum += float(x);
+    }
+    EXPECT_NEAR(view.optimize_sum(), sum, 1e-2);
+}
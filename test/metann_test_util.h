@@ -0,0 +1,42 @@
+#pragma once
+
+// Includes and fixtures shared by the MetaNN tests. The MetaNN headers are not self-contained: the
+// facilities below have to come first, in this order, before any data type or operator header.
+#include <gtest/gtest.h>
+#include <facilities/traits.h>
+#include <data/facilities/traits.h>
+#include <data/facilities/tags.h>
+#include <evaluate/facilities/eval_handle.h>
+#include <evaluate/facilities/eval_buffer.h>
+#include <evaluate/facilities/eval_plan.h>
+#include <data/matrics/cpu_matrix.h>
+#include <data/matrics/trival_matrix.h>
+#include <data/batch/duplicate.h>
+
+using CpuMatrix = Matrix<float, DeviceTags::CPU>;
+
+// A rows x cols matrix of small values in [-0.5, 0.5) that differ from one seed to the next.
+inline CpuMatrix make_matrix(size_t rows, size_t cols, size_t seed, RowLayout layout = DefaultRowLayout()) {
+    CpuMatrix res(rows, cols, layout);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            res.SetValue(i, j, static_cast<float>((i * 7 + j * 3 + seed) % 11) / 10 - 0.5f);
+        }
+    }
+    return res;
+}
+
+// Same shape and elements. With no tolerance, elements compare within 4 ulps (EXPECT_FLOAT_EQ).
+inline void expect_matrix_eq(const CpuMatrix& a, const CpuMatrix& b, float tolerance = 0) {
+    ASSERT_EQ(a.RowNum(), b.RowNum());
+    ASSERT_EQ(a.ColNum(), b.ColNum());
+    for (size_t i = 0; i < a.RowNum(); ++i) {
+        for (size_t j = 0; j < a.ColNum(); ++j) {
+            if (tolerance == 0) {
+                EXPECT_FLOAT_EQ(a(i, j), b(i, j)) << "at (" << i << ", " << j << ")";
+            } else {
+                EXPECT_NEAR(a(i, j), b(i, j), tolerance) << "at (" << i << ", " << j << ")";
+            }
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include "../src/tensor/tensor.hpp"
+
+// A fake /sys/devices/system/node tree, removed when the test ends.
+struct FakeNodeDir {
+    std::string root = "numa_test_nodes";
+    std::vector<std::string> files;
+
+    void add(const std::string& node, const std::string& cpulist) {
+        ::mkdir(root.c_str(), 0755);
+        ::mkdir((root + "/" + node).c_str(), 0755);
+        files.push_back(root + "/" + node + "/cpulist");
+        std::ofstream(files.back()) << cpulist << "\n";
+    }
+
+    ~FakeNodeDir() {
+        for (const std::string& f : files) {
+            std::remove(f.c_str());
+            ::rmdir(f.substr(0, f.rfind('/')).c_str());
+        }
+        ::rmdir(root.c_str());
+    }
+};
+
+TEST(NumaTest, ParsesCpuLists) {
+    EXPECT_EQ(numa_detail::parse_cpu_list("0-3,8,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(numa_detail::parse_cpu_list("5"), (std::vector<int>{5}));
+    EXPECT_TRUE(numa_detail::parse_cpu_list("").empty());
+}
+
+TEST(NumaTest, ReadsNodesFromSysfs) {
+    FakeNodeDir dir;
+    dir.add("node2", "4-7");
+    dir.add("node0", "0-3");
+    dir.add("node1", "");   // memory only
+    dir.add("possible", "0-2");
+
+    NumaTopology all = NumaTopology::from_sysfs(dir.root, {});
+    ASSERT_EQ(all.node_count(), 2u);
+    EXPECT_EQ(all.node(0).id, 0);
+    EXPECT_EQ(all.node(1).id, 2);
+    EXPECT_EQ(all.cpu_order(), (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+    EXPECT_EQ(all.node_of_cpu(5), 1);
+    EXPECT_EQ(all.node_of_cpu(9), -1);
+
+    NumaTopology allowed = NumaTopology::from_sysfs(dir.root, {1, 2, 3});
+    ASSERT_EQ(allowed.node_count(), 1u);
+    EXPECT_EQ(allowed.node(0).cpus, (std::vector<int>{1, 2, 3}));
+
+    NumaTopology none = NumaTopology::from_sysfs("numa_test_missing", {0, 1});
+    ASSERT_EQ(none.node_count(), 1u);
+    EXPECT_EQ(none.node(0).cpus, (std::vector<int>{0, 1}));
+}
+
+TEST(NumaTest, SystemTopologyCoversThisThread) {
+    const NumaTopology& topology = NumaTopology::system();
+    ASSERT_GE(topology.node_count(), 1u);
+    EXPECT_GE(topology.node_of_cpu(sched_getcpu()), 0);
+}
+
+TEST(NumaTest, PlacedTensorsAreZeroedAndBehaveNormally) {
+    for (NumaPlacement placement : {NumaPlacement::Default, NumaPlacement::Parallel, NumaPlacement::Interleave}) {
+        Tensor<float, 2> t(std::array<size_t, 2>{512, 300}, placement);
+        Tensor<float, 2> small(std::array<size_t, 2>{2, 2}, placement);
+        for (size_t i = 0; i < t.size(); ++i) {
+            ASSERT_EQ(std::as_const(t).data()[i], 0.0f);
+        }
+        EXPECT_EQ(small({{1, 1}}), 0.0f);
+
+        t.add_(2.0f);
+        Tensor<float, 2> copy = t;
+        copy({{0, 0}}) = 5.0f;
+        EXPECT_EQ(t({{0, 0}}), 2.0f);
+        EXPECT_EQ(t({{511, 299}}), 2.0f);
+        EXPECT_EQ(copy({{0, 0}}), 5.0f);
+    }
+    EXPECT_TRUE(numa_interleave(nullptr, 0));
+}
+
+TEST(ThreadPoolTest, PinnedThreadsOwnTheirBlocks) {
+    cpu_set_t before;
+    pthread_getaffinity_np(pthread_self(), sizeof(before), &before);
+    EXPECT_TRUE(pin_thread_pool());
+    const NumaTopology& topology = NumaTopology::system();
+    EXPECT_EQ(sched_getcpu(), topology.cpu_order()[0]);
+
+    // Every chunk still runs exactly once, and with one thread the calling thread runs them all.
+    std::vector<std::atomic<int>> hits(10000);
+    std::set<std::thread::id> threads;
+    std::mutex mutex;
+    parallel_for(0, hits.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            ++hits[i];
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    }, 16);
+    for (auto& h : hits) {
+        ASSERT_EQ(h.load(), 1);
+    }
+    EXPECT_LE(threads.size(), ThreadPool::instance().num_threads());
+    if (ThreadPool::instance().num_threads() == 1) {
+        EXPECT_EQ(*threads.begin(), std::this_thread::get_id());
+    }
+
+    // Only the thread that pinned the pool can undo it, and that restores its earlier affinity.
+    bool unpinned_elsewhere = true;
+    std::thread([&]() { unpinned_elsewhere = unpin_thread_pool(); }).join();
+    EXPECT_FALSE(unpinned_elsewhere);
+    EXPECT_TRUE(unpin_thread_pool());
+    EXPECT_FALSE(unpin_thread_pool());
+    cpu_set_t after;
+    pthread_getaffinity_np(pthread_self(), sizeof(after), &after);
+    EXPECT_TRUE(CPU_EQUAL(&after, &before));
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "../src/tensor/tensor.hpp"
+
+static std::vector<int8_t> random_int8(size_t n, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(-128, 127);
+    std::vector<int8_t> v(n);
+    for (auto& x : v) {
+        x = static_cast<int8_t>(dist(gen));
+    }
+    return v;
+}
+
+static Tensor<float, 2> random_matrix(size_t rows, size_t cols, float lo, float hi, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(lo, hi);
+    Tensor<float, 2> t(std::array<size_t, 2>{rows, cols});
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = dist(gen);
+    }
+    return t;
+}
+
+// Every level up to the detected one.
+static std::vector<SimdLevel> levels() {
+    std::vector<SimdLevel> res;
+    for (int l = 0; l <= static_cast<int>(detected_simd_level()); ++l) {
+        res.push_back(static_cast<SimdLevel>(l));
+    }
+    return res;
+}
+
+TEST(QuantizeTest, ScalesKeepZeroExactAndRoundToEven) {
+    const QuantScale asym = choose_quant_scale(-1.0f, 3.0f, false);
+    EXPECT_FLOAT_EQ(asym.scale, 4.0f / 255);
+    EXPECT_EQ(dequantize_value(quantize_value(0.0f, asym), asym), 0.0f);
+    EXPECT_EQ(quantize_value(-1.0f, asym), -128);
+    EXPECT_EQ(quantize_value(3.0f, asym), 127);
+    EXPECT_EQ(quantize_value(100.0f, asym), 127);
+    EXPECT_EQ(quantize_value(std::nanf(""), asym), asym.zero_point);
+
+    const QuantScale sym = choose_quant_scale(-2.0f, 0.5f, true);
+    EXPECT_EQ(sym.zero_point, 0);
+    EXPECT_FLOAT_EQ(sym.scale, 2.0f / 127);
+    EXPECT_EQ(quantize_value(-2.0f, sym), -127);
+    EXPECT_EQ(quantize_value(2.5f * sym.scale, sym), 2);  // tie, to even
+    EXPECT_EQ(quantize_value(3.5f * sym.scale, sym), 4);
+
+    // Ranges that exclude zero are widened to include it.
+    EXPECT_EQ(dequantize_value(quantize_value(0.0f, choose_quant_scale(2.0f, 5.0f, false)),
+                               choose_quant_scale(2.0f, 5.0f, false)), 0.0f);
+}
+
+// The integer core against an exact reference, for every kernel level, with zero points on both sides
+// and shapes that leave edge tiles, span several depth blocks and several column blocks.
+TEST(QuantizeTest, IntegerGemmIsExactAtEveryLevel) {
+    const size_t shapes[][3] = {{1, 1, 1}, {7, 5, 3}, {8, 16, 4}, {37, 53, 29}, {150, 70, 517}, {13, 4100, 9}};
+    for (SimdLevel level : levels()) {
+        const QGemmKernel& kernel = qgemm_kernel(level);
+        SCOPED_TRACE(kernel.name);
+        for (const auto& s : shapes) {
+            const size_t m = s[0], n = s[1], k = s[2];
+            const auto a = random_int8(m * k, 1);
+            const auto b = random_int8(k * n, 2);
+            std::vector<float> scales(n, 1.0f);
+            std::vector<int32_t> zeros(n);
+            for (size_t j = 0; j < n; ++j) {
+                zeros[j] = static_cast<int32_t>(j % 7) - 3;
+            }
+            const int32_t a_zero = -5;
+            std::vector<int32_t> c(m * n, 42);
+            qgemm_s32(m, n, k, a.data(), k, a_zero, b.data(), n, QuantChannels{scales.data(), zeros.data(), true},
+                      c.data(), n, kernel);
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    int64_t ref = 0;
+                    for (size_t p = 0; p < k; ++p) {
+                        ref += (int64_t(a[i * k + p]) - a_zero) * (int64_t(b[p * n + j]) - zeros[j]);
+                    }
+                    ASSERT_EQ(c[i * n + j], ref) << "m=" << m << " n=" << n << " k=" << k << " i=" << i << " j=" << j;
+                }
+            }
+        }
+    }
+}
+
+TEST(QuantizeTest, PerChannelRoundTripIsWithinHalfAStep) {
+    auto w = random_matrix(64, 10, -1, 1, 3);
+    for (size_t i = 0; i < 64; ++i) {
+        w({{i, 3}}) *= 100;  // one channel with a much wider range
+    }
+    const QuantParams params = calibrate_per_channel(w, 1);
+    ASSERT_EQ(params.scales.size(), 10u);
+    EXPECT_GT(params.scales[3], 50 * params.scales[0]);
+
+    const auto q = QuantizedTensor<2>::quantize(w, params);
+    const auto back = q.dequantize();
+    for (size_t i = 0; i < 64; ++i) {
+        for (size_t j = 0; j < 10; ++j) {
+            EXPECT_LE(std::fabs(back({{i, j}}) - w({{i, j}})), params.scales[j] / 2 * 1.0001f);
+        }
+    }
+}
+
+TEST(QuantizeTest, ObserverTracksRangeOverBatches) {
+    MinMaxObserver observer;
+    observer.observe(random_matrix(4, 4, -1, 2, 4));
+    observer.observe(random_matrix(4, 4, -3, 1, 5));
+    EXPECT_LT(observer.min(), -2);
+    EXPECT_GT(observer.max(), 1.5f);
+    const QuantParams p = observer.params();
+    EXPECT_FALSE(p.per_channel);
+    EXPECT_FLOAT_EQ(p.scales[0], (observer.max() - observer.min()) / 255);
+
+    MinMaxObserver averaged(0.1f);
+    averaged.observe(random_matrix(4, 4, -1, 1, 6));
+    const float first = averaged.max();
+    averaged.observe(random_matrix(4, 4, -100, 100, 7));
+    EXPECT_LT(averaged.max(), first + 10.1f);
+
+    EXPECT_THROW(MinMaxObserver().params(), std::logic_error);
+}
+
+TEST(QuantizeTest, MatmulMatchesFloat) {
+    const size_t m = 20, k = 300, n = 33;
+    const auto x = random_matrix(m, k, 0, 2, 8);
+    const auto w = random_matrix(k, n, -0.5f, 0.5f, 9);
+    const auto expected = x.matmul(w);
+
+    MinMaxObserver observer;
+    observer.observe(x);
+    const auto qx = QuantizedTensor<2>::quantize(x, observer.params());
+    const auto qw = QuantizedTensor<2>::quantize(w, calibrate_per_channel(w, 1));
+
+    // Against the float product of the dequantised operands the only difference is float rounding.
+    const auto exact = qx.dequantize().matmul(qw.dequantize());
+    const auto y = qx.matmul(qw);
+    double max_err = 0, max_ref = 0;
+    for (size_t i = 0; i < y.size(); ++i) {
+        EXPECT_NEAR(y.data()[i], exact.data()[i], 1e-4f);
+        max_err = std::max(max_err, std::fabs(double(y.data()[i]) - expected.data()[i]));
+        max_ref = std::max(max_ref, std::fabs(double(expected.data()[i])));
+    }
+    EXPECT_LT(max_err / max_ref, 0.02);
+
+    // Float activations quantised on the fly give the same result here, since x has the same range.
+    const auto y2 = x.matmul(qw);
+    for (size_t i = 0; i < y.size(); ++i) {
+        EXPECT_NEAR(y2.data()[i], y.data()[i], 1e-4f);
+    }
+
+    // Requantised output, and a transposed (strided) weight view.
+    const QuantParams out = QuantParams::per_tensor(choose_quant_scale(-20, 20, false));
+    const auto qy = qx.matmul(qw, out);
+    for (size_t i = 0; i < y.size(); ++i) {
+        EXPECT_EQ(qy.values().data()[i], quantize_value(y.data()[i], out.at(0)));
+    }
+    const auto wt = QuantizedTensor<2>::quantize(w.transpose().contiguous(), QuantParams::per_tensor({0.01f, 0}));
+    const QuantizedTensor<2> view(wt.values().transpose(), wt.params());
+    EXPECT_NEAR(qx.matmul(view)({{3, 4}}), qx.dequantize().matmul(view.dequantize())({{3, 4}}), 1e-4f);
+}
+
+TEST(QuantizeTest, RejectsInvalidParameters) {
+    const auto w = random_matrix(4, 3, -1, 1, 10);
+    EXPECT_THROW(QuantizedTensor<2>::quantize(w, QuantParams::per_axis(1, {1, 1}, {0, 0})), std::invalid_argument);
+    EXPECT_THROW(QuantizedTensor<2>::quantize(w, QuantParams::per_axis(2, {1}, {0})), std::invalid_argument);
+    EXPECT_THROW(QuantizedTensor<2>::quantize(w, QuantParams::per_tensor({0.0f, 0})), std::invalid_argument);
+    EXPECT_THROW(QuantizedTensor<2>::quantize(w, QuantParams::per_tensor({1.0f, 300})), std::invalid_argument);
+
+    const auto rows = QuantizedTensor<2>::quantize(w, calibrate_per_channel(w, 0));
+    const auto x = QuantizedTensor<2>::quantize(random_matrix(2, 4, -1, 1, 11), QuantParams::per_tensor({0.1f, 0}));
+    EXPECT_THROW(x.matmul(rows), std::invalid_argument);     // weights per row, not per column
+    EXPECT_THROW(rows.matmul(x), std::invalid_argument);     // left operand per channel
+    EXPECT_THROW(x.matmul(x), std::invalid_argument);        // 2x4 times 2x4
+    EXPECT_THROW(x.dequantize().matmul(rows), std::invalid_argument);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "../src/tensor/tensor.hpp"
+
+static std::vector<const RandomKernel*> kernels() {
+    return {&random_kernel(SimdLevel::Scalar), &random_kernel(SimdLevel::AVX2), &random_kernel(SimdLevel::AVX512)};
+}
+
+// Known-answer vectors of the Random123 reference implementation of Philox4x32-10.
+TEST(RandomTest, PhiloxMatchesReferenceVectors) {
+    uint32_t x[4];
+    random_scalar::philox(RandomStream{0, 0}, 0, 0, x);
+    EXPECT_EQ(x[0], 0x6627e8d5u);
+    EXPECT_EQ(x[1], 0xe169c58du);
+    EXPECT_EQ(x[2], 0xbc57ac4cu);
+    EXPECT_EQ(x[3], 0x9b00dbd8u);
+
+    random_scalar::philox(RandomStream{~0ull, ~0u}, ~0u, ~0ull, x);
+    EXPECT_EQ(x[0], 0x408f276du);
+    EXPECT_EQ(x[1], 0x41c83b0eu);
+    EXPECT_EQ(x[2], 0xa20bc7c6u);
+    EXPECT_EQ(x[3], 0x6d5451fdu);
+
+    random_scalar::philox(RandomStream{0x299f31d0a4093822ull, 0x13198a2eu}, 0x03707344u, 0x85a308d3243f6a88ull, x);
+    EXPECT_EQ(x[0], 0xd16cfe09u);
+    EXPECT_EQ(x[1], 0x94fdccebu);
+    EXPECT_EQ(x[2], 0x5001e420u);
+    EXPECT_EQ(x[3], 0x24126ea1u);
+}
+
+// Every kernel gives the same bits, and any sub-range equals the same elements of a whole-buffer fill,
+// so the result cannot depend on how the work is split between threads.
+TEST(RandomTest, SameNumbersForEveryLevelAndRange) {
+    const size_t n = 100003;
+    const RandomStream s{12345, 3};
+    for (int dist = 0; dist < 3; ++dist) {
+        std::vector<float> reference(n);
+        for (const RandomKernel* kernel : kernels()) {
+            std::vector<float> v(n);
+            if (dist == 0) {
+                random_uniform(v.data(), n, s, -2.0f, 5.0f, *kernel);
+            } else if (dist == 1) {
+                random_normal(v.data(), n, s, 1.0f, 3.0f, *kernel);
+            } else {
+                random_truncated_normal(v.data(), n, s, 0.0f, 1.0f, *kernel);
+            }
+            if (kernel->level == SimdLevel::Scalar) {
+                reference = v;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                ASSERT_EQ(v[i], reference[i]) << kernel->name << " distribution " << dist << " at " << i;
+            }
+        }
+        if (dist == 2) {
+            continue;   // truncation is applied by the fill, not by the kernel
+        }
+        for (const RandomKernel* kernel : kernels()) {
+            for (size_t first : {0, 5, 64, 1000, 99990}) {
+                const size_t count = std::min<size_t>(777, n - first);
+                std::vector<float> part(count);
+                (dist == 0 ? kernel->uniform : kernel->normal)(s, 0, first, count, dist == 0 ? 7.0f : 3.0f,
+                                                                dist == 0 ? -2.0f : 1.0f, part.data());
+                for (size_t i = 0; i < count; ++i) {
+                    ASSERT_EQ(part[i], reference[first + i]) << kernel->name << " from " << first;
+                }
+            }
+        }
+    }
+}
+
+TEST(RandomTest, DistributionsHaveTheExpectedMoments) {
+    const size_t n = 1 << 20;
+    std::vector<double> v(n);
+    auto moments = [&](double& mean, double& var, double& kurtosis) {
+        mean = var = kurtosis = 0;
+        for (double x : v) {
+            mean += x;
+        }
+        mean /= n;
+        for (double x : v) {
+            var += (x - mean) * (x - mean);
+            kurtosis += std::pow(x - mean, 4);
+        }
+        var /= n;
+        kurtosis = kurtosis / n / (var * var);
+    };
+    double mean, var, kurtosis;
+
+    random_uniform(v.data(), n, RandomStream{1, 0}, -1.0f, 3.0f);
+    moments(mean, var, kurtosis);
+    EXPECT_NEAR(mean, 1.0, 0.01);
+    EXPECT_NEAR(var, 16.0 / 12, 0.01);
+    EXPECT_GE(*std::min_element(v.begin(), v.end()), -1.0);
+    EXPECT_LE(*std::max_element(v.begin(), v.end()), 3.0);
+
+    random_normal(v.data(), n, RandomStream{1, 1}, 2.0f, 0.5f);
+    moments(mean, var, kurtosis);
+    EXPECT_NEAR(mean, 2.0, 0.005);
+    EXPECT_NEAR(var, 0.25, 0.005);
+    EXPECT_NEAR(kurtosis, 3.0, 0.05);
+
+    // A standard normal truncated to [-2, 2] has variance 0.7737.
+    random_truncated_normal(v.data(), n, RandomStream{1, 2}, 0.0f, 1.0f);
+    moments(mean, var, kurtosis);
+    EXPECT_NEAR(mean, 0.0, 0.005);
+    EXPECT_NEAR(var, 0.7737, 0.005);
+    EXPECT_GE(*std::min_element(v.begin(), v.end()), -2.0);
+    EXPECT_LE(*std::max_element(v.begin(), v.end()), 2.0);
+}
+
+TEST(RandomTest, TensorFillsAreReproducible) {
+    Philox a(99), b(99);
+    Tensor<float, 2> w1(std::array<size_t, 2>{300, 500}), w2(std::array<size_t, 2>{300, 500});
+    fill_xavier_uniform(w1, a);
+    fill_xavier_uniform(w2, b);
+    const float limit = std::sqrt(6.0f / 800);
+    for (size_t i = 0; i < w1.size(); ++i) {
+        ASSERT_EQ(std::as_const(w1).data()[i], std::as_const(w2).data()[i]);
+        ASSERT_LE(std::fabs(std::as_const(w1).data()[i]), limit);
+    }
+
+    // The next fill takes the next stream, so it differs from the first.
+    fill_xavier_uniform(w2, b);
+    EXPECT_NE(w1({{0, 0}}), w2({{0, 0}}));
+    EXPECT_EQ(b.stream(), 2u);
+
+    // Fills write through copy-on-write like any other write.
+    Tensor<double, 2> h(std::array<size_t, 2>{2000, 64});
+    Tensor<double, 2> zeros = h;
+    fill_he_normal(h, a);
+    double var = 0;
+    for (size_t i = 0; i < h.size(); ++i) {
+        var += std::as_const(h).data()[i] * std::as_const(h).data()[i];
+    }
+    EXPECT_NEAR(var / h.size(), 2.0 / 2000, 0.1 * 2.0 / 2000);
+    EXPECT_EQ(zeros({{5, 5}}), 0.0);
+
+    Tensor<float16, 3> half(std::array<size_t, 3>{4, 5, 6});
+    fill_truncated_normal(half, a, 1.0f, 0.1f);
+    EXPECT_NEAR(static_cast<float>(half({{3, 4, 5}})), 1.0f, 0.2f);
+
+    Tensor<float, 2> transposed = w1.transpose();
+    EXPECT_THROW(fill_normal(transposed, a, 0.0f, 1.0f), std::invalid_argument);
+}
@@ -0,0 +1,155 @@
+#include "metann_test_util.h"
+#include <data/matrics/zero_matrix.h>
+#include <data/matrics/one_hot_vector.h>
+#include <operators/add.h>
+#include <operators/dot.h>
+#include <operators/element_mul.h>
+#include <operators/sigmoid.h>
+#include <operators/substract.h>
+#include <operators/tanh.h>
+
+static size_t row_len(const CpuMatrix& m) {
+    return LowerAccess(m).RowLen();
+}
+
+// Runs every test with evaluation results allocated in `layout`, fusion off and on.
+class RowLayoutTest : public ::testing::TestWithParam<bool> {
+protected:
+    void SetUp() override { EvalPlan<DeviceTags::CPU>::SetFusion(GetParam()); }
+    void TearDown() override {
+        EvalPlan<DeviceTags::CPU>::SetFusion(false);
+        DefaultRowLayout() = RowLayout::Packed;
+    }
+
+    // Evaluates `make(layout)` once with every operand and result packed, once padded.
+    template <typename TMake>
+    static void expect_layouts_match(TMake make) {
+        DefaultRowLayout() = RowLayout::Packed;
+        const CpuMatrix packed = Evaluate(make(RowLayout::Packed));
+        EXPECT_EQ(row_len(packed), packed.ColNum());
+
+        DefaultRowLayout() = RowLayout::Padded;
+        const CpuMatrix padded = Evaluate(make(RowLayout::Padded));
+        EXPECT_EQ(row_len(padded), RowLenFor<float>(padded.ColNum(), RowLayout::Padded));
+        DefaultRowLayout() = RowLayout::Packed;
+
+        expect_matrix_eq(padded, packed);
+    }
+};
+
+TEST(RowLayout, RowLenRoundsToCacheLines) {
+    EXPECT_EQ(RowLenFor<float>(1, RowLayout::Padded), 16u);
+    EXPECT_EQ(RowLenFor<float>(16, RowLayout::Padded), 16u);
+    EXPECT_EQ(RowLenFor<float>(17, RowLayout::Padded), 32u);
+    EXPECT_EQ(RowLenFor<double>(9, RowLayout::Padded), 16u);
+    EXPECT_EQ(RowLenFor<float>(17, RowLayout::Packed), 17u);
+
+    // Padding starts out zero and every row starts on a cache line.
+    const CpuMatrix m = make_matrix(5, 17, 1, RowLayout::Padded);
+    const float* mem = LowerAccess(m).RawMemory();
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(mem + i * 32) % CpuRowAlignment, 0u);
+        for (size_t j = 17; j < 32; ++j) {
+            EXPECT_EQ(mem[i * 32 + j], 0.0f);
+        }
+    }
+}
+
+TEST_P(RowLayoutTest, ElementwiseChainsMatchPacked) {
+    // 37 columns: padded to 48, so neither the data nor the padding is a whole number of tiles.
+    expect_layouts_match([](RowLayout l) {
+        auto a = make_matrix(9, 37, 1, l), b = make_matrix(9, 37, 2, l);
+        auto c = make_matrix(9, 37, 3, l), d = make_matrix(9, 37, 4, l);
+        return (a + b) * c - d;
+    });
+    expect_layouts_match([](RowLayout l) {
+        auto a = make_matrix(9, 300, 1, l), b = make_matrix(9, 300, 2, l), c = make_matrix(9, 300, 3, l);
+        return Tanh(Sigmoid(a + b) * c);
+    });
+    expect_layouts_match([](RowLayout l) {
+        auto x = make_matrix(7, 20, 4, l), w = make_matrix(20, 37, 5, l), b = make_matrix(7, 37, 6, l);
+        return Sigmoid(Dot(x, w) + b);
+    });
+}
+
+TEST_P(RowLayoutTest, MixedLayoutsAndViewsWalkRowByRow) {
+    const auto packed = make_matrix(6, 37, 1, RowLayout::Packed);
+    const auto padded = make_matrix(6, 37, 2, RowLayout::Padded);
+    const CpuMatrix expected = Evaluate(make_matrix(6, 37, 1, RowLayout::Packed) +
+                                        make_matrix(6, 37, 2, RowLayout::Packed));
+
+    for (RowLayout out : {RowLayout::Packed, RowLayout::Padded}) {
+        DefaultRowLayout() = out;
+        expect_matrix_eq(Evaluate(packed + padded), expected);
+        expect_matrix_eq(Evaluate(padded + packed), expected);
+    }
+
+    // A view that starts inside its matrix is not dense: its row length is the parent's.
+    const auto big = make_matrix(8, 40, 3, RowLayout::Padded);
+    const auto view = big.SubMatrix(1, 7, 2, 39);
+    const auto other = make_matrix(6, 37, 4, RowLayout::Padded);
+    DefaultRowLayout() = RowLayout::Padded;
+    const CpuMatrix res = Evaluate(view * other);
+    for (size_t i = 0; i < 6; ++i) {
+        for (size_t j = 0; j < 37; ++j) {
+            EXPECT_FLOAT_EQ(res(i, j), big(i + 1, j + 2) * other(i, j));
+        }
+    }
+}
+
+TEST_P(RowLayoutTest, WholeSpanPassWritesPadding) {
+    DefaultRowLayout() = RowLayout::Padded;
+    const auto x = make_matrix(4, 20, 1, RowLayout::Padded);
+    const CpuMatrix s = Evaluate(Sigmoid(x));
+
+    // Dense operands with one row length are walked as a single span, padding included: the zero
+    // padding of x became sigmoid(0) in s.
+    const size_t len = row_len(s);
+    ASSERT_EQ(len, 32u);
+    const float* mem = LowerAccess(s).RawMemory();
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 20; j < len; ++j) {
+            EXPECT_FLOAT_EQ(mem[i * len + j], 0.5f);
+        }
+    }
+
+    // Whatever the padding holds, consumers only read the first ColNum() elements of a row.
+    const auto w = make_matrix(20, 9, 2, RowLayout::Padded);
+    DefaultRowLayout() = RowLayout::Packed;
+    const CpuMatrix packedS = Evaluate(Sigmoid(make_matrix(4, 20, 1, RowLayout::Packed)));
+    expect_matrix_eq(s, packedS);
+    expect_matrix_eq(Evaluate(Dot(s, w)), Evaluate(Dot(packedS, make_matrix(20, 9, 2, RowLayout::Packed))));
+    expect_matrix_eq(Evaluate(s - s), Evaluate(packedS - packedS));
+}
+
+TEST_P(RowLayoutTest, ZeroMatrixAndOneHotVectorUseTheRowStride) {
+    DefaultRowLayout() = RowLayout::Padded;
+    const CpuMatrix zero = Evaluate(ZeroMatrix<float, DeviceTags::CPU>(5, 37));
+    ASSERT_EQ(row_len(zero), 48u);
+    for (size_t i = 0; i < 5; ++i) {
+        for (size_t j = 0; j < 37; ++j) {
+            EXPECT_EQ(zero(i, j), 0.0f);
+        }
+    }
+
+    const CpuMatrix hot = Evaluate(OneHotVector<float, DeviceTags::CPU>(37, 20));
+    ASSERT_EQ(hot.RowNum(), 1u);
+    ASSERT_EQ(row_len(hot), 48u);
+    for (size_t j = 0; j < 37; ++j) {
+        EXPECT_EQ(hot(0, j), j == 20 ? 1.0f : 0.0f);
+    }
+
+    // Both feed element-wise units like any other padded matrix.
+    const auto a = make_matrix(5, 37, 1, RowLayout::Padded);
+    expect_matrix_eq(Evaluate(a + ZeroMatrix<float, DeviceTags::CPU>(5, 37)), a);
+    const auto row = make_matrix(1, 37, 2, RowLayout::Padded);
+    const CpuMatrix masked = Evaluate(row * OneHotVector<float, DeviceTags::CPU>(37, 20));
+    for (size_t j = 0; j < 37; ++j) {
+        EXPECT_FLOAT_EQ(masked(0, j), j == 20 ? row(0, 20) : 0.0f);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Fusion, RowLayoutTest, ::testing::Bool(),
+                         [](const ::testing::TestParamInfo<bool>& info) {
+                             return info.param ? "Fused" : "Unfused";
+                         });
@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "../src/tensor/tensor_advanced.hpp"
+
+template <typename T>
+class SimdKernelsTest : public ::testing::Test {
+protected:
+    static std::vector<T> random_vector(size_t n, double lo, double hi, unsigned seed) {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<double> dist(lo, hi);
+        std::vector<T> v(n);
+        for (auto& x : v) {
+            x = static_cast<T>(dist(gen));
+        }
+        return v;
+    }
+
+    // Every level up to the detected one; levels the host lacks fall back and are skipped.
+    static std::vector<SimdLevel> levels() {
+        std::vector<SimdLevel> res;
+        for (int l = 0; l <= static_cast<int>(detected_simd_level()); ++l) {
+            res.push_back(static_cast<SimdLevel>(l));
+        }
+        return res;
+    }
+
+    // Error of `actual` in units in the last place of the correctly rounded `expected`.
+    static double ulps(T actual, long double expected) {
+        const T rounded = static_cast<T>(expected);
+        T ulp = std::nextafter(std::fabs(rounded), std::numeric_limits<T>::infinity()) - std::fabs(rounded);
+        ulp = std::max(ulp, std::numeric_limits<T>::denorm_min());
+        return static_cast<double>(std::fabs(static_cast<long double>(actual) - expected) / ulp);
+    }
+
+    // Max ulp error of kernel over n points uniform in [lo, hi] (or 2^[lo, hi] when log2_spaced).
+    template <typename Kernel, typename Ref>
+    static double max_ulps(Kernel kernel, Ref ref, double lo, double hi, bool log2_spaced = false) {
+        const size_t n = 20000;
+        auto x = random_vector(n, lo, hi, 11);
+        if (log2_spaced) {
+            for (auto& v : x) v = static_cast<T>(std::exp2(static_cast<double>(v)));
+        }
+        std::vector<T> y(n);
+        kernel(x.data(), y.data(), n);
+        double worst = 0;
+        for (size_t i = 0; i < n; ++i) {
+            worst = std::max(worst, ulps(y[i], ref(static_cast<long double>(x[i]))));
+        }
+        return worst;
+    }
+};
+
+using KernelTypes = ::testing::Types<float, double>;
+TYPED_TEST_SUITE(SimdKernelsTest, KernelTypes);
+
+// Sizes that cover empty input, pure tails and full vectors of every width.
+static const size_t kSizes[] = {0, 1, 3, 7, 15, 16, 33, 100, 1003};
+
+TYPED_TEST(SimdKernelsTest, BinaryOpsMatchScalarArithmetic) {
+    using T = TypeParam;
+    for (SimdLevel level : this->levels()) {
+        const SimdKernels<T>& k = simd_kernels<T>(level);
+        ASSERT_EQ(k.level, level);
+        for (size_t n : kSizes) {
+            auto a = this->random_vector(n, -10, 10, 1), b = this->random_vector(n, 0.5, 10, 2);
+            std::vector<T> out(n);
+            k.add(a.data(), b.data(), out.data(), n);
+            for (size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], a[i] + b[i]);
+            k.sub(a.data(), b.data(), out.data(), n);
+            for (size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], a[i] - b[i]);
+            k.mul(a.data(), b.data(), out.data(), n);
+            for (size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], a[i] * b[i]);
+            k.div(a.data(), b.data(), out.data(), n);
+            for (size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], a[i] / b[i]);
+            k.min(a.data(), b.data(), out.data(), n);
+            for (size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], std::min(a[i], b[i]));
+            k.max(a.data(), b.data(), out.data(), n);
+            for (size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], std::max(a[i], b[i]));
+
+            // In place, with out aliasing the first operand.
+            std::vector<T> c = a;
+            k.add(c.data(), b.data(), c.data(), n);
+            for (size_t i = 0; i < n; ++i) EXPECT_EQ(c[i], a[i] + b[i]);
+        }
+    }
+}
+
+TYPED_TEST(SimdKernelsTest, Reductions) {
+    using T = TypeParam;
+    for (SimdLevel level : this->levels()) {
+        const SimdKernels<T>& k = simd_kernels<T>(level);
+        for (size_t n : kSizes) {
+            auto a = this->random_vector(n, -1, 1, 3), b = this->random_vector(n, -1, 1, 4);
+            double sum = 0, dot = 0;
+            for (size_t i = 0; i < n; ++i) {
+                sum += a[i];
+                dot += static_cast<double>(a[i]) * b[i];
+            }
+            EXPECT_NEAR(k.sum(a.data(), n), sum, 1e-4);
+            EXPECT_NEAR(k.dot(a.data(), b.data(), n), dot, 1e-4);
+            if (n > 0) {
+                EXPECT_EQ(k.reduce_max(a.data(), n), *std::max_element(a.begin(), a.end()));
+                EXPECT_EQ(k.reduce_min(a.data(), n), *std::min_element(a.begin(), a.end()));
+            }
+        }
+    }
+}
+
+// The bounds documented in simd_kernels.hpp.
+TYPED_TEST(SimdKernelsTest, TranscendentalUlpBounds) {
+    using T = TypeParam;
+    const bool f32 = sizeof(T) == 4;
+    const double max_log = f32 ? 88.72 : 709.78, min_log = f32 ? -103.9 : -745.1;
+    const double min_exp2 = f32 ? -149 : -1074, max_exp2 = f32 ? 127.9 : 1023.9;
+    for (SimdLevel level : this->levels()) {
+        SCOPED_TRACE(simd_level_name(level));
+        const SimdKernels<T>& k = simd_kernels<T>(level);
+        auto exp_ref = [](long double v) { return std::exp(v); };
+        auto log_ref = [](long double v) { return std::log(v); };
+        auto tanh_ref = [](long double v) { return std::tanh(v); };
+        auto sigmoid_ref = [](long double v) { return 1 / (1 + std::exp(-v)); };
+        EXPECT_LE(this->max_ulps(k.exp, exp_ref, -max_log, max_log), 2.0);
+        EXPECT_LE(this->max_ulps(k.exp, exp_ref, min_log, -max_log + 1.4), 2.0);  // denormal results
+        EXPECT_LE(this->max_ulps(k.log, log_ref, min_exp2, max_exp2, true), 1.0);
+        EXPECT_LE(this->max_ulps(k.log, log_ref, 0.5, 2.0), 1.0);
+        EXPECT_LE(this->max_ulps(k.tanh, tanh_ref, -20, 20), 2.0);
+        EXPECT_LE(this->max_ulps(k.tanh, tanh_ref, -1, 1), 2.0);
+        EXPECT_LE(this->max_ulps(k.sigmoid, sigmoid_ref, -max_log + 1, max_log - 1), 4.0);
+    }
+}
+
+TYPED_TEST(SimdKernelsTest, ReluMatchesMax) {
+    using T = TypeParam;
+    for (SimdLevel level : this->levels()) {
+        const size_t n = 1003;
+        auto a = this->random_vector(n, -5, 5, 5);
+        std::vector<T> out(n);
+        simd_kernels<T>(level).relu(a.data(), out.data(), n);
+        for (size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], a[i] > 0 ? a[i] : T(0));
+    }
+}
+
+TYPED_TEST(SimdKernelsTest, SpecialValues) {
+    using T = TypeParam;
+    const T inf = std::numeric_limits<T>::infinity(), nan = std::numeric_limits<T>::quiet_NaN();
+    std::vector<T> in = {T(0), T(1e4), T(-1e4), inf, -inf, nan}, out(in.size());
+    for (SimdLevel level : this->levels()) {
+        SCOPED_TRACE(simd_level_name(level));
+        const SimdKernels<T>& k = simd_kernels<T>(level);
+        k.exp(in.data(), out.data(), in.size());
+        EXPECT_EQ(out[0], T(1));
+        EXPECT_EQ(out[1], inf);
+        EXPECT_EQ(out[2], T(0));
+        EXPECT_EQ(out[3], inf);
+        EXPECT_EQ(out[4], T(0));
+        EXPECT_TRUE(std::isnan(out[5]));
+
+        std::vector<T> lin = {T(1), T(0), T(-0.0), T(-1), inf, nan, std::numeric_limits<T>::denorm_min()};
+        std::vector<T> lout(lin.size());
+        k.log(lin.data(), lout.data(), lin.size());
+        EXPECT_EQ(lout[0], T(0));
+        EXPECT_EQ(lout[1], -inf);
+        EXPECT_EQ(lout[2], -inf);
+        EXPECT_TRUE(std::isnan(lout[3]));
+        EXPECT_EQ(lout[4], inf);
+        EXPECT_TRUE(std::isnan(lout[5]));
+        EXPECT_NEAR(lout[6], std::log(static_cast<long double>(std::numeric_limits<T>::denorm_min())), 1e-3);
+
+        k.sigmoid(in.data(), out.data(), in.size());
+        EXPECT_EQ(out[0], T(0.5));
+        EXPECT_EQ(out[1], T(1));
+        EXPECT_EQ(out[2], T(0));
+        k.tanh(in.data(), out.data(), in.size());
+        EXPECT_EQ(out[0], T(0));
+        EXPECT_EQ(out[1], T(1));
+        EXPECT_EQ(out[2], T(-1));
+    }
+}
+
+TYPED_TEST(SimdKernelsTest, SoftmaxAndNegLogLikelihood) {
+    using T = TypeParam;
+    for (SimdLevel level : this->levels()) {
+        const SimdKernels<T>& k = simd_kernels<T>(level);
+        for (size_t n : kSizes) {
+            if (n == 0) continue;
+            auto a = this->random_vector(n, -30, 30, 6);
+            std::vector<T> out(n);
+            k.softmax(a.data(), out.data(), n);
+            // The shifted inputs are rounded to T first, as the kernel (and any scalar loop) does.
+            const T m = *std::max_element(a.begin(), a.end());
+            std::vector<long double> e(n);
+            long double sum = 0;
+            for (size_t i = 0; i < n; ++i) sum += e[i] = std::exp(static_cast<long double>(T(a[i] - m)));
+            const double bound = 4.0 + std::sqrt(static_cast<double>(n));
+            for (size_t i = 0; i < n; ++i) EXPECT_LE(this->ulps(out[i], e[i] / sum), bound);
+
+            auto target = this->random_vector(n, 0, 1, 7);
+            long double nll = 0;
+            for (size_t i = 0; i < n; ++i) nll -= target[i] * std::log(static_cast<long double>(out[i]));
+            EXPECT_NEAR(k.neg_log_likelihood(target.data(), out.data(), n), nll, 1e-4 * std::fabs(nll) + 1e-6);
+        }
+    }
+}
+
+TEST(SimdDispatchTest, ActiveLevelIsSupported) {
+    EXPECT_LE(static_cast<int>(simd_level()), static_cast<int>(detected_simd_level()));
+    EXPECT_EQ(simd_kernels<float>().level, simd_level());
+    // Asking for more than the host has falls back to the detected level.
+    EXPECT_EQ(simd_kernels<float>(SimdLevel::AVX512).level, detected_simd_level());
+    if (detected_simd_level() >= SimdLevel::AVX2) {
+        EXPECT_TRUE(cpu_features().avx2);
+        EXPECT_TRUE(cpu_features().fma);
+    }
+}
+
+TEST(SimdDispatchTest, TensorActivationsOnStridedViews) {
+    AdvancedTensor<float, 2> a(std::array<size_t, 2>{5, 9});
+    for (size_t i = 0; i < 5; ++i) {
+        for (size_t j = 0; j < 9; ++j) {
+            a({{i, j}}) = static_cast<float>(i) - static_cast<float>(j) * 0.5f;
+        }
+    }
+    AdvancedTensor<float, 2> dense(a.contiguous());
+    AdvancedTensor<float, 2> view(a.transpose());
+    dense.optimize_tanh();
+    view.optimize_tanh();
+    for (size_t i = 0; i < 5; ++i) {
+        for (size_t j = 0; j < 9; ++j) {
+            EXPECT_EQ(a({{i, j}}), dense({{i, j}}));
+        }
+    }
+}
+
+TEST(SimdDispatchTest, TensorReductions) {
+    AdvancedTensor<double, 2> a(std::array<size_t, 2>{3, 4}, {1, -2, 3, 4, 5, 6, -7, 8, 9, 10, 11, -12});
+    EXPECT_DOUBLE_EQ(a.optimize_sum(), 36);
+    EXPECT_DOUBLE_EQ(a.optimize_max(), 11);
+    EXPECT_DOUBLE_EQ(a.optimize_min(), -12);
+    EXPECT_DOUBLE_EQ(a.optimize_dot(a), 650);
+    AdvancedTensor<double, 2> t(a.transpose());
+    EXPECT_DOUBLE_EQ(t.optimize_sum(), 36);
+
+    AdvancedTensor<double, 1> empty(std::array<size_t, 1>{0});
+    EXPECT_DOUBLE_EQ(empty.optimize_sum(), 0);
+    EXPECT_THROW(empty.optimize_max(), std::invalid_argument);
+}
+
+TEST(SimdDispatchTest, DivideByZeroLeavesTensorUntouched) {
+    AdvancedTensor<float, 1> a(std::array<size_t, 1>{20}, std::vector<float>(20, 6.0f));
+    std::vector<float> d(20, 2.0f);
+    d[17] = 0.0f;
+    AdvancedTensor<float, 1> b(std::array<size_t, 1>{20}, d);
+    EXPECT_THROW(a.optimize_div(b), std::runtime_error);
+    EXPECT_FLOAT_EQ(a({{0}}), 6.0f);
+}
+
+TEST(SimdDispatchTest, IntegerTensorsUseScalarPath) {
+    AdvancedTensor<int, 1> a(std::array<size_t, 1>{9}, {1, 2, 3, 4, 5, 6, 7, 8, 9});
+    AdvancedTensor<int, 1> b(std::array<size_t, 1>{9}, {9, 8, 7, 6, 5, 4, 3, 2, 1});
+    a.optimize_mul(b);
+    EXPECT_EQ(a({{4}}), 25);
+    a.optimize_maximum(b);
+    EXPECT_EQ(a({{8}}), 9);
+    EXPECT_EQ(a.optimize_sum(), 9 + 16 + 21 + 24 + 25 + 24 + 21 + 16 + 9);
+    EXPECT_THROW(a.optimize_div(AdvancedTensor<int, 1>(std::array<size_t, 1>{9})), std::runtime_error);
+}
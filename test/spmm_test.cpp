@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "../src/kernels/gemm.hpp"
+#include "../src/kernels/spmm.hpp"
+
+// Dense row-major matrix with roughly `density` of its elements non-zero.
+template <typename T>
+static std::vector<T> random_sparse(size_t rows, size_t cols, double density, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> pick(0, 1);
+    std::uniform_int_distribution<int> value(-4, 4);
+    std::vector<T> m(rows * cols, T(0));
+    for (auto& x : m) {
+        if (pick(gen) < density) {
+            x = static_cast<T>(value(gen)) + T(0.5);
+        }
+    }
+    return m;
+}
+
+template <typename T>
+static std::vector<T> reference(size_t m, size_t n, size_t k, const std::vector<T>& a, const std::vector<T>& b) {
+    std::vector<T> c(m * n);
+    gemm(m, n, k, a.data(), k, b.data(), n, c.data(), n);
+    return c;
+}
+
+TEST(SpmmTest, FromDenseKeepsOnlyNonZeroBlocks) {
+    // 1 0 0 0 0
+    // 0 0 0 0 2
+    // 0 0 0 0 0
+    const std::vector<float> a = {1, 0, 0, 0, 0,
+                                  0, 0, 0, 0, 2,
+                                  0, 0, 0, 0, 0};
+    const auto csr = BsrMatrix<float>::from_dense(3, 5, a.data(), 5);
+    EXPECT_EQ(csr.block_ptr, (std::vector<size_t>{0, 1, 2, 2}));
+    EXPECT_EQ(csr.block_col, (std::vector<size_t>{0, 4}));
+    EXPECT_EQ(csr.values, (std::vector<float>{1, 2}));
+
+    // 2 x 2 blocks: (0, 0) and the partial block (0, 2), padded with zeros past column 4.
+    const auto bsr = BsrMatrix<float>::from_dense(3, 5, a.data(), 5, 2, 2);
+    EXPECT_EQ(bsr.block_row_count(), 2u);
+    EXPECT_EQ(bsr.block_ptr, (std::vector<size_t>{0, 2, 2}));
+    EXPECT_EQ(bsr.block_col, (std::vector<size_t>{0, 2}));
+    EXPECT_EQ(bsr.values, (std::vector<float>{1, 0, 0, 0,  0, 0, 2, 0}));
+
+    EXPECT_THROW(BsrMatrix<float>::from_dense(3, 5, a.data(), 5, 0, 1), std::invalid_argument);
+}
+
+TEST(SpmmTest, FromCsrValidatesArrays) {
+    const auto ok = BsrMatrix<double>::from_csr(2, 3, {0, 1, 3}, {2, 1, 0}, {1.0, 2.0, 3.0});
+    EXPECT_EQ(ok.block_count(), 3u);
+    EXPECT_THROW(BsrMatrix<double>::from_csr(2, 3, {0, 1}, {2}, {1.0}), std::invalid_argument);
+    EXPECT_THROW(BsrMatrix<double>::from_csr(2, 3, {0, 2, 1}, {2}, {1.0}), std::invalid_argument);
+    EXPECT_THROW(BsrMatrix<double>::from_csr(2, 3, {0, 1, 1}, {3}, {1.0}), std::invalid_argument);
+    EXPECT_THROW(BsrMatrix<double>::from_csr(2, 3, {0, 1, 1}, {0}, {}), std::invalid_argument);
+}
+
+// Both products against the dense GEMM, for CSR and for block shapes that do not divide the matrix.
+// Values are half-integers, so every partial sum is exact and the comparison can be exact too.
+TEST(SpmmTest, MatchesDenseProduct) {
+    const size_t blocks[][2] = {{1, 1}, {2, 2}, {4, 1}, {1, 4}, {3, 5}};
+    const size_t m = 67, k = 45, n = 39;
+    for (double density : {0.0, 0.05, 0.3, 1.0}) {
+        const auto s = random_sparse<float>(m, k, density, 1);
+        const auto st = random_sparse<float>(k, n, density, 2);
+        const auto dense_b = random_sparse<float>(k, n, 1.0, 3);
+        const auto dense_a = random_sparse<float>(m, k, 0.8, 4);  // some zeros for the skip path
+        const auto expected_left = reference(m, n, k, s, dense_b);
+        const auto expected_right = reference(m, n, k, dense_a, st);
+        for (const auto& blk : blocks) {
+            SCOPED_TRACE(testing::Message() << "density " << density << " block " << blk[0] << "x" << blk[1]);
+            const auto a = BsrMatrix<float>::from_dense(m, k, s.data(), k, blk[0], blk[1]);
+            std::vector<float> c(m * n, -1.0f);
+            spmm(a, n, dense_b.data(), n, c.data(), n);
+            EXPECT_EQ(c, expected_left);
+
+            const auto b = BsrMatrix<float>::from_dense(k, n, st.data(), n, blk[0], blk[1]);
+            std::vector<float> c2(m * n, -1.0f);
+            spmm(m, dense_a.data(), k, b, c2.data(), n);
+            EXPECT_EQ(c2, expected_right);
+        }
+    }
+}
+
+TEST(SpmmTest, HonoursLeadingDimensions) {
+    const size_t m = 9, k = 7, n = 5, ld = 11;
+    const auto s = random_sparse<double>(m, k, 0.4, 5);
+    const auto b = random_sparse<double>(k, n, 1.0, 6);
+    std::vector<double> b_padded(k * ld, 99.0), c(m * ld, 77.0);
+    for (size_t i = 0; i < k; ++i) {
+        std::copy(b.begin() + i * n, b.begin() + (i + 1) * n, b_padded.begin() + i * ld);
+    }
+    spmm(BsrMatrix<double>::from_dense(m, k, s.data(), k, 2, 3), n, b_padded.data(), ld, c.data(), ld);
+    const auto expected = reference(m, n, k, s, b);
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < ld; ++j) {
+            EXPECT_EQ(c[i * ld + j], j < n ? expected[i * n + j] : 77.0);
+        }
+    }
+}
+
+// Large enough to be split over the pool; each output row is still computed by one thread in a
+// fixed order, so the result matches the dense product exactly.
+TEST(SpmmTest, ParallelRowsMatchDenseProduct) {
+    const size_t m = 600, k = 512, n = 128;
+    const auto s = random_sparse<float>(m, k, 0.02, 7);
+    const auto b = random_sparse<float>(k, n, 1.0, 8);
+    std::vector<float> c(m * n);
+    spmm(BsrMatrix<float>::from_dense(m, k, s.data(), k), n, b.data(), n, c.data(), n);
+    EXPECT_EQ(c, reference(m, n, k, s, b));
+
+    const auto st = random_sparse<float>(k, n, 0.02, 9);
+    const auto a = random_sparse<float>(m, k, 1.0, 10);
+    std::vector<float> c2(m * n);
+    spmm(m, a.data(), k, BsrMatrix<float>::from_dense(k, n, st.data(), n, 4, 4), c2.data(), n);
+    EXPECT_EQ(c2, reference(m, n, k, a, st));
+}
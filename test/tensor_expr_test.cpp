@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "../src/tensor/tensor_advanced.hpp"
+
+static Tensor<float, 2> filled(size_t rows, size_t cols, float start) {
+    Tensor<float, 2> t(std::array<size_t, 2>{rows, cols});
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            t({{i, j}}) = start + static_cast<float>(i * cols + j);
+        }
+    }
+    return t;
+}
+
+TEST(TensorExprTest, FusedChainMatchesElementwise) {
+    auto a = filled(5, 7, 1.0f), b = filled(5, 7, 2.0f), c = filled(5, 7, 3.0f), d = filled(5, 7, 4.0f);
+    Tensor<float, 2> r = a + b * c - d / a;
+    for (size_t i = 0; i < 5; ++i) {
+        for (size_t j = 0; j < 7; ++j) {
+            const std::array<size_t, 2> idx{i, j};
+            EXPECT_FLOAT_EQ(r(idx), a(idx) + b(idx) * c(idx) - d(idx) / a(idx));
+        }
+    }
+}
+
+TEST(TensorExprTest, ExpressionIsLazy) {
+    auto a = filled(2, 3, 0.0f), b = filled(2, 3, 1.0f);
+    auto expr = a + b;
+    a({{0, 0}}) = 100.0f;
+
+    // Leaves share the operand buffers, so the expression sees writes made before evaluation.
+    Tensor<float, 2> r = expr;
+    EXPECT_FLOAT_EQ(r({{0, 0}}), 101.0f);
+    EXPECT_FLOAT_EQ(expr.eval()({{1, 2}}), 5.0f + 6.0f);
+}
+
+TEST(TensorExprTest, FollowsOperandDetachedByWrite) {
+    // Large enough for a heap buffer, which copies share until one of them is written.
+    auto x = filled(16, 16, 0.0f), y = filled(16, 16, 1.0f);
+    auto expr = x + y;
+    {
+        // The write detaches x from the copy, and the old buffer is freed with it.
+        Tensor<float, 2> copy = x;
+        x({{0, 0}}) = 7.0f;
+    }
+    Tensor<float, 2> r = expr;
+    EXPECT_FLOAT_EQ(r({{0, 0}}), 7.0f + 1.0f);
+    EXPECT_FLOAT_EQ(r({{15, 15}}), 255.0f + 256.0f);
+}
+
+TEST(TensorExprTest, OutlivesTemporaries) {
+    auto expr = filled(2, 2, 1.0f) * filled(2, 2, 1.0f);
+    Tensor<float, 2> r = expr;
+    EXPECT_FLOAT_EQ(r({{1, 1}}), 16.0f);
+}
+
+TEST(TensorExprTest, AssignReusesUnsharedBuffer) {
+    auto a = filled(3, 3, 1.0f), b = filled(3, 3, 2.0f);
+    Tensor<float, 2> out(std::array<size_t, 2>{3, 3});
+    const float* before = out.data();
+    out = a * b;
+    EXPECT_EQ(out.data(), before);
+    EXPECT_FLOAT_EQ(out({{2, 2}}), 9.0f * 10.0f);
+
+    // A buffer shared with another tensor is not written through.
+    Tensor<float, 2> alias = out;
+    out = a + b;
+    EXPECT_NE(out.data(), alias.data());
+    EXPECT_FLOAT_EQ(alias({{2, 2}}), 90.0f);
+    EXPECT_FLOAT_EQ(out({{2, 2}}), 19.0f);
+}
+
+TEST(TensorExprTest, SelfAssignment) {
+    auto a = filled(2, 4, 1.0f), b = filled(2, 4, 0.0f);
+    a = a + b + a;
+    EXPECT_FLOAT_EQ(a({{1, 3}}), 8.0f + 7.0f + 8.0f);
+}
+
+TEST(TensorExprTest, StridedOperands) {
+    auto a = filled(3, 4, 0.0f);
+    auto b = filled(4, 3, 0.0f);
+    Tensor<float, 2> r = a + b.transpose() * a.slice(0, 0, 3);
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+            EXPECT_FLOAT_EQ(r({{i, j}}), a({{i, j}}) + b({{j, i}}) * a({{i, j}}));
+        }
+    }
+}
+
+TEST(TensorExprTest, ShapeMismatchThrows) {
+    auto a = filled(2, 3, 0.0f), b = filled(3, 2, 0.0f);
+    EXPECT_THROW(a + b, std::invalid_argument);
+    EXPECT_THROW((a + a) * b, std::invalid_argument);
+}
+
+TEST(TensorExprTest, AdvancedTensorOperands) {
+    AdvancedTensor<float, 2> a(filled(2, 2, 1.0f)), b(filled(2, 2, 5.0f));
+    AdvancedTensor<float, 2> r = a * b - a;
+    EXPECT_FLOAT_EQ(r({{1, 0}}), 3.0f * 7.0f - 3.0f);
+    r.optimize_add(a);
+    EXPECT_FLOAT_EQ(r({{1, 0}}), 21.0f);
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+#include "../src/tensor/tensor.hpp"
+#include "tensor_test_util.h"
+
+TEST(TensorIoTest, RoundTripsManyNamedTensors) {
+    TempFile file("tensor_io_test_many.tnsr");
+    auto w = iota_matrix(5, 7);
+    Tensor<double, 1> bias(std::array<size_t, 1>{3}, std::vector<double>{0.5, -1.5, 2.5});
+    Tensor<int32_t, 3> ids(std::array<size_t, 3>{2, 2, 2}, std::vector<int32_t>{1, 2, 3, 4, 5, 6, 7, 8});
+    Tensor<uint8_t, 1> empty(std::array<size_t, 1>{0});
+
+    TensorFileWriter writer;
+    writer.add("layer0.weight", w);
+    writer.add("layer0.bias", bias);
+    writer.add("ids", ids);
+    writer.add("empty", empty);
+    writer.write(file.path);
+
+    TensorFile tensors(file.path);
+    ASSERT_EQ(tensors.size(), 4u);
+    EXPECT_EQ(tensors.entry(1).name, "layer0.bias");
+    EXPECT_EQ(tensors.entry(1).dtype, TensorDType::Float64);
+    EXPECT_EQ(tensors.entry(2).shape, (std::vector<uint64_t>{2, 2, 2}));
+
+    auto w2 = tensors.get<float, 2>("layer0.weight");
+    ASSERT_EQ(w2.shape(), w.shape());
+    for (size_t i = 0; i < w.size(); ++i) {
+        EXPECT_EQ(w2.data()[i], w.data()[i]);
+    }
+    auto bias2 = tensors.get<double, 1>("layer0.bias");
+    EXPECT_EQ(bias2({{1}}), -1.5);
+    auto ids2 = tensors.get<int32_t, 3>("ids");
+    EXPECT_EQ(ids2({{1, 0, 1}}), 6);
+    EXPECT_EQ((tensors.get<uint8_t, 1>("empty").size()), 0u);
+}
+
+TEST(TensorIoTest, StoresHalfPrecisionTensors) {
+    TempFile file("tensor_io_test_half.tnsr");
+    Tensor<float16, 2> h(std::array<size_t, 2>{2, 2}, {float16(0.5f), float16(-1.0f), float16(65504.0f), float16(0.1f)});
+    Tensor<bfloat16, 1> g(std::array<size_t, 1>{2}, {bfloat16(3.0e38f), bfloat16(-0.1f)});
+    TensorFileWriter writer;
+    writer.add("h", h);
+    writer.add("g", g);
+    writer.write(file.path);
+
+    TensorFile tensors(file.path);
+    EXPECT_EQ(tensors.entry(0).dtype, TensorDType::Float16);
+    EXPECT_EQ(tensors.entry(1).dtype, TensorDType::BFloat16);
+    auto h2 = tensors.get<float16, 2>("h");
+    for (size_t i = 0; i < h.size(); ++i) {
+        EXPECT_EQ(h2.data()[i].bits, h.data()[i].bits);
+    }
+    EXPECT_EQ((tensors.get<bfloat16, 1>("g")({{1}}).bits), g({{1}}).bits);
+    EXPECT_THROW((tensors.get<float16, 1>("g")), std::runtime_error);
+}
+
+TEST(TensorIoTest, LoadedTensorsAreMappedWithoutCopies) {
+    TempFile file("tensor_io_test_mapped.tnsr");
+    auto t = iota_matrix(64, 64);
+    TensorFileWriter writer;
+    writer.add("a", t);
+    writer.add("b", t.transpose());
+    writer.write(file.path);
+
+    Tensor<float, 2> b;
+    {
+        TensorFile tensors(file.path);
+        auto a = tensors.get<float, 2>("a");
+        EXPECT_TRUE(a.data_ptr()->is_external());
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(std::as_const(a).data()) % 4096, 0u);
+        b = tensors.get<float, 2>("b");
+    }
+    // The tensor keeps the mapping alive, and its contents are the logical (transposed) layout.
+    EXPECT_EQ(b({{3, 5}}), t({{5, 3}}));
+
+    // Writes go to private pages: the file itself is unchanged.
+    b({{0, 0}}) = 42;
+    EXPECT_EQ((TensorFile(file.path).get<float, 2>("b")({{0, 0}})), t({{0, 0}}));
+
+    // Copies of a mapped buffer own their elements.
+    TensorStorage<float> copy = *b.data_ptr();
+    EXPECT_FALSE(copy.is_external());
+    EXPECT_EQ(copy[0], 42);
+}
+
+TEST(TensorIoTest, TensorsOfOneEntryAreCopiedOnWrite) {
+    TempFile file("tensor_io_test_cow.tnsr");
+    auto t = iota_matrix(8, 8);
+    TensorFileWriter writer;
+    writer.add("t", t);
+    writer.write(file.path);
+
+    TensorFile tensors(file.path);
+    auto a = tensors.get<float, 2>("t");
+    auto b = tensors.get<float, 2>("t");
+    EXPECT_TRUE(a.data_ptr()->shares_elements(*b.data_ptr()));
+
+    // Writing to one tensor copies it; the other and later ones still read the file.
+    a({{0, 0}}) = 42;
+    EXPECT_FALSE(a.data_ptr()->is_external());
+    EXPECT_TRUE(b.data_ptr()->is_external());
+    EXPECT_EQ(a({{0, 0}}), 42);
+    EXPECT_EQ(b({{0, 0}}), t({{0, 0}}));
+    EXPECT_EQ((tensors.get<float, 2>("t")({{0, 0}})), t({{0, 0}}));
+}
+
+TEST(TensorIoTest, SaveAndLoadUseTheContainerFormat) {
+    TempFile file("tensor_io_test_single.tnsr");
+    auto t = iota_matrix(3, 4);
+    t.save(file.path);
+
+    TensorFile tensors(file.path);
+    ASSERT_EQ(tensors.size(), 1u);
+    auto loaded = Tensor<float, 2>::load(file.path);
+    EXPECT_TRUE(loaded.data_ptr()->is_external());
+    EXPECT_EQ(loaded({{2, 3}}), 11);
+}
+
+TEST(TensorIoTest, LoadReadsTheEarlierRawFormat) {
+    TempFile file("tensor_io_test_legacy.bin");
+    const size_t shape[2] = {2, 3};
+    const float values[6] = {1, 2, 3, 4, 5, 6};
+    {
+        std::ofstream out(file.path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(shape), sizeof(shape));
+        out.write(reinterpret_cast<const char*>(values), sizeof(values));
+    }
+    auto loaded = Tensor<float, 2>::load(file.path);
+    ASSERT_EQ(loaded.shape()[0], 2u);
+    ASSERT_EQ(loaded.shape()[1], 3u);
+    EXPECT_EQ(loaded({{1, 2}}), 6);
+}
+
+// Element types without a file dtype keep the raw format, so save/load work for them as before.
+TEST(TensorIoTest, TypesWithoutDtypeUseTheRawFormat) {
+    static_assert(!tensor_io_detail::has_dtype<char> && !tensor_io_detail::has_dtype<long long>, "");
+
+    TempFile file("tensor_io_test_char.bin");
+    Tensor<char, 2> text(std::array<size_t, 2>{2, 5},
+                         std::vector<char>{'h', 'e', 'l', 'l', 'o', 'w', 'o', 'r', 'l', 'd'});
+    text.transpose().save(file.path);
+    {
+        std::ifstream in(file.path, std::ios::binary);
+        size_t shape[2];
+        in.read(reinterpret_cast<char*>(shape), sizeof(shape));
+        EXPECT_EQ(shape[0], 5u);
+        EXPECT_EQ(shape[1], 2u);
+    }
+    auto chars = Tensor<char, 2>::load(file.path);
+    ASSERT_EQ(chars.shape()[0], 5u);
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(chars({{i, 0}}), text({{0, i}}));
+        EXPECT_EQ(chars({{i, 1}}), text({{1, i}}));
+    }
+
+    Tensor<long long, 1> big(std::array<size_t, 1>{3}, std::vector<long long>{-1, 1LL << 40, 7});
+    big.save(file.path);
+    auto loaded = Tensor<long long, 1>::load(file.path);
+    EXPECT_EQ(loaded({2}), 7);
+    EXPECT_EQ(loaded({1}), 1LL << 40);
+}
+
+TEST(TensorIoTest, RejectsMismatchedAndCorruptFiles) {
+    TempFile file("tensor_io_test_errors.tnsr");
+    TensorFileWriter writer;
+    writer.add("w", iota_matrix(4, 4));
+    EXPECT_THROW(writer.add("w", iota_matrix(1, 1)), std::invalid_argument);
+    writer.write(file.path);
+
+    TensorFile tensors(file.path);
+    EXPECT_THROW((tensors.get<float, 2>("missing")), std::out_of_range);
+    EXPECT_THROW((tensors.get<double, 2>("w")), std::runtime_error);
+    EXPECT_THROW((tensors.get<float, 3>("w")), std::runtime_error);
+
+    // Cut the payload short.
+    {
+        std::ifstream in(file.path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out(file.path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size() - 8);
+    }
+    EXPECT_THROW(TensorFile{file.path}, std::runtime_error);
+
+    {
+        std::ofstream out(file.path, std::ios::binary | std::ios::trunc);
+        out << "not a tensor file at all, just some text";
+    }
+    EXPECT_THROW(TensorFile{file.path}, std::runtime_error);
+    EXPECT_THROW(TensorFile{"tensor_io_test_does_not_exist.tnsr"}, std::runtime_error);
+}
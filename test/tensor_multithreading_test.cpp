@@ -52,3 +52,120 @@ TEST(MultithreadedTensorTest, ParallelSum) {
 
     EXPECT_NEAR(sum, expected_sum, 1e-10 * expected_sum);
 }
+
+TEST(ThreadPoolTest, ParallelForCoversRangeOnce) {
+    const size_t size = 100003;
+    std::vector<int> hits(size, 0);
+
+    parallel_for(0, size, [&hits](size_t start, size_t end) {
+        for (size_t i = start; i < end; ++i) {
+            ++hits[i];
+        }
+    }, 64);
+
+    for (size_t i = 0; i < size; ++i) {
+        ASSERT_EQ(hits[i], 1);
+    }
+}
+
+TEST(ThreadPoolTest, ParallelReduceIsIndependentOfGrain) {
+    const size_t size = 50000;
+    std::vector<float> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = 1.0f / (1 + i % 97);
+    }
+
+    auto sum_with_grain = [&data](size_t grain) {
+        return parallel_reduce(0, data.size(), 0.0, [&data](size_t start, size_t end) {
+            double sum = 0;
+            for (size_t i = start; i < end; ++i) {
+                sum += data[i];
+            }
+            return sum;
+        }, std::plus<double>(), grain);
+    };
+
+    EXPECT_NEAR(sum_with_grain(1000), sum_with_grain(size), 1e-9);
+    EXPECT_NEAR(sum_with_grain(1), sum_with_grain(size), 1e-9);
+}
+
+TEST(ThreadPoolTest, ParallelReduceIsIndependentOfThreadCount) {
+    // Float sums of values spanning several magnitudes, so any change in chunk boundaries or in the
+    // order partials are combined shows up in the low bits.
+    const size_t size = 123457;
+    std::vector<float> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = (i % 3 == 0 ? 1e4f : 1.0f) / (1 + i % 97);
+    }
+    auto map = [&data](size_t start, size_t end) {
+        float sum = 0;
+        for (size_t i = start; i < end; ++i) {
+            sum += data[i];
+        }
+        return sum;
+    };
+
+    for (size_t grain : {size_t(1), size_t(64), size_t(1000), size_t(40000)}) {
+        // Single-threaded reference with the chunk boundaries documented by reduce_chunk_size.
+        const size_t chunk = ThreadPool::reduce_chunk_size(size, grain);
+        float expected = 0;
+        for (size_t start = 0; start < size; start += chunk) {
+            expected += map(start, std::min(start + chunk, size));
+        }
+
+        // On the whole pool...
+        const float pooled = parallel_reduce(0, size, 0.0f, map, std::plus<float>(), grain);
+        // ...and from inside a chunk, where the pool runs everything on the calling thread.
+        float inline_result = 0;
+        parallel_for(0, 2, [&](size_t start, size_t) {
+            if (start == 0) {
+                inline_result = parallel_reduce(0, size, 0.0f, map, std::plus<float>(), grain);
+            }
+        }, 1);
+
+        EXPECT_EQ(pooled, expected) << "grain " << grain;
+        EXPECT_EQ(inline_result, expected) << "grain " << grain;
+    }
+}
+
+TEST(ThreadPoolTest, NestedCallsAndExceptions) {
+    std::atomic<size_t> count{0};
+    parallel_for(0, 8, [&count](size_t start, size_t end) {
+        for (size_t i = start; i < end; ++i) {
+            parallel_for(0, 100, [&count](size_t s, size_t e) { count += e - s; }, 1);
+        }
+    }, 1);
+    EXPECT_EQ(count.load(), 800u);
+
+    EXPECT_THROW(parallel_for(0, 10000, [](size_t start, size_t) {
+        if (start == 0) {
+            throw std::runtime_error("chunk failed");
+        }
+    }, 10), std::runtime_error);
+}
+
+TEST(MultithreadedTensorTest, ParallelBroadcastAddLeadingDims) {
+    MultithreadedTensor<float, 3> t1(std::array<size_t, 3>{{4, 30, 50}});
+    MultithreadedTensor<float, 2> t2(std::array<size_t, 2>{{1, 50}});
+
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 30; ++j) {
+            for (size_t k = 0; k < 50; ++k) {
+                t1({{i, j, k}}) = i * 1500 + j * 50 + k;
+            }
+        }
+    }
+    for (size_t k = 0; k < 50; ++k) {
+        t2({{0, k}}) = 0.5f * k;
+    }
+
+    auto result = t1.parallel_broadcast_add(t2, 64);
+
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 30; ++j) {
+            for (size_t k = 0; k < 50; ++k) {
+                EXPECT_FLOAT_EQ(result({{i, j, k}}), t1({{i, j, k}}) + t2({{0, k}}));
+            }
+        }
+    }
+}
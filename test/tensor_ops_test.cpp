@@ -0,0 +1,290 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "../src/tensor/tensor_advanced.hpp"
+#include "tensor_test_util.h"
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+// Counts every operator new in this test binary, so a test can check that a block of code allocates nothing.
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t n) {
+    ++g_allocations;
+    if (void* p = std::malloc(n ? n : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+TEST(TensorOpsTest, OutVariantsMatchOperators) {
+    const auto a = iota_matrix<float>(7, 33, 1.0f);
+    const auto b = iota_matrix<float>(7, 33, 0.5f);
+    Tensor<float, 2> out(std::array<size_t, 2>{7, 33});
+    const float* buffer = std::as_const(out).data();
+
+    add_out(a, b, out);
+    Tensor<float, 2> expected = a + b;
+    for (size_t i = 0; i < out.size(); ++i) {
+        EXPECT_EQ(out.data()[i], expected.data()[i]);
+    }
+    sub_out(a, b, out);
+    expected = a - b;
+    EXPECT_EQ(out({{6, 32}}), expected({{6, 32}}));
+    mul_out(a, b, out);
+    expected = a * b;
+    EXPECT_EQ(out({{3, 4}}), expected({{3, 4}}));
+    div_out(a, b, out);
+    expected = a / b;
+    EXPECT_EQ(out({{5, 1}}), expected({{5, 1}}));
+    EXPECT_EQ(std::as_const(out).data(), buffer);
+}
+
+TEST(TensorOpsTest, ScalarsOnEitherSide) {
+    const auto a = iota_matrix<double>(3, 5, 1.0);
+    Tensor<double, 2> out(std::array<size_t, 2>{3, 5});
+    sub_out(a, 1, out);
+    EXPECT_EQ(out({{0, 0}}), 0.0);
+    sub_out(10, a, out);
+    EXPECT_EQ(out({{0, 1}}), 8.0);
+    div_out(1, a, out);
+    EXPECT_EQ(out({{0, 3}}), 0.25);
+    mul_out(a, 2.5, out);
+    EXPECT_EQ(out({{2, 4}}), 37.5);
+
+    Tensor<int, 2> i = iota_matrix<int>(2, 2, 1);
+    i.mul_(3).sub_(1);
+    EXPECT_EQ(i({{1, 1}}), 11);
+    i.div_(2);
+    EXPECT_EQ(i({{1, 1}}), 5);
+}
+
+TEST(TensorOpsTest, BroadcastingOperands) {
+    const auto x = iota_matrix<float>(4, 3, 1.0f);
+    Tensor<float, 1> bias(std::array<size_t, 1>{3}, {10, 20, 30});
+    Tensor<float, 2> scale(std::array<size_t, 2>{4, 1}, {1, 2, 3, 4});
+    Tensor<float, 2> out(std::array<size_t, 2>{4, 3});
+
+    add_out(x, bias, out);
+    EXPECT_EQ(out({{2, 1}}), x({{2, 1}}) + 20);
+    mul_out(scale, x, out);
+    EXPECT_EQ(out({{3, 2}}), 4 * x({{3, 2}}));
+    sub_out(bias, scale, out);   // both operands broadcast
+    EXPECT_EQ(out({{1, 0}}), 8.0f);
+
+    Tensor<float, 2> y = x;
+    y.div_(scale).add_(bias);
+    EXPECT_EQ(y({{3, 0}}), x({{3, 0}}) / 4 + 10);
+    EXPECT_EQ(x({{3, 0}}), 10.0f);  // y was a copy
+
+    EXPECT_THROW(add_out(x, Tensor<float, 1>(std::array<size_t, 1>{4}), out), std::invalid_argument);
+    Tensor<float, 2> wrong(std::array<size_t, 2>{3, 4});
+    EXPECT_THROW(add_out(x, bias, wrong), std::invalid_argument);
+}
+
+TEST(TensorOpsTest, StridedAndOverlappingOutputs) {
+    auto t = iota_matrix<float>(4, 4, 1.0f);
+    const Tensor<float, 2> original = t.contiguous();
+
+    // In place through a transposed view: every element is read before it is overwritten.
+    auto tt = t.transpose();
+    tt.add_(original.transpose());
+    EXPECT_EQ(t({{1, 2}}), 2 * original({{1, 2}}));
+
+    // An operand overlapping the output differently is copied first.
+    auto u = original.contiguous();
+    add_out(u.transpose(), u, u);
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+            EXPECT_EQ(u({{i, j}}), original({{i, j}}) + original({{j, i}}));
+        }
+    }
+
+    // Writing into a column of a larger tensor.
+    Tensor<float, 2> big(std::array<size_t, 2>{4, 3});
+    auto column = big.slice(1, 1, 2);
+    mul_out(original.slice(1, 0, 1), 2.0f, column);
+    EXPECT_EQ(big({{2, 1}}), 2 * original({{2, 0}}));
+    EXPECT_EQ(big({{2, 0}}), 0.0f);
+}
+
+TEST(TensorOpsTest, HalfPrecision) {
+    Tensor<float16, 2> a(std::array<size_t, 2>{2, 40});
+    Tensor<float16, 1> b(std::array<size_t, 1>{40});
+    for (size_t i = 0; i < 80; ++i) {
+        a.data()[i] = float16(static_cast<float>(i % 7));
+    }
+    for (size_t i = 0; i < 40; ++i) {
+        b.data()[i] = float16(0.5f);
+    }
+    a.mul_(b).add_(float16(1.0f));
+    EXPECT_EQ(static_cast<float>(a({{1, 5}})), (45 % 7) * 0.5f + 1.0f);
+
+    // A broadcast column is widened once and reused by every row.
+    Tensor<float16, 2> column(std::array<size_t, 2>{2, 1});
+    column.data()[0] = float16(2.0f);
+    column.data()[1] = float16(-1.0f);
+    div_out(a, column, a);
+    EXPECT_EQ(static_cast<float>(a({{0, 3}})), (3 * 0.5f + 1.0f) / 2);
+    sub_out(column, a, a);
+    EXPECT_EQ(static_cast<float>(a({{1, 5}})), -1.0f + (45 % 7) * 0.5f + 1.0f);
+}
+
+// Bias and scale shapes whose broadcast dimensions do and do not merge with their neighbours, checked
+// element by element against a direct computation.
+TEST(TensorOpsTest, BroadcastMatchesReference) {
+    const std::array<size_t, 4> shape{2, 3, 5, 7};
+    Tensor<float, 4> x(shape);
+    for (size_t i = 0; i < x.size(); ++i) {
+        x.data()[i] = static_cast<float>(i % 11) - 5.0f;
+    }
+    Tensor<float, 3> bias(std::array<size_t, 3>{3, 1, 1}, {1, 2, 3});
+    Tensor<float, 4> scale(std::array<size_t, 4>{2, 1, 5, 1});
+    for (size_t i = 0; i < scale.size(); ++i) {
+        scale.data()[i] = static_cast<float>(i) * 0.5f - 2.0f;
+    }
+    Tensor<float, 4> out(shape);
+
+    auto check = [&](auto op) {
+        for (size_t n = 0; n < 2; ++n) {
+            for (size_t c = 0; c < 3; ++c) {
+                for (size_t h = 0; h < 5; ++h) {
+                    for (size_t w = 0; w < 7; ++w) {
+                        const float expected = op(x({{n, c, h, w}}), bias({{c, 0, 0}}), scale({{n, 0, h, 0}}));
+                        ASSERT_EQ(out({{n, c, h, w}}), expected) << n << c << h << w;
+                    }
+                }
+            }
+        }
+    };
+    add_out(x, bias, out);
+    check([](float v, float b, float) { return v + b; });
+    mul_out(scale, x, out);
+    check([](float v, float, float s) { return s * v; });
+    sub_out(bias, scale, out);
+    check([](float, float b, float s) { return b - s; });
+    minimum_out(x, scale, out);
+    check([](float v, float, float s) { return std::min(v, s); });
+    maximum_out(bias, x, out);
+    check([](float v, float b, float) { return std::max(b, v); });
+}
+
+// Rows longer than a parallel chunk are split, and very short rows are batched.
+TEST(TensorOpsTest, LongAndShortRows) {
+    Tensor<double, 2> wide(std::array<size_t, 2>{3, 100000});
+    Tensor<double, 2> column(std::array<size_t, 2>{3, 1}, {1, 2, 3});
+    for (size_t i = 0; i < wide.size(); ++i) {
+        wide.data()[i] = static_cast<double>(i);
+    }
+    wide.mul_(column);
+    EXPECT_EQ(wide({{0, 99999}}), 99999.0);
+    EXPECT_EQ(wide({{2, 40000}}), 3 * 240000.0);
+
+    Tensor<double, 2> tall(std::array<size_t, 2>{100000, 3});
+    Tensor<double, 1> row(std::array<size_t, 1>{3}, {1, 2, 3});
+    add_out(tall, row, tall);
+    EXPECT_EQ(tall({{99999, 2}}), 3.0);
+    auto tall_t = tall.transpose();
+    add_out(tall_t, 1.0, tall_t);
+    EXPECT_EQ(tall({{50000, 1}}), 3.0);
+}
+
+TEST(TensorOpsTest, MinimumMaximumAndComparisons) {
+    auto x = iota_matrix<float>(3, 4, -5.0f);
+    Tensor<float, 1> limit(std::array<size_t, 1>{4}, {0, 1, 2, 3});
+    Tensor<float, 2> out(std::array<size_t, 2>{3, 4});
+    minimum_out(x, limit, out);
+    EXPECT_EQ(out({{0, 3}}), -2.0f);
+    EXPECT_EQ(out({{2, 3}}), 3.0f);
+    maximum_out(x, 0.0f, x);   // relu in place
+    EXPECT_EQ(x({{0, 0}}), 0.0f);
+    EXPECT_EQ(x({{2, 3}}), 6.0f);
+    minimum_out(1.0f, x, out);
+    EXPECT_EQ(out({{2, 0}}), 1.0f);
+    EXPECT_EQ(out({{0, 0}}), 0.0f);
+
+    Tensor<uint8_t, 2> mask(std::array<size_t, 2>{3, 4});
+    greater_out(x, limit, mask);
+    EXPECT_EQ(mask({{1, 0}}), 0);   // 0 > 0
+    EXPECT_EQ(mask({{1, 2}}), 0);   // 1 > 2
+    EXPECT_EQ(mask({{2, 0}}), 1);   // 3 > 0
+    less_equal_out(x, 2.0f, mask);
+    EXPECT_EQ(mask({{2, 0}}), 0);
+    EXPECT_EQ(mask({{1, 3}}), 1);
+    auto first_row = mask.slice(0, 0, 1);
+    equal_out(limit, x.slice(0, 2, 3), first_row);
+    EXPECT_EQ(mask({{0, 0}}), 0);
+    auto mask_t = mask.transpose();
+    not_equal_out(x.transpose(), x.transpose(), mask_t);
+    EXPECT_EQ(mask({{2, 2}}), 0);
+    greater_equal_out(x, 6.0f, mask);
+    less_out(Tensor<float, 1>(std::array<size_t, 1>{4}), x, mask);
+    EXPECT_EQ(mask({{0, 0}}), 0);
+    EXPECT_EQ(mask({{2, 1}}), 1);
+
+    // Comparisons work for every element type, with the mask itself as an operand.
+    greater_out(mask, uint8_t(0), mask);
+    EXPECT_EQ(mask({{2, 1}}), 1);
+}
+
+TEST(TensorOpsTest, BroadcastOutputIsRejected) {
+    Tensor<float, 1> row(std::array<size_t, 1>{4}, {1, 2, 3, 4});
+    auto rows = row.broadcast_to(std::array<size_t, 2>{3, 4});
+    EXPECT_THROW(add_out(row, 1.0f, rows), std::invalid_argument);
+    EXPECT_EQ(row({{0}}), 1.0f);
+}
+
+TEST(TensorOpsTest, OptimizedOpsReturnNewTensors) {
+    AdvancedTensor<float, 2> a(iota_matrix<float>(3, 3, 1.0f));
+    AdvancedTensor<float, 2> b(iota_matrix<float>(3, 3, 2.0f));
+    EXPECT_EQ(a.optimized_add(b)({{2, 2}}), 19.0f);
+    EXPECT_EQ(a.optimized_sub(b)({{2, 2}}), -1.0f);
+    EXPECT_EQ(a.optimized_mul(b)({{0, 1}}), 6.0f);
+    EXPECT_EQ(a.optimized_div(b)({{0, 0}}), 0.5f);
+    EXPECT_EQ(a({{2, 2}}), 9.0f);
+    AdvancedTensor<float, 2> zero(std::array<size_t, 2>{3, 3});
+    EXPECT_THROW(a.optimized_div(zero), std::runtime_error);
+    EXPECT_THROW(a.optimized_add(AdvancedTensor<float, 2>(std::array<size_t, 2>{3, 2})), std::invalid_argument);
+}
+
+// A linear layer with bias, a ReLU-like clamp and an SGD update, written with the in-place and out
+// variants: after the first step it runs without a single allocation. The matrices are larger than
+// kGrain, so the element-wise loops are split over the thread pool.
+TEST(TensorOpsTest, TrainingStepDoesNotAllocate) {
+    const size_t batch = 256, in = 256, out_dim = 256;
+    static_assert(256 * 256 > ops_detail::kGrain, "the step must reach the thread pool");
+    Tensor<float, 2> x = iota_matrix<float>(batch, in, 0.0f);
+    x.mul_(1e-3f);
+    Tensor<float, 2> w = iota_matrix<float>(in, out_dim, 0.0f);
+    w.mul_(1e-4f);
+    Tensor<float, 1> bias(std::array<size_t, 1>{out_dim});
+    Tensor<float, 2> y(std::array<size_t, 2>{batch, out_dim});
+    Tensor<float, 2> target(std::array<size_t, 2>{batch, out_dim});
+    Tensor<float, 2> err(std::array<size_t, 2>{batch, out_dim});
+    Tensor<float, 2> grad(std::array<size_t, 2>{in, out_dim});
+
+    auto step = [&] {
+        gemm(batch, out_dim, in, std::as_const(x).data(), in, std::as_const(w).data(), out_dim, y.data(), out_dim);
+        y.add_(bias);
+        maximum_out(y, 0.0f, y);
+        sub_out(y, target, err);
+        mul_out(err, 2.0f / batch, err);
+        const auto xt = x.transpose();
+        gemm(in, out_dim, batch, std::as_const(xt).data(), xt.strides()[0], xt.strides()[1],
+             std::as_const(err).data(), out_dim, 1, grad.data(), out_dim);
+        grad.mul_(0.01f);
+        w.sub_(grad);
+        sub_out(bias, err.slice(0, 0, 1).reshape(std::array<size_t, 1>{out_dim}), bias);
+    };
+    step();
+
+    const size_t before = g_allocations.load();
+    for (int i = 0; i < 10; ++i) {
+        step();
+    }
+    EXPECT_EQ(g_allocations.load() - before, 0u);
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "../src/tensor/tensor.hpp"
+
+template <typename T, size_t Dim>
+static Tensor<T, Dim> random_tensor(const std::array<size_t, Dim>& shape, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(-50, 50);
+    Tensor<T, Dim> t(shape);
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = static_cast<T>(dist(gen)) / T(4);
+    }
+    return t;
+}
+
+// Reference: reduce `mask` axes of a 3D tensor with op, starting from the first element of each group.
+template <typename T, typename Op>
+static std::vector<T> reference3(const Tensor<T, 3>& t, std::array<bool, 3> mask, Op op) {
+    const auto& s = t.shape();
+    std::array<size_t, 3> out_shape;
+    for (size_t d = 0; d < 3; ++d) {
+        out_shape[d] = mask[d] ? 1 : s[d];
+    }
+    std::vector<T> out(out_shape[0] * out_shape[1] * out_shape[2]);
+    std::vector<bool> seen(out.size(), false);
+    for (size_t i = 0; i < s[0]; ++i) {
+        for (size_t j = 0; j < s[1]; ++j) {
+            for (size_t k = 0; k < s[2]; ++k) {
+                const size_t o = ((mask[0] ? 0 : i) * out_shape[1] + (mask[1] ? 0 : j)) * out_shape[2] + (mask[2] ? 0 : k);
+                const T v = t({{i, j, k}});
+                out[o] = seen[o] ? op(out[o], v) : v;
+                seen[o] = true;
+            }
+        }
+    }
+    return out;
+}
+
+// Every combination of axes of a shape whose inner dimension is not a multiple of any vector width,
+// against a naive loop. Values are multiples of 1/4, so the sums are exact in any order.
+TEST(TensorReduceTest, AllAxisCombinationsMatchNaiveLoops) {
+    const auto t = random_tensor<double, 3>({5, 7, 37}, 1);
+    const std::array<bool, 3> masks[] = {{true, false, false}, {false, true, false}, {false, false, true},
+                                         {true, true, false}, {true, false, true}, {false, true, true},
+                                         {true, true, true}};
+    for (const auto& mask : masks) {
+        SCOPED_TRACE(testing::Message() << mask[0] << mask[1] << mask[2]);
+        std::vector<size_t> axes;
+        for (size_t d = 0; d < 3; ++d) {
+            if (mask[d]) {
+                axes.push_back(d);
+            }
+        }
+        Tensor<double, 3> sum, mx, mn;
+        if (axes.size() == 1) {
+            sum = reduce_sum<true>(t, axes[0]);
+            mx = reduce_max<true>(t, axes[0]);
+            mn = reduce_min<true>(t, axes[0]);
+        } else if (axes.size() == 2) {
+            sum = reduce_sum<true>(t, {axes[0], axes[1]});
+            mx = reduce_max<true>(t, {axes[0], axes[1]});
+            mn = reduce_min<true>(t, {axes[0], axes[1]});
+        } else {
+            sum = reduce_sum<true>(t, {0, 1, 2});
+            mx = reduce_max<true>(t, {0, 1, 2});
+            mn = reduce_min<true>(t, {0, 1, 2});
+        }
+        const auto esum = reference3(t, mask, [](double a, double b) { return a + b; });
+        const auto emax = reference3(t, mask, [](double a, double b) { return std::max(a, b); });
+        const auto emin = reference3(t, mask, [](double a, double b) { return std::min(a, b); });
+        ASSERT_EQ(sum.size(), esum.size());
+        for (size_t i = 0; i < esum.size(); ++i) {
+            EXPECT_EQ(sum.data()[i], esum[i]);
+            EXPECT_EQ(mx.data()[i], emax[i]);
+            EXPECT_EQ(mn.data()[i], emin[i]);
+        }
+    }
+}
+
+TEST(TensorReduceTest, ShapesWithAndWithoutKeepDims) {
+    const auto t = random_tensor<float, 3>({2, 3, 4}, 2);
+    EXPECT_EQ(reduce_sum(t, 1).shape(), (std::array<size_t, 2>{2, 4}));
+    EXPECT_EQ(reduce_sum<true>(t, 1).shape(), (std::array<size_t, 3>{2, 1, 4}));
+    EXPECT_EQ(reduce_mean(t, {0, 2}).shape(), (std::array<size_t, 1>{3}));
+    EXPECT_EQ(reduce_max<true>(t, {0, 2}).shape(), (std::array<size_t, 3>{1, 3, 1}));
+    EXPECT_EQ(reduce_argmax(t, 2).shape(), (std::array<size_t, 2>{2, 3}));
+    EXPECT_EQ(reduce_argmin<true>(t, 0).shape(), (std::array<size_t, 3>{1, 3, 4}));
+
+    EXPECT_THROW(reduce_sum(t, 3), std::invalid_argument);
+    EXPECT_THROW(reduce_sum(t, {1, 1}), std::invalid_argument);
+}
+
+TEST(TensorReduceTest, MeanAndStridedViews) {
+    const auto t = random_tensor<float, 2>({6, 10}, 3);
+    const auto view = t.transpose().slice(0, 1, 9, 2);  // 4 x 6, strided
+    const auto m = reduce_mean(view, 1);
+    for (size_t i = 0; i < 4; ++i) {
+        float s = 0;
+        for (size_t j = 0; j < 6; ++j) {
+            s += view({{i, j}});
+        }
+        EXPECT_FLOAT_EQ(m({{i}}), s / 6);
+    }
+}
+
+TEST(TensorReduceTest, ArgExtremaReportFirstOccurrence) {
+    Tensor<float, 2> t({3, 4}, {1, 5, 5, 2,
+                                7, 0, 7, -1,
+                                3, NAN, 9, NAN});
+    const auto row_max = reduce_argmax(t, 1);
+    EXPECT_EQ(row_max({{0}}), 1u);
+    EXPECT_EQ(row_max({{1}}), 0u);
+    EXPECT_EQ(row_max({{2}}), 1u);  // NaN wins, as in numpy
+    const auto col_min = reduce_argmin(t, 0);
+    EXPECT_EQ(col_min({{0}}), 0u);
+    EXPECT_EQ(col_min({{1}}), 2u);
+    EXPECT_EQ(col_min({{2}}), 0u);
+    EXPECT_EQ(col_min({{3}}), 2u);
+    const auto col_max = reduce_argmax(t.slice(0, 0, 2), 0);
+    EXPECT_EQ(col_max({{2}}), 1u);
+}
+
+TEST(TensorReduceTest, EmptyAxes) {
+    Tensor<float, 2> t(std::array<size_t, 2>{3, 0});
+    const auto s = reduce_sum(t, 1);
+    ASSERT_EQ(s.size(), 3u);
+    EXPECT_EQ(s({{2}}), 0.0f);
+    EXPECT_EQ(reduce_sum(t, 0).size(), 0u);
+    EXPECT_THROW(reduce_max(t, 1), std::invalid_argument);
+    EXPECT_THROW(reduce_argmin(t, 1), std::invalid_argument);
+}
+
+// A long float axis: pairwise summation keeps the error near that of a double sum, where a plain
+// running sum of the same values drifts by orders of magnitude more.
+TEST(TensorReduceTest, PairwiseSumsStayAccurateOnLongAxes) {
+    const size_t n = 1 << 22;
+    Tensor<float, 2> row(std::array<size_t, 2>{1, n});
+    Tensor<float, 2> col(std::array<size_t, 2>{n, 3});
+    std::mt19937 gen(4);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    double exact = 0;
+    float naive = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const float v = dist(gen);
+        row.data()[i] = v;
+        for (size_t j = 0; j < 3; ++j) {
+            col.data()[i * 3 + j] = v;
+        }
+        exact += v;
+        naive += v;
+    }
+    const double naive_err = std::fabs(naive - exact);
+    const double row_err = std::fabs(reduce_sum(row, 1)({{0}}) - exact);
+    const double col_err = std::fabs(reduce_sum(col, 0)({{1}}) - exact);
+    EXPECT_LT(row_err, exact * 1e-6);
+    EXPECT_LT(col_err, exact * 1e-6);
+    EXPECT_GT(naive_err, 10 * std::max(row_err, col_err));
+}
+
+TEST(TensorReduceTest, HalfPrecisionAccumulatesInFloat) {
+    Tensor<float16, 2> t(std::array<size_t, 2>{2, 3000});
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = float16(1.0f);
+    }
+    const Tensor<float, 1> rows = reduce_sum(t, 1);   // 3000 is past float16's exact integers
+    EXPECT_EQ(rows({{0}}), 3000.0f);
+    const Tensor<float, 1> cols = reduce_mean(t, 0);
+    EXPECT_EQ(cols({{2999}}), 1.0f);
+    t.data()[4321] = float16(-2.5f);
+    const Tensor<float16, 1> mn = reduce_min(t, 1);
+    EXPECT_EQ(static_cast<float>(mn({{1}})), -2.5f);
+    EXPECT_EQ(reduce_argmin(t, 1)({{1}}), 4321u - 3000u);
+}
+
+TEST(TensorReduceTest, IntegerTensors) {
+    Tensor<int, 2> t({2, 3}, {1, 2, 3, 4, 5, 6});
+    EXPECT_EQ(reduce_sum(t, 0)({{2}}), 9);
+    EXPECT_EQ(reduce_max(t, 1)({{0}}), 3);
+    EXPECT_EQ(reduce_argmax(t, 0)({{1}}), 1u);
+}
+
+// Outputs split over the ThreadPool give the same result as computing each one alone.
+TEST(TensorReduceTest, LargeReductionsMatchSmallOnes) {
+    const auto t = random_tensor<float, 3>({64, 130, 70}, 5);
+    const auto s = reduce_sum(t, {0, 2});
+    const auto m = reduce_max(t, 1);
+    for (size_t j = 0; j < 130; j += 17) {
+        const auto slice = t.slice(1, j, j + 1);
+        EXPECT_EQ(s({{j}}), reduce_sum(slice, {0, 2})({{0}}));
+    }
+    for (size_t i = 0; i < 64; i += 9) {
+        const auto slice = t.slice(0, i, i + 1);
+        const auto expected = reduce_max(slice, 1);
+        for (size_t k = 0; k < 70; ++k) {
+            EXPECT_EQ(m({{i, k}}), expected({{0, k}}));
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <utility>
+#include "../src/tensor/tensor.hpp"
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+// Counts every operator new in this test binary, so a test can check that a block of code allocates nothing.
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t n) {
+    ++g_allocations;
+    if (void* p = std::malloc(n ? n : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+TEST(TensorStorageTest, SmallBuffersAreInline) {
+    Tensor<float, 2> small(std::array<size_t, 2>{4, 4});
+    Tensor<float, 2> large(std::array<size_t, 2>{4, 5});
+    Tensor<double, 1> from_data({3}, {1.0, 2.0, 3.0});
+    EXPECT_TRUE(small.data_ptr()->is_inline());
+    EXPECT_FALSE(large.data_ptr()->is_inline());
+    EXPECT_TRUE(from_data.data_ptr()->is_inline());
+    EXPECT_EQ(from_data({{2}}), 3.0);
+    for (size_t i = 0; i < small.size(); ++i) {
+        EXPECT_EQ(small.data()[i], 0.0f);
+    }
+}
+
+TEST(TensorStorageTest, CopiesAndMovesKeepContents) {
+    TensorStorage<int> a(std::vector<int>{1, 2, 3});
+    TensorStorage<int> b(a);
+    b[0] = 7;
+    EXPECT_EQ(a[0], 1);
+    EXPECT_TRUE(b.is_inline());
+    EXPECT_NE(a.data(), b.data());
+
+    TensorStorage<int> c(std::move(b));
+    EXPECT_TRUE(c.is_inline());
+    EXPECT_EQ(c.size(), 3u);
+    EXPECT_EQ(c[0], 7);
+    EXPECT_EQ(c[2], 3);
+    EXPECT_TRUE(b.empty());
+
+    TensorStorage<int> big(100);
+    const int* heap = big.data();
+    c = std::move(big);
+    EXPECT_FALSE(c.is_inline());
+    EXPECT_EQ(c.data(), heap);
+    EXPECT_EQ(c.size(), 100u);
+}
+
+// Views of a small tensor still share its buffer.
+TEST(TensorStorageTest, ViewsShareInlineStorage) {
+    Tensor<float, 2> t({2, 2}, {1, 2, 3, 4});
+    auto tt = t.transpose();
+    tt({{1, 0}}) = 9;
+    EXPECT_EQ(t({{0, 1}}), 9.0f);
+    EXPECT_EQ(tt.data_ptr(), t.data_ptr());
+}
+
+TEST(TensorStorageTest, TinyTensorsDoNotAllocate) {
+    Tensor<float, 2> a({2, 2}, {1, 2, 3, 4});
+    Tensor<float, 2> b({2, 2}, {5, 6, 7, 8});
+    auto step = [&](int i) {
+        Tensor<float, 1> scalar(std::array<size_t, 1>{1});
+        scalar({{0}}) = static_cast<float>(i);
+        Tensor<float, 2> c = a * b + a;
+        return c({{1, 1}}) + scalar({{0}});
+    };
+    step(0);  // fills this thread's storage cache
+
+    const size_t before = g_allocations.load();
+    float total = 0;
+    for (int i = 0; i < 1000; ++i) {
+        total += step(i);
+    }
+    EXPECT_EQ(g_allocations.load() - before, 0u);
+    EXPECT_EQ(total, 1000 * 36.0f + 999 * 1000 / 2);
+}
+
+// A storage freed on a thread other than the one that created it goes to the freeing thread's cache.
+TEST(TensorStorageTest, StoragesMayDieOnAnotherThread) {
+    std::vector<Tensor<float, 1>> made;
+    std::thread producer([&] {
+        for (int i = 0; i < 100; ++i) {
+            made.emplace_back(std::array<size_t, 1>{4});
+        }
+    });
+    producer.join();
+    made.clear();
+    Tensor<float, 1> t(std::array<size_t, 1>{4});
+    EXPECT_TRUE(t.data_ptr()->is_inline());
+}
+
+TEST(TensorStorageTest, ShareDefersTheCopy) {
+    auto heap = make_tensor_storage<float>(100);
+    (*heap)[5] = 5.0f;
+    auto other = heap->share();
+    EXPECT_TRUE(heap->is_shared());
+    EXPECT_EQ(std::as_const(*other).data(), std::as_const(*heap).data());
+
+    (*other)[5] = 6.0f;
+    EXPECT_FALSE(heap->is_shared());
+    EXPECT_FALSE(other->is_shared());
+    EXPECT_EQ(std::as_const(*heap)[5], 5.0f);
+    EXPECT_EQ(std::as_const(*other)[5], 6.0f);
+
+    // Inline storages are small enough to copy right away.
+    auto small = make_tensor_storage<float>(4);
+    auto small_copy = small->share();
+    EXPECT_FALSE(small->is_shared());
+    EXPECT_NE(std::as_const(*small_copy).data(), std::as_const(*small).data());
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include "../src/tensor/tensor_stream.hpp"
+
+// Removes the file when the test ends, whether it passes or not.
+struct TempFile {
+    std::string path;
+    explicit TempFile(const std::string& name) : path(name) { std::remove(path.c_str()); }
+    ~TempFile() { std::remove(path.c_str()); }
+};
+
+static bool file_exists(const std::string& path) {
+    return std::ifstream(path).good();
+}
+
+// Rows [first, first + rows) of a tensor whose element i is i.
+static Tensor<float, 3> rows_from(size_t first, size_t rows) {
+    Tensor<float, 3> t(std::array<size_t, 3>{rows, 3, 5});
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = static_cast<float>(first * 15 + i);
+    }
+    return t;
+}
+
+TEST(TensorStreamTest, StreamsChunksInOrder) {
+    TempFile file("tensor_stream_test_rows.tchk");
+    ChunkedTensorWriter<float, 3> writer(file.path, {4, 3, 5});
+    writer.append(rows_from(0, 3));
+    writer.append(rows_from(3, 9));   // fills two chunks and starts a third
+    writer.append(rows_from(12, 1));
+    EXPECT_EQ(writer.rows(), 13u);
+    EXPECT_FALSE(file_exists(file.path));
+    writer.close();
+
+    for (size_t prefetch : {1, 2, 8}) {
+        ChunkedTensorReader<float, 3> reader(file.path, prefetch);
+        EXPECT_EQ(reader.shape(), (std::array<size_t, 3>{13, 3, 5}));
+        EXPECT_EQ(reader.chunk_rows(), 4u);
+        ASSERT_EQ(reader.chunk_count(), 4u);
+
+        Tensor<float, 3> chunk;
+        size_t row = 0;
+        while (reader.next(chunk)) {
+            EXPECT_EQ(chunk.shape()[0], row + 4 <= 13 ? 4u : 1u);
+            for (size_t i = 0; i < chunk.size(); ++i) {
+                ASSERT_EQ(chunk.data()[i], static_cast<float>(row * 15 + i));
+            }
+            row += chunk.shape()[0];
+        }
+        EXPECT_EQ(row, 13u);
+        EXPECT_FALSE(reader.next(chunk));
+    }
+}
+
+// Chunks handed out stay valid for as long as they are held, even after the reader is gone.
+TEST(TensorStreamTest, ChunksOutliveTheReader) {
+    TempFile file("tensor_stream_test_keep.tchk");
+    ChunkedTensorWriter<int32_t, 1> writer(file.path, {1000});
+    Tensor<int32_t, 1> values(std::array<size_t, 1>{5000});
+    for (size_t i = 0; i < values.size(); ++i) {
+        values.data()[i] = static_cast<int32_t>(i);
+    }
+    writer.append(values.slice(0, 0, 5000));
+    writer.close();
+
+    std::vector<Tensor<int32_t, 1>> kept;
+    {
+        ChunkedTensorReader<int32_t, 1> reader(file.path, 1);
+        Tensor<int32_t, 1> chunk;
+        while (reader.next(chunk)) {
+            kept.push_back(chunk);
+        }
+    }
+    ASSERT_EQ(kept.size(), 5u);
+    EXPECT_EQ(kept[0]({{999}}), 999);
+    EXPECT_EQ(kept[4]({{0}}), 4000);
+    kept[2]({{0}}) = -1;
+    EXPECT_EQ(kept[3]({{0}}), 3000);
+}
+
+TEST(TensorStreamTest, StridedAppendsAndDirectIo) {
+    TempFile file("tensor_stream_test_direct.tchk");
+    Tensor<double, 2> t(std::array<size_t, 2>{6, 700});
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = static_cast<double>(i) * 0.5;
+    }
+    ChunkedTensorWriter<double, 2> writer(file.path, {3, 6});
+    writer.append(t.transpose());
+    writer.close();
+
+    ChunkedTensorReader<double, 2> reader(file.path, 2, true);
+    Tensor<double, 2> chunk;
+    size_t row = 0;
+    while (reader.next(chunk)) {
+        for (size_t i = 0; i < chunk.shape()[0]; ++i) {
+            for (size_t j = 0; j < 6; ++j) {
+                ASSERT_EQ(chunk({{i, j}}), t({{j, row + i}}));
+            }
+        }
+        row += chunk.shape()[0];
+    }
+    EXPECT_EQ(row, 700u);
+}
+
+TEST(TensorStreamTest, RejectsMismatchesAndTruncation) {
+    TempFile file("tensor_stream_test_bad.tchk");
+    {
+        ChunkedTensorWriter<float, 3> writer(file.path, {2, 3, 5});
+        writer.append(rows_from(0, 1));
+        EXPECT_THROW(writer.append(Tensor<float, 3>(std::array<size_t, 3>{1, 5, 3})), std::invalid_argument);
+    }
+    EXPECT_FALSE(file_exists(file.path));   // never closed
+    EXPECT_FALSE(file_exists(file.path + ".tmp"));
+
+    ChunkedTensorWriter<float, 3> writer(file.path, {2, 3, 5});
+    writer.append(rows_from(0, 5));
+    writer.close();
+    EXPECT_THROW((ChunkedTensorReader<double, 3>(file.path)), std::runtime_error);
+    EXPECT_THROW((ChunkedTensorReader<float, 2>(file.path)), std::runtime_error);
+    EXPECT_THROW((ChunkedTensorReader<float, 3>("tensor_stream_test_missing.tchk")), std::runtime_error);
+
+    // Cut the file inside the second chunk: the first still arrives, the error comes with the second.
+    {
+        std::ifstream in(file.path, std::ios::binary);
+        std::vector<char> bytes(4096 + 4096 + 16);
+        in.read(bytes.data(), bytes.size());
+        std::ofstream out(file.path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size());
+    }
+    ChunkedTensorReader<float, 3> reader(file.path);
+    Tensor<float, 3> chunk;
+    EXPECT_TRUE(reader.next(chunk));
+    EXPECT_EQ(chunk({{1, 2, 4}}), 29.0f);
+    EXPECT_THROW(reader.next(chunk), std::runtime_error);
+}
+
+TEST(TensorStreamTest, EmptyTensor) {
+    TempFile file("tensor_stream_test_empty.tchk");
+    ChunkedTensorWriter<uint8_t, 2> writer(file.path, {16, 4});
+    writer.close();
+    ChunkedTensorReader<uint8_t, 2> reader(file.path);
+    EXPECT_EQ(reader.shape(), (std::array<size_t, 2>{0, 4}));
+    Tensor<uint8_t, 2> chunk;
+    EXPECT_FALSE(reader.next(chunk));
+}
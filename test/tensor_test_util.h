@@ -0,0 +1,24 @@
+#pragma once
+
+// Fixtures shared by the tensor tests.
+#include <array>
+#include <cstdio>
+#include <string>
+#include "../src/tensor/tensor.hpp"
+
+// A rows x cols matrix holding start, start + 1, ... in row-major order.
+template <typename T = float>
+Tensor<T, 2> iota_matrix(size_t rows, size_t cols, T start = T(0)) {
+    Tensor<T, 2> t(std::array<size_t, 2>{rows, cols});
+    for (size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = start + static_cast<T>(i);
+    }
+    return t;
+}
+
+// Removes the file when the test ends, whether it passes or not.
+struct TempFile {
+    std::string path;
+    explicit TempFile(const std::string& name) : path(name) { std::remove(path.c_str()); }
+    ~TempFile() { std::remove(path.c_str()); }
+};
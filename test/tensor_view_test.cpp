@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <utility>
+#include "../src/tensor/tensor_advanced.hpp"
+#include "tensor_test_util.h"
+
+TEST(TensorViewTest, TransposeIsAView) {
+    auto t = iota_matrix(3, 4);
+    auto tt = t.transpose();
+
+    ASSERT_EQ(tt.shape()[0], 4);
+    ASSERT_EQ(tt.shape()[1], 3);
+    EXPECT_EQ(tt.data_ptr(), t.data_ptr());
+    EXPECT_FALSE(tt.is_contiguous());
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+            EXPECT_FLOAT_EQ(tt({{j, i}}), t({{i, j}}));
+        }
+    }
+
+    tt({{1, 2}}) = -1.0f;
+    EXPECT_FLOAT_EQ(t({{2, 1}}), -1.0f);
+}
+
+TEST(TensorViewTest, SliceWithStep) {
+    auto t = iota_matrix(6, 5);
+    auto s = t.slice(0, 1, 6, 2).slice(1, 1, 4);
+
+    ASSERT_EQ(s.shape()[0], 3);
+    ASSERT_EQ(s.shape()[1], 3);
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            EXPECT_FLOAT_EQ(s({{i, j}}), t({{1 + 2 * i, 1 + j}}));
+        }
+    }
+    EXPECT_THROW(t.slice(0, 2, 7), std::out_of_range);
+}
+
+TEST(TensorViewTest, ReshapeSharesContiguousBuffer) {
+    auto t = iota_matrix(4, 6);
+    auto r = t.reshape(std::array<size_t, 3>{2, 3, 4});
+    EXPECT_EQ(r.data_ptr(), t.data_ptr());
+    EXPECT_FLOAT_EQ(r({{1, 2, 3}}), 23.0f);
+
+    auto rt = t.transpose().reshape(std::array<size_t, 1>{24});
+    EXPECT_NE(rt.data_ptr(), t.data_ptr());
+    EXPECT_FLOAT_EQ(rt({{1}}), t({{1, 0}}));
+    EXPECT_THROW(t.reshape(std::array<size_t, 1>{25}), std::invalid_argument);
+}
+
+TEST(TensorViewTest, BroadcastToUsesZeroStride) {
+    Tensor<float, 1> row(std::array<size_t, 1>{3}, {1, 2, 3});
+    auto b = row.broadcast_to(std::array<size_t, 2>{4, 3});
+
+    EXPECT_EQ(b.strides()[0], 0);
+    EXPECT_EQ(b.data_ptr(), row.data_ptr());
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            EXPECT_FLOAT_EQ(b({{i, j}}), row({{j}}));
+        }
+    }
+    EXPECT_THROW(row.broadcast_to(std::array<size_t, 2>{4, 2}), std::invalid_argument);
+}
+
+TEST(TensorViewTest, ArithmeticOnStridedViews) {
+    auto t = iota_matrix(3, 3);
+    Tensor<float, 2> sum = t + t.transpose();
+    Tensor<float, 2> prod = t.transpose() * t.transpose();
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            EXPECT_FLOAT_EQ(sum({{i, j}}), t({{i, j}}) + t({{j, i}}));
+            EXPECT_FLOAT_EQ(prod({{i, j}}), t({{j, i}}) * t({{j, i}}));
+        }
+    }
+
+    AdvancedTensor<float, 2> a(iota_matrix(3, 3).transpose());
+    AdvancedTensor<float, 2> ones(std::array<size_t, 2>{3, 3}, std::vector<float>(9, 1.0f));
+    a.optimize_add(ones);
+    EXPECT_FLOAT_EQ(a({{0, 1}}), 4.0f);
+}
+
+TEST(TensorViewTest, MatmulOnTransposedView) {
+    auto a = iota_matrix(4, 3);
+    auto c = a.transpose().matmul(a);
+    auto expected = a.transpose().contiguous().matmul(a);
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            EXPECT_FLOAT_EQ(c({{i, j}}), expected({{i, j}}));
+        }
+    }
+}
+
+TEST(TensorViewTest, SaveWritesLogicalLayout) {
+    auto t = iota_matrix(2, 3);
+    const std::string path = "tensor_view_test.bin";
+    t.transpose().save(path);
+    auto loaded = Tensor<float, 2>::load(path);
+    std::remove(path.c_str());
+
+    ASSERT_EQ(loaded.shape()[0], 3);
+    ASSERT_EQ(loaded.shape()[1], 2);
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            EXPECT_FLOAT_EQ(loaded({{i, j}}), t({{j, i}}));
+        }
+    }
+}
+
+TEST(TensorViewTest, CopiesAreCopyOnWrite) {
+    auto t = iota_matrix(8, 8);
+    const float* original = std::as_const(t).data();
+    Tensor<float, 2> c = t;
+    EXPECT_EQ(std::as_const(c).data(), original);
+    EXPECT_TRUE(c.data_ptr()->shares_elements(*t.data_ptr()));
+
+    c({{0, 1}}) = -1.0f;
+    EXPECT_FLOAT_EQ(t({{0, 1}}), 1.0f);
+    EXPECT_FLOAT_EQ(c({{0, 1}}), -1.0f);
+    EXPECT_FALSE(c.data_ptr()->is_shared());
+    EXPECT_EQ(std::as_const(t).data(), original);
+
+    // Views taken before the write follow the tensor that was written.
+    auto u = t;
+    auto row = t.slice(0, 3, 4);
+    t({{3, 0}}) = 100.0f;
+    EXPECT_FLOAT_EQ(row({{0, 0}}), 100.0f);
+    EXPECT_FLOAT_EQ(u({{3, 0}}), 24.0f);
+}
+
+TEST(TensorViewTest, InPlaceOpsDoNotLeakIntoCopies) {
+    AdvancedTensor<float, 2> a(iota_matrix(4, 5));
+    AdvancedTensor<float, 2> b = a;
+    b.optimize_add(a);
+    EXPECT_FLOAT_EQ(a({{3, 4}}), 19.0f);
+    EXPECT_FLOAT_EQ(b({{3, 4}}), 38.0f);
+
+    // Converting a view keeps it a view.
+    AdvancedTensor<float, 2> v(a.transpose());
+    v.optimize_relu();
+    v({{4, 3}}) = 0.0f;
+    EXPECT_FLOAT_EQ(a({{3, 4}}), 0.0f);
+}
@@ -0,0 +1,98 @@
+#include <vector>
+#include "metann_test_util.h"
+
+// A stand-in for the Batch of data/batch/matrix.h, which cannot be included here because data/batch/batch.h is
+// missing. It holds one matrix per batch element, so unlike a real Batch its matrices may differ in row length.
+template <typename TElem, typename TDevice>
+class Batch<TElem, TDevice, CategoryTags::Matrix>
+{
+public:
+    using ElementType = TElem;
+    using DeviceType = TDevice;
+
+    Batch(size_t p_batchNum = 0, size_t p_rowNum = 0, size_t p_colNum = 0)
+        : m_rowNum(p_rowNum)
+        , m_colNum(p_colNum)
+    {
+        for (size_t i = 0; i < p_batchNum; ++i)
+        {
+            m_matrices.emplace_back(p_rowNum, p_colNum);
+        }
+    }
+
+    // All matrices must have the same shape.
+    explicit Batch(std::vector<Matrix<TElem, TDevice>> p_matrices)
+        : m_matrices(std::move(p_matrices))
+        , m_rowNum(m_matrices.front().RowNum())
+        , m_colNum(m_matrices.front().ColNum())
+    { }
+
+    size_t RowNum() const { return m_rowNum; }
+    size_t ColNum() const { return m_colNum; }
+    size_t BatchNum() const { return m_matrices.size(); }
+
+    const auto operator [] (size_t p_batchId) const
+    {
+        return m_matrices[p_batchId];
+    }
+
+    auto EvalRegister() const
+    {
+        return MakeConstEvalHandle(*this);
+    }
+
+private:
+    std::vector<Matrix<TElem, TDevice>> m_matrices;
+    size_t m_rowNum;
+    size_t m_colNum;
+};
+
+#include <operators/transpose.h>
+
+using CpuBatchMatrix = Batch<float, DeviceTags::CPU, CategoryTags::Matrix>;
+
+static CpuMatrix transposed(const CpuMatrix& m) {
+    CpuMatrix res(m.ColNum(), m.RowNum());
+    for (size_t i = 0; i < m.RowNum(); ++i) {
+        for (size_t j = 0; j < m.ColNum(); ++j) {
+            res.SetValue(j, i, m(i, j));
+        }
+    }
+    return res;
+}
+
+static void expect_batch_transposed(const CpuBatchMatrix& res, const CpuBatchMatrix& src) {
+    ASSERT_EQ(res.BatchNum(), src.BatchNum());
+    ASSERT_EQ(res.RowNum(), src.ColNum());
+    ASSERT_EQ(res.ColNum(), src.RowNum());
+    for (size_t b = 0; b < src.BatchNum(); ++b) {
+        expect_matrix_eq(res[b], transposed(src[b]));
+    }
+}
+
+TEST(TransposeOperatorTest, Matrix) {
+    const auto m = make_matrix(37, 70, 1, RowLayout::Padded);
+    expect_matrix_eq(Evaluate(Transpose(m)), transposed(m));
+}
+
+// Matrices with one row length are transposed by a single transpose_batched call.
+TEST(TransposeOperatorTest, BatchWithUniformRowLengths) {
+    const CpuBatchMatrix src({make_matrix(37, 70, 1), make_matrix(37, 70, 2), make_matrix(37, 70, 3)});
+    expect_batch_transposed(Evaluate(Transpose(src)), src);
+}
+
+// A padded matrix among packed ones sends every matrix through its own transpose call.
+TEST(TransposeOperatorTest, BatchWithMixedRowLengths) {
+    const CpuBatchMatrix src({make_matrix(37, 70, 1), make_matrix(37, 70, 2, RowLayout::Padded),
+                              make_matrix(37, 70, 3)});
+    ASSERT_NE(LowerAccess(src[0]).RowLen(), LowerAccess(src[1]).RowLen());
+    expect_batch_transposed(Evaluate(Transpose(src)), src);
+}
+
+TEST(TransposeOperatorTest, EmptyBatch) {
+    const CpuBatchMatrix src(0, 37, 70);
+    const CpuBatchMatrix res = Evaluate(Transpose(src));
+    EXPECT_EQ(res.BatchNum(), 0u);
+    EXPECT_EQ(res.RowNum(), 70u);
+    EXPECT_EQ(res.ColNum(), 37u);
+}
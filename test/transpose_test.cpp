@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "../src/tensor/tensor.hpp"
+
+// Element i * 1000 + j of a rows x cols matrix, so every element is distinct.
+template <typename T>
+static std::vector<T> numbered(size_t rows, size_t cols, size_t ld) {
+    std::vector<T> v(rows * ld, T(-1));
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            v[i * ld + j] = static_cast<T>(static_cast<float>((i * 1000 + j) % 2048));
+        }
+    }
+    return v;
+}
+
+static std::vector<const TransposeKernel*> kernels() {
+    return {&transpose_kernel(SimdLevel::Scalar), &transpose_kernel(SimdLevel::AVX512)};
+}
+
+template <typename T>
+static void check_shapes() {
+    const size_t shapes[][2] = {{1, 1}, {1, 37}, {8, 8}, {7, 9}, {16, 4}, {64, 64}, {65, 130}, {300, 17}, {513, 260}};
+    for (const TransposeKernel* kernel : kernels()) {
+        for (const auto& s : shapes) {
+            const size_t rows = s[0], cols = s[1], lds = cols + 3, ldd = rows + 5;
+            auto src = numbered<T>(rows, cols, lds);
+            std::vector<T> dst(cols * ldd, T(7));
+            transpose(src.data(), lds, dst.data(), ldd, rows, cols, *kernel);
+            for (size_t j = 0; j < cols; ++j) {
+                for (size_t i = 0; i < ldd; ++i) {
+                    const T expected = i < rows ? src[i * lds + j] : T(7);   // padding untouched
+                    ASSERT_EQ(static_cast<float>(dst[j * ldd + i]), static_cast<float>(expected))
+                        << kernel->name << " " << rows << "x" << cols << " at " << j << "," << i;
+                }
+            }
+        }
+    }
+}
+
+TEST(TransposeTest, MatchesReferenceForEveryElementSize) {
+    check_shapes<float>();
+    check_shapes<double>();
+    check_shapes<int32_t>();
+    check_shapes<float16>();
+    check_shapes<bfloat16>();
+    check_shapes<int8_t>();
+}
+
+TEST(TransposeTest, BatchedMatricesAtArbitraryAddresses) {
+    const size_t batch = 5, rows = 70, cols = 300;
+    std::vector<std::vector<float>> srcs, dsts;
+    for (size_t b = 0; b < batch; ++b) {
+        srcs.push_back(numbered<float>(rows, cols, cols));
+        srcs.back()[b] = -5.0f;
+        dsts.emplace_back(rows * cols);
+    }
+    transpose_batched<float>(batch, rows, cols, [&](size_t b) { return srcs[b].data(); }, cols,
+                             [&](size_t b) { return dsts[b].data(); }, rows);
+    for (size_t b = 0; b < batch; ++b) {
+        for (size_t i = 0; i < rows; ++i) {
+            for (size_t j = 0; j < cols; ++j) {
+                ASSERT_EQ(dsts[b][j * rows + i], srcs[b][i * cols + j]);
+            }
+        }
+    }
+}
+
+// contiguous() of views whose last two axes are swapped goes through the blocked kernel.
+TEST(TransposeTest, TensorCopiesOfTransposedViews) {
+    Tensor<float, 2> m(std::array<size_t, 2>{123, 517});
+    for (size_t i = 0; i < m.size(); ++i) {
+        m.data()[i] = static_cast<float>(i);
+    }
+    Tensor<float, 2> t = m.transpose().contiguous();
+    ASSERT_EQ(t.shape(), (std::array<size_t, 2>{517, 123}));
+    for (size_t i = 0; i < 123; ++i) {
+        for (size_t j = 0; j < 517; ++j) {
+            ASSERT_EQ(t({{j, i}}), m({{i, j}}));
+        }
+    }
+
+    Tensor<double, 4> x(std::array<size_t, 4>{3, 2, 20, 33});
+    for (size_t i = 0; i < x.size(); ++i) {
+        x.data()[i] = static_cast<double>(i);
+    }
+    auto p = x.permute({1, 0, 3, 2});
+    Tensor<double, 4> q = p.contiguous();
+    for (size_t a = 0; a < 2; ++a) {
+        for (size_t b = 0; b < 3; ++b) {
+            for (size_t c = 0; c < 33; ++c) {
+                for (size_t d = 0; d < 20; ++d) {
+                    ASSERT_EQ(q({{a, b, c, d}}), x({{b, a, d, c}}));
+                }
+            }
+        }
+    }
+
+    // A sliced source: the leading dimension is larger than the number of rows read.
+    auto s = m.slice(1, 10, 100).transpose().contiguous();
+    EXPECT_EQ(s({{5, 7}}), m({{7, 15}}));
+    // Element-wise operations on transposed operands see the same values.
+    Tensor<float, 2> sum = m.transpose() + m.transpose();
+    EXPECT_EQ(sum({{400, 100}}), 2 * m({{100, 400}}));
+}